@@ -1,199 +1,252 @@
-// 版本更新记录:
-// 2025.1.5: 右侧新增RGB色彩自定义功能 (左侧四个固定颜色按钮暂保留)。感谢群友 xiao_hj909。
-// 2025.3.23: 新增息屏功能。短按BOOT键息屏/亮屏，长按2秒进入深度睡眠。
-//            息屏状态下：红色LED为电源指示，蓝色LED为连接指示，绿色LED为远程更新指示。
-//            LED亮度可通过PWM调节。感谢群友 2093416185 (shapaper@126.com)。
-// 2025.5.9: 新增调试信息区域，显示设备数量、Uptime、MAC地址、内存使用情况等。
-//            调试信息区域在屏幕底部，包含4行信息。
-//            1. 绘图历史数量
-//            2. Uptime (毫秒)
-//            3. Compared Uptime (相对启动时间)
-//            4. 内存使用情况 (已用/总内存)
-//            重构了所有代码，解耦分离了UI、触摸、ESP-NOW等模块。
-//            代码结构更清晰，便于后续维护和扩展。
-//            添加历史记录同步功能，支持多设备间的绘图历史同步。
-//            感谢群友 2093416185 (shapaper@126.com)。
-// 2025.5.10: 修复了清屏bug,同步bug,并且优化了debug按钮，添加了嵌入式的coffee按钮（已获得Kurio Reiko授权）。
-// 2025.5.17: 支持触摸点超过2048个的情况
-// 2025.5.17: 新增对端信息界面和心跳包逻辑，10s无心跳认为对端下线。
-
-#include <SPI.h>
-#include <XPT2046_Touchscreen.h>
-#include <TFT_eSPI.h>
-#include <esp_now.h>
-#include <WiFi.h>
-#include <esp_wifi.h> // 用于 esp_wifi_get_mac()
-#include <queue>
-#include <set>
-#include <vector>
-#include <cmath>      // 用于 abs()
-#include <map>        // For std::map (needed for peerInfoMap)
-
-#include "src/config.h" // 引入配置文件
-#include "src/wifi_manager.h" // 引入 WiFi 管理模块
-#include "src/mqtt_handler.h" // 引入 MQTT 处理模块
-#include "src/esp_now_handler.h" // 引入 ESP-NOW 处理模块
-#include "src/ui_manager.h"   // 引入 UI 管理模块
-#include "src/touch_handler.h" // 引入触摸处理模块
-#include "src/power_manager.h" // 引入电源管理模块
-
-// XY_structure (now XY_TouchPoint_t) 已移至 touch_handler.h
-
-// 呼吸灯相关变量 (breathBrightness, breathDirection, lastBreathTime, hasNewUpdateWhileScreenOff)
-// 已移至 power_manager.cpp (作为 static 或 extern)
-
-// 创建 SPI 和触摸屏对象 (这些是硬件相关的，通常在主文件初始化)
-SPIClass mySpi = SPIClass(VSPI);
-XPT2046_Touchscreen ts(XPT2046_CS, XPT2046_IRQ); // 触摸屏对象
-TFT_eSPI tft = TFT_eSPI();                     // TFT 显示对象
-
-// 全局变量，部分已移至 esp_now_handler.cpp 并通过 esp_now_handler.h extern 声明
-// 此处保留那些尚未模块化或确实需要在主文件直接访问的变量
-
-unsigned long deviceInitialBootMillis = 0; // 本机启动时的 millis() 值 (仅供调试参考)
-
-// 与ESP-NOW同步逻辑相关的常量 (如果只在esp_now_handler中使用，可以移至其.cpp文件)
-// const unsigned long MIN_UPTIME_DIFF_FOR_NEW_SYNC_TARGET = 200UL; // 已移至 esp_now_handler.h/cpp (作为定义)
-// const unsigned long EFFECTIVE_UPTIME_SYNC_THRESHOLD = 1000UL; // 已移至 esp_now_handler.h/cpp
-
-// 其他全局变量
-// TS_Point lastLocalPoint = {0, 0, 0};  // 已移至 touch_handler.cpp (作为 static)
-// unsigned long lastLocalTouchTime = 0; // 已移至 touch_handler.cpp (作为 static)
-
-// macSet, allDrawingHistory, incomingMessageQueue 等已移至 esp_now_handler
-// currentColor, inCustomColorMode, redValue, greenValue, blueValue, savedScreenBuffer 已移至 ui_manager
-
-// 彩蛋相关变量 (lastResetTime, resetPressCount) 已移至 touch_handler.cpp
-
-// 定时器相关变量
-unsigned long lastBroadcastTime = 0;         // 上次广播 MAC 地址发现消息的时间戳 (用于UI更新设备数)
-unsigned long lastUptimeInfoBroadcastTime = 0; // 上次广播 Uptime 信息的时间戳 (ESP-NOW模块也用)
-unsigned long lastDebugInfoUpdateTime = 0;   // 上次更新调试信息区域的时间戳 (UI模块用)
-unsigned long lastHeartbeatSendTime = 0;     // 新增：上次发送心跳包的时间戳
-unsigned long lastPeerInfoUpdateTime = 0;    // 新增：上次更新对端信息界面的时间戳
-
-
-// 屏幕状态变量 (isScreenOn) 已移至 power_manager.cpp (作为 extern)
-
-// UI绘制函数已移至 ui_manager.cpp
-
-
-void setup()
-{
-    Serial.begin(115200);
-
-    // 1. 初始化自定义模块
-    powerManagerInit();  // 初始化电源管理 (引脚设置, LED, 按钮)
-    uiManagerInit();     // 初始化 UI 管理器 (如果需要特定设置)
-    touchHandlerInit();  // 初始化触摸处理器 (如果需要特定设置)
-    wifiManagerInit();   // 初始化 WiFi 管理器
-    // 在这里，我们暂时不自动连接WiFi或初始化MQTT，
-    // 这将通过UI菜单触发。
-
-    // 2. 初始化硬件接口 (SPI, 触摸屏, TFT)
-    mySpi.begin(XPT2046_CLK, XPT2046_MISO, XPT2046_MOSI, XPT2046_CS);
-    ts.begin(mySpi);
-    ts.setRotation(1); // 设置触摸屏方向
-
-    tft.init();
-    tft.setRotation(1); // 设置TFT显示方向
-
-    // 3. 初始化 WiFi 和 ESP-NOW
-    WiFi.mode(WIFI_STA);
-    WiFi.disconnect();   // 断开之前的连接，确保ESP-NOW在干净的状态下初始化
-    espNowInit();        // 初始化 ESP-NOW (来自 esp_now_handler.cpp)
-
-    // 4. 记录启动时间 (调试用)
-    deviceInitialBootMillis = millis();
-    Serial.print("设备初始启动毫秒数: ");
-    Serial.println(deviceInitialBootMillis);
-
-    // 5. 初始 UPTIME_INFO 广播 (在所有核心服务初始化后)
-    SyncMessage_t initialUptimeMsg; // 已重命名以避免与 setup 中的 uptimeMsg 冲突
-    initialUptimeMsg.type = MSG_TYPE_UPTIME_INFO;
-    initialUptimeMsg.senderUptime = millis();
-    initialUptimeMsg.senderOffset = relativeBootTimeOffset; // 来自 esp_now_handler 的 extern 变量
-    memset(&initialUptimeMsg.touch_data, 0, sizeof(TouchData_t));
-    sendSyncMessage(&initialUptimeMsg); // 来自 esp_now_handler.cpp
-    lastUptimeInfoBroadcastTime = millis(); // 更新上次广播时间
-
-    // 6. 绘制初始界面
-    drawMainInterface(); // 来自 ui_manager.cpp
-}
-
-// updateBreathLED, readBatteryVoltagePercentage 已移至 power_manager.cpp
-// UI 绘制及按钮检测函数已移至 ui_manager.cpp
-// averageXY 和 handleLocalTouch 函数已移至 touch_handler.cpp
-
-void loop()
-{
-    // 处理输入和通信
-    handleLocalTouch();         // from touch_handler.cpp
-    if (isWifiConnected()) {
-        mqttLoop(); // 如果WiFi已连接，则处理MQTT
-    } else {
-        processIncomingMessages();  // 否则，继续使用ESP-NOW
-    }
-    handleBootButton();         // from power_manager.cpp
-
-    unsigned long currentTimeForLoop = millis();
-
-    // 定期任务
-    // 1. 广播 UPTIME_INFO
-    if (currentTimeForLoop - lastUptimeInfoBroadcastTime >= UPTIME_INFO_BROADCAST_INTERVAL) {
-        SyncMessage_t uptimeMsgLoop; // 已重命名以避免与 setup 中的 uptimeMsg 冲突
-        uptimeMsgLoop.type = MSG_TYPE_UPTIME_INFO;
-        uptimeMsgLoop.senderUptime = currentTimeForLoop;
-        uptimeMsgLoop.senderOffset = relativeBootTimeOffset; // 来自 esp_now_handler 的 extern 变量
-        memset(&uptimeMsgLoop.touch_data, 0, sizeof(TouchData_t));
-        // 新增：填充内存信息
-        uptimeMsgLoop.usedMemory = esp_get_free_heap_size();
-        uptimeMsgLoop.totalMemory = ESP.getHeapSize();
-        sendSyncMessage(&uptimeMsgLoop); // 来自 esp_now_handler.cpp
-        lastUptimeInfoBroadcastTime = currentTimeForLoop;
-    }
-
-    // 2. 发送心跳包
-    // 心跳包现在也包含内存信息，并且用于心跳超时检测。
-    // UPTIME_INFO 消息现在也包含内存信息，并且用于同步决策。
-    // 两个消息都包含内存信息，确保对端能收到最新的内存数据。
-    // 我们可以保留心跳包，因为它有专门的心跳超时检测逻辑。
-    if (currentTimeForLoop - lastHeartbeatSendTime >= HEARTBEAT_SEND_INTERVAL_MS) {
-        sendHeartbeat(); // 来自 esp_now_handler.cpp
-        lastHeartbeatSendTime = currentTimeForLoop;
-    }
-
-    // 3. 检查对端心跳超时
-    checkPeerHeartbeatTimeout(); // 来自 esp_now_handler.cpp
-
-    // 4. 更新调试信息 (如果屏幕亮且不在调色模式)
-    // isScreenOn 和 inCustomColorMode 分别是来自 power_manager 和 ui_manager 的 extern 变量
-    if (isScreenOn && !inCustomColorMode && (currentTimeForLoop - lastDebugInfoUpdateTime >= DEBUG_INFO_UPDATE_INTERVAL)) {
-        drawDebugInfo(); // 来自 ui_manager.cpp
-        lastDebugInfoUpdateTime = currentTimeForLoop;
-    }
-
-    // 5. 更新连接设备计数 (如果不在调色模式且在主界面)
-    // inCustomColorMode 和 currentUIState 是来自 ui_manager 的 extern 变量
-    if (!inCustomColorMode && currentUIState == UI_STATE_MAIN && (currentTimeForLoop - lastBroadcastTime >= BROADCAST_INTERVAL)) { // BROADCAST_INTERVAL 也用于设备数量的UI更新
-        updateConnectedDevicesCount(); // 来自 ui_manager.cpp
-        lastBroadcastTime = currentTimeForLoop;
-    }
-
-    // 6. 管理屏幕关闭时的 LED 状态 (包括呼吸灯)
-    // isScreenOn 和 hasNewUpdateWhileScreenOff 是来自 power_manager 的 extern 变量
-    if (!isScreenOn && hasNewUpdateWhileScreenOff) {
-        updateBreathLED(); // 来自 power_manager.cpp
-    }
-    manageScreenStateLEDs(); // 来自 power_manager.cpp (根据 isScreenOn 处理其他 LED)
-
-    // 7. 周期性更新对端信息界面 (如果当前处于该界面)
-    // currentUIState 和 isPeerInfoScreenVisible 是来自 ui_manager 的 extern 变量
-    if (currentUIState == UI_STATE_PEER_INFO && isPeerInfoScreenVisible && (currentTimeForLoop - lastPeerInfoUpdateTime >= PEER_INFO_UPDATE_INTERVAL)) {
-        updatePeerInfoScreen(); // 来自 ui_manager.cpp
-        lastPeerInfoUpdateTime = currentTimeForLoop;
-    }
-
-    // 短暂延时，避免过于频繁的循环，给其他任务（如WiFi栈）一些时间
-    // delay(1); // 可选，根据实际情况调整
-}
+// 版本更新记录:
+// 2025.1.5: 右侧新增RGB色彩自定义功能 (左侧四个固定颜色按钮暂保留)。感谢群友 xiao_hj909。
+// 2025.3.23: 新增息屏功能。短按BOOT键息屏/亮屏，长按2秒进入深度睡眠。
+//            息屏状态下：红色LED为电源指示，蓝色LED为连接指示，绿色LED为远程更新指示。
+//            LED亮度可通过PWM调节。感谢群友 2093416185 (shapaper@126.com)。
+// 2025.5.9: 新增调试信息区域，显示设备数量、Uptime、MAC地址、内存使用情况等。
+//            调试信息区域在屏幕底部，包含4行信息。
+//            1. 绘图历史数量
+//            2. Uptime (毫秒)
+//            3. Compared Uptime (相对启动时间)
+//            4. 内存使用情况 (已用/总内存)
+//            重构了所有代码，解耦分离了UI、触摸、ESP-NOW等模块。
+//            代码结构更清晰，便于后续维护和扩展。
+//            添加历史记录同步功能，支持多设备间的绘图历史同步。
+//            感谢群友 2093416185 (shapaper@126.com)。
+// 2025.5.10: 修复了清屏bug,同步bug,并且优化了debug按钮，添加了嵌入式的coffee按钮（已获得Kurio Reiko授权）。
+// 2025.5.17: 支持触摸点超过2048个的情况
+// 2025.5.17: 新增对端信息界面和心跳包逻辑，10s无心跳认为对端下线。
+
+#include <SPI.h>
+#include <XPT2046_Touchscreen.h>
+#include <TFT_eSPI.h>
+#include <esp_now.h>
+#include <WiFi.h>
+#include <esp_wifi.h> // 用于 esp_wifi_get_mac()
+#include <queue>
+#include <set>
+#include <vector>
+#include <cmath>      // 用于 abs()
+#include <map>        // For std::map
+
+#include "src/config.h" // 引入配置文件
+#include "src/wifi_manager.h" // 引入 WiFi 管理模块
+#include "src/mqtt_handler.h" // 引入 MQTT 处理模块
+#include "src/esp_now_handler.h" // 引入 ESP-NOW 处理模块
+#include "src/ui_manager.h"   // 引入 UI 管理模块
+#include "src/ui_widgets.h"   // 引入控件树 (脏控件重绘)
+#include "src/touch_handler.h" // 引入触摸处理模块
+#include "src/power_manager.h" // 引入电源管理模块
+#include "src/serial_console.h" // 引入串口调试命令行
+#include "src/scheduler.h"      // 引入主循环调度器
+#include "src/render_queue.h"   // 引入渲染命令队列 (网络任务 -> 主循环)
+#include "src/canvas_store.h"   // 引入画布持久化 (LittleFS)
+#include "src/perf_counters.h"  // 引入运行时性能计数器
+#include "src/memory_tier.h"    // 引入内存分层 (内部 SRAM / PSRAM)
+#include "src/canvas_framebuffer.h" // 引入画布帧缓冲 (有 PSRAM 时)
+
+// XY_structure (now XY_TouchPoint_t) 已移至 touch_handler.h
+
+// 呼吸灯相关变量 (breathBrightness, breathDirection, lastBreathTime, hasNewUpdateWhileScreenOff)
+// 已移至 power_manager.cpp (作为 static 或 extern)
+
+// 创建 SPI 和触摸屏对象 (这些是硬件相关的，通常在主文件初始化)
+SPIClass mySpi = SPIClass(VSPI);
+XPT2046_Touchscreen ts(XPT2046_CS, XPT2046_IRQ); // 触摸屏对象
+TFT_eSPI tft = TFT_eSPI();                     // TFT 显示对象
+
+// 全局变量，部分已移至 esp_now_handler.cpp 并通过 esp_now_handler.h extern 声明
+// 此处保留那些尚未模块化或确实需要在主文件直接访问的变量
+
+unsigned long deviceInitialBootMillis = 0; // 本机启动时的 millis() 值 (仅供调试参考)
+
+// 与ESP-NOW同步逻辑相关的常量 (如果只在esp_now_handler中使用，可以移至其.cpp文件)
+// const unsigned long MIN_UPTIME_DIFF_FOR_NEW_SYNC_TARGET = 200UL; // 已移至 esp_now_handler.h/cpp (作为定义)
+// const unsigned long EFFECTIVE_UPTIME_SYNC_THRESHOLD = 1000UL; // 已移至 esp_now_handler.h/cpp
+
+// 其他全局变量
+// TS_Point lastLocalPoint = {0, 0, 0};  // 已移至 touch_handler.cpp (作为 static)
+// unsigned long lastLocalTouchTime = 0; // 已移至 touch_handler.cpp (作为 static)
+
+// 对端列表, allDrawingHistory, radioRxQueue 等已移至 esp_now_handler
+// currentColor, inCustomColorMode, redValue, greenValue, blueValue 已移至 ui_manager
+
+// 彩蛋相关变量 (lastResetTime, resetPressCount) 已移至 touch_handler.cpp
+
+// 定时任务改由 scheduler 模块按周期调度 (见 registerMainLoopTasks)，不再逐个比较 millis() 时间戳
+static void registerMainLoopTasks(); // 定义在 loop() 之前
+
+
+// 屏幕状态变量 (isScreenOn) 已移至 power_manager.cpp (作为 extern)
+
+// UI绘制函数已移至 ui_manager.cpp
+
+
+void setup()
+{
+    Serial.begin(115200);
+    memoryTierInit();        // 检测 PSRAM，须在分配绘图历史之前
+    canvasFramebufferInit(); // 有 PSRAM 时分配画布帧缓冲，重绘时推送缓冲而不是逐点重播
+    schedulerInit(); // 须在触摸任务和 ESP-NOW 启动前调用，之后它们才能唤醒主循环
+
+    // 1. 初始化自定义模块
+    powerManagerInit();  // 初始化电源管理 (引脚设置, LED, 按钮)
+    uiManagerInit();     // 初始化 UI 管理器 (如果需要特定设置)
+    touchHandlerInit();  // 初始化触摸处理器 (如果需要特定设置)
+    wifiManagerInit();   // 初始化 WiFi 管理器
+    // 在这里，我们暂时不自动连接WiFi或初始化MQTT，
+    // 这将通过UI菜单触发。
+
+    // 2. 初始化硬件接口 (SPI, 触摸屏, TFT)
+    mySpi.begin(XPT2046_CLK, XPT2046_MISO, XPT2046_MOSI, XPT2046_CS);
+    ts.begin(mySpi);
+    ts.setRotation(1); // 设置触摸屏方向
+    touchTaskStart();  // 触摸屏就绪后启动固定频率的触摸采样任务 (来自 touch_handler.cpp)
+
+    tft.init();
+    tft.setRotation(1); // 设置TFT显示方向
+
+    // 从闪存恢复绘图历史并绘制主界面和画布 (在无线启动前，画布尽快可用)
+    canvasStoreBootRestore(); // 来自 canvas_store.cpp
+    sleepSyncRestore();       // 从深度睡眠醒来时恢复同步元数据，之后只向对端请求增量 (来自 esp_now_handler.cpp)
+
+    // 3. 初始化 WiFi 和 ESP-NOW
+    WiFi.mode(WIFI_STA);
+    WiFi.disconnect();   // 断开之前的连接，确保ESP-NOW在干净的状态下初始化
+    espNowInit();        // 初始化 ESP-NOW (来自 esp_now_handler.cpp)
+    networkTaskStart();  // 启动核心 0 上的网络任务 (处理 ESP-NOW 消息、绘制历史、心跳超时)
+
+    // 4. 记录启动时间 (调试用)
+    deviceInitialBootMillis = millis();
+    Serial.print("设备初始启动毫秒数: ");
+    Serial.println(deviceInitialBootMillis);
+
+    // 5. 初始 UPTIME_INFO 广播 (在所有核心服务初始化后)
+    SyncMessage_t initialUptimeMsg; // 已重命名以避免与 setup 中的 uptimeMsg 冲突
+    initialUptimeMsg.type = MSG_TYPE_UPTIME_INFO;
+    initialUptimeMsg.senderUptime = millis();
+    initialUptimeMsg.senderOffset = relativeBootTimeOffset; // 来自 esp_now_handler 的 extern 变量
+    memset(&initialUptimeMsg.touch_data, 0, sizeof(TouchData_t));
+    sendSyncMessage(&initialUptimeMsg); // 来自 esp_now_handler.cpp
+
+    // 6. 注册主循环任务 (周期广播在首次广播一个周期之后开始)
+    registerMainLoopTasks();
+}
+
+// updateBreathLED, readBatteryVoltagePercentage 已移至 power_manager.cpp
+// UI 绘制及按钮检测函数已移至 ui_manager.cpp
+// 触摸采样任务 (touchTaskStart) 和 handleLocalTouch 函数已移至 touch_handler.cpp
+
+// --- 主循环任务 (均在 loop 任务中由 scheduler 调用) ---
+
+// 触摸采样任务放入新样本
+static void onTouchEvent() {
+    handleLocalTouch(); // from touch_handler.cpp
+}
+
+static void pollMqtt() {
+    if (isWifiConnected()) {
+        mqttLoop(); // 如果WiFi已连接，则处理MQTT
+    }
+}
+
+// 1. 广播 UPTIME_INFO
+static void broadcastUptimeInfo() {
+    SyncMessage_t uptimeMsgLoop; // 已重命名以避免与 setup 中的 uptimeMsg 冲突
+    uptimeMsgLoop.type = MSG_TYPE_UPTIME_INFO;
+    uptimeMsgLoop.senderUptime = millis();
+    uptimeMsgLoop.senderOffset = relativeBootTimeOffset; // 来自 esp_now_handler 的 extern 变量
+    memset(&uptimeMsgLoop.touch_data, 0, sizeof(TouchData_t));
+    // 新增：填充内存信息
+    uptimeMsgLoop.usedMemory = esp_get_free_heap_size();
+    uptimeMsgLoop.totalMemory = ESP.getHeapSize();
+    sendSyncMessage(&uptimeMsgLoop); // 来自 esp_now_handler.cpp
+}
+
+// 4. 更新调试信息 (如果屏幕亮且不在调色模式)
+// isScreenOn 和 inCustomColorMode 分别是来自 power_manager 和 ui_manager 的 extern 变量
+static void refreshDebugInfo() {
+    if (isScreenOn && !inCustomColorMode) {
+        widgetInvalidate(WIDGET_DEBUG_PANEL); // 由 loop 中的 widgetRenderDirty 增量重绘
+    }
+}
+
+// 5. 更新连接设备计数 (如果不在调色模式且在主界面)
+// inCustomColorMode 和 currentUIState 是来自 ui_manager 的 extern 变量
+static void refreshDeviceCount() {
+    if (!inCustomColorMode && currentUIState == UI_STATE_MAIN) {
+        updateConnectedDevicesCount(); // 来自 ui_manager.cpp (设备数变化时才标记重绘)
+    }
+}
+
+// 6. 管理屏幕关闭时的 LED 状态 (包括呼吸灯)
+// isScreenOn 和 hasNewUpdateWhileScreenOff 是来自 power_manager 的 extern 变量
+static void updateLeds() {
+    if (!isScreenOn && hasNewUpdateWhileScreenOff) {
+        updateBreathLED(); // 来自 power_manager.cpp
+    }
+    manageScreenStateLEDs(); // 来自 power_manager.cpp (根据 isScreenOn 处理其他 LED)
+}
+
+// 7. 周期性更新对端信息界面 (如果当前处于该界面)
+// currentUIState 和 isPeerInfoScreenVisible 是来自 ui_manager 的 extern 变量
+static void refreshPeerInfoScreen() {
+    if (currentUIState == UI_STATE_PEER_INFO && isPeerInfoScreenVisible) {
+        updatePeerInfoScreen(); // 来自 ui_manager.cpp
+    }
+}
+
+// 8. WiFi 连接时发布性能计数器快照，便于在 MQTT 上观察多块板子
+static void publishPerfStats() {
+    if (isWifiConnected()) {
+        mqttPublishStats(); // 来自 mqtt_handler.cpp
+    }
+}
+
+// 9. 把新的历史点画进画布帧缓冲 (有 PSRAM 时)，重绘时只需推送缓冲
+static void catchUpCanvasFramebuffer() {
+    historyLock(); // 来自 esp_now_handler.cpp
+    canvasFramebufferCatchUp(allDrawingHistory, CANVAS_FB_CATCHUP_POINTS);
+    historyUnlock();
+}
+
+static void registerMainLoopTasks() {
+    schedulerOnEvent("touch", SCHED_EVENT_TOUCH, onTouchEvent);
+    schedulerOnEvent("render", SCHED_EVENT_RENDER, renderQueueDrain); // 网络任务放入的远端点、清屏、进度条
+    schedulerAddPeriodic("mqtt", MQTT_POLL_INTERVAL_MS, pollMqtt);
+    schedulerAddPeriodic("boot_button", BOOT_BUTTON_POLL_INTERVAL_MS, handleBootButton);
+    schedulerAddPeriodic("console", SERIAL_CONSOLE_POLL_INTERVAL_MS, serialConsolePoll); // 例如输入 "sched" 打印各任务耗时
+    schedulerAddPeriodic("uptime_bcast", UPTIME_INFO_BROADCAST_INTERVAL, broadcastUptimeInfo, UPTIME_INFO_BROADCAST_INTERVAL);
+    // 2. 发送心跳包 (心跳包和 UPTIME_INFO 都带内存信息，心跳包另用于超时检测)
+    schedulerAddPeriodic("heartbeat", HEARTBEAT_SEND_INTERVAL_MS, sendHeartbeat);
+    // 3. 对端心跳超时检查在网络任务中进行 (esp_now_handler.cpp)
+    schedulerAddPeriodic("debug_info", DEBUG_INFO_UPDATE_INTERVAL, refreshDebugInfo);
+    schedulerAddPeriodic("peer_count", BROADCAST_INTERVAL, refreshDeviceCount); // BROADCAST_INTERVAL 也用于设备数量的UI更新
+    schedulerAddPeriodic("leds", LED_UPDATE_INTERVAL_MS, updateLeds);
+    schedulerAddPeriodic("screen_idle", SCREEN_IDLE_CHECK_INTERVAL_MS, powerManagerCheckIdle); // 无操作超时自动息屏
+    schedulerAddPeriodic("peer_screen", PEER_INFO_UPDATE_INTERVAL, refreshPeerInfoScreen);
+    schedulerAddPeriodic("perf", PERF_WINDOW_MS, perfWindowTick); // 串口输入 "perf" 打印计数器快照
+    schedulerAddPeriodic("perf_mqtt", PERF_MQTT_INTERVAL_MS, publishPerfStats, PERF_MQTT_INTERVAL_MS);
+    CanvasFramebufferStats_t canvasFramebufferStats;
+    canvasFramebufferGetStats(canvasFramebufferStats);
+    if (canvasFramebufferStats.enabled) {
+        schedulerAddPeriodic("canvas_fb", CANVAS_FB_CATCHUP_INTERVAL_MS, catchUpCanvasFramebuffer);
+    }
+}
+
+void loop()
+{
+    // 执行已发生的事件和到期的定时任务
+    uint32_t passStart = micros();
+    schedulerRunPending();
+
+    // 重绘本轮被标记为脏的控件
+    widgetRenderDirty(); // 来自 ui_widgets.cpp
+    perfLoopPassEnd(micros() - passStart); // 主循环轮数和帧耗时 (来自 perf_counters.cpp)
+
+    // 息屏空闲时浅睡眠一个周期 (来自 power_manager.cpp)；
+    // 否则没有到期任务也没有事件时阻塞，直到触摸/ESP-NOW 唤醒或下一个任务到期
+    if (!powerManagerLightSleep()) {
+        schedulerWaitForWork();
+    }
+}
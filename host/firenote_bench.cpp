@@ -0,0 +1,447 @@
+// FireNote 基准程序 (主机端)
+// 在固定的画布上测量固件热点代码的吞吐，结果以 JSON 输出，便于在提交之间比较:
+//   history  DrawingHistory::push_back / size / operator[] (顺序与随机访问) 每次操作的纳秒数
+//   replay   replayAllDrawings 重播到内存帧缓冲 (TFT_eSPI 替身) 的耗时和点速率
+//   mqtt     sendStroke 序列化 + 发布、mqttCallback 解析 + 绘制的点速率，每点的 MQTT 负载字节数，
+//            以及因 JSON 文档容量不足被截掉的点数
+//   sync     ESP-NOW 逐点全量同步和光栅同步每个历史点折合的负载字节数和空中时间 (按设备结构大小计算)，
+//            以及光栅编码耗时
+//
+// 画布: small / 10k / 100k 为固定种子生成的合成画布 (手写笔划 + 反复涂抹的区域 + 一次清屏)，每次运行完全相同；
+// --canvas 另外加入一张录制的画布: 设备 LittleFS 内容解包到的目录 (含 canvas.snap / canvas.log)，
+// 通过固件自己的 canvasStoreBootRestore 读取。
+// 计时为主机真实时间，每项重复运行取最好的一次；JSON 库为 mock/ArduinoJson.h 时 mqtt 数据只反映替身的速度，
+// 需要与设备相关的数字时用 -DARDUINOJSON_DIR 配置真实库 (输出中 json_library 字段注明)。
+//
+// 构建:
+//   cmake -S host -B build-host && cmake --build build-host -j
+//
+// 用法:
+//   firenote_bench [--label 提交号] [--canvas 目录] [--only 名称] [--quick] [--out 结果.json]
+
+#include <Arduino.h>
+#include "canvas_store.h"
+#include "config.h"
+#include "esp_now_handler.h"
+#include "host_io.h"
+#include "mqtt_handler.h"
+#include "raster_sync.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#define BENCH_DEVICE_SYNC_MESSAGE_BYTES 44 // ESP32 上 sizeof(SyncMessage_t)
+#define BENCH_MIN_REPEATS 3
+#define BENCH_MIN_SECONDS 0.2              // 每项至少累计运行的时间
+#define BENCH_MAX_REPEATS 50
+
+extern TFT_eSPI tft;
+void mqttCallback(char *topic, byte *payload, unsigned int length); // mqtt_handler.cpp
+
+typedef struct BenchCanvas_s
+{
+    std::string name;
+    std::vector<TouchData_t> points;
+} BenchCanvas_t;
+
+static bool quick = false;
+
+// --- 计时 ---
+
+// 重复运行 fn，返回最好一次的秒数
+static double timeBest(const std::function<void()> &fn)
+{
+    int minRepeats = quick ? 1 : BENCH_MIN_REPEATS;
+    double minSeconds = quick ? 0.0 : BENCH_MIN_SECONDS;
+    double best = 1e30, total = 0;
+    for (int i = 0; i < BENCH_MAX_REPEATS && (i < minRepeats || total < minSeconds); i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds);
+        total += seconds;
+    }
+    return best;
+}
+
+// --- 画布 ---
+
+static void synthCanvas(size_t targetPoints, uint32_t seed, std::vector<TouchData_t> &out)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const uint32_t colors[] = {TFT_WHITE, TFT_RED, TFT_GREEN, TFT_BLUE, TFT_YELLOW};
+    unsigned long t = 1000;
+    bool resetDone = false;
+    while (out.size() < targetPoints)
+    {
+        if (!resetDone && out.size() > targetPoints / 5)
+        {
+            TouchData_t reset;
+            memset(&reset, 0, sizeof(reset));
+            reset.isReset = true;
+            reset.timestamp = t;
+            out.push_back(reset);
+            resetDone = true;
+        }
+        TouchData_t point;
+        memset(&point, 0, sizeof(point));
+        point.color = colors[(int)(uniform(rng) * 5)];
+        bool scribble = uniform(rng) < 0.35;
+        double cx = scribble ? 60 + 40 * uniform(rng) : 20 + 280 * uniform(rng);
+        double cy = scribble ? 60 + 40 * uniform(rng) : 20 + 200 * uniform(rng);
+        double heading = 2 * M_PI * uniform(rng);
+        double turn = (uniform(rng) - 0.5) * 0.2;
+        int samples = 40 + (int)(uniform(rng) * 160);
+        for (int i = 0; i < samples && out.size() < targetPoints; i++, t += 5)
+        {
+            heading += turn;
+            cx += 1.5 * cos(heading);
+            cy += 1.5 * sin(heading);
+            if (scribble && (cx < 50 || cx > 110 || cy < 50 || cy > 110))
+                heading += M_PI; // 在涂抹区域内来回
+            point.x = std::min(std::max((int)cx, 0), SCREEN_WIDTH - 1);
+            point.y = std::min(std::max((int)cy, 0), SCREEN_HEIGHT - 1);
+            point.timestamp = t;
+            out.push_back(point);
+        }
+        t += TOUCH_STROKE_INTERVAL + 50 + (unsigned long)(uniform(rng) * 400); // 笔划间隔
+    }
+}
+
+// 按 replayAllDrawings 的连线规则切分笔划 (sendStroke 每次发送一条)
+static void splitStrokes(const std::vector<TouchData_t> &points, std::vector<std::vector<TouchData_t>> &strokes)
+{
+    strokes.clear();
+    const TouchData_t *previous = nullptr;
+    for (const TouchData_t &point : points)
+    {
+        if (point.isReset)
+        {
+            previous = nullptr;
+            continue;
+        }
+        if (previous == nullptr || point.timestamp - previous->timestamp > TOUCH_STROKE_INTERVAL)
+            strokes.emplace_back();
+        strokes.back().push_back(point);
+        previous = &point;
+    }
+}
+
+static void loadHistory(const std::vector<TouchData_t> &points)
+{
+    allDrawingHistory.clear();
+    for (const TouchData_t &point : points)
+        allDrawingHistory.push_back(point);
+}
+
+// --- JSON 输出 ---
+
+static FILE *out = stdout;
+static bool firstField = true;
+
+static void jsonOpen(const char *key)
+{
+    fprintf(out, "%s\"%s\": {", firstField ? "" : ", ", key);
+    firstField = true;
+}
+
+static void jsonClose()
+{
+    fprintf(out, "}");
+    firstField = false;
+}
+
+static void jsonNumber(const char *key, double value)
+{
+    fprintf(out, "%s\"%s\": %.6g", firstField ? "" : ", ", key, value);
+    firstField = false;
+}
+
+static void jsonString(const char *key, const char *value)
+{
+    fprintf(out, "%s\"%s\": \"%s\"", firstField ? "" : ", ", key, value);
+    firstField = false;
+}
+
+// --- 各项测量 ---
+
+static void benchHistory(const BenchCanvas_t &canvas)
+{
+    size_t n = canvas.points.size();
+    DrawingHistory history;
+    double pushSeconds = timeBest([&]() {
+        history.clear();
+        for (const TouchData_t &point : canvas.points)
+            history.push_back(point);
+    });
+
+    volatile size_t sizeSink = 0;
+    double sizeSeconds = timeBest([&]() {
+        for (size_t i = 0; i < n; i++)
+            sizeSink = sizeSink + history.size();
+    });
+
+    volatile long indexSink = 0;
+    double seqSeconds = timeBest([&]() {
+        long sum = 0;
+        for (size_t i = 0; i < n; i++)
+            sum += history[i].x;
+        indexSink = sum;
+    });
+
+    std::vector<uint32_t> order(n);
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < n; i++)
+        order[i] = (uint32_t)(rng() % n);
+    double randomSeconds = timeBest([&]() {
+        long sum = 0;
+        for (uint32_t index : order)
+            sum += history[index].y;
+        indexSink = sum;
+    });
+
+    jsonOpen("history");
+    jsonNumber("push_back_ns", pushSeconds * 1e9 / n);
+    jsonNumber("size_ns", sizeSeconds * 1e9 / n);
+    jsonNumber("index_seq_ns", seqSeconds * 1e9 / n);
+    jsonNumber("index_random_ns", randomSeconds * 1e9 / n);
+    jsonClose();
+}
+
+static void benchReplay(const BenchCanvas_t &canvas)
+{
+    loadHistory(canvas.points);
+    uint32_t callsBefore = hostTftDrawCalls();
+    replayAllDrawings();
+    uint32_t calls = hostTftDrawCalls() - callsBefore;
+    double seconds = timeBest([]() { replayAllDrawings(); });
+
+    jsonOpen("replay");
+    jsonNumber("ms", seconds * 1e3);
+    jsonNumber("points_per_s", canvas.points.size() / seconds);
+    jsonNumber("draw_calls", calls);
+    jsonClose();
+}
+
+static std::vector<std::string> publishedPayloads;
+
+static void benchMqtt(const BenchCanvas_t &canvas)
+{
+    std::vector<std::vector<TouchData_t>> strokes;
+    splitStrokes(canvas.points, strokes);
+    size_t strokePoints = 0;
+    for (const auto &stroke : strokes)
+        strokePoints += stroke.size();
+
+    double serializeSeconds = timeBest([&]() {
+        publishedPayloads.clear();
+        for (const auto &stroke : strokes)
+            sendStroke(stroke);
+    });
+    uint64_t payloadBytes = 0;
+    for (const std::string &payload : publishedPayloads)
+        payloadBytes += payload.size();
+
+    // 接收方实际能还原的点数 (文档容量不足时 sendStroke 截掉笔划尾部)
+    size_t deliveredPoints = 0;
+    for (const std::string &payload : publishedPayloads)
+    {
+        StaticJsonDocument<MQTT_MAX_PACKET_SIZE> doc;
+        if (!deserializeJson(doc, payload.c_str(), payload.size()))
+            deliveredPoints += doc["p"].size() / 2;
+    }
+
+    char topic[] = "firenote/strokes";
+    std::vector<std::string> payloads = publishedPayloads;
+    double parseSeconds = timeBest([&]() {
+        for (std::string &payload : payloads)
+            mqttCallback(topic, (byte *)&payload[0], (unsigned int)payload.size());
+    });
+
+    jsonOpen("mqtt");
+    jsonNumber("strokes", (double)strokes.size());
+    jsonNumber("messages", (double)publishedPayloads.size());
+    jsonNumber("serialize_points_per_s", deliveredPoints / serializeSeconds); // 只计实际编码进消息的点
+    jsonNumber("parse_points_per_s", deliveredPoints > 0 ? deliveredPoints / parseSeconds : 0);
+    jsonNumber("bytes_per_point", deliveredPoints > 0 ? (double)payloadBytes / deliveredPoints : 0);
+    jsonNumber("points_truncated", (double)(strokePoints - deliveredPoints));
+    jsonClose();
+}
+
+static void benchSync(const BenchCanvas_t &canvas)
+{
+    size_t n = canvas.points.size();
+    loadHistory(canvas.points);
+
+    // 逐点同步: SYNC_START + 每点一条 DRAW_POINT + ALL_DRAWINGS_COMPLETE
+    double pointFrames = (double)n + 2;
+    double pointBytes = pointFrames * BENCH_DEVICE_SYNC_MESSAGE_BYTES;
+    double pointAirtimeUs = pointFrames * hostRadioAirtimeUs(BENCH_DEVICE_SYNC_MESSAGE_BYTES);
+
+    // 光栅同步: RASTER_SYNC_START + 每段一条 RasterTileMessage_t + ALL_DRAWINGS_COMPLETE
+    uint32_t chunks = 0;
+    double encodeSeconds = timeBest([&]() {
+        static bool marked[RASTER_TILE_COUNT];
+        static uint16_t pixels[RASTER_TILE_PIXELS];
+        size_t end = allDrawingHistory.size();
+        size_t start = rasterVisibleStart(allDrawingHistory, end);
+        memset(marked, 0, sizeof(marked));
+        rasterMarkTiles(allDrawingHistory, start, end, marked);
+        RasterTileMessage_t tileMsg;
+        chunks = 0;
+        for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+        {
+            if (!marked[tile])
+                continue;
+            rasterRenderTile(allDrawingHistory, start, end, tile, pixels);
+            uint16_t offset = 0;
+            while (rasterEncodeChunk(tile, pixels, offset, tileMsg.data, RASTER_CHUNK_DATA_BYTES, tileMsg.pixelOffset,
+                                     tileMsg.length, offset))
+                chunks++;
+        }
+    });
+    double rasterBytes = 2.0 * BENCH_DEVICE_SYNC_MESSAGE_BYTES + (double)chunks * sizeof(RasterTileMessage_t);
+    double rasterAirtimeUs = 2.0 * hostRadioAirtimeUs(BENCH_DEVICE_SYNC_MESSAGE_BYTES) +
+                             (double)chunks * hostRadioAirtimeUs(sizeof(RasterTileMessage_t));
+
+    jsonOpen("sync");
+    jsonNumber("points_bytes_per_point", pointBytes / n);
+    jsonNumber("points_airtime_us_per_point", pointAirtimeUs / n);
+    jsonNumber("raster_chunks", chunks);
+    jsonNumber("raster_bytes_per_point", rasterBytes / n);
+    jsonNumber("raster_airtime_us_per_point", rasterAirtimeUs / n);
+    jsonNumber("raster_encode_ms", encodeSeconds * 1e3);
+    jsonClose();
+}
+
+// --- 主程序 ---
+
+static void usage()
+{
+    fprintf(stderr, "usage: firenote_bench [--label text] [--canvas littlefs-dir] [--only name] [--quick] [--out file.json]\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *label = "";
+    const char *canvasDir = nullptr;
+    const char *only = nullptr;
+    const char *outPath = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--label") == 0 && hasValue)
+            label = argv[++i];
+        else if (strcmp(argv[i], "--canvas") == 0 && hasValue)
+            canvasDir = argv[++i];
+        else if (strcmp(argv[i], "--only") == 0 && hasValue)
+            only = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && hasValue)
+            outPath = argv[++i];
+        else if (strcmp(argv[i], "--quick") == 0)
+            quick = true;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    hostSerialSetSink([](const char *, size_t) {}); // 固件日志不混入 JSON
+    tft.init();
+    tft.setRotation(1);
+
+    std::vector<BenchCanvas_t> canvases;
+    const struct
+    {
+        const char *name;
+        size_t points;
+    } synthetic[] = {{"small", 1000}, {"10k", 10000}, {"100k", 100000}};
+    for (const auto &spec : synthetic)
+    {
+        BenchCanvas_t canvas;
+        canvas.name = spec.name;
+        synthCanvas(spec.points, 12345, canvas.points);
+        canvases.push_back(canvas);
+    }
+    if (canvasDir != nullptr)
+    {
+        // 用固件的启动恢复读取录制的画布
+        hostFsSetDirectory(canvasDir);
+        canvasStoreBootRestore();
+        BenchCanvas_t canvas;
+        canvas.name = "recorded";
+        for (size_t i = 0; i < allDrawingHistory.size(); i++)
+            canvas.points.push_back(allDrawingHistory[i]);
+        if (canvas.points.empty())
+        {
+            fprintf(stderr, "no canvas found in %s\n", canvasDir);
+            return 1;
+        }
+        canvases.push_back(canvas);
+    }
+
+    // sendStroke 只在 MQTT 连接时发布
+    hostWifiSetAvailable(true);
+    WiFi.begin("bench", "bench");
+    mqttInit("bench", 1883);
+    mqttLoop();
+    hostMqttSetPublishHook([](const char *topic, const uint8_t *payload, size_t len) {
+        if (strcmp(topic, "firenote/strokes") == 0)
+            publishedPayloads.emplace_back((const char *)payload, len);
+    });
+
+    if (outPath != nullptr)
+    {
+        out = fopen(outPath, "w");
+        if (out == nullptr)
+        {
+            fprintf(stderr, "cannot write %s\n", outPath);
+            return 1;
+        }
+    }
+    fprintf(out, "{");
+    firstField = true;
+    jsonString("benchmark", "firenote_bench");
+    jsonString("label", label);
+#ifdef ARDUINOJSON_VERSION
+    jsonString("json_library", "ArduinoJson " ARDUINOJSON_VERSION);
+#else
+    jsonString("json_library", "mock");
+#endif
+    jsonNumber("sizeof_touch_data", sizeof(TouchData_t));
+    fprintf(out, ", \"canvases\": [");
+    bool firstCanvas = true;
+    for (const BenchCanvas_t &canvas : canvases)
+    {
+        if (only != nullptr && canvas.name != only)
+            continue;
+        fprintf(stderr, "canvas %s (%u points)...\n", canvas.name.c_str(), (unsigned)canvas.points.size());
+        fprintf(out, "%s\n  {", firstCanvas ? "" : ",");
+        firstCanvas = false;
+        firstField = true;
+        jsonString("name", canvas.name.c_str());
+        jsonNumber("points", (double)canvas.points.size());
+        benchHistory(canvas);
+        benchReplay(canvas);
+        benchMqtt(canvas);
+        benchSync(canvas);
+        fprintf(out, "}");
+        fflush(out);
+    }
+    fprintf(out, "\n]}\n");
+    if (out != stdout)
+        fclose(out);
+    fflush(stdout);
+    _Exit(0);
+}
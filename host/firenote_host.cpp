@@ -0,0 +1,185 @@
+// FireNote 单节点主机运行器
+// 在虚拟时间内运行完整固件 (setup/loop、触摸任务、网络任务)，输入来自触摸脚本和串口命令，结束时输出画布图像和统计。
+//
+// 构建:
+//   cmake -S host -B build-host && cmake --build build-host -j
+//
+// 用法:
+//   firenote_host [--ms 毫秒] [--touch 脚本] [--serial "命令"]... [--ppm 输出.ppm] [--mac aa:bb:cc:dd:ee:ff]
+//                 [--fs 目录] [--trace 轨迹] [--psram KB] [--wifi] [--quiet]
+//     --ms      运行的虚拟时间 (默认 3000)
+//     --touch   触摸脚本，每行 "毫秒 x y z" (XPT2046 原始坐标，z = 0 为抬笔，# 开头为注释)
+//     --serial  启动 1 秒后送入串口控制台的一行命令，可重复 (如 --serial lat)；"@毫秒 命令" 在指定时间送入
+//     --ppm     结束时把屏幕帧缓冲写成 PPM 图像
+//     --mac     本机 MAC 地址
+//     --fs      LittleFS 内容保存在该主机目录下 (可用于测试重启恢复)
+//     --trace   触摸轨迹文件 (串口 "trace dump" 导出后用 tools/touch_trace_convert 转成二进制)，启动 1 秒后开始作为触摸屏读数
+//     --psram   模拟 PSRAM 容量 (KB，如 4096)，冷数据和画布帧缓冲分配到其中 (默认没有 PSRAM)
+//     --wifi    WiFi.begin 能连上 (MQTT 连接成功，发布的消息打印为 "MQTT> 主题 负载")
+//     --quiet   不打印固件的串口输出
+
+#include <Arduino.h>
+#include "esp_now_handler.h"
+#include "host_io.h"
+#include "host_kernel.h"
+#include "touch_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void usage()
+{
+    fprintf(stderr, "usage: firenote_host [--ms N] [--touch script] [--serial cmd]... [--ppm out.ppm] [--mac mac] [--fs dir] "
+                    "[--trace file] [--psram KB] [--wifi] [--quiet]\n");
+}
+
+static bool parseMac(const char *text, uint8_t mac[6])
+{
+    unsigned int b[6];
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6)
+        return false;
+    for (int i = 0; i < 6; i++)
+        mac[i] = (uint8_t)b[i];
+    return true;
+}
+
+// 把二进制触摸轨迹加入触摸脚本 (每条记录是一次 getPoint() 读数，保持到下一条记录)
+static bool loadTouchTrace(const char *path, uint64_t offsetUs)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+    TouchTraceHeader_t header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == TOUCH_TRACE_MAGIC &&
+              header.version == TOUCH_TRACE_VERSION && header.recordSize == sizeof(TouchTraceRecord_t);
+    TouchTraceRecord_t record;
+    memset(&record, 0, sizeof(record));
+    for (uint32_t i = 0; ok && i < header.count; i++)
+    {
+        ok = fread(&record, sizeof(record), 1, file) == 1;
+        if (ok)
+            hostTouchAdd(offsetUs + record.timeUs, record.x, record.y, record.z);
+    }
+    if (ok && record.z > 0)
+        hostTouchAdd(offsetUs + record.timeUs + header.periodUs, 0, 0, 0); // 轨迹在笔划中间结束
+    fclose(file);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t runMs = 3000;
+    const char *touchScript = nullptr;
+    const char *ppmPath = nullptr;
+    bool quiet = false;
+    const char *tracePath = nullptr;
+    std::vector<std::string> serialCommands;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--ms") == 0 && hasValue)
+            runMs = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--touch") == 0 && hasValue)
+            touchScript = argv[++i];
+        else if (strcmp(argv[i], "--serial") == 0 && hasValue)
+            serialCommands.push_back(argv[++i]);
+        else if (strcmp(argv[i], "--ppm") == 0 && hasValue)
+            ppmPath = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && hasValue)
+            tracePath = argv[++i];
+        else if (strcmp(argv[i], "--fs") == 0 && hasValue)
+            hostFsSetDirectory(argv[++i]);
+        else if (strcmp(argv[i], "--mac") == 0 && hasValue)
+        {
+            uint8_t mac[6];
+            if (!parseMac(argv[++i], mac))
+            {
+                fprintf(stderr, "bad MAC address: %s\n", argv[i]);
+                return 2;
+            }
+            hostRadioSetMac(mac);
+        }
+        else if (strcmp(argv[i], "--psram") == 0 && hasValue)
+            hostPsramSetSize((uint32_t)strtoul(argv[++i], nullptr, 10) * 1024);
+        else if (strcmp(argv[i], "--wifi") == 0)
+            hostWifiSetAvailable(true);
+        else if (strcmp(argv[i], "--quiet") == 0)
+            quiet = true;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    if (quiet)
+        hostSerialSetSink([](const char *, size_t) {});
+    if (touchScript != nullptr && !hostTouchLoadScript(touchScript, 0))
+    {
+        fprintf(stderr, "cannot read touch script %s\n", touchScript);
+        return 1;
+    }
+    if (tracePath != nullptr && !loadTouchTrace(tracePath, 1000 * 1000))
+    {
+        fprintf(stderr, "cannot read touch trace %s\n", tracePath);
+        return 1;
+    }
+    hostMqttSetPublishHook([](const char *topic, const uint8_t *payload, size_t len) {
+        printf("MQTT> %s %.*s\n", topic, (int)len, (const char *)payload);
+    });
+
+    hostStartArduino();
+    // 按送入时间排序 (同一时间保持命令行中的顺序)
+    std::vector<std::pair<uint64_t, std::string>> timedCommands;
+    for (const std::string &command : serialCommands)
+    {
+        uint64_t atMs = 1000;
+        size_t textStart = 0;
+        if (command[0] == '@')
+        {
+            char *end;
+            atMs = strtoull(command.c_str() + 1, &end, 10);
+            textStart = end - command.c_str();
+            while (textStart < command.size() && command[textStart] == ' ')
+                textStart++;
+        }
+        timedCommands.push_back({atMs * 1000, command.substr(textStart)});
+    }
+    std::stable_sort(timedCommands.begin(), timedCommands.end(),
+                     [](const std::pair<uint64_t, std::string> &a, const std::pair<uint64_t, std::string> &b) {
+                         return a.first < b.first;
+                     });
+    for (const std::pair<uint64_t, std::string> &command : timedCommands)
+    {
+        if (command.first >= runMs * 1000)
+            break;
+        hostRunUntil(command.first);
+        hostSerialFeed(command.second.c_str());
+        hostSerialFeed("\n");
+    }
+    hostRunUntil(runMs * 1000);
+
+    // 所有任务此时都阻塞在内核中，可以直接读取固件状态
+    printf("\n== %llu ms virtual", (unsigned long long)(hostNowUs() / 1000));
+    if (hostHalted())
+        printf(" (halted)");
+    printf(", history %u points, %u draw calls, free heap %u\n", (unsigned)allDrawingHistory.size(),
+           (unsigned)hostTftDrawCalls(), (unsigned)ESP.getFreeHeap());
+
+    if (ppmPath != nullptr)
+    {
+        if (!hostTftWritePpm(ppmPath))
+        {
+            fprintf(stderr, "cannot write %s\n", ppmPath);
+            return 1;
+        }
+        printf("canvas written to %s (%dx%d)\n", ppmPath, hostTftWidth(), hostTftHeight());
+    }
+    fflush(stdout);
+    _Exit(0); // 任务线程仍阻塞在内核中，直接退出而不析构全局对象
+}
@@ -0,0 +1,969 @@
+// FireNote 多节点 ESP-NOW 网络仿真器 (主机端)
+// 每个节点是一个子进程，运行完整固件 (与 firenote_host 相同的替身)；父进程作为无线信道，按保守的离散事件同步
+// 推进所有节点的虚拟时间: 每一步只把节点推进到 "全局最早事件 + 最短帧空中时间"，这段时间内任何节点发出的帧
+// 都不可能早于窗口末尾到达别的节点，因此结果与节点的执行先后无关，同样的参数和种子总是得到同样的输出。
+//
+// 信道模型:
+//   - 每条有向链路独立丢包 (伯努利)、固定延迟 + 均匀抖动，同一链路上的帧不乱序
+//   - 发送方按物理层速率排队 (hostRadioAirtimeUs)，广播由每个接收方独立判定是否收到
+//   - 单播在目的节点收到时报告 ACK 成功，否则失败 (不模拟 MAC 层重传和多个发送方之间的碰撞)
+//   - 尚未启动或已深度睡眠的节点收不到帧，浅睡眠 (射频关闭) 期间到达的帧丢失
+// 每个节点在 [--draw-start, --draw-end] 内画若干条随机笔划 (开始前先点一个颜色按钮)，节点按 --boot-stagger 依次启动。
+//
+// 报告:
+//   收敛时间   最后一次触摸输入之后，所有节点第一次一致 (且保持到结束) 所需的时间，分两级:
+//              历史 = 各节点绘图历史中的点集合相同 (不计顺序和时间戳)；画布 = 屏幕画布区域逐像素相同
+//   空中字节   所有帧的负载字节数和按设备结构大小折算的空中时间、信道占用率，按消息类型分列
+//   画布分歧   结束时每个节点与逐像素多数结果不同的像素数 (不含左侧工具栏和右上角的颜色、撤销/重做按钮)
+//
+// 构建:
+//   cmake -S host -B build-host && cmake --build build-host -j
+//
+// 用法:
+//   firenote_sim [--nodes N] [--ms 毫秒] [--seed S] [--loss 概率] [--latency 微秒] [--jitter 微秒] [--rate kbps]
+//                [--link A-B:丢包[:延迟[:抖动]]]... [--boot-stagger 毫秒] [--strokes K] [--draw-start 毫秒]
+//                [--draw-end 毫秒] [--sample 毫秒] [--undo K] [--doze N] [--ppm 前缀] [--verbose] [--require-canvas]
+//                [--check-replay]
+//     --undo     每个节点画完后点 K 次撤销按钮 (撤销自己最近的 K 条笔划，通过 ESP-NOW 广播撤销记录)
+//     --doze     节点 N 不画笔划，启动后短按 BOOT 息屏，之后进入浅睡眠待机 (待机期间错过的点靠增量同步补回)
+//     --link     覆盖节点 A、B 之间双向链路的参数 (如 --link 0-3:1 让 0 和 3 互相收不到)
+//     --ppm      结束时把每个节点的屏幕写成 <前缀><节点号>.ppm
+//     --verbose  打印各节点的串口输出 (带节点号和全局虚拟时间，单位秒)
+//     --require-canvas  只有画布收敛且结束时没有分歧像素才返回 0 (无丢包时各节点画面应逐像素相同)
+//     --check-replay    结束时每个节点清屏后从历史全量重播，与重播前的屏幕 (实时绘制的点、撤销/重做后按笔划索引
+//                       局部重绘的区域) 比较，再与按笔划索引局部重绘整个屏幕的结果比较，有不同的画布像素时返回 1
+// 历史或画布收敛时退出码为 0，否则为 1 (光栅同步只传画布，历史本来就不会一致)。
+//
+// 注意: 主机上 SyncMessage_t 比设备上大 (unsigned long 为 64 位)，字节数和空中时间按设备上的 44 字节折算。
+
+#include <Arduino.h>
+#include "config.h"
+#include "esp_now_handler.h"
+#include "ui_manager.h" // drawMainInterface
+#include "host_io.h"
+#include "host_kernel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern TFT_eSPI tft; // 定义于 FireNote-ESP32.ino
+
+#define SIM_DEVICE_SYNC_MESSAGE_BYTES 44 // ESP32 上 sizeof(SyncMessage_t)
+#define SIM_RSSI -50
+#define SIM_MASK_LEFT 40                 // 左侧工具栏 (按钮、对端数、进度圆) 不计入画布比较
+#define SIM_TOUCH_Z 1500
+#define SIM_TOUCH_SAMPLE_MS 8            // 笔划采样间隔
+#define SIM_TAP_MS 80                    // 点颜色按钮的按下时长
+#define SIM_FIRST_INPUT_AFTER_BOOT_MS 2000
+#define SIM_BOOT_PRESS_MS 200            // --doze: 息屏的 BOOT 短按时长
+#define SIM_MAX_NODES 32
+
+// 父子进程之间的消息 (所有消息共用同一个头，后面跟 len 字节负载)
+enum SimMsgType_e
+{
+    SIM_MSG_RUN = 'R',     // 父 -> 子: 运行到 timeUs (节点本地时间)
+    SIM_MSG_DELIVER = 'X', // 父 -> 子: 在 timeUs 收到来自 mac 的帧
+    SIM_MSG_QUERY = 'Q',   // 父 -> 子: 请求 SimNodeReport_t
+    SIM_MSG_CANVAS = 'C',  // 父 -> 子: 请求帧缓冲
+    SIM_MSG_REPLAY = 'V',  // 父 -> 子: 重播检查，回复 SimReplayDiff_t
+    SIM_MSG_EXIT = 'E',    // 父 -> 子: 退出
+    SIM_MSG_FRAME = 'F',   // 子 -> 父: 发出一帧 (mac 为目的地址，timeUs 为发送完毕时间)，父进程回复 1 字节 ACK
+    SIM_MSG_DONE = 'D',    // 子 -> 父: 运行结束，timeUs 为下一次唤醒时间，len 为 1 表示已停机
+    SIM_MSG_REPLY = 'P',   // 子 -> 父: QUERY/CANVAS 的回复
+};
+
+typedef struct SimMsgHeader_s
+{
+    uint8_t type;
+    uint8_t mac[6];
+    int8_t rssi;
+    uint64_t timeUs;
+    uint32_t len;
+} SimMsgHeader_t;
+
+typedef struct SimNodeReport_s
+{
+    uint64_t canvasHash;
+    uint64_t historyHash; // 与点的顺序无关
+    uint32_t historyPoints;
+    NetworkTaskStats_t net;
+} SimNodeReport_t;
+
+typedef struct SimLink_s
+{
+    double loss;
+    uint32_t latencyUs;
+    uint32_t jitterUs;
+} SimLink_t;
+
+typedef struct SimTouch_s
+{
+    uint64_t atUs; // 全局时间
+    int16_t x, y, z;
+} SimTouch_t;
+
+typedef struct SimNode_s
+{
+    pid_t pid;
+    int fd;
+    uint64_t bootUs;
+    bool booted;
+    bool halted;
+    uint64_t nextWakeUs; // 全局时间
+    std::vector<SimTouch_t> touches;
+    uint64_t lastInputUs;
+    // 统计
+    uint32_t framesSent;
+    uint64_t payloadBytes;    // 主机上的实际长度
+    uint64_t deviceBytes;     // 按设备结构大小折算
+    uint64_t airtimeUs;       // 按设备长度折算
+    uint32_t framesReceived;
+    uint32_t framesLost;      // 本节点作为接收方丢失的帧
+} SimNode_t;
+
+static const char *messageTypeNames[] = {"UPTIME_INFO", "DRAW_POINT", "REQUEST_ALL", "ALL_COMPLETE", "CLEAR_AND_REQ",
+                                         "RESET_CANVAS", "SYNC_START", "HEARTBEAT", "SLEEP_NOTICE", "REQUEST_DELTA",
+                                         "DELTA_COMPLETE", "RASTER_START", "RASTER_TILE", "TOMBSTONE"};
+#define SIM_MESSAGE_TYPES (int)(sizeof(messageTypeNames) / sizeof(messageTypeNames[0]))
+
+// --- 参数 ---
+
+static int nodeCount = 4;
+static uint64_t durationMs = 30000;
+static uint32_t seed = 1;
+static SimLink_t defaultLink = {0.0, 0, 0};
+static uint32_t bitrateKbps = 1000;
+static uint32_t bootStaggerMs = 1500;
+static int strokesPerNode = 3;
+static int undosPerNode = 0;
+static int dozeNode = -1;
+static uint64_t drawStartMs = 0; // 0: 最后一个节点启动后
+static uint64_t drawEndMs = 0;   // 0: 运行时间的一半
+static uint32_t sampleMs = 100;
+static const char *ppmPrefix = nullptr;
+static bool verbose = false;
+static bool requireCanvas = false;
+static bool checkReplay = false;
+
+static SimLink_t links[SIM_MAX_NODES][SIM_MAX_NODES];
+static std::vector<SimNode_t> nodes;
+
+// --- 通信 ---
+
+static void writeAll(int fd, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0)
+    {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0)
+        {
+            perror("sim write");
+            _Exit(1);
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static void readAll(int fd, void *data, size_t len)
+{
+    uint8_t *p = (uint8_t *)data;
+    while (len > 0)
+    {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0)
+        {
+            fprintf(stderr, "sim: peer process closed the connection\n");
+            _Exit(1);
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static void sendMsg(int fd, uint8_t type, uint64_t timeUs, const uint8_t *mac, int8_t rssi, const void *payload,
+                    uint32_t len)
+{
+    SimMsgHeader_t header;
+    memset(&header, 0, sizeof(header));
+    header.type = type;
+    if (mac != nullptr)
+        memcpy(header.mac, mac, 6);
+    header.rssi = rssi;
+    header.timeUs = timeUs;
+    header.len = len;
+    writeAll(fd, &header, sizeof(header));
+    if (len > 0 && payload != nullptr)
+        writeAll(fd, payload, len);
+}
+
+static void nodeMac(int index, uint8_t mac[6])
+{
+    const uint8_t base[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00};
+    memcpy(mac, base, 6);
+    mac[4] = (uint8_t)((index + 1) >> 8);
+    mac[5] = (uint8_t)(index + 1);
+}
+
+static int nodeIndexOf(const uint8_t mac[6])
+{
+    for (int i = 0; i < nodeCount; i++)
+    {
+        uint8_t m[6];
+        nodeMac(i, m);
+        if (memcmp(m, mac, 6) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static bool inCanvasMask(int x, int y)
+{
+    if (x < SIM_MASK_LEFT)
+        return false;
+    if (x >= CUSTOM_COLOR_BUTTON_X - 2 && y < REDO_BUTTON_Y + REDO_BUTTON_H + 2)
+        return false;
+    return true;
+}
+
+// --- 子进程 (一个节点) ---
+
+static int childFd = -1;
+static std::string serialLine;
+static int childIndex = 0;
+
+static void childSerialSink(const char *data, size_t len)
+{
+    if (!verbose)
+        return;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (data[i] == '\n')
+        {
+            fprintf(stderr, "[n%d %9.3f] %s\n", childIndex, (hostNowUs() + nodes[childIndex].bootUs) / 1e6, serialLine.c_str());
+            serialLine.clear();
+        }
+        else if (data[i] != '\r')
+        {
+            serialLine += data[i];
+        }
+    }
+}
+
+static uint64_t childCanvasHash()
+{
+    const uint16_t *fb = hostTftFramebuffer();
+    int w = hostTftWidth(), h = hostTftHeight();
+    uint64_t hash = 1469598103934665603ULL; // FNV-1a
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            if (!inCanvasMask(x, y))
+                continue;
+            uint16_t c = fb[y * w + x];
+            hash = (hash ^ (c & 0xFF)) * 1099511628211ULL;
+            hash = (hash ^ (c >> 8)) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+static uint64_t mixPoint(const TouchData_t &point)
+{
+    uint64_t h = ((uint64_t)(uint16_t)point.x << 48) ^ ((uint64_t)(uint16_t)point.y << 32) ^ point.color ^
+                 ((uint64_t)point.isReset << 63);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+// 点集合的哈希 (各点哈希之和，与顺序无关)。调用时所有任务都阻塞在内核中，不需要 historyLock
+static uint64_t childHistoryHash()
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < allDrawingHistory.size(); i++)
+        sum += mixPoint(allDrawingHistory[i]);
+    return sum;
+}
+
+// 重播检查的结果 (画布像素数)
+typedef struct SimReplayDiff_s
+{
+    uint32_t live;   // 实时绘制的屏幕与全量重播不同的像素
+    uint32_t region; // 按笔划索引局部重绘整个屏幕与全量重播不同的像素
+} SimReplayDiff_t;
+
+static uint32_t canvasDiff(const uint16_t *fb, const std::vector<uint16_t> &other, int w, int h)
+{
+    uint32_t diff = 0;
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            if (inCanvasMask(x, y) && fb[y * w + x] != other[y * w + x])
+                diff++;
+        }
+    }
+    return diff;
+}
+
+// 清屏后全量重播 (与开机恢复画布相同)，与之前的屏幕比较；再清屏后用 replayRegion 重绘整个屏幕，与全量重播比较。
+// 调用时所有任务都阻塞在内核中
+static SimReplayDiff_t childReplayDiff()
+{
+    const uint16_t *fb = hostTftFramebuffer();
+    int w = hostTftWidth(), h = hostTftHeight();
+    SimReplayDiff_t result;
+    std::vector<uint16_t> before(fb, fb + w * h);
+    tft.fillScreen(TFT_BLACK);
+    drawMainInterface();
+    replayAllDrawings();
+    result.live = canvasDiff(fb, before, w, h);
+
+    std::vector<uint16_t> full(fb, fb + w * h);
+    tft.fillScreen(TFT_BLACK);
+    drawMainInterface();
+    replayRegion(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    result.region = canvasDiff(fb, full, w, h);
+    return result;
+}
+
+static void childMain(int index, int fd)
+{
+    childFd = fd;
+    childIndex = index;
+    const SimNode_t &self = nodes[index];
+
+    hostSerialSetSink(childSerialSink);
+    uint8_t mac[6];
+    nodeMac(index, mac);
+    hostRadioSetMac(mac);
+    hostRadioSetBitrateKbps(bitrateKbps);
+    for (const SimTouch_t &touch : self.touches)
+        hostTouchAdd(touch.atUs - self.bootUs, touch.x, touch.y, touch.z);
+    if (index == dozeNode)
+    {
+        // 短按 BOOT 息屏 (handleBootButton 轮询检测)，空闲 LIGHT_SLEEP_IDLE_MS 后进入浅睡眠待机
+        hostPost(SIM_FIRST_INPUT_AFTER_BOOT_MS * 1000ULL, []() { hostGpioSet(BUTTON_IO0, LOW); });
+        hostPost((SIM_FIRST_INPUT_AFTER_BOOT_MS + SIM_BOOT_PRESS_MS) * 1000ULL, []() { hostGpioSet(BUTTON_IO0, HIGH); });
+    }
+    hostRadioSetMedium([](const uint8_t *destMac, const uint8_t *data, size_t len, uint64_t txDoneUs) {
+        sendMsg(childFd, SIM_MSG_FRAME, txDoneUs, destMac, 0, data, (uint32_t)len);
+        uint8_t ack = 0;
+        readAll(childFd, &ack, 1);
+        return ack != 0;
+    });
+    hostStartArduino();
+
+    for (;;)
+    {
+        SimMsgHeader_t header;
+        readAll(fd, &header, sizeof(header));
+        std::vector<uint8_t> payload(header.len);
+        if (header.len > 0)
+            readAll(fd, payload.data(), header.len);
+
+        if (header.type == SIM_MSG_RUN)
+        {
+            hostRunUntil(header.timeUs);
+            uint64_t next = hostNextWakeUs();
+            sendMsg(fd, SIM_MSG_DONE, next, nullptr, 0, nullptr, hostHalted() ? 1 : 0);
+        }
+        else if (header.type == SIM_MSG_DELIVER)
+        {
+            hostRadioDeliver(header.timeUs, header.mac, payload.data(), payload.size(), header.rssi);
+        }
+        else if (header.type == SIM_MSG_QUERY)
+        {
+            SimNodeReport_t report;
+            memset(&report, 0, sizeof(report));
+            report.canvasHash = childCanvasHash();
+            report.historyHash = childHistoryHash();
+            report.historyPoints = (uint32_t)allDrawingHistory.size();
+            networkTaskGetStats(report.net);
+            sendMsg(fd, SIM_MSG_REPLY, 0, nullptr, 0, &report, sizeof(report));
+        }
+        else if (header.type == SIM_MSG_CANVAS)
+        {
+            uint32_t bytes = (uint32_t)(hostTftWidth() * hostTftHeight() * sizeof(uint16_t));
+            sendMsg(fd, SIM_MSG_REPLY, 0, nullptr, 0, hostTftFramebuffer(), bytes);
+        }
+        else if (header.type == SIM_MSG_REPLAY)
+        {
+            SimReplayDiff_t diff = childReplayDiff();
+            sendMsg(fd, SIM_MSG_REPLY, 0, nullptr, 0, &diff, sizeof(diff));
+        }
+        else
+        {
+            fflush(stderr);
+            _Exit(0); // 任务线程仍阻塞在内核中，直接退出
+        }
+    }
+}
+
+// --- 父进程 (信道) ---
+
+typedef struct SimTraffic_s
+{
+    uint32_t frames[SIM_MESSAGE_TYPES + 1]; // 最后一项为未知类型
+    uint64_t deviceBytes[SIM_MESSAGE_TYPES + 1];
+    uint64_t airtimeUs;
+    uint32_t deliveries;
+    uint32_t losses;
+} SimTraffic_t;
+
+static SimTraffic_t traffic;
+static std::mt19937 channelRng;
+static uint64_t lastArrivalUs[SIM_MAX_NODES][SIM_MAX_NODES]; // 每条链路上一帧的到达时间 (保持顺序)
+
+static uint64_t nodeNextEvent(const SimNode_t &node)
+{
+    if (node.halted)
+        return HOST_TIME_NEVER;
+    return node.booted ? node.nextWakeUs : node.bootUs;
+}
+
+// 把一帧交给接收方，返回是否收到
+static bool transmitTo(int src, int dst, const uint8_t *data, size_t len, uint64_t txDoneUs)
+{
+    SimNode_t &receiver = nodes[dst];
+    const SimLink_t &link = links[src][dst];
+    std::uniform_real_distribution<double> lossDist(0.0, 1.0);
+    bool lost = lossDist(channelRng) < link.loss;
+    uint64_t jitter = link.jitterUs > 0 ? channelRng() % (link.jitterUs + 1) : 0;
+    if (lost || !receiver.booted || receiver.halted || txDoneUs < receiver.bootUs)
+    {
+        receiver.framesLost++;
+        traffic.losses++;
+        return false;
+    }
+    uint64_t arrivalUs = std::max(txDoneUs + link.latencyUs + jitter, lastArrivalUs[src][dst] + 1);
+    lastArrivalUs[src][dst] = arrivalUs;
+    uint8_t srcMac[6];
+    nodeMac(src, srcMac);
+    sendMsg(receiver.fd, SIM_MSG_DELIVER, arrivalUs - receiver.bootUs, srcMac, SIM_RSSI, data, (uint32_t)len);
+    receiver.nextWakeUs = std::min(receiver.nextWakeUs, arrivalUs);
+    receiver.framesReceived++;
+    traffic.deliveries++;
+    return true;
+}
+
+static void handleFrame(int src, const SimMsgHeader_t &header, const std::vector<uint8_t> &data)
+{
+    SimNode_t &sender = nodes[src];
+    uint64_t txDoneUs = header.timeUs + sender.bootUs;
+    size_t deviceLen = data.size() == sizeof(SyncMessage_t) ? SIM_DEVICE_SYNC_MESSAGE_BYTES : data.size();
+    uint32_t airtime = hostRadioAirtimeUs(deviceLen);
+
+    int type = SIM_MESSAGE_TYPES;
+    if (data.size() >= sizeof(MessageType_t))
+    {
+        MessageType_t t;
+        memcpy(&t, data.data(), sizeof(t));
+        if ((int)t >= 0 && (int)t < SIM_MESSAGE_TYPES)
+            type = (int)t;
+    }
+    traffic.frames[type]++;
+    traffic.deviceBytes[type] += deviceLen;
+    traffic.airtimeUs += airtime;
+    sender.framesSent++;
+    sender.payloadBytes += data.size();
+    sender.deviceBytes += deviceLen;
+    sender.airtimeUs += airtime;
+
+    bool acked = false;
+    int dst = nodeIndexOf(header.mac);
+    if (dst >= 0)
+    {
+        acked = transmitTo(src, dst, data.data(), data.size(), txDoneUs);
+    }
+    else
+    {
+        for (int i = 0; i < nodeCount; i++)
+        {
+            if (i != src)
+                transmitTo(src, i, data.data(), data.size(), txDoneUs);
+        }
+    }
+    uint8_t ack = acked ? 1 : 0;
+    writeAll(sender.fd, &ack, 1);
+}
+
+// 把节点推进到全局时间 targetUs，期间转发它发出的帧
+static void runNode(int index, uint64_t targetUs)
+{
+    SimNode_t &node = nodes[index];
+    node.booted = true;
+    sendMsg(node.fd, SIM_MSG_RUN, targetUs - node.bootUs, nullptr, 0, nullptr, 0);
+    for (;;)
+    {
+        SimMsgHeader_t header;
+        readAll(node.fd, &header, sizeof(header));
+        std::vector<uint8_t> payload(header.len);
+        if (header.type == SIM_MSG_FRAME)
+        {
+            if (header.len > 0)
+                readAll(node.fd, payload.data(), header.len);
+            handleFrame(index, header, payload);
+            continue;
+        }
+        // SIM_MSG_DONE
+        node.halted = header.len != 0;
+        node.nextWakeUs = header.timeUs == HOST_TIME_NEVER ? HOST_TIME_NEVER : header.timeUs + node.bootUs;
+        // 运行期间收到的帧可能早于节点报告的下次唤醒
+        return;
+    }
+}
+
+static SimNodeReport_t queryNode(int index)
+{
+    SimNodeReport_t report;
+    sendMsg(nodes[index].fd, SIM_MSG_QUERY, 0, nullptr, 0, nullptr, 0);
+    SimMsgHeader_t header;
+    readAll(nodes[index].fd, &header, sizeof(header));
+    readAll(nodes[index].fd, &report, sizeof(report));
+    return report;
+}
+
+static std::vector<uint16_t> fetchCanvas(int index)
+{
+    sendMsg(nodes[index].fd, SIM_MSG_CANVAS, 0, nullptr, 0, nullptr, 0);
+    SimMsgHeader_t header;
+    readAll(nodes[index].fd, &header, sizeof(header));
+    std::vector<uint16_t> pixels(header.len / sizeof(uint16_t));
+    readAll(nodes[index].fd, pixels.data(), header.len);
+    return pixels;
+}
+
+static SimReplayDiff_t replayNode(int index)
+{
+    SimReplayDiff_t diff = {0, 0};
+    sendMsg(nodes[index].fd, SIM_MSG_REPLAY, 0, nullptr, 0, nullptr, 0);
+    SimMsgHeader_t header;
+    readAll(nodes[index].fd, &header, sizeof(header));
+    readAll(nodes[index].fd, &diff, sizeof(diff));
+    return diff;
+}
+
+static bool writePpm(const char *path, const std::vector<uint16_t> &pixels)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == nullptr)
+        return false;
+    fprintf(f, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    for (uint16_t c : pixels)
+    {
+        uint8_t rgb[3] = {(uint8_t)(((c >> 11) & 0x1F) << 3), (uint8_t)(((c >> 5) & 0x3F) << 2), (uint8_t)((c & 0x1F) << 3)};
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+    return true;
+}
+
+// 收敛时间取最后一段连续一致的起点
+static void updateConvergence(uint64_t &convergedUs, bool agree, uint64_t sampleUs)
+{
+    if (!agree)
+        convergedUs = HOST_TIME_NEVER;
+    else if (convergedUs == HOST_TIME_NEVER)
+        convergedUs = sampleUs;
+}
+
+static void printConvergence(const char *what, uint64_t convergedUs, uint64_t lastInputUs)
+{
+    if (convergedUs == HOST_TIME_NEVER)
+        printf("%s convergence: NOT converged by the end of the run\n", what);
+    else
+        printf("%s convergence: %.3f s after the last input (at %.3f s, sampled every %u ms)\n", what,
+               (convergedUs - std::min(convergedUs, lastInputUs)) / 1e6, convergedUs / 1e6, sampleMs);
+}
+
+// --- 输入脚本 ---
+
+static int16_t rawX(int screenX)
+{
+    return (int16_t)(TOUCH_MIN_X + (long)screenX * (TOUCH_MAX_X - TOUCH_MIN_X) / SCREEN_WIDTH);
+}
+
+static int16_t rawY(int screenY)
+{
+    return (int16_t)(TOUCH_MIN_Y + (long)screenY * (TOUCH_MAX_Y - TOUCH_MIN_Y) / SCREEN_HEIGHT);
+}
+
+static void buildTouchScript(int index, SimNode_t &node)
+{
+    if (index == dozeNode)
+        return; // 待机的节点不画
+    std::mt19937 rng(seed * 7919u + (uint32_t)index);
+    uint64_t t = std::max<uint64_t>(drawStartMs * 1000, node.bootUs + SIM_FIRST_INPUT_AFTER_BOOT_MS * 1000ULL);
+    t += (rng() % 1000) * 1000ULL;
+
+    // 先点一个颜色按钮，让各节点的笔划颜色不同
+    int colorIndex = index % 4;
+    int tapX = RESET_BUTTON_X + COLOR_BUTTON_WIDTH / 2;
+    int tapY = COLOR_BUTTON_START_Y + (COLOR_BUTTON_HEIGHT + COLOR_BUTTON_SPACING) * colorIndex + COLOR_BUTTON_HEIGHT / 2;
+    node.touches.push_back(SimTouch_s{t, rawX(tapX), rawY(tapY), SIM_TOUCH_Z});
+    t += SIM_TAP_MS * 1000ULL;
+    node.touches.push_back(SimTouch_s{t, 0, 0, 0});
+    t += 300 * 1000ULL;
+
+    for (int s = 0; s < strokesPerNode && t < drawEndMs * 1000; s++)
+    {
+        float x = SIM_MASK_LEFT + 10 + rng() % (SCREEN_WIDTH - SIM_MASK_LEFT - 40);
+        float y = 24 + rng() % (SCREEN_HEIGHT - 40);
+        float heading = (rng() % 628) / 100.0f;
+        int samples = 20 + rng() % 40;
+        for (int i = 0; i < samples; i++)
+        {
+            node.touches.push_back(SimTouch_s{t, rawX((int)x), rawY((int)y), SIM_TOUCH_Z});
+            heading += ((int)(rng() % 61) - 30) / 100.0f;
+            float nx = x + 3.0f * cosf(heading);
+            float ny = y + 3.0f * sinf(heading);
+            if (nx < SIM_MASK_LEFT + 4 || nx > SCREEN_WIDTH - 4 || ny < 24 || ny > SCREEN_HEIGHT - 4)
+                heading += 3.14159f; // 碰到边界掉头
+            else
+            {
+                x = nx;
+                y = ny;
+            }
+            t += SIM_TOUCH_SAMPLE_MS * 1000ULL;
+        }
+        node.touches.push_back(SimTouch_s{t, 0, 0, 0});
+        node.lastInputUs = t;
+        t += (300 + rng() % 1700) * 1000ULL;
+    }
+
+    // 撤销自己最近的几条笔划 (撤销按钮在右上角，自定义颜色按钮下方)
+    for (int u = 0; u < undosPerNode; u++)
+    {
+        node.touches.push_back(SimTouch_s{t, rawX(UNDO_BUTTON_X + UNDO_BUTTON_W / 2), rawY(UNDO_BUTTON_Y + UNDO_BUTTON_H / 2), SIM_TOUCH_Z});
+        t += SIM_TAP_MS * 1000ULL;
+        node.touches.push_back(SimTouch_s{t, 0, 0, 0});
+        node.lastInputUs = t;
+        t += 300 * 1000ULL;
+    }
+}
+
+// --- 参数解析 ---
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: firenote_sim [--nodes N] [--ms N] [--seed S] [--loss P] [--latency US] [--jitter US] [--rate KBPS]\n"
+            "                    [--link A-B:loss[:latency[:jitter]]]... [--boot-stagger MS] [--strokes K]\n"
+            "                    [--draw-start MS] [--draw-end MS] [--sample MS] [--undo K] [--doze N] [--ppm prefix] [--verbose]\n"
+            "                    [--require-canvas] [--check-replay]\n");
+}
+
+static bool parseLink(const char *text, std::vector<std::pair<std::pair<int, int>, SimLink_t>> &out)
+{
+    int a, b;
+    double loss;
+    unsigned latency = defaultLink.latencyUs, jitter = defaultLink.jitterUs;
+    int n = sscanf(text, "%d-%d:%lf:%u:%u", &a, &b, &loss, &latency, &jitter);
+    if (n < 3 || a < 0 || b < 0 || a == b)
+        return false;
+    out.push_back({{a, b}, SimLink_t{loss, latency, jitter}});
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::pair<std::pair<int, int>, SimLink_t>> overrides;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        const char *arg = argv[i];
+        if (strcmp(arg, "--nodes") == 0 && hasValue)
+            nodeCount = atoi(argv[++i]);
+        else if (strcmp(arg, "--ms") == 0 && hasValue)
+            durationMs = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--seed") == 0 && hasValue)
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--loss") == 0 && hasValue)
+            defaultLink.loss = atof(argv[++i]);
+        else if (strcmp(arg, "--latency") == 0 && hasValue)
+            defaultLink.latencyUs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--jitter") == 0 && hasValue)
+            defaultLink.jitterUs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--rate") == 0 && hasValue)
+            bitrateKbps = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--link") == 0 && hasValue)
+        {
+            if (!parseLink(argv[++i], overrides))
+            {
+                fprintf(stderr, "bad link spec: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (strcmp(arg, "--boot-stagger") == 0 && hasValue)
+            bootStaggerMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--strokes") == 0 && hasValue)
+            strokesPerNode = atoi(argv[++i]);
+        else if (strcmp(arg, "--undo") == 0 && hasValue)
+            undosPerNode = atoi(argv[++i]);
+        else if (strcmp(arg, "--doze") == 0 && hasValue)
+            dozeNode = atoi(argv[++i]);
+        else if (strcmp(arg, "--draw-start") == 0 && hasValue)
+            drawStartMs = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--draw-end") == 0 && hasValue)
+            drawEndMs = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--sample") == 0 && hasValue)
+            sampleMs = (uint32_t)std::max(1UL, strtoul(argv[++i], nullptr, 10));
+        else if (strcmp(arg, "--ppm") == 0 && hasValue)
+            ppmPrefix = argv[++i];
+        else if (strcmp(arg, "--verbose") == 0)
+            verbose = true;
+        else if (strcmp(arg, "--require-canvas") == 0)
+            requireCanvas = true;
+        else if (strcmp(arg, "--check-replay") == 0)
+            checkReplay = true;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (nodeCount < 2 || nodeCount > SIM_MAX_NODES)
+    {
+        fprintf(stderr, "--nodes must be between 2 and %d\n", SIM_MAX_NODES);
+        return 2;
+    }
+    for (int a = 0; a < nodeCount; a++)
+        for (int b = 0; b < nodeCount; b++)
+            links[a][b] = defaultLink;
+    for (const auto &o : overrides)
+    {
+        if (o.first.first >= nodeCount || o.first.second >= nodeCount)
+        {
+            fprintf(stderr, "link %d-%d: no such node\n", o.first.first, o.first.second);
+            return 2;
+        }
+        links[o.first.first][o.first.second] = o.second;
+        links[o.first.second][o.first.first] = o.second;
+    }
+    uint64_t lastBootMs = (uint64_t)bootStaggerMs * (nodeCount - 1);
+    if (drawStartMs == 0)
+        drawStartMs = lastBootMs + SIM_FIRST_INPUT_AFTER_BOOT_MS;
+    if (drawEndMs == 0)
+        drawEndMs = std::max(drawStartMs + 1000, durationMs / 2);
+
+    // 节点和输入脚本在 fork 之前生成，父子进程看到的完全相同
+    nodes.resize(nodeCount);
+    for (int i = 0; i < nodeCount; i++)
+    {
+        SimNode_t &node = nodes[i];
+        node.pid = -1;
+        node.fd = -1;
+        node.bootUs = (uint64_t)bootStaggerMs * 1000ULL * i;
+        node.booted = false;
+        node.halted = false;
+        node.nextWakeUs = node.bootUs;
+        node.lastInputUs = 0;
+        node.framesSent = node.framesReceived = node.framesLost = 0;
+        node.payloadBytes = node.deviceBytes = node.airtimeUs = 0;
+        buildTouchScript(i, node);
+    }
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = 0; i < nodeCount; i++)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            perror("socketpair");
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0)
+        {
+            close(fds[0]);
+            for (int j = 0; j < i; j++)
+                close(nodes[j].fd);
+            childMain(i, fds[1]);
+        }
+        close(fds[1]);
+        nodes[i].pid = pid;
+        nodes[i].fd = fds[0];
+    }
+
+    // 保守同步: 窗口长度不超过最短帧的空中时间 + 最小链路延迟，窗口内发出的帧一定在窗口之后到达
+    hostRadioSetBitrateKbps(bitrateKbps);
+    uint32_t minLatency = UINT32_MAX;
+    for (int a = 0; a < nodeCount; a++)
+        for (int b = 0; b < nodeCount; b++)
+            if (a != b)
+                minLatency = std::min(minLatency, links[a][b].latencyUs);
+    uint64_t lookaheadUs = hostRadioAirtimeUs(1) + minLatency;
+    channelRng.seed(seed);
+
+    uint64_t endUs = durationMs * 1000;
+    uint64_t nextSampleUs = sampleMs * 1000ULL;
+    uint64_t lastInputUs = 0;
+    for (const SimNode_t &node : nodes)
+        lastInputUs = std::max(lastInputUs, node.lastInputUs);
+    uint64_t historyConvergedUs = HOST_TIME_NEVER, canvasConvergedUs = HOST_TIME_NEVER;
+    uint32_t windows = 0;
+
+    for (;;)
+    {
+        uint64_t earliest = nextSampleUs;
+        for (const SimNode_t &node : nodes)
+            earliest = std::min(earliest, nodeNextEvent(node));
+        if (earliest >= endUs)
+            break;
+        uint64_t windowEnd = std::min(std::min(earliest + lookaheadUs, nextSampleUs), endUs);
+        for (int i = 0; i < nodeCount; i++)
+        {
+            if (nodeNextEvent(nodes[i]) < windowEnd)
+                runNode(i, windowEnd);
+        }
+        windows++;
+
+        if (windowEnd == nextSampleUs)
+        {
+            bool allBooted = true, historyAgree = true, canvasAgree = true;
+            SimNodeReport_t first;
+            memset(&first, 0, sizeof(first));
+            bool haveFirst = false;
+            for (int i = 0; i < nodeCount && allBooted; i++)
+            {
+                allBooted = nodes[i].booted;
+                if (!allBooted || nodes[i].halted)
+                    continue;
+                SimNodeReport_t report = queryNode(i);
+                if (!haveFirst)
+                {
+                    first = report;
+                    haveFirst = true;
+                    continue;
+                }
+                historyAgree = historyAgree && report.historyHash == first.historyHash;
+                canvasAgree = canvasAgree && report.canvasHash == first.canvasHash;
+            }
+            bool settled = allBooted && nextSampleUs >= lastInputUs;
+            updateConvergence(historyConvergedUs, settled && historyAgree, nextSampleUs);
+            updateConvergence(canvasConvergedUs, settled && canvasAgree, nextSampleUs);
+            nextSampleUs += sampleMs * 1000ULL;
+        }
+    }
+
+    // --- 报告 ---
+    printf("nodes %d, %llu ms virtual, seed %u, loss %.3f, latency %u us, jitter %u us, %u kbps, %u windows\n", nodeCount,
+           (unsigned long long)durationMs, seed, defaultLink.loss, defaultLink.latencyUs, defaultLink.jitterUs, bitrateKbps,
+           windows);
+    printf("last touch input at %.3f s\n", lastInputUs / 1e6);
+    printConvergence("history", historyConvergedUs, lastInputUs);
+    printConvergence("canvas ", canvasConvergedUs, lastInputUs);
+
+    uint32_t totalFrames = 0;
+    uint64_t totalBytes = 0;
+    for (int t = 0; t <= SIM_MESSAGE_TYPES; t++)
+    {
+        totalFrames += traffic.frames[t];
+        totalBytes += traffic.deviceBytes[t];
+    }
+    printf("on air: %u frames, %llu payload bytes, %.1f ms airtime (%.2f%% of the channel), %u deliveries, %u losses\n",
+           totalFrames, (unsigned long long)totalBytes, traffic.airtimeUs / 1000.0, 100.0 * traffic.airtimeUs / endUs,
+           traffic.deliveries, traffic.losses);
+    for (int t = 0; t <= SIM_MESSAGE_TYPES; t++)
+    {
+        if (traffic.frames[t] > 0)
+            printf("  %-14s %8u frames %10llu bytes\n", t < SIM_MESSAGE_TYPES ? messageTypeNames[t] : "(unknown)",
+                   traffic.frames[t], (unsigned long long)traffic.deviceBytes[t]);
+    }
+
+    std::vector<std::vector<uint16_t>> canvases(nodeCount);
+    std::vector<SimNodeReport_t> reports(nodeCount);
+    for (int i = 0; i < nodeCount; i++)
+    {
+        reports[i] = queryNode(i);
+        canvases[i] = fetchCanvas(i);
+    }
+    // 逐像素多数结果
+    size_t pixelCount = canvases[0].size();
+    std::vector<uint32_t> diffPixels(nodeCount, 0);
+    uint32_t contested = 0;
+    for (size_t p = 0; p < pixelCount; p++)
+    {
+        int x = (int)(p % SCREEN_WIDTH), y = (int)(p / SCREEN_WIDTH);
+        if (!inCanvasMask(x, y))
+            continue;
+        uint16_t best = canvases[0][p];
+        int bestVotes = 0;
+        bool same = true;
+        for (int i = 0; i < nodeCount; i++)
+        {
+            int votes = 0;
+            for (int j = 0; j < nodeCount; j++)
+                votes += canvases[j][p] == canvases[i][p];
+            if (votes > bestVotes)
+            {
+                bestVotes = votes;
+                best = canvases[i][p];
+            }
+            same = same && canvases[i][p] == canvases[0][p];
+        }
+        if (!same)
+            contested++;
+        for (int i = 0; i < nodeCount; i++)
+            diffPixels[i] += canvases[i][p] != best;
+    }
+    printf("canvas divergence: %u pixels differ between nodes\n", contested);
+    printf("  node  boot(s)  history  diff_px  tx_frames  tx_bytes  airtime_ms  rx_frames  rx_lost  full_syncs  raster_syncs  rx_dropped\n");
+    for (int i = 0; i < nodeCount; i++)
+    {
+        const SimNode_t &node = nodes[i];
+        printf("  %4d %8.1f %8u %8u %10u %9llu %11.1f %10u %8u %11u %13u %11u%s\n", i, node.bootUs / 1e6,
+               reports[i].historyPoints, diffPixels[i], node.framesSent, (unsigned long long)node.deviceBytes,
+               node.airtimeUs / 1000.0, node.framesReceived, node.framesLost, reports[i].net.fullSyncsSent,
+               reports[i].net.rasterSyncsSent, reports[i].net.rxDropped, node.halted ? "  (halted)" : "");
+        if (ppmPrefix != nullptr)
+        {
+            std::string path = std::string(ppmPrefix) + std::to_string(i) + ".ppm";
+            if (!writePpm(path.c_str(), canvases[i]))
+                fprintf(stderr, "cannot write %s\n", path.c_str());
+        }
+    }
+
+    uint32_t replayDiff = 0;
+    if (checkReplay)
+    {
+        // 在比较画布之后: 重播会改写屏幕
+        for (int i = 0; i < nodeCount; i++)
+        {
+            SimReplayDiff_t diff = replayNode(i);
+            printf("replay check: node %d: %u canvas pixels (live) and %u (region replay) differ from a full replay\n", i,
+                   diff.live, diff.region);
+            replayDiff += diff.live + diff.region;
+        }
+    }
+
+    for (int i = 0; i < nodeCount; i++)
+    {
+        sendMsg(nodes[i].fd, SIM_MSG_EXIT, 0, nullptr, 0, nullptr, 0);
+        waitpid(nodes[i].pid, nullptr, 0);
+    }
+    if (replayDiff > 0)
+        return 1;
+    if (requireCanvas)
+        return canvasConvergedUs != HOST_TIME_NEVER && contested == 0 ? 0 : 1;
+    return historyConvergedUs == HOST_TIME_NEVER && canvasConvergedUs == HOST_TIME_NEVER ? 1 : 0;
+}
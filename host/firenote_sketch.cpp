@@ -0,0 +1,6 @@
+// 草图的主机编译单元: 与 Arduino 构建相同，先包含 Arduino.h 并补上草图中先使用后定义的函数原型
+#include <Arduino.h>
+
+static void registerMainLoopTasks();
+
+#include "../FireNote-ESP32.ino"
@@ -0,0 +1,59 @@
+#include "fuzz_common.h"
+
+#include <Arduino.h>
+#include "esp_now_handler.h"
+#include "mqtt_handler.h"
+#include "host_io.h"
+#include "host_kernel.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const uint8_t resetSenderMac[6] = {0x02, 0x00, 0x00, 0x00, 0x0F, 0x0F};
+
+void fuzzBoot(bool wifi)
+{
+    hostSerialSetSink([](const char *, size_t) {}); // 固件每条消息都打印日志，模糊测试时丢弃
+    hostWifiSetAvailable(wifi);
+    hostStartArduino();
+    hostRunUntil(FUZZ_BOOT_MS * 1000ULL);
+    if (wifi)
+    {
+        // 与 WiFi 按钮相同的连接流程 (connectToWiFi 中的等待循环在驱动方线程里不能阻塞)
+        WiFi.begin("fuzz", "fuzz");
+        mqttInit("fuzz", 1883);
+        hostRunFor(FUZZ_SETTLE_MS * 1000ULL);
+    }
+}
+
+void fuzzDeliver(const uint8_t srcMac[6], const uint8_t *data, size_t len, uint32_t settleMs)
+{
+    hostRadioDeliver(hostNowUs(), srcMac, data, len, -40);
+    hostRunFor(settleMs * 1000ULL);
+}
+
+void fuzzResetCanvas()
+{
+    SyncMessage_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.type = MSG_TYPE_RESET_CANVAS;
+    fuzzDeliver(resetSenderMac, (const uint8_t *)&msg, sizeof(msg), FUZZ_SETTLE_MS);
+}
+
+void fuzzCheckHistory(const char *target)
+{
+    // 所有任务此时都阻塞在内核中，可以直接读取历史
+    for (size_t i = 0; i < allDrawingHistory.size(); i++)
+    {
+        const TouchData_t &point = allDrawingHistory[i];
+        uint8_t resetByte;
+        memcpy(&resetByte, &point.isReset, sizeof(resetByte));
+        if (resetByte > 1 || !remotePointInRange(point))
+        {
+            fprintf(stderr, "%s: history[%u] corrupted: x=%d y=%d isReset=%u\n", target, (unsigned)i, point.x,
+                    point.y, resetByte);
+            abort();
+        }
+    }
+}
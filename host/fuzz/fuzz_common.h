@@ -0,0 +1,29 @@
+#ifndef FUZZ_COMMON_H
+#define FUZZ_COMMON_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 模糊测试目标的公共部分: 每个进程只启动一次固件 (setup 和启动同步在虚拟时间里跑完)，之后每个输入在同一个节点上
+// 运行。输入之间先清空画布 (收到 RESET_CANVAS / MQTT "reset")，让历史不随输入数累积。
+// 发现问题时打印原因并 abort()，由 libFuzzer (或 fuzz_main.cpp) 保存触发它的输入。
+
+#define FUZZ_BOOT_MS 1500   // 启动后先运行的虚拟时间 (毫秒)，越过 setup 和第一次 UPTIME_INFO 广播
+#define FUZZ_SETTLE_MS 50   // 每帧/每条消息之后运行的虚拟时间 (毫秒)，让网络任务和主循环处理完
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// 启动固件 (wifi 为 true 时连上 WiFi 并初始化 MQTT，此时固件忽略 ESP-NOW 同步消息)
+void fuzzBoot(bool wifi);
+
+// 从 srcMac 送来一帧 ESP-NOW 数据，并运行 settleMs 虚拟时间
+void fuzzDeliver(const uint8_t srcMac[6], const uint8_t *data, size_t len, uint32_t settleMs);
+
+// 收到对端的 RESET_CANVAS: 清空历史、回到初始同步状态
+void fuzzResetCanvas();
+
+// 检查绘图历史: 每个点都在 remotePointInRange 范围内，isReset 只能是 0 或 1
+void fuzzCheckHistory(const char *target);
+
+#endif // FUZZ_COMMON_H
@@ -0,0 +1,47 @@
+// 模糊测试: ESP-NOW 接收回调 OnSyncDataRecv 与网络任务对单帧的处理
+// 输入第一个字节选择帧长 (0: SyncMessage_t，1: RasterTileMessage_t，2: MAC 字符串广播，其他: 其余字节的原长)，
+// 其余字节为帧内容 (不足时补零)。每帧之后检查绘图历史没有被写入越界坐标或非法的 isReset。
+
+#include "fuzz_common.h"
+#include "esp_now_handler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static const uint8_t peerMac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x42};
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    fuzzBoot(false);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size == 0)
+        return 0;
+    size_t len = size - 1;
+    switch (data[0])
+    {
+    case 0:
+        len = sizeof(SyncMessage_t);
+        break;
+    case 1:
+        len = sizeof(RasterTileMessage_t);
+        break;
+    case 2:
+        len = strlen("XX:XX:XX:XX:XX:XX");
+        break;
+    }
+    std::vector<uint8_t> frame(len, 0);
+    if (len > 0)
+        memcpy(frame.data(), data + 1, std::min(len, size - 1));
+
+    fuzzResetCanvas();
+    fuzzDeliver(peerMac, frame.data(), frame.size(), FUZZ_SETTLE_MS);
+    fuzzCheckHistory("fuzz_espnow_frame");
+    return 0;
+}
@@ -0,0 +1,170 @@
+// 没有 libFuzzer 时 (例如用 GCC 构建) 的替代入口，与 libFuzzer 的命令行兼容一部分:
+//   fuzz_xxx [-runs=N] [-seed=S] [-max_len=L] [-timeout=秒] 输入文件或目录...
+// 先依次运行给出的输入 (复现 libFuzzer 保存的 crash-* 文件)，再对这些输入 (没有时从空输入开始) 做 N 次随机变异
+// (翻转、覆盖、插入、删除、截断字节) 并运行。没有覆盖率反馈，只用于在没有 Clang 的机器上复现问题和冒烟测试。
+// 发现问题时 (abort、sanitizer 报告或单个输入超时) 把当前输入写到 crash-fuzz_main 再退出。
+
+#include "fuzz_common.h"
+
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<uint8_t> currentInput;
+
+static void saveCurrentInput()
+{
+    FILE *f = fopen("crash-fuzz_main", "wb");
+    if (f == nullptr)
+        return;
+    fwrite(currentInput.data(), 1, currentInput.size(), f);
+    fclose(f);
+    fprintf(stderr, "fuzz_main: input (%u bytes) written to crash-fuzz_main\n", (unsigned)currentInput.size());
+}
+
+static void onFatalSignal(int sig)
+{
+    fprintf(stderr, "fuzz_main: %s\n", sig == SIGALRM ? "input timed out" : strsignal(sig));
+    saveCurrentInput();
+    signal(sig, SIG_DFL);
+    raise(sig == SIGALRM ? SIGABRT : sig);
+}
+
+static void runOne(const std::vector<uint8_t> &input, unsigned timeoutS)
+{
+    currentInput = input;
+    alarm(timeoutS);
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+    alarm(0);
+}
+
+static bool readFile(const std::string &path, std::vector<uint8_t> &out)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+    out.clear();
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        out.insert(out.end(), buffer, buffer + n);
+    fclose(f);
+    return true;
+}
+
+static void addInputs(const char *path, std::vector<std::vector<uint8_t>> &corpus)
+{
+    DIR *dir = opendir(path);
+    if (dir == nullptr)
+    {
+        std::vector<uint8_t> input;
+        if (readFile(path, input))
+            corpus.push_back(input);
+        else
+            fprintf(stderr, "fuzz_main: cannot read %s\n", path);
+        return;
+    }
+    while (struct dirent *entry = readdir(dir))
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+        std::vector<uint8_t> input;
+        if (readFile(std::string(path) + "/" + entry->d_name, input))
+            corpus.push_back(input);
+    }
+    closedir(dir);
+}
+
+static void mutate(std::vector<uint8_t> &input, std::mt19937 &rng, size_t maxLen)
+{
+    int edits = 1 + rng() % 4;
+    for (int i = 0; i < edits; i++)
+    {
+        size_t pos = input.empty() ? 0 : rng() % input.size();
+        switch (rng() % 5)
+        {
+        case 0: // 翻转一位
+            if (!input.empty())
+                input[pos] ^= (uint8_t)(1 << (rng() % 8));
+            break;
+        case 1: // 覆盖为随机值或边界值
+            if (!input.empty())
+            {
+                static const uint8_t special[] = {0x00, 0x01, 0x7F, 0x80, 0xFF};
+                input[pos] = (rng() % 2) ? (uint8_t)rng() : special[rng() % sizeof(special)];
+            }
+            break;
+        case 2: // 插入随机字节
+            if (input.size() < maxLen)
+                input.insert(input.begin() + pos, (uint8_t)rng());
+            break;
+        case 3: // 删除一个字节
+            if (!input.empty())
+                input.erase(input.begin() + pos);
+            break;
+        case 4: // 截断
+            input.resize(input.empty() ? 0 : rng() % input.size());
+            break;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long runs = 0;
+    unsigned seed = 1;
+    size_t maxLen = 1024;
+    unsigned timeoutS = 20;
+    std::vector<std::vector<uint8_t>> corpus;
+
+    LLVMFuzzerInitialize(&argc, &argv);
+    signal(SIGABRT, onFatalSignal);
+    signal(SIGSEGV, onFatalSignal);
+    signal(SIGALRM, onFatalSignal);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (sscanf(argv[i], "-runs=%lu", &runs) == 1 || sscanf(argv[i], "-seed=%u", &seed) == 1 ||
+            sscanf(argv[i], "-max_len=%zu", &maxLen) == 1 || sscanf(argv[i], "-timeout=%u", &timeoutS) == 1)
+            continue;
+        if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "fuzz_main: ignoring libFuzzer option %s\n", argv[i]);
+            continue;
+        }
+        addInputs(argv[i], corpus);
+    }
+
+    for (const std::vector<uint8_t> &input : corpus)
+        runOne(input, timeoutS);
+    fprintf(stderr, "fuzz_main: %u inputs ran\n", (unsigned)corpus.size());
+
+    if (corpus.empty())
+        corpus.push_back(std::vector<uint8_t>());
+    std::mt19937 rng(seed);
+    for (unsigned long i = 0; i < runs; i++)
+    {
+        std::vector<uint8_t> input = corpus[rng() % corpus.size()];
+        if (input.empty() || rng() % 8 == 0)
+        {
+            input.resize(rng() % (maxLen + 1));
+            for (uint8_t &b : input)
+                b = (uint8_t)rng();
+        }
+        mutate(input, rng, maxLen);
+        runOne(input, timeoutS);
+        if (corpus.size() < 256 && rng() % 16 == 0)
+            corpus.push_back(input); // 没有覆盖率信息，随机保留一些变异结果作为后续变异的起点
+    }
+    if (runs > 0)
+        fprintf(stderr, "fuzz_main: %lu mutated inputs ran (seed %u)\n", runs, seed);
+    fflush(stdout);
+    _Exit(0); // 任务线程仍阻塞在内核中，直接退出而不析构全局对象
+}
@@ -0,0 +1,29 @@
+// 模糊测试: MQTT 订阅回调 mqttCallback (JSON 解析、processStroke、processReset)
+// 输入第一个字节选择主题 (0: firenote/strokes，1: firenote/control，其他: 未订阅的主题)，其余字节为负载。
+// 消息经 PubSubClient::loop() 在主循环中交给回调，与设备上的路径相同；之后检查绘图历史。
+
+#include "fuzz_common.h"
+#include "host_io.h"
+#include "host_kernel.h"
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    fuzzBoot(true);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size == 0)
+        return 0;
+    static const char *const topics[] = {"firenote/strokes", "firenote/control", "firenote/other"};
+    const char *topic = topics[data[0] < 2 ? data[0] : 2];
+
+    hostMqttInject("firenote/control", (const uint8_t *)"reset", 5);
+    hostMqttInject(topic, data + 1, size - 1);
+    hostRunFor(FUZZ_SETTLE_MS * 1000ULL);
+    fuzzCheckHistory("fuzz_mqtt_callback");
+    return 0;
+}
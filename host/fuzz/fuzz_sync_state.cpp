@@ -0,0 +1,71 @@
+// 模糊测试: ESP-NOW 同步状态机 (多个对端交错发送的消息序列)
+// 输入是若干步，每步:
+//   1 字节  距上一步的虚拟时间 (毫秒)
+//   1 字节  低 2 位选择 4 个对端 MAC 之一；第 2 位为 1 时发送图块帧 (RasterTileMessage_t)，否则发送 SyncMessage_t；
+//           高 5 位为消息类型 (大于 MSG_TYPE_RASTER_TILE 的值用于测试未知类型)
+//   其余    帧中类型字段之后的内容 (输入不足时补零，并结束)
+// 每步之后检查绘图历史；全部送完后静默 SYNC_RECEIVE_TIMEOUT_MS 以上，节点不能停在请求/接收全量同步的状态
+// (否则它会一直忽略对端的实时点，也不再发起新的同步)。
+
+#include "fuzz_common.h"
+#include "esp_now_handler.h"
+#include "host_kernel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define FUZZ_SYNC_MAX_STEPS 64
+
+static const uint8_t peerMacs[4][6] = {
+    {0x02, 0x00, 0x00, 0x00, 0x00, 0x10},
+    {0x02, 0x00, 0x00, 0x00, 0x00, 0x20},
+    {0x02, 0x00, 0x00, 0x00, 0x00, 0x30},
+    {0x02, 0x00, 0x00, 0x00, 0x00, 0x40},
+};
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    fuzzBoot(false);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    fuzzResetCanvas();
+
+    size_t pos = 0;
+    for (int step = 0; step < FUZZ_SYNC_MAX_STEPS && pos + 2 <= size; step++)
+    {
+        uint32_t delayMs = data[pos];
+        uint8_t control = data[pos + 1];
+        pos += 2;
+
+        size_t len = (control & 0x04) ? sizeof(RasterTileMessage_t) : sizeof(SyncMessage_t);
+        std::vector<uint8_t> frame(len, 0);
+        int type = control >> 3;
+        memcpy(frame.data(), &type, sizeof(type));
+        size_t body = std::min(len - sizeof(type), size - pos);
+        memcpy(frame.data() + sizeof(type), data + pos, body);
+        pos += body;
+
+        hostRunFor(delayMs * 1000ULL);
+        fuzzDeliver(peerMacs[control & 0x03], frame.data(), frame.size(), 1);
+        fuzzCheckHistory("fuzz_sync_state");
+    }
+
+    hostRunFor((SYNC_RECEIVE_TIMEOUT_MS + 2 * HEARTBEAT_CHECK_INTERVAL_MS) * 1000ULL);
+    fuzzCheckHistory("fuzz_sync_state");
+    if (iamRequestingAllData || isReceivingDrawingData)
+    {
+        fprintf(stderr, "fuzz_sync_state: stuck after %lums of silence (requesting %d, receiving %d, awaiting start %d)\n",
+                (unsigned long)SYNC_RECEIVE_TIMEOUT_MS, iamRequestingAllData, isReceivingDrawingData,
+                isAwaitingSyncStartResponse);
+        abort();
+    }
+    return 0;
+}
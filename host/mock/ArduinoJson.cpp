@@ -0,0 +1,602 @@
+#include "ArduinoJson.h"
+
+#include <errno.h>
+
+using namespace ArduinoJsonHost;
+
+static Node makeNode(NodeType_e type)
+{
+    Node n;
+    n.type = type;
+    n.intValue = 0;
+    n.floatValue = 0;
+    n.firstChild = -1;
+    n.lastChild = -1;
+    n.next = -1;
+    n.childCount = 0;
+    return n;
+}
+
+// 把节点重置为标量 (原来的子节点不再可达，占用的槽与库中一样不回收)
+static void resetNode(Node &n, NodeType_e type)
+{
+    n.type = type;
+    n.intValue = 0;
+    n.floatValue = 0;
+    n.text.clear();
+    n.firstChild = -1;
+    n.lastChild = -1;
+    n.childCount = 0;
+}
+
+// --- JsonDocument ---
+
+JsonDocument::JsonDocument(size_t capacityBytes)
+    : slotCapacity(capacityBytes / ARDUINOJSON_HOST_SLOT_BYTES), overflow(false)
+{
+    nodes.reserve(slotCapacity + 1);
+    nodes.push_back(makeNode(NODE_NULL));
+}
+
+void JsonDocument::clear()
+{
+    nodes.resize(1);
+    nodes[0] = makeNode(NODE_NULL);
+    overflow = false;
+}
+
+int JsonDocument::allocate(int parent, const char *key)
+{
+    if (nodes.size() - 1 >= slotCapacity)
+    {
+        overflow = true;
+        return -1;
+    }
+    int index = (int)nodes.size();
+    nodes.push_back(makeNode(NODE_NULL));
+    if (key != nullptr)
+        nodes[index].key = key;
+    Node &p = nodes[parent];
+    if (p.lastChild >= 0)
+        nodes[p.lastChild].next = index;
+    else
+        p.firstChild = index;
+    p.lastChild = index;
+    p.childCount++;
+    return index;
+}
+
+JsonArray JsonDocument::createNestedArray(const char *key)
+{
+    JsonVariant member = (*this)[key];
+    member.setInteger(0); // 先创建成员
+    JsonVariant created = (*this)[key];
+    if (created.nodeIndex() < 0)
+        return JsonArray();
+    resetNode(nodes[created.nodeIndex()], NODE_ARRAY);
+    return JsonArray(this, created.nodeIndex());
+}
+
+JsonObject JsonDocument::createNestedObject(const char *key)
+{
+    JsonVariant member = (*this)[key];
+    member.setInteger(0);
+    JsonVariant created = (*this)[key];
+    if (created.nodeIndex() < 0)
+        return JsonObject();
+    resetNode(nodes[created.nodeIndex()], NODE_OBJECT);
+    return JsonObject(this, created.nodeIndex());
+}
+
+// --- JsonVariant ---
+
+bool JsonVariant::isNull() const
+{
+    return doc == nullptr || node < 0 || doc->at(node).type == NODE_NULL;
+}
+
+JsonVariant JsonVariant::operator[](const char *memberKey) const
+{
+    if (doc == nullptr || node < 0)
+        return JsonVariant();
+    const Node &n = doc->at(node);
+    if (n.type == NODE_OBJECT)
+    {
+        for (int child = n.firstChild; child >= 0; child = doc->at(child).next)
+        {
+            if (doc->at(child).key == memberKey)
+                return JsonVariant(doc, child);
+        }
+    }
+    if (n.type == NODE_OBJECT || n.type == NODE_NULL)
+        return JsonVariant(doc, -1, node, memberKey); // 赋值时创建
+    return JsonVariant();
+}
+
+JsonVariant JsonVariant::operator[](size_t index) const
+{
+    if (doc == nullptr || node < 0 || doc->at(node).type != NODE_ARRAY)
+        return JsonVariant();
+    int child = doc->at(node).firstChild;
+    for (size_t i = 0; child >= 0 && i < index; i++)
+        child = doc->at(child).next;
+    return child >= 0 ? JsonVariant(doc, child) : JsonVariant();
+}
+
+size_t JsonVariant::size() const
+{
+    if (doc == nullptr || node < 0)
+        return 0;
+    const Node &n = doc->at(node);
+    return (n.type == NODE_ARRAY || n.type == NODE_OBJECT) ? n.childCount : 0;
+}
+
+int JsonVariant::resolveForWrite()
+{
+    if (doc == nullptr)
+        return -1;
+    if (node >= 0)
+        return node;
+    if (parent < 0)
+        return -1;
+    Node &p = doc->at(parent);
+    if (p.type == NODE_NULL)
+        resetNode(p, NODE_OBJECT);
+    if (p.type != NODE_OBJECT)
+        return -1;
+    node = doc->allocate(parent, key.c_str());
+    return node;
+}
+
+bool JsonVariant::setInteger(int64_t value)
+{
+    int index = resolveForWrite();
+    if (index < 0)
+        return false;
+    Node &n = doc->at(index);
+    resetNode(n, NODE_INT);
+    n.intValue = value;
+    return true;
+}
+
+bool JsonVariant::setFloat(double value)
+{
+    int index = resolveForWrite();
+    if (index < 0)
+        return false;
+    Node &n = doc->at(index);
+    resetNode(n, NODE_FLOAT);
+    n.floatValue = value;
+    return true;
+}
+
+bool JsonVariant::setBool(bool value)
+{
+    int index = resolveForWrite();
+    if (index < 0)
+        return false;
+    Node &n = doc->at(index);
+    resetNode(n, NODE_BOOL);
+    n.intValue = value ? 1 : 0;
+    return true;
+}
+
+bool JsonVariant::setString(const char *value)
+{
+    int index = resolveForWrite();
+    if (index < 0)
+        return false;
+    Node &n = doc->at(index);
+    if (value == nullptr)
+    {
+        resetNode(n, NODE_NULL);
+        return true;
+    }
+    resetNode(n, NODE_STRING);
+    n.text = value;
+    return true;
+}
+
+// --- JsonArray ---
+
+JsonVariant JsonArray::addSlot()
+{
+    if (doc == nullptr || node < 0)
+        return JsonVariant();
+    int index = doc->allocate(node, nullptr);
+    return index >= 0 ? JsonVariant(doc, index) : JsonVariant();
+}
+
+size_t JsonArray::size() const
+{
+    return JsonVariant(doc, node).size();
+}
+
+JsonVariant JsonArray::operator[](size_t index) const
+{
+    return JsonVariant(doc, node)[index];
+}
+
+const char *DeserializationError::c_str() const
+{
+    static const char *const names[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep"};
+    return names[errorCode];
+}
+
+// --- 序列化 ---
+
+static void writeString(std::string &out, const std::string &text)
+{
+    out += '"';
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\b':
+            out += "\\b";
+            break;
+        case '\f':
+            out += "\\f";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+static void writeNode(JsonDocument &doc, int index, std::string &out)
+{
+    const Node &n = doc.at(index);
+    char number[32];
+    switch (n.type)
+    {
+    case NODE_NULL:
+        out += "null";
+        break;
+    case NODE_BOOL:
+        out += n.intValue ? "true" : "false";
+        break;
+    case NODE_INT:
+        snprintf(number, sizeof(number), "%lld", (long long)n.intValue);
+        out += number;
+        break;
+    case NODE_FLOAT:
+        snprintf(number, sizeof(number), "%.9g", n.floatValue);
+        out += number;
+        break;
+    case NODE_STRING:
+        writeString(out, n.text);
+        break;
+    case NODE_ARRAY:
+    case NODE_OBJECT:
+        out += n.type == NODE_ARRAY ? '[' : '{';
+        for (int child = n.firstChild; child >= 0; child = doc.at(child).next)
+        {
+            if (child != n.firstChild)
+                out += ',';
+            if (n.type == NODE_OBJECT)
+            {
+                writeString(out, doc.at(child).key);
+                out += ':';
+            }
+            writeNode(doc, child, out);
+        }
+        out += n.type == NODE_ARRAY ? ']' : '}';
+        break;
+    }
+}
+
+size_t serializeJson(JsonDocument &doc, char *buffer, size_t size)
+{
+    std::string out;
+    writeNode(doc, 0, out);
+    if (size == 0)
+        return 0;
+    size_t n = std::min(out.size(), size - 1); // 与库相同: 缓冲区不够时截断，总是以 '\0' 结尾
+    memcpy(buffer, out.data(), n);
+    buffer[n] = '\0';
+    return n;
+}
+
+size_t measureJson(JsonDocument &doc)
+{
+    std::string out;
+    writeNode(doc, 0, out);
+    return out.size();
+}
+
+// --- 解析 ---
+
+namespace
+{
+class Parser
+{
+public:
+    Parser(JsonDocument &doc, const char *input, size_t length) : doc(doc), p(input), end(input + length) {}
+
+    DeserializationError parseDocument()
+    {
+        skipSpace();
+        if (p >= end || *p == '\0')
+            return DeserializationError::EmptyInput;
+        DeserializationError err = parseValue(0, 0);
+        return err;
+    }
+
+private:
+    void skipSpace()
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            p++;
+    }
+
+    bool atEnd() const { return p >= end || *p == '\0'; }
+
+    DeserializationError parseValue(int index, int depth)
+    {
+        skipSpace();
+        if (atEnd())
+            return DeserializationError::IncompleteInput;
+        char c = *p;
+        if (c == '{' || c == '[')
+        {
+            if (depth >= ARDUINOJSON_DEFAULT_NESTING_LIMIT)
+                return DeserializationError::TooDeep;
+            return c == '{' ? parseObject(index, depth + 1) : parseArray(index, depth + 1);
+        }
+        if (c == '"' || c == '\'')
+        {
+            std::string text;
+            DeserializationError err = parseString(text);
+            if (err)
+                return err;
+            Node &n = doc.at(index);
+            resetNode(n, NODE_STRING);
+            n.text = text;
+            return DeserializationError::Ok;
+        }
+        return parseLiteral(index);
+    }
+
+    DeserializationError parseObject(int index, int depth)
+    {
+        resetNode(doc.at(index), NODE_OBJECT);
+        p++; // '{'
+        skipSpace();
+        if (atEnd())
+            return DeserializationError::IncompleteInput;
+        if (*p == '}')
+        {
+            p++;
+            return DeserializationError::Ok;
+        }
+        for (;;)
+        {
+            skipSpace();
+            if (atEnd())
+                return DeserializationError::IncompleteInput;
+            std::string key;
+            DeserializationError err = (*p == '"' || *p == '\'') ? parseString(key) : parseBareKey(key);
+            if (err)
+                return err;
+            skipSpace();
+            if (atEnd())
+                return DeserializationError::IncompleteInput;
+            if (*p != ':')
+                return DeserializationError::InvalidInput;
+            p++;
+            int child = doc.allocate(index, key.c_str());
+            if (child < 0)
+                return DeserializationError::NoMemory;
+            err = parseValue(child, depth);
+            if (err)
+                return err;
+            skipSpace();
+            if (atEnd())
+                return DeserializationError::IncompleteInput;
+            if (*p == '}')
+            {
+                p++;
+                return DeserializationError::Ok;
+            }
+            if (*p != ',')
+                return DeserializationError::InvalidInput;
+            p++;
+        }
+    }
+
+    DeserializationError parseArray(int index, int depth)
+    {
+        resetNode(doc.at(index), NODE_ARRAY);
+        p++; // '['
+        skipSpace();
+        if (atEnd())
+            return DeserializationError::IncompleteInput;
+        if (*p == ']')
+        {
+            p++;
+            return DeserializationError::Ok;
+        }
+        for (;;)
+        {
+            int child = doc.allocate(index, nullptr);
+            if (child < 0)
+                return DeserializationError::NoMemory;
+            DeserializationError err = parseValue(child, depth);
+            if (err)
+                return err;
+            skipSpace();
+            if (atEnd())
+                return DeserializationError::IncompleteInput;
+            if (*p == ']')
+            {
+                p++;
+                return DeserializationError::Ok;
+            }
+            if (*p != ',')
+                return DeserializationError::InvalidInput;
+            p++;
+        }
+    }
+
+    DeserializationError parseString(std::string &out)
+    {
+        char quote = *p++;
+        while (!atEnd())
+        {
+            char c = *p++;
+            if (c == quote)
+                return DeserializationError::Ok;
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (atEnd())
+                return DeserializationError::IncompleteInput;
+            c = *p++;
+            switch (c)
+            {
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u':
+            {
+                if (end - p < 4)
+                    return DeserializationError::IncompleteInput;
+                unsigned code = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    char h = *p++;
+                    code <<= 4;
+                    if (h >= '0' && h <= '9')
+                        code |= h - '0';
+                    else if (h >= 'a' && h <= 'f')
+                        code |= h - 'a' + 10;
+                    else if (h >= 'A' && h <= 'F')
+                        code |= h - 'A' + 10;
+                    else
+                        return DeserializationError::InvalidInput;
+                }
+                // UTF-8 编码 (不处理代理对)
+                if (code < 0x80)
+                {
+                    out += (char)code;
+                }
+                else if (code < 0x800)
+                {
+                    out += (char)(0xC0 | (code >> 6));
+                    out += (char)(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    out += (char)(0xE0 | (code >> 12));
+                    out += (char)(0x80 | ((code >> 6) & 0x3F));
+                    out += (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:
+                out += c; // \" \\ \/ 以及库同样接受的其他字符
+            }
+        }
+        return DeserializationError::IncompleteInput;
+    }
+
+    // 与库相同，接受不带引号的键
+    DeserializationError parseBareKey(std::string &out)
+    {
+        while (!atEnd() && (isalnum((unsigned char)*p) || *p == '_'))
+            out += *p++;
+        if (out.empty())
+            return atEnd() ? DeserializationError::IncompleteInput : DeserializationError::InvalidInput;
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError parseLiteral(int index)
+    {
+        std::string token;
+        while (!atEnd() && (isalnum((unsigned char)*p) || *p == '+' || *p == '-' || *p == '.'))
+            token += *p++;
+        if (token.empty())
+            return DeserializationError::InvalidInput;
+        Node &n = doc.at(index);
+        if (token == "null")
+        {
+            resetNode(n, NODE_NULL);
+            return DeserializationError::Ok;
+        }
+        if (token == "true" || token == "false")
+        {
+            resetNode(n, NODE_BOOL);
+            n.intValue = token == "true";
+            return DeserializationError::Ok;
+        }
+        char *parsedEnd = nullptr;
+        bool isInteger = token.find_first_of(".eE") == std::string::npos;
+        if (isInteger)
+        {
+            errno = 0;
+            long long value = strtoll(token.c_str(), &parsedEnd, 10);
+            if (*parsedEnd == '\0' && errno == 0)
+            {
+                resetNode(n, NODE_INT);
+                n.intValue = value;
+                return DeserializationError::Ok;
+            }
+        }
+        double value = strtod(token.c_str(), &parsedEnd);
+        if (*parsedEnd != '\0')
+            return DeserializationError::InvalidInput;
+        resetNode(n, NODE_FLOAT);
+        n.floatValue = value;
+        return DeserializationError::Ok;
+    }
+
+    JsonDocument &doc;
+    const char *p;
+    const char *end;
+};
+} // namespace
+
+DeserializationError deserializeJson(JsonDocument &doc, const char *input, size_t length)
+{
+    doc.clear();
+    if (input == nullptr)
+        return DeserializationError::EmptyInput;
+    Parser parser(doc, input, length);
+    return parser.parseDocument();
+}
+
+DeserializationError deserializeJson(JsonDocument &doc, const char *input)
+{
+    return deserializeJson(doc, input, input ? strlen(input) : 0);
+}
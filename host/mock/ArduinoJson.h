@@ -0,0 +1,329 @@
+#pragma once
+// ArduinoJson 6 的最小主机替身，只实现固件用到的部分 (StaticJsonDocument、JsonVariant/JsonArray/JsonObject、
+// serializeJson、deserializeJson)。容量按 ESP32 上每个值占一个 16 字节的槽计算，超出容量时 add 失败、
+// 解析返回 NoMemory，与设备上的截断行为一致；整数转换超出目标类型范围时得到 0 (与库相同)。
+// 需要与真实库逐字节一致时，配置 CMake 时用 -DARDUINOJSON_DIR=<ArduinoJson/src> 改用真实库。
+#include <Arduino.h>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#define ARDUINOJSON_HOST_SLOT_BYTES 16 // ESP32 上 sizeof(VariantSlot)
+#define ARDUINOJSON_DEFAULT_NESTING_LIMIT 10
+
+class JsonDocument;
+class JsonArray;
+class JsonObject;
+
+namespace ArduinoJsonHost
+{
+enum NodeType_e
+{
+    NODE_NULL,
+    NODE_BOOL,
+    NODE_INT,
+    NODE_FLOAT,
+    NODE_STRING,
+    NODE_ARRAY,
+    NODE_OBJECT
+};
+
+struct Node
+{
+    NodeType_e type;
+    int64_t intValue;
+    double floatValue;
+    std::string text; // 字符串值
+    std::string key;  // 对象成员的键
+    int firstChild;
+    int lastChild;
+    int next;
+    size_t childCount;
+};
+} // namespace ArduinoJsonHost
+
+class JsonVariant
+{
+public:
+    JsonVariant() : doc(nullptr), node(-1), parent(-1) {}
+    JsonVariant(JsonDocument *doc, int node, int parent = -1, const char *key = nullptr)
+        : doc(doc), node(node), parent(parent), key(key ? key : "")
+    {
+    }
+
+    bool isNull() const;
+    template <typename T> T as() const;
+    template <typename T> bool is() const;
+    template <typename T> operator T() const { return as<T>(); }
+
+    template <typename T> JsonVariant &operator=(const T &value)
+    {
+        set(value);
+        return *this;
+    }
+    JsonVariant &operator=(const JsonVariant &) = delete;
+
+    JsonVariant operator[](size_t index) const;
+    JsonVariant operator[](int index) const { return (*this)[(size_t)index]; }
+    JsonVariant operator[](const char *key) const;
+    size_t size() const;
+
+    // 内部使用
+    bool setInteger(int64_t value);
+    bool setFloat(double value);
+    bool setBool(bool value);
+    bool setString(const char *value);
+    int nodeIndex() const { return node; }
+    JsonDocument *document() const { return doc; }
+
+private:
+    template <typename T> void set(const T &value)
+    {
+        if constexpr (std::is_same<T, bool>::value)
+            setBool(value);
+        else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value)
+            setInteger((int64_t)value);
+        else if constexpr (std::is_floating_point<T>::value)
+            setFloat((double)value);
+        else
+            static_assert(std::is_arithmetic<T>::value, "unsupported JSON value type");
+    }
+    void set(const char *value) { setString(value); }
+    void set(const String &value) { setString(value.c_str()); }
+    int resolveForWrite();
+
+    JsonDocument *doc;
+    int node;   // -1: 尚不存在的成员 (赋值时创建)
+    int parent; // 尚不存在的成员所属的对象
+    std::string key;
+};
+
+class JsonArray
+{
+public:
+    JsonArray() : doc(nullptr), node(-1) {}
+    JsonArray(JsonDocument *doc, int node) : doc(doc), node(node) {}
+
+    template <typename T> bool add(const T &value)
+    {
+        JsonVariant slot = addSlot();
+        if (slot.nodeIndex() < 0)
+            return false;
+        slot = value;
+        return true;
+    }
+    size_t size() const;
+    JsonVariant operator[](size_t index) const;
+    JsonVariant operator[](int index) const { return (*this)[(size_t)index]; }
+    bool isNull() const { return doc == nullptr || node < 0; }
+    operator JsonVariant() const { return JsonVariant(doc, node); }
+
+private:
+    JsonVariant addSlot();
+    JsonDocument *doc;
+    int node;
+};
+
+class JsonObject
+{
+public:
+    JsonObject() : doc(nullptr), node(-1) {}
+    JsonObject(JsonDocument *doc, int node) : doc(doc), node(node) {}
+
+    JsonVariant operator[](const char *key) const { return JsonVariant(doc, node)[key]; }
+    bool containsKey(const char *key) const { return !(*this)[key].isNull(); }
+    bool isNull() const { return doc == nullptr || node < 0; }
+    size_t size() const { return JsonVariant(doc, node).size(); }
+    operator JsonVariant() const { return JsonVariant(doc, node); }
+
+private:
+    JsonDocument *doc;
+    int node;
+};
+
+class DeserializationError
+{
+public:
+    enum Code
+    {
+        Ok,
+        EmptyInput,
+        IncompleteInput,
+        InvalidInput,
+        NoMemory,
+        TooDeep
+    };
+    DeserializationError(Code code = Ok) : errorCode(code) {}
+    explicit operator bool() const { return errorCode != Ok; }
+    bool operator==(Code code) const { return errorCode == code; }
+    bool operator!=(Code code) const { return errorCode != code; }
+    Code code() const { return errorCode; }
+    const char *c_str() const;
+
+private:
+    Code errorCode;
+};
+
+class JsonDocument
+{
+public:
+    explicit JsonDocument(size_t capacityBytes);
+
+    JsonVariant operator[](const char *key) { return JsonVariant(this, 0)[key]; }
+    JsonVariant operator[](size_t index) { return JsonVariant(this, 0)[index]; }
+    JsonArray createNestedArray(const char *key);
+    JsonObject createNestedObject(const char *key);
+    template <typename T> T as() { return JsonVariant(this, 0).as<T>(); }
+    template <typename T> bool is() { return JsonVariant(this, 0).is<T>(); }
+    bool isNull() const { return nodes[0].type == ArduinoJsonHost::NODE_NULL; }
+    void clear();
+    size_t memoryUsage() const { return (nodes.size() - 1) * ARDUINOJSON_HOST_SLOT_BYTES; }
+    size_t capacity() const { return slotCapacity * ARDUINOJSON_HOST_SLOT_BYTES; }
+    bool overflowed() const { return overflow; }
+
+    // 内部使用
+    ArduinoJsonHost::Node &at(int index) { return nodes[index]; }
+    int allocate(int parent, const char *key); // 在 parent (数组或对象) 末尾追加一个空值，容量不足返回 -1
+
+private:
+    std::vector<ArduinoJsonHost::Node> nodes; // nodes[0] 为根，不占容量
+    size_t slotCapacity;
+    bool overflow;
+};
+
+template <size_t N> class StaticJsonDocument : public JsonDocument
+{
+public:
+    StaticJsonDocument() : JsonDocument(N) {}
+};
+
+class DynamicJsonDocument : public JsonDocument
+{
+public:
+    explicit DynamicJsonDocument(size_t capacity) : JsonDocument(capacity) {}
+};
+
+size_t serializeJson(JsonDocument &doc, char *buffer, size_t size);
+template <size_t N> size_t serializeJson(JsonDocument &doc, char (&buffer)[N])
+{
+    return serializeJson(doc, buffer, N);
+}
+size_t measureJson(JsonDocument &doc);
+DeserializationError deserializeJson(JsonDocument &doc, const char *input, size_t length);
+DeserializationError deserializeJson(JsonDocument &doc, const char *input);
+inline DeserializationError deserializeJson(JsonDocument &doc, const uint8_t *input, size_t length)
+{
+    return deserializeJson(doc, (const char *)input, length);
+}
+
+// --- 类型转换 ---
+
+namespace ArduinoJsonHost
+{
+template <typename T, typename Enable = void> struct Converter;
+
+template <typename T> struct Converter<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+{
+    static T from(const Node *n)
+    {
+        if (n == nullptr)
+            return 0;
+        if (n->type == NODE_INT)
+        {
+            // 超出目标类型范围时返回 0
+            if (std::is_signed<T>::value)
+            {
+                if (n->intValue < (int64_t)std::numeric_limits<T>::min() || n->intValue > (int64_t)std::numeric_limits<T>::max())
+                    return 0;
+            }
+            else if (n->intValue < 0 || (uint64_t)n->intValue > (uint64_t)std::numeric_limits<T>::max())
+            {
+                return 0;
+            }
+            return (T)n->intValue;
+        }
+        if (n->type == NODE_FLOAT)
+        {
+            double v = n->floatValue;
+            if (!(v >= (double)std::numeric_limits<T>::min() && v <= (double)std::numeric_limits<T>::max()))
+                return 0;
+            return (T)v;
+        }
+        if (n->type == NODE_BOOL)
+            return (T)n->intValue;
+        return 0;
+    }
+    static bool is(const Node *n)
+    {
+        return n != nullptr && n->type == NODE_INT && (int64_t)from(n) == n->intValue;
+    }
+};
+
+template <typename T> struct Converter<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static T from(const Node *n)
+    {
+        if (n == nullptr)
+            return 0;
+        if (n->type == NODE_FLOAT)
+            return (T)n->floatValue;
+        if (n->type == NODE_INT)
+            return (T)n->intValue;
+        return 0;
+    }
+    static bool is(const Node *n) { return n != nullptr && (n->type == NODE_FLOAT || n->type == NODE_INT); }
+};
+
+template <> struct Converter<bool>
+{
+    static bool from(const Node *n) { return n != nullptr && n->type == NODE_BOOL && n->intValue != 0; }
+    static bool is(const Node *n) { return n != nullptr && n->type == NODE_BOOL; }
+};
+
+template <> struct Converter<const char *>
+{
+    static const char *from(const Node *n) { return n != nullptr && n->type == NODE_STRING ? n->text.c_str() : nullptr; }
+    static bool is(const Node *n) { return n != nullptr && n->type == NODE_STRING; }
+};
+
+template <> struct Converter<String>
+{
+    static String from(const Node *n) { return String(n != nullptr && n->type == NODE_STRING ? n->text.c_str() : "null"); }
+    static bool is(const Node *n) { return n != nullptr && n->type == NODE_STRING; }
+};
+} // namespace ArduinoJsonHost
+
+template <typename T> T JsonVariant::as() const
+{
+    const ArduinoJsonHost::Node *n = (doc != nullptr && node >= 0) ? &doc->at(node) : nullptr;
+    return ArduinoJsonHost::Converter<T>::from(n);
+}
+
+template <typename T> bool JsonVariant::is() const
+{
+    const ArduinoJsonHost::Node *n = (doc != nullptr && node >= 0) ? &doc->at(node) : nullptr;
+    return ArduinoJsonHost::Converter<T>::is(n);
+}
+
+template <> inline JsonArray JsonVariant::as<JsonArray>() const
+{
+    bool isArray = doc != nullptr && node >= 0 && doc->at(node).type == ArduinoJsonHost::NODE_ARRAY;
+    return isArray ? JsonArray(doc, node) : JsonArray();
+}
+
+template <> inline JsonObject JsonVariant::as<JsonObject>() const
+{
+    bool isObject = doc != nullptr && node >= 0 && doc->at(node).type == ArduinoJsonHost::NODE_OBJECT;
+    return isObject ? JsonObject(doc, node) : JsonObject();
+}
+
+template <> inline bool JsonVariant::is<JsonArray>() const
+{
+    return !as<JsonArray>().isNull();
+}
+
+template <> inline bool JsonVariant::is<JsonObject>() const
+{
+    return !as<JsonObject>().isNull();
+}
@@ -0,0 +1,51 @@
+#pragma once
+// LittleFS 的主机替身: 文件保存在内存中，可用 hostFsSetDirectory 映射到主机目录 (挂载时读入，关闭写入的文件时写回)。
+// 容量与默认分区表的 spiffs 分区相同，写满后 write 返回的字节数小于请求
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+#define LITTLEFS_HOST_PARTITION_BYTES 0x160000
+#define LITTLEFS_HOST_BLOCK_BYTES 4096
+
+struct HostOpenFile;
+
+class File
+{
+public:
+    File() {}
+    explicit File(std::shared_ptr<HostOpenFile> state) : state(std::move(state)) {}
+    size_t write(const uint8_t *buf, size_t size);
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t read(uint8_t *buf, size_t size);
+    int read();
+    int available();
+    size_t size() const;
+    size_t position() const;
+    bool seek(uint32_t pos);
+    void flush() {}
+    void close();
+    operator bool() const { return state != nullptr; }
+
+private:
+    std::shared_ptr<HostOpenFile> state;
+};
+
+class LittleFSFS
+{
+public:
+    bool begin(bool formatOnFail = false, const char *basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char *partitionLabel = "spiffs");
+    void end() {}
+    bool format();
+    File open(const char *path, const char *mode = FILE_READ, const bool create = false);
+    bool exists(const char *path);
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+    size_t totalBytes();
+    size_t usedBytes();
+};
+extern LittleFSFS LittleFS;
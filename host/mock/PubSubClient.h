@@ -0,0 +1,43 @@
+#pragma once
+// PubSubClient 的主机替身: WiFi 连上 (hostWifiSetAvailable) 时 connect 成功；发布交给 hostMqttSetPublishHook，
+// hostMqttInject 注入的消息在 loop() 中交给回调。与库相同，超过缓冲区大小的消息发布失败
+#include <Arduino.h>
+#include <functional>
+
+#ifndef MQTT_MAX_PACKET_SIZE
+#define MQTT_MAX_PACKET_SIZE 256
+#endif
+#define MQTT_MAX_HEADER_SIZE 5
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTED 0
+
+class WiFiClient;
+
+class PubSubClient
+{
+public:
+    PubSubClient(WiFiClient &c) : bufferSize(MQTT_MAX_PACKET_SIZE), isConnected(false) { (void)c; }
+    PubSubClient &setServer(const char *domain, uint16_t port);
+    PubSubClient &setCallback(std::function<void(char *, uint8_t *, unsigned int)> cb);
+    bool setBufferSize(uint16_t size);
+    bool connect(const char *id, const char *user, const char *pass);
+    void disconnect() { isConnected = false; }
+    bool connected();
+    int state();
+    bool loop();
+    bool subscribe(const char *topic);
+    bool publish(const char *topic, const char *payload);
+    bool publish(const char *topic, const char *payload, bool retained);
+    bool publish(const char *topic, const uint8_t *payload, unsigned int plength);
+    bool publish(const char *topic, const uint8_t *payload, unsigned int plength, bool retained)
+    {
+        (void)retained;
+        return publish(topic, payload, plength);
+    }
+
+private:
+    uint16_t bufferSize;
+    bool isConnected;
+    std::function<void(char *, uint8_t *, unsigned int)> callback;
+};
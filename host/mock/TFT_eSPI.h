@@ -0,0 +1,128 @@
+#pragma once
+// TFT_eSPI 的主机替身: 内存中的 RGB565 帧缓冲 (ILI9341 240x320，按 setRotation 旋转)。
+// 图形原语按 TFT_eSPI/Adafruit GFX 的算法逐像素实现 (drawLine 与设备上画出的像素完全相同)，支持视口裁剪。
+// 文字不绘制字形，只在背景色与前景色不同时填充文字所占的格子 (与设备上的背景填充范围相近)。
+#include <Arduino.h>
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_DARKGREEN 0x03E0
+#define TFT_DARKCYAN 0x03EF
+#define TFT_MAROON 0x7800
+#define TFT_PURPLE 0x780F
+#define TFT_OLIVE 0x7BE0
+#define TFT_LIGHTGREY 0xD69A
+#define TFT_DARKGREY 0x7BEF
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_MAGENTA 0xF81F
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+#define TFT_ORANGE 0xFDA0
+#define TFT_GREENYELLOW 0xB7E0
+#define TFT_PINK 0xFE19
+#define TFT_BROWN 0x9A60
+#define TFT_GOLD 0xFEA0
+#define TFT_SILVER 0xC618
+#define TFT_SKYBLUE 0x867D
+#define TFT_VIOLET 0x915C
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define MC_DATUM 4
+#define MR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+#define TFT_HOST_NATIVE_WIDTH 240
+#define TFT_HOST_NATIVE_HEIGHT 320
+
+class TFT_eSPI : public Print
+{
+public:
+    TFT_eSPI(int16_t w = TFT_HOST_NATIVE_WIDTH, int16_t h = TFT_HOST_NATIVE_HEIGHT);
+
+    void init(uint8_t tc = 0);
+    void begin(uint8_t tc = 0) { init(tc); }
+    void setRotation(uint8_t r);
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    void fillScreen(uint32_t color);
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    uint16_t readPixel(int32_t x, int32_t y);
+    void drawLine(int32_t xs, int32_t ys, int32_t xe, int32_t ye, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t radius, uint32_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t radius, uint32_t color);
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void drawArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle, uint32_t fg_color,
+                 uint32_t bg_color, bool smoothArc = true);
+    void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t fgcolor);
+    void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t fgcolor, uint16_t bgcolor);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+    void readRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data);
+    void setWindow(int32_t xs, int32_t ys, int32_t xe, int32_t ye);
+    void pushColor(uint16_t color, uint32_t len = 1);
+    void pushColors(const uint16_t *data, uint32_t len, bool swap = true);
+    void startWrite() {}
+    void endWrite() {}
+
+    // vpDatum 为 true 时坐标相对视口左上角，否则仍为屏幕坐标；两种情况都裁剪到视口内
+    void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum = true);
+    void resetViewport();
+
+    void setTextColor(uint16_t color);
+    void setTextColor(uint16_t fgcolor, uint16_t bgcolor, bool bgfill = false);
+    void setTextDatum(uint8_t datum) { textDatum = datum; }
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextFont(uint8_t font) { textFont = font; }
+    void setCursor(int16_t x, int16_t y);
+    void setCursor(int16_t x, int16_t y, uint8_t font);
+    int16_t drawString(const char *string, int32_t x, int32_t y, uint8_t font);
+    int16_t drawString(const char *string, int32_t x, int32_t y);
+    int16_t drawString(const String &string, int32_t x, int32_t y, uint8_t font);
+    int16_t drawString(const String &string, int32_t x, int32_t y);
+    void drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size);
+    int16_t drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font);
+    int16_t textWidth(const char *string, uint8_t font);
+    int16_t textWidth(const char *string) { return textWidth(string, textFont); }
+    int16_t fontHeight(int16_t font);
+    int16_t fontHeight() { return fontHeight(textFont); }
+    uint16_t color565(uint8_t red, uint8_t green, uint8_t blue);
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // 主机专用: 帧缓冲 (width() x height()，按行存放) 和绘图调用计数
+    const uint16_t *framebuffer() const { return pixels; }
+    uint32_t drawCalls() const { return drawCallCount; }
+
+private:
+    void plot(int32_t x, int32_t y, uint16_t color);     // 视口坐标 -> 屏幕坐标并裁剪
+    void fillSpan(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void circleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t corners, uint16_t color);
+    void fillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t corners, int32_t delta, uint16_t color);
+    int charWidth(uint8_t font) const;
+    void drawTextBox(int32_t x, int32_t y, int32_t w, int32_t h);
+
+    uint16_t pixels[TFT_HOST_NATIVE_WIDTH * TFT_HOST_NATIVE_HEIGHT];
+    int16_t _init_width, _init_height;
+    int16_t _width, _height;
+    int32_t vpX, vpY, vpW, vpH;      // 视口裁剪区域 (屏幕坐标)
+    int32_t originX, originY;        // 绘图坐标原点 (vpDatum 为 true 时为视口左上角)
+    int32_t winX0, winY0, winX1, winY1, winX, winY; // setWindow/pushColor 的写入窗口
+    uint16_t textColor, textBgColor;
+    uint8_t textDatum, textSize, textFont;
+    int32_t cursorX, cursorY;
+    uint32_t drawCallCount;
+};
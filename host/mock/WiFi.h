@@ -0,0 +1,42 @@
+#pragma once
+// WiFi 的主机替身: 默认连不上 (hostWifiSetAvailable 可改变)，不影响 ESP-NOW
+#include <Arduino.h>
+#include "esp_wifi.h"
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+} wl_status_t;
+
+#define WIFI_OFF 0
+#define WIFI_STA 1
+
+class IPAddress : public Printable
+{
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+    String toString() const;
+    size_t printTo(Print &p) const override;
+
+private:
+    uint8_t octets[4];
+};
+
+class WiFiClass
+{
+public:
+    bool mode(int m);
+    bool disconnect(bool wifioff = false);
+    wl_status_t begin(const char *ssid, const char *pass);
+    wl_status_t status();
+    IPAddress localIP();
+    String macAddress();
+    int channel();
+};
+extern WiFiClass WiFi;
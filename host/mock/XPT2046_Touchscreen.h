@@ -0,0 +1,30 @@
+#pragma once
+// XPT2046 的主机替身: 读数来自触摸脚本 (hostTouchAdd / hostTouchLoadScript)，脚本中的坐标是 getPoint() 返回的
+// 原始值 (已按 setRotation 旋转)。z >= XPT2046_HOST_Z_THRESHOLD 时 touched() 为真，z > 0 时 IRQ 为低电平
+#include <Arduino.h>
+#include <SPI.h>
+
+#define XPT2046_HOST_Z_THRESHOLD 400 // 与库中 Z_THRESHOLD 相同
+
+class TS_Point
+{
+public:
+    TS_Point() : x(0), y(0), z(0) {}
+    TS_Point(int16_t x, int16_t y, int16_t z) : x(x), y(y), z(z) {}
+    int16_t x, y, z;
+};
+
+class XPT2046_Touchscreen
+{
+public:
+    XPT2046_Touchscreen(uint8_t cspin, uint8_t tirq = 255);
+    bool begin(SPIClass &wspi);
+    TS_Point getPoint();
+    bool tirqTouched();
+    bool touched();
+    void readData(uint16_t *x, uint16_t *y, uint8_t *z);
+    void setRotation(uint8_t n) { rotation = n; }
+
+private:
+    uint8_t rotation;
+};
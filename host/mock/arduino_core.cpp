@@ -0,0 +1,591 @@
+#include "Arduino.h"
+#include "driver/gpio.h"
+#include "host_io.h"
+#include "host_kernel.h"
+#include "esp_heap_caps.h"
+
+#include <deque>
+#include <malloc.h>
+#include <map>
+#include <mutex>
+#include <stdarg.h>
+
+// --- String ---
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base)
+{
+    if (base < 2 || base > 36)
+        base = 10;
+    char buffer[72];
+    int pos = sizeof(buffer) - 1;
+    buffer[pos] = '\0';
+    do
+    {
+        int digit = (int)(value % base);
+        buffer[--pos] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10); // Arduino 的 HEX 输出为小写
+        value /= base;
+    } while (value > 0);
+    if (negative)
+        buffer[--pos] = '-';
+    return std::string(buffer + pos);
+}
+
+static std::string formatSigned(long long value, unsigned char base)
+{
+    if (value < 0 && base == 10)
+        return formatInteger((unsigned long long)(-(value + 1)) + 1, true, base);
+    return formatInteger((unsigned long long)value, false, base);
+}
+
+static std::string formatFloat(double value, unsigned int decimals)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+    return buffer;
+}
+
+String::String(const char *s) : s_(s ? s : "") {}
+String::String(const std::string &s) : s_(s) {}
+String::String(char c) : s_(1, c) {}
+String::String(int value, unsigned char base) : s_(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : s_(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : s_(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : s_(formatInteger(value, false, base)) {}
+String::String(float value, unsigned int decimals) : s_(formatFloat(value, decimals)) {}
+String::String(double value, unsigned int decimals) : s_(formatFloat(value, decimals)) {}
+
+String &String::operator+=(const String &other)
+{
+    s_ += other.s_;
+    return *this;
+}
+
+String &String::operator+=(const char *other)
+{
+    if (other)
+        s_ += other;
+    return *this;
+}
+
+String &String::operator+=(char c)
+{
+    s_ += c;
+    return *this;
+}
+
+bool String::concat(const String &other)
+{
+    s_ += other.s_;
+    return true;
+}
+
+String operator+(const String &a, const String &b)
+{
+    return String(a.s_ + b.s_);
+}
+
+String operator+(const String &a, const char *b)
+{
+    return String(a.s_ + (b ? b : ""));
+}
+
+long String::toInt() const
+{
+    return strtol(s_.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const
+{
+    return strtof(s_.c_str(), nullptr);
+}
+
+void String::trim()
+{
+    size_t begin = s_.find_first_not_of(" \t\r\n");
+    size_t end = s_.find_last_not_of(" \t\r\n");
+    s_ = begin == std::string::npos ? std::string() : s_.substr(begin, end - begin + 1);
+}
+
+void String::toUpperCase()
+{
+    for (char &c : s_)
+        c = (char)toupper((unsigned char)c);
+}
+
+void String::toLowerCase()
+{
+    for (char &c : s_)
+        c = (char)tolower((unsigned char)c);
+}
+
+bool String::startsWith(const String &prefix) const
+{
+    return s_.compare(0, prefix.s_.size(), prefix.s_) == 0;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    return s_.size() >= suffix.s_.size() && s_.compare(s_.size() - suffix.s_.size(), suffix.s_.size(), suffix.s_) == 0;
+}
+
+String String::substring(unsigned int from) const
+{
+    return from >= s_.size() ? String() : String(s_.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to)
+        std::swap(from, to);
+    if (from >= s_.size())
+        return String();
+    return String(s_.substr(from, std::min<size_t>(to, s_.size()) - from));
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t pos = s_.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &s, unsigned int from) const
+{
+    size_t pos = s_.find(s.s_, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+// --- Print ---
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+        n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(const char *s) { return write(s); }
+size_t Print::print(const String &s) { return write(s.c_str()); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(int value, int base) { return print(String(value, (unsigned char)base)); }
+size_t Print::print(unsigned int value, int base) { return print(String(value, (unsigned char)base)); }
+size_t Print::print(long value, int base) { return print(String(value, (unsigned char)base)); }
+size_t Print::print(unsigned long value, int base) { return print(String(value, (unsigned char)base)); }
+size_t Print::print(long long value, int base) { return print(String(formatSigned(value, (unsigned char)base))); }
+size_t Print::print(unsigned long long value, int base)
+{
+    return print(String(formatInteger(value, false, (unsigned char)base)));
+}
+size_t Print::print(double value, int digits) { return print(String(value, (unsigned int)digits)); }
+size_t Print::print(const Printable &value) { return value.printTo(*this); }
+
+size_t Print::println() { return write("\r\n"); }
+size_t Print::println(const char *s) { return print(s) + println(); }
+size_t Print::println(const String &s) { return print(s) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(int value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned int value, int base) { return print(value, base) + println(); }
+size_t Print::println(long value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned long value, int base) { return print(value, base) + println(); }
+size_t Print::println(long long value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned long long value, int base) { return print(value, base) + println(); }
+size_t Print::println(double value, int digits) { return print(value, digits) + println(); }
+size_t Print::println(const Printable &value) { return print(value) + println(); }
+
+size_t Print::printf(const char *format, ...)
+{
+    char stackBuffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+    va_end(args);
+    if (len < 0)
+        return 0;
+    if ((size_t)len < sizeof(stackBuffer))
+        return write((const uint8_t *)stackBuffer, len);
+    std::string heapBuffer(len + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&heapBuffer[0], heapBuffer.size(), format, args);
+    va_end(args);
+    return write((const uint8_t *)heapBuffer.data(), len);
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String result;
+    while (available() > 0)
+    {
+        int c = read();
+        if (c == terminator)
+            break;
+        result += (char)c;
+    }
+    return result;
+}
+
+// --- Serial ---
+
+static std::mutex serialLock;
+static std::function<void(const char *, size_t)> serialSink;
+static std::deque<char> serialInput;
+
+HardwareSerial Serial;
+
+void hostSerialSetSink(std::function<void(const char *data, size_t len)> sink)
+{
+    std::lock_guard<std::mutex> guard(serialLock);
+    serialSink = std::move(sink);
+}
+
+void hostSerialFeed(const char *text)
+{
+    std::lock_guard<std::mutex> guard(serialLock);
+    while (text && *text)
+        serialInput.push_back(*text++);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    std::lock_guard<std::mutex> guard(serialLock);
+    if (serialSink)
+        serialSink((const char *)buffer, size);
+    else
+        fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+int HardwareSerial::available()
+{
+    std::lock_guard<std::mutex> guard(serialLock);
+    return (int)serialInput.size();
+}
+
+int HardwareSerial::read()
+{
+    std::lock_guard<std::mutex> guard(serialLock);
+    if (serialInput.empty())
+        return -1;
+    char c = serialInput.front();
+    serialInput.pop_front();
+    return (unsigned char)c;
+}
+
+int HardwareSerial::peek()
+{
+    std::lock_guard<std::mutex> guard(serialLock);
+    return serialInput.empty() ? -1 : (unsigned char)serialInput.front();
+}
+
+// --- 时间 ---
+
+unsigned long millis()
+{
+    return (unsigned long)(hostClockRead() / 1000ULL);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)hostClockRead();
+}
+
+void delay(unsigned long ms)
+{
+    vTaskDelay((TickType_t)ms);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    hostSleepUntilUs(hostNowUs() + us);
+}
+
+void yield()
+{
+    hostYield();
+}
+
+int64_t esp_timer_get_time()
+{
+    return (int64_t)hostClockRead();
+}
+
+// --- 随机数 (固定种子，保证可重复) ---
+
+static uint32_t randomState = 0x12345678;
+
+void randomSeed(unsigned long seed)
+{
+    if (seed != 0)
+        randomState = (uint32_t)seed;
+}
+
+static uint32_t nextRandom()
+{
+    // xorshift32
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+long random(long howBig)
+{
+    return howBig <= 0 ? 0 : (long)(nextRandom() % (uint32_t)howBig);
+}
+
+long random(long howSmall, long howBig)
+{
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    // 与 Arduino-ESP32 3.x 的实现相同
+    const long run = inMax - inMin;
+    if (run == 0)
+        return -1;
+    const long rise = outMax - outMin;
+    const long delta = x - inMin;
+    return (delta * rise) / run + outMin;
+}
+
+// --- GPIO ---
+
+static std::mutex gpioLock;
+static std::map<uint8_t, int> gpioInputs;
+static std::map<uint8_t, int> gpioOutputs;
+
+void hostGpioSet(uint8_t pin, int level)
+{
+    std::lock_guard<std::mutex> guard(gpioLock);
+    gpioInputs[pin] = level;
+}
+
+int hostGpioOutput(uint8_t pin)
+{
+    std::lock_guard<std::mutex> guard(gpioLock);
+    auto it = gpioOutputs.find(pin);
+    return it == gpioOutputs.end() ? 0 : it->second;
+}
+
+// 触摸屏 IRQ 引脚的电平由触摸脚本决定 (见 xpt2046_mock.cpp)
+bool hostTouchIrqPin(uint8_t pin);
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (hostTouchIrqPin(pin))
+        return hostTouchIsDown() ? LOW : HIGH;
+    std::lock_guard<std::mutex> guard(gpioLock);
+    auto it = gpioInputs.find(pin);
+    return it == gpioInputs.end() ? HIGH : it->second;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    std::lock_guard<std::mutex> guard(gpioLock);
+    gpioOutputs[pin] = value;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    (void)pin;
+    return 2048; // 电池分压读数约为满量程的一半
+}
+
+uint32_t analogReadMilliVolts(uint8_t pin)
+{
+    return analogRead(pin) * 3300 / 4095;
+}
+
+void analogWrite(uint8_t pin, int value)
+{
+    std::lock_guard<std::mutex> guard(gpioLock);
+    gpioOutputs[pin] = value;
+}
+
+void analogWriteResolution(uint8_t pin, uint8_t bits)
+{
+    (void)pin;
+    (void)bits;
+}
+
+void analogWriteFrequency(uint8_t pin, uint32_t frequency)
+{
+    (void)pin;
+    (void)frequency;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode)
+{
+    (void)pin;
+    (void)isr;
+    (void)mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    (void)pin;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type)
+{
+    (void)gpio;
+    (void)type;
+    return ESP_OK;
+}
+
+// --- 堆 ---
+
+#define HOST_DEFAULT_HEAP_BYTES (320 * 1024) // 与 ESP32 (无 PSRAM) 启动后的堆总量相近
+
+static uint32_t heapSize = HOST_DEFAULT_HEAP_BYTES;
+static size_t heapBaseline = 0;
+static uint32_t minFreeHeap = UINT32_MAX;
+
+// 模拟的 PSRAM: 块仍来自主机 malloc，按块大小单独记账 (不计入内部堆)
+static uint32_t psramSize = 0;
+static uint32_t psramUsed = 0;
+static uint32_t minFreePsram = UINT32_MAX;
+static std::map<void *, size_t> psramBlocks;
+
+void hostHeapSetSize(uint32_t bytes)
+{
+    heapSize = bytes;
+}
+
+void hostPsramSetSize(uint32_t bytes)
+{
+    psramSize = bytes;
+}
+
+// 已用量 = 主机 malloc 在用字节数减去第一次查询时的基线 (排除替身和 C++ 运行时自己的分配) 和 PSRAM 块
+static uint32_t hostFreeHeap()
+{
+    struct mallinfo2 info = mallinfo2();
+    size_t internalUsed = info.uordblks + info.hblkhd - psramUsed; // hblkhd: glibc 用 mmap 分配的大块
+    if (heapBaseline == 0)
+        heapBaseline = internalUsed;
+    size_t used = internalUsed > heapBaseline ? internalUsed - heapBaseline : 0;
+    uint32_t free = used >= heapSize ? 0 : heapSize - (uint32_t)used;
+    if (free < minFreeHeap)
+        minFreeHeap = free;
+    return free;
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getFreeHeap() { return hostFreeHeap(); }
+uint32_t EspClass::getHeapSize() { return heapSize; }
+uint32_t EspClass::getMinFreeHeap()
+{
+    hostFreeHeap();
+    return minFreeHeap;
+}
+uint32_t EspClass::getMaxAllocHeap() { return hostFreeHeap() / 2; }
+uint32_t EspClass::getPsramSize() { return psramSize; }
+uint32_t EspClass::getFreePsram() { return psramSize - psramUsed; }
+uint32_t EspClass::getMinFreePsram() { return psramSize == 0 ? 0 : minFreePsram; }
+uint32_t EspClass::getMaxAllocPsram() { return psramSize - psramUsed; }
+
+void EspClass::restart()
+{
+    hostHalt("ESP.restart()");
+}
+
+uint32_t esp_get_free_heap_size()
+{
+    return hostFreeHeap();
+}
+
+uint32_t esp_get_minimum_free_heap_size()
+{
+    return ESP.getMinFreeHeap();
+}
+
+bool psramFound()
+{
+    return psramSize > 0;
+}
+
+void *ps_malloc(size_t size)
+{
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    if (!(caps & MALLOC_CAP_SPIRAM))
+        return malloc(size);
+    if (size > psramSize - psramUsed)
+        return nullptr;
+    void *ptr = malloc(size != 0 ? size : 1);
+    if (ptr == nullptr)
+        return nullptr;
+    psramBlocks[ptr] = size;
+    psramUsed += size;
+    if (psramSize - psramUsed < minFreePsram)
+        minFreePsram = psramSize - psramUsed;
+    return ptr;
+}
+
+void heap_caps_free(void *ptr)
+{
+    auto it = psramBlocks.find(ptr);
+    if (it != psramBlocks.end())
+    {
+        psramUsed -= it->second;
+        psramBlocks.erase(it);
+    }
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? psramSize - psramUsed : hostFreeHeap();
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? psramSize - psramUsed : ESP.getMaxAllocHeap();
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_ESPNOW_NOT_INIT:
+        return "ESP_ERR_ESPNOW_NOT_INIT";
+    case ESP_ERR_ESPNOW_ARG:
+        return "ESP_ERR_ESPNOW_ARG";
+    case ESP_ERR_ESPNOW_NO_MEM:
+        return "ESP_ERR_ESPNOW_NO_MEM";
+    case ESP_ERR_ESPNOW_FULL:
+        return "ESP_ERR_ESPNOW_FULL";
+    case ESP_ERR_ESPNOW_NOT_FOUND:
+        return "ESP_ERR_ESPNOW_NOT_FOUND";
+    case ESP_ERR_ESPNOW_EXIST:
+        return "ESP_ERR_ESPNOW_EXIST";
+    default:
+        return "UNKNOWN_ERROR";
+    }
+}
@@ -0,0 +1,22 @@
+#include "host_kernel.h"
+#include "freertos/task.h"
+
+// 由草图 (FireNote-ESP32.ino) 提供
+void setup();
+void loop();
+
+// 与 ESP32 Arduino 核心的 loopTask 相同: setup() 之后反复调用 loop()
+static void loopTask(void *)
+{
+    setup();
+    for (;;)
+    {
+        loop();
+        hostYield();
+    }
+}
+
+void hostStartArduino()
+{
+    xTaskCreatePinnedToCore(loopTask, "loopTask", 8192, nullptr, HOST_LOOP_TASK_PRIORITY, nullptr, 1);
+}
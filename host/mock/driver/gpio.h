@@ -0,0 +1,4 @@
+#pragma once
+#include "../esp_sleep.h"
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type);
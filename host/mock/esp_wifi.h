@@ -0,0 +1,19 @@
+#pragma once
+#include <Arduino.h>
+
+typedef enum
+{
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP
+} wifi_interface_t;
+typedef enum
+{
+    WIFI_PS_NONE,
+    WIFI_PS_MIN_MODEM,
+    WIFI_PS_MAX_MODEM
+} wifi_ps_type_t;
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]); // hostRadioSetMac 设置的地址
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+esp_err_t esp_wifi_connectionless_module_set_wake_interval(uint16_t wake_interval);
+esp_err_t esp_wifi_get_channel(uint8_t *primary, int *second);
@@ -0,0 +1,71 @@
+#ifndef HOST_IO_H
+#define HOST_IO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+// 主机替身的外部接口: 运行器、仿真器和基准程序用它们给固件喂输入、取输出。固件本身不包含此文件。
+
+// --- Serial ---
+// 固件的串口输出 (默认写到 stdout)
+void hostSerialSetSink(std::function<void(const char *data, size_t len)> sink);
+// 追加串口输入 (串口控制台逐字节读取)
+void hostSerialFeed(const char *text);
+
+// --- GPIO ---
+// 设置输入引脚电平 (未设置的引脚读到 HIGH，即按钮松开)。触摸屏 IRQ 引脚由触摸脚本决定
+void hostGpioSet(uint8_t pin, int level);
+int hostGpioOutput(uint8_t pin); // 固件最后写到输出引脚的值 (analogWrite 为占空比)
+
+// --- 触摸屏 (XPT2046) ---
+// 触摸脚本: 在虚拟时间 atUs 起触摸屏读数变为 (x, y, z) 原始值 (z = 0 为抬笔)，直到下一条。必须按时间顺序添加
+void hostTouchAdd(uint64_t atUs, int16_t x, int16_t y, int16_t z);
+// 从文本文件读取触摸脚本，每行 "毫秒 x y z" (原始坐标，# 开头为注释)，时间相对 offsetUs
+bool hostTouchLoadScript(const char *path, uint64_t offsetUs);
+// afterUs 之后第一次按下 (z > 0) 的时间 (没有则 HOST_TIME_NEVER)，浅睡眠的触摸唤醒使用
+uint64_t hostTouchNextDownUs(uint64_t afterUs);
+bool hostTouchIsDown();
+
+// --- 显示屏 (TFT_eSPI) ---
+// 屏幕帧缓冲 (旋转后的 SCREEN_WIDTH x SCREEN_HEIGHT，RGB565，按行存放)
+const uint16_t *hostTftFramebuffer();
+int hostTftWidth();
+int hostTftHeight();
+bool hostTftWritePpm(const char *path);
+uint32_t hostTftDrawCalls(); // 固件发出的绘图调用次数
+
+// --- ESP-NOW ---
+// 本机 MAC 地址 (默认 02:00:00:00:00:01)
+void hostRadioSetMac(const uint8_t mac[6]);
+// 每发出一帧调用 medium (目的地址为广播地址或单播对端)，txDoneUs 为这一帧在空中发送完毕的虚拟时间
+// (本机发送按 hostRadioAirtimeUs 排队)。返回 false 表示单播没有收到 ACK，发送回调报告 FAIL (广播总是报告成功)。
+// 未设置时帧被丢弃
+typedef std::function<bool(const uint8_t *destMac, const uint8_t *data, size_t len, uint64_t txDoneUs)> HostRadioMedium_t;
+void hostRadioSetMedium(HostRadioMedium_t medium);
+// 在虚拟时间 atUs 把一帧交给固件的接收回调 (在系统事件任务中执行，与设备上的 WiFi 任务一样)
+void hostRadioDeliver(uint64_t atUs, const uint8_t srcMac[6], const uint8_t *data, size_t len, int8_t rssi);
+// 一帧的空中时间估算 (前导码 + MAC/厂商动作帧头 + 负载)，发送回调在发送完毕后到达
+uint32_t hostRadioAirtimeUs(size_t len);
+// ESP-NOW 物理层速率 (默认 1000 kbps，与 ESP-NOW 默认的 1Mbps 相同)
+void hostRadioSetBitrateKbps(uint32_t kbps);
+
+// --- WiFi / MQTT ---
+// 调用 WiFi.begin 后是否连上 (默认不连接，ESP-NOW 不受影响)
+void hostWifiSetAvailable(bool available);
+// 固件发布消息时调用
+void hostMqttSetPublishHook(std::function<void(const char *topic, const uint8_t *payload, size_t len)> hook);
+// 注入一条订阅消息，在固件下次调用 client.loop() 时交给回调
+void hostMqttInject(const char *topic, const uint8_t *payload, size_t len);
+
+// --- LittleFS ---
+// 用主机目录保存文件系统内容: 挂载时读入，每次关闭写入的文件后写回 (默认只在内存中)
+void hostFsSetDirectory(const char *path);
+
+// --- 堆 ---
+// ESP.getFreeHeap 等报告的堆大小 (默认与 ESP32 无 PSRAM 时相近)，已用量取自主机 malloc 统计
+void hostHeapSetSize(uint32_t bytes);
+// 模拟的 PSRAM 容量 (默认 0，即没有 PSRAM；psramFound、ps_malloc 和 heap_caps_malloc(MALLOC_CAP_SPIRAM) 按它工作)
+void hostPsramSetSize(uint32_t bytes);
+
+#endif // HOST_IO_H
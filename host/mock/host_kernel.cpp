@@ -0,0 +1,540 @@
+#include "host_kernel.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 任务等待的原因
+enum HostWait_e
+{
+    HOST_WAIT_NONE = 0,  // 就绪
+    HOST_WAIT_TIME,      // vTaskDelay / 浅睡眠
+    HOST_WAIT_NOTIFY,    // ulTaskNotifyTake
+    HOST_WAIT_SEMAPHORE, // xSemaphoreTake
+    HOST_WAIT_FOREVER    // 已结束、被删除或停机
+};
+
+struct HostSemaphore;
+
+typedef struct HostTask_s
+{
+    std::string name;
+    TaskFunction_t fn;
+    void *param;
+    UBaseType_t priority;
+    std::condition_variable cv;
+    HostWait_e wait;
+    uint64_t wakeUs;       // 超时时间 (HOST_TIME_NEVER 为无限等待)
+    uint64_t readySeq;     // 变为就绪的先后 (同优先级先就绪先运行)
+    uint32_t notifyCount;
+    bool timedOut;
+    HostSemaphore *waitingOn;
+} HostTask_t;
+
+struct HostSemaphore
+{
+    bool isMutex;
+    int count;                     // 互斥量: 1 为空闲；二值信号量: 0 或 1
+    HostTask_t *holder;
+    std::deque<HostTask_t *> waiters;
+};
+
+typedef struct HostEvent_s
+{
+    uint64_t atUs;
+    uint64_t seq;
+    std::function<void()> fn;
+} HostEvent_t;
+
+struct HostEventLater
+{
+    bool operator()(const HostEvent_t &a, const HostEvent_t &b) const
+    {
+        return a.atUs != b.atUs ? a.atUs > b.atUs : a.seq > b.seq;
+    }
+};
+
+// 内核状态有意不析构: 进程退出时仍阻塞在条件变量上的任务线程不能碰到已销毁的对象
+struct HostKernel
+{
+    std::mutex lock;
+    std::condition_variable driverCv;
+    std::vector<HostTask_t *> tasks;
+    HostTask_t *running = nullptr;
+    uint64_t nowUs = 0;
+    uint64_t readySeq = 0;
+    bool halted = false;
+    std::priority_queue<HostEvent_t, std::vector<HostEvent_t>, HostEventLater> events;
+    uint64_t eventSeq = 0;
+    HostTask_t *eventTask = nullptr;
+};
+
+static HostKernel &kernel = *new HostKernel();
+static thread_local HostTask_t *currentTask = nullptr;
+
+// --- 调度 (调用者持有 kernel.lock) ---
+
+static void makeReady(HostTask_t *task, bool timedOut)
+{
+    if (task->wait == HOST_WAIT_SEMAPHORE && task->waitingOn != nullptr)
+    {
+        std::deque<HostTask_t *> &waiters = task->waitingOn->waiters;
+        for (auto it = waiters.begin(); it != waiters.end(); ++it)
+        {
+            if (*it == task)
+            {
+                waiters.erase(it);
+                break;
+            }
+        }
+    }
+    task->wait = HOST_WAIT_NONE;
+    task->waitingOn = nullptr;
+    task->timedOut = timedOut;
+    task->readySeq = ++kernel.readySeq;
+}
+
+static void wakeExpired()
+{
+    for (HostTask_t *task : kernel.tasks)
+    {
+        if (task->wait != HOST_WAIT_NONE && task->wait != HOST_WAIT_FOREVER && task->wakeUs <= kernel.nowUs)
+            makeReady(task, true);
+    }
+}
+
+static HostTask_t *pickReady()
+{
+    HostTask_t *best = nullptr;
+    for (HostTask_t *task : kernel.tasks)
+    {
+        if (task->wait != HOST_WAIT_NONE)
+            continue;
+        if (best == nullptr || task->priority > best->priority ||
+            (task->priority == best->priority && task->readySeq < best->readySeq))
+            best = task;
+    }
+    return best;
+}
+
+static uint64_t earliestWake()
+{
+    uint64_t earliest = HOST_TIME_NEVER;
+    for (HostTask_t *task : kernel.tasks)
+    {
+        if (task->wait == HOST_WAIT_NONE)
+            return kernel.nowUs;
+        if (task->wait != HOST_WAIT_FOREVER && task->wakeUs < earliest)
+            earliest = task->wakeUs;
+    }
+    return earliest;
+}
+
+// 当前任务让出 CPU，直到驱动方再次选中它
+static void switchOut(std::unique_lock<std::mutex> &guard)
+{
+    HostTask_t *self = currentTask;
+    kernel.running = nullptr;
+    kernel.driverCv.notify_one();
+    self->cv.wait(guard, [self] { return kernel.running == self; });
+}
+
+// 当前任务进入等待；返回 true 表示被唤醒 (而不是超时)
+static bool blockLocked(std::unique_lock<std::mutex> &guard, HostWait_e wait, uint64_t wakeUs)
+{
+    HostTask_t *self = currentTask;
+    self->wait = wait;
+    self->wakeUs = wakeUs;
+    switchOut(guard);
+    return !self->timedOut;
+}
+
+// 唤醒了更高优先级的任务时模拟抢占
+static void preemptIfNeeded(std::unique_lock<std::mutex> &guard)
+{
+    HostTask_t *self = currentTask;
+    if (self == nullptr)
+        return;
+    HostTask_t *next = pickReady();
+    if (next != nullptr && next != self && next->priority > self->priority)
+    {
+        makeReady(self, false);
+        switchOut(guard);
+    }
+}
+
+static uint64_t ticksToWakeUs(TickType_t ticks)
+{
+    return ticks == portMAX_DELAY ? HOST_TIME_NEVER : kernel.nowUs + (uint64_t)ticks * 1000ULL;
+}
+
+static void taskTrampoline(HostTask_t *task)
+{
+    currentTask = task;
+    {
+        std::unique_lock<std::mutex> guard(kernel.lock);
+        task->cv.wait(guard, [task] { return kernel.running == task; });
+    }
+    task->fn(task->param);
+    // FreeRTOS 任务函数不允许返回，这里按删除自身处理
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    task->wait = HOST_WAIT_FOREVER;
+    switchOut(guard);
+}
+
+static HostTask_t *createTaskLocked(TaskFunction_t fn, const char *name, void *param, UBaseType_t priority)
+{
+    HostTask_t *task = new HostTask_t();
+    task->name = name ? name : "";
+    task->fn = fn;
+    task->param = param;
+    task->priority = priority;
+    task->wait = HOST_WAIT_NONE;
+    task->wakeUs = HOST_TIME_NEVER;
+    task->readySeq = ++kernel.readySeq;
+    task->notifyCount = 0;
+    task->timedOut = false;
+    task->waitingOn = nullptr;
+    kernel.tasks.push_back(task);
+    std::thread(taskTrampoline, task).detach();
+    return task;
+}
+
+// --- 驱动方 ---
+
+uint64_t hostNowUs()
+{
+    std::lock_guard<std::mutex> guard(kernel.lock);
+    return kernel.nowUs;
+}
+
+uint64_t hostClockRead()
+{
+    std::lock_guard<std::mutex> guard(kernel.lock);
+    kernel.nowUs += HOST_CLOCK_READ_COST_US;
+    return kernel.nowUs;
+}
+
+void hostRunUntil(uint64_t targetUs)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    while (!kernel.halted)
+    {
+        wakeExpired();
+        HostTask_t *task = pickReady();
+        if (task == nullptr)
+        {
+            uint64_t next = earliestWake();
+            if (next == HOST_TIME_NEVER || next > targetUs)
+                break;
+            kernel.nowUs = next;
+            continue;
+        }
+        if (kernel.nowUs >= targetUs && targetUs != HOST_TIME_NEVER)
+            break;
+        kernel.running = task;
+        task->cv.notify_one();
+        kernel.driverCv.wait(guard, [] { return kernel.running == nullptr; });
+    }
+    if (!kernel.halted && targetUs != HOST_TIME_NEVER && kernel.nowUs < targetUs)
+        kernel.nowUs = targetUs; // 没有任务可运行时时间照样流逝
+}
+
+void hostRunFor(uint64_t durationUs)
+{
+    hostRunUntil(hostNowUs() + durationUs);
+}
+
+uint64_t hostNextWakeUs()
+{
+    std::lock_guard<std::mutex> guard(kernel.lock);
+    if (kernel.halted)
+        return HOST_TIME_NEVER;
+    return earliestWake();
+}
+
+static void eventTaskMain(void *)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    for (;;)
+    {
+        if (kernel.events.empty())
+        {
+            blockLocked(guard, HOST_WAIT_FOREVER, HOST_TIME_NEVER);
+            continue;
+        }
+        if (kernel.events.top().atUs > kernel.nowUs)
+        {
+            blockLocked(guard, HOST_WAIT_TIME, kernel.events.top().atUs);
+            continue;
+        }
+        std::function<void()> fn = kernel.events.top().fn;
+        kernel.events.pop();
+        guard.unlock();
+        fn();
+        guard.lock();
+    }
+}
+
+void hostPost(uint64_t atUs, std::function<void()> fn)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    if (kernel.eventTask == nullptr)
+        kernel.eventTask = createTaskLocked(eventTaskMain, "sys_evt", nullptr, HOST_EVENT_TASK_PRIORITY);
+    kernel.events.push(HostEvent_t{atUs, ++kernel.eventSeq, std::move(fn)});
+    HostTask_t *eventTask = kernel.eventTask;
+    if (eventTask->wait == HOST_WAIT_FOREVER || (eventTask->wait == HOST_WAIT_TIME && eventTask->wakeUs > atUs))
+    {
+        eventTask->wait = HOST_WAIT_TIME;
+        eventTask->wakeUs = atUs;
+    }
+}
+
+void hostHalt(const char *reason)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    kernel.halted = true;
+    fprintf(stderr, "[host] halted at %.3fms: %s\n", kernel.nowUs / 1000.0, reason ? reason : "");
+    if (currentTask != nullptr)
+    {
+        currentTask->wait = HOST_WAIT_FOREVER;
+        switchOut(guard); // 不会再被选中
+    }
+}
+
+bool hostHalted()
+{
+    std::lock_guard<std::mutex> guard(kernel.lock);
+    return kernel.halted;
+}
+
+void hostSleepUntilUs(uint64_t untilUs)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    if (currentTask == nullptr)
+    {
+        if (untilUs != HOST_TIME_NEVER && untilUs > kernel.nowUs)
+            kernel.nowUs = untilUs;
+        return;
+    }
+    if (untilUs == HOST_TIME_NEVER)
+        blockLocked(guard, HOST_WAIT_FOREVER, HOST_TIME_NEVER);
+    else
+        blockLocked(guard, HOST_WAIT_TIME, untilUs);
+}
+
+void hostYield()
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    if (currentTask == nullptr)
+        return;
+    kernel.nowUs += HOST_CLOCK_READ_COST_US;
+    makeReady(currentTask, false);
+    switchOut(guard);
+}
+
+bool hostInTask()
+{
+    return currentTask != nullptr;
+}
+
+// --- FreeRTOS 任务 API ---
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t coreId)
+{
+    (void)stackDepth;
+    (void)coreId;
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    HostTask_t *task = createTaskLocked(fn, name, param, priority);
+    if (handle != nullptr)
+        *handle = task;
+    preemptIfNeeded(guard);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param, UBaseType_t priority,
+                       TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, 0);
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    HostTask_t *task = handle != nullptr ? (HostTask_t *)handle : currentTask;
+    if (task == nullptr)
+        return;
+    if (task->wait == HOST_WAIT_SEMAPHORE)
+        makeReady(task, true);
+    task->wait = HOST_WAIT_FOREVER;
+    if (task == currentTask)
+        switchOut(guard);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    if (currentTask == nullptr)
+    {
+        kernel.nowUs += (uint64_t)ticks * 1000ULL;
+        return;
+    }
+    if (ticks == 0)
+    {
+        makeReady(currentTask, false);
+        switchOut(guard);
+        return;
+    }
+    blockLocked(guard, HOST_WAIT_TIME, kernel.nowUs + (uint64_t)ticks * 1000ULL);
+}
+
+void vTaskDelayUntil(TickType_t *previousWake, TickType_t increment)
+{
+    TickType_t wakeTick = *previousWake + increment;
+    *previousWake = wakeTick;
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    uint64_t wakeUs = (uint64_t)wakeTick * 1000ULL;
+    if (wakeUs <= kernel.nowUs)
+        return; // 已经错过，与 FreeRTOS 相同立即返回
+    if (currentTask == nullptr)
+    {
+        kernel.nowUs = wakeUs;
+        return;
+    }
+    blockLocked(guard, HOST_WAIT_TIME, wakeUs);
+}
+
+TickType_t xTaskGetTickCount()
+{
+    std::lock_guard<std::mutex> guard(kernel.lock);
+    return (TickType_t)(kernel.nowUs / 1000ULL);
+}
+
+TickType_t xTaskGetTickCountFromISR()
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return currentTask;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    HostTask_t *self = currentTask;
+    if (self == nullptr)
+        return 0;
+    if (self->notifyCount == 0 && ticksToWait > 0)
+        blockLocked(guard, HOST_WAIT_NOTIFY, ticksToWakeUs(ticksToWait));
+    uint32_t count = self->notifyCount;
+    if (count > 0)
+        self->notifyCount = clearOnExit ? 0 : count - 1;
+    return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    HostTask_t *task = (HostTask_t *)handle;
+    if (task == nullptr)
+        return pdFAIL;
+    task->notifyCount++;
+    if (task->wait == HOST_WAIT_NOTIFY)
+    {
+        makeReady(task, false);
+        preemptIfNeeded(guard);
+    }
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t handle, BaseType_t *higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken != nullptr)
+        *higherPriorityTaskWoken = pdFALSE;
+    xTaskNotifyGive(handle);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle)
+{
+    (void)handle;
+    return 0;
+}
+
+BaseType_t xPortGetCoreID()
+{
+    return 0;
+}
+
+// --- 信号量 ---
+
+static SemaphoreHandle_t createSemaphore(bool isMutex, int count)
+{
+    HostSemaphore *semaphore = new HostSemaphore();
+    semaphore->isMutex = isMutex;
+    semaphore->count = count;
+    semaphore->holder = nullptr;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return createSemaphore(true, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return createSemaphore(false, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    HostSemaphore *semaphore = (HostSemaphore *)handle;
+    if (semaphore->count > 0)
+    {
+        semaphore->count--;
+        semaphore->holder = currentTask;
+        return pdTRUE;
+    }
+    if (currentTask == nullptr || ticksToWait == 0)
+        return pdFALSE;
+    semaphore->waiters.push_back(currentTask);
+    currentTask->waitingOn = semaphore;
+    // Give 时直接把信号量交给队首的等待者，被唤醒即已持有
+    return blockLocked(guard, HOST_WAIT_SEMAPHORE, ticksToWakeUs(ticksToWait)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+{
+    std::unique_lock<std::mutex> guard(kernel.lock);
+    HostSemaphore *semaphore = (HostSemaphore *)handle;
+    if (!semaphore->waiters.empty())
+    {
+        HostTask_t *next = semaphore->waiters.front();
+        makeReady(next, false); // 同时从等待队列移除
+        semaphore->holder = next;
+        preemptIfNeeded(guard);
+        return pdTRUE;
+    }
+    if (semaphore->count >= 1)
+        return pdFALSE;
+    semaphore->count++;
+    semaphore->holder = nullptr;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t handle)
+{
+    delete (HostSemaphore *)handle;
+}
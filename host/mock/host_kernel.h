@@ -0,0 +1,49 @@
+#ifndef HOST_KERNEL_H
+#define HOST_KERNEL_H
+
+#include <stdint.h>
+#include <functional>
+
+// 虚拟时间协作式内核 (FreeRTOS 的主机替身)
+// 每个任务是一个线程，但同一时刻只有一个在运行: 任务只在阻塞调用 (vTaskDelay、ulTaskNotifyTake、等信号量、delay 等)
+// 处让出，控制权回到驱动方 (hostRunUntil 的调用者)，由它按优先级和就绪先后选出下一个任务；所有任务都在等待时
+// 把虚拟时钟拨到最早的唤醒时间。固件代码本身不消耗虚拟时间 (每次读时钟只前进 HOST_CLOCK_READ_COST_US，
+// 防止忙等死循环)，因此同样的输入总是得到同样的执行顺序和时间戳。
+// 不模拟抢占: 高优先级任务被唤醒后要等当前任务阻塞才运行，与设备上的相对时序可能差几百微秒。
+
+#define HOST_TIME_NEVER UINT64_MAX
+#define HOST_CLOCK_READ_COST_US 1      // 每次读取 millis()/micros() 虚拟时间前进的微秒数
+#define HOST_LOOP_TASK_PRIORITY 1      // Arduino loopTask 的优先级 (与 ESP32 Arduino 核心相同)
+#define HOST_EVENT_TASK_PRIORITY 23    // 系统事件任务 (ESP-NOW 回调等) 的优先级，与 ESP32 WiFi 任务相同
+
+// 当前虚拟时间 (微秒)。hostClockRead 额外让时钟前进 HOST_CLOCK_READ_COST_US
+uint64_t hostNowUs();
+uint64_t hostClockRead();
+
+// 运行所有任务直到虚拟时间到达 targetUs、节点停机或没有任何任务能再被唤醒
+void hostRunUntil(uint64_t targetUs);
+void hostRunFor(uint64_t durationUs);
+
+// 最早的任务唤醒时间 (没有则 HOST_TIME_NEVER)，多节点仿真用它决定下一步推进哪个节点
+uint64_t hostNextWakeUs();
+
+// 在虚拟时间 atUs 于系统事件任务中执行 fn (模拟 WiFi 任务里的 ESP-NOW 回调)，同一时刻的事件按投递顺序执行
+void hostPost(uint64_t atUs, std::function<void()> fn);
+
+// 节点停机 (深度睡眠): 不再调度任何任务，在任务中调用时当前任务不再返回
+void hostHalt(const char *reason);
+bool hostHalted();
+
+// 当前任务阻塞到虚拟时间 untilUs (微秒精度，浅睡眠等使用)
+void hostSleepUntilUs(uint64_t untilUs);
+
+// 抢占点: 时钟前进一点，让已到期或同优先级的就绪任务先运行 (loopTask 每轮 loop() 之后调用)
+void hostYield();
+
+// 创建 Arduino loopTask: 先调用 setup()，之后反复调用 loop()
+void hostStartArduino();
+
+// 当前是否在某个任务中运行 (否则是在驱动方线程中直接调用固件代码)
+bool hostInTask();
+
+#endif // HOST_KERNEL_H
@@ -0,0 +1,242 @@
+#include "LittleFS.h"
+#include "host_io.h"
+
+#include <dirent.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct HostOpenFile
+{
+    std::string path;
+    bool writable;
+    size_t position;
+};
+
+static std::mutex fsLock;
+static std::map<std::string, std::vector<uint8_t>> files;
+static std::string hostDirectory;
+
+LittleFSFS LittleFS;
+
+void hostFsSetDirectory(const char *path)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    hostDirectory = path ? path : "";
+}
+
+// 固件只在根目录下建文件，主机目录中使用同样的文件名
+static std::string hostPathFor(const std::string &path)
+{
+    return hostDirectory + path;
+}
+
+static void saveToHost(const std::string &path)
+{
+    if (hostDirectory.empty())
+        return;
+    std::string hostPath = hostPathFor(path);
+    auto it = files.find(path);
+    if (it == files.end())
+    {
+        ::remove(hostPath.c_str());
+        return;
+    }
+    FILE *f = fopen(hostPath.c_str(), "wb");
+    if (f == nullptr)
+        return;
+    if (!it->second.empty())
+        fwrite(it->second.data(), 1, it->second.size(), f);
+    fclose(f);
+}
+
+static size_t usedBytesLocked()
+{
+    size_t used = 2 * LITTLEFS_HOST_BLOCK_BYTES; // 超级块
+    for (const auto &entry : files)
+        used += (entry.second.size() / LITTLEFS_HOST_BLOCK_BYTES + 1) * LITTLEFS_HOST_BLOCK_BYTES;
+    return used;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel)
+{
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    std::lock_guard<std::mutex> guard(fsLock);
+    if (hostDirectory.empty())
+        return true;
+    DIR *dir = opendir(hostDirectory.c_str());
+    if (dir == nullptr)
+        return true; // 空文件系统
+    while (struct dirent *entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name.empty() || name[0] == '.')
+            continue;
+        std::string path = "/" + name;
+        FILE *f = fopen((hostDirectory + "/" + name).c_str(), "rb");
+        if (f == nullptr)
+            continue;
+        std::vector<uint8_t> data;
+        uint8_t buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+            data.insert(data.end(), buffer, buffer + n);
+        fclose(f);
+        files[path] = std::move(data);
+    }
+    closedir(dir);
+    return true;
+}
+
+bool LittleFSFS::format()
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    std::vector<std::string> paths;
+    for (const auto &entry : files)
+        paths.push_back(entry.first);
+    files.clear();
+    for (const std::string &path : paths)
+        saveToHost(path);
+    return true;
+}
+
+File LittleFSFS::open(const char *path, const char *mode, const bool create)
+{
+    (void)create;
+    std::lock_guard<std::mutex> guard(fsLock);
+    std::shared_ptr<HostOpenFile> state = std::make_shared<HostOpenFile>();
+    state->path = path;
+    state->writable = mode[0] != 'r';
+    state->position = 0;
+    if (mode[0] == 'r')
+    {
+        if (!files.count(path))
+            return File();
+    }
+    else if (mode[0] == 'w')
+    {
+        files[path].clear();
+    }
+    else // 'a'
+    {
+        state->position = files[path].size();
+    }
+    return File(state);
+}
+
+bool LittleFSFS::exists(const char *path)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    return files.count(path) > 0;
+}
+
+bool LittleFSFS::remove(const char *path)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    if (!files.erase(path))
+        return false;
+    saveToHost(path);
+    return true;
+}
+
+bool LittleFSFS::rename(const char *from, const char *to)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    auto it = files.find(from);
+    if (it == files.end())
+        return false;
+    files[to] = std::move(it->second);
+    files.erase(from);
+    saveToHost(from);
+    saveToHost(to);
+    return true;
+}
+
+size_t LittleFSFS::totalBytes()
+{
+    return LITTLEFS_HOST_PARTITION_BYTES;
+}
+
+size_t LittleFSFS::usedBytes()
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    return usedBytesLocked();
+}
+
+size_t File::write(const uint8_t *buf, size_t size)
+{
+    if (!state || !state->writable)
+        return 0;
+    std::lock_guard<std::mutex> guard(fsLock);
+    std::vector<uint8_t> &data = files[state->path];
+    size_t used = usedBytesLocked();
+    size_t room = used >= LITTLEFS_HOST_PARTITION_BYTES ? 0 : LITTLEFS_HOST_PARTITION_BYTES - used;
+    size = std::min(size, room);
+    if (state->position + size > data.size())
+        data.resize(state->position + size);
+    if (size > 0)
+        memcpy(data.data() + state->position, buf, size);
+    state->position += size;
+    return size;
+}
+
+size_t File::read(uint8_t *buf, size_t size)
+{
+    if (!state)
+        return 0;
+    std::lock_guard<std::mutex> guard(fsLock);
+    auto it = files.find(state->path);
+    if (it == files.end() || state->position >= it->second.size())
+        return 0;
+    size = std::min(size, it->second.size() - state->position);
+    memcpy(buf, it->second.data() + state->position, size);
+    state->position += size;
+    return size;
+}
+
+int File::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::available()
+{
+    return (int)(size() - position());
+}
+
+size_t File::size() const
+{
+    if (!state)
+        return 0;
+    std::lock_guard<std::mutex> guard(fsLock);
+    auto it = files.find(state->path);
+    return it == files.end() ? 0 : it->second.size();
+}
+
+size_t File::position() const
+{
+    return state ? state->position : 0;
+}
+
+bool File::seek(uint32_t pos)
+{
+    if (!state || pos > size())
+        return false;
+    state->position = pos;
+    return true;
+}
+
+void File::close()
+{
+    if (state && state->writable)
+    {
+        std::lock_guard<std::mutex> guard(fsLock);
+        saveToHost(state->path);
+    }
+    state.reset();
+}
@@ -0,0 +1,132 @@
+#include "PubSubClient.h"
+#include "WiFi.h"
+#include "host_io.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef struct HostMqttMessage_s
+{
+    std::string topic;
+    std::vector<uint8_t> payload;
+} HostMqttMessage_t;
+
+static std::mutex mqttLock;
+static std::function<void(const char *, const uint8_t *, size_t)> publishHook;
+static std::deque<HostMqttMessage_t> injected;
+
+void hostMqttSetPublishHook(std::function<void(const char *topic, const uint8_t *payload, size_t len)> hook)
+{
+    std::lock_guard<std::mutex> guard(mqttLock);
+    publishHook = std::move(hook);
+}
+
+void hostMqttInject(const char *topic, const uint8_t *payload, size_t len)
+{
+    std::lock_guard<std::mutex> guard(mqttLock);
+    injected.push_back(HostMqttMessage_t{topic, std::vector<uint8_t>(payload, payload + len)});
+}
+
+PubSubClient &PubSubClient::setServer(const char *domain, uint16_t port)
+{
+    (void)domain;
+    (void)port;
+    return *this;
+}
+
+PubSubClient &PubSubClient::setCallback(std::function<void(char *, uint8_t *, unsigned int)> cb)
+{
+    callback = std::move(cb);
+    return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size)
+{
+    if (size == 0)
+        return false;
+    bufferSize = size;
+    return true;
+}
+
+bool PubSubClient::connect(const char *id, const char *user, const char *pass)
+{
+    (void)id;
+    (void)user;
+    (void)pass;
+    isConnected = WiFi.status() == WL_CONNECTED;
+    return isConnected;
+}
+
+bool PubSubClient::connected()
+{
+    if (WiFi.status() != WL_CONNECTED)
+        isConnected = false;
+    return isConnected;
+}
+
+int PubSubClient::state()
+{
+    return isConnected ? MQTT_CONNECTED : MQTT_CONNECTION_TIMEOUT;
+}
+
+bool PubSubClient::loop()
+{
+    if (!connected())
+        return false;
+    for (;;)
+    {
+        HostMqttMessage_t message;
+        {
+            std::lock_guard<std::mutex> guard(mqttLock);
+            if (injected.empty())
+                break;
+            message = std::move(injected.front());
+            injected.pop_front();
+        }
+        // 与库相同，超过缓冲区的消息被丢弃；回调拿到的负载后面没有结束符
+        if (MQTT_MAX_HEADER_SIZE + 2 + message.topic.size() + message.payload.size() > bufferSize)
+            continue;
+        if (callback)
+        {
+            std::vector<char> topic(message.topic.begin(), message.topic.end());
+            topic.push_back('\0');
+            callback(topic.data(), message.payload.data(), (unsigned int)message.payload.size());
+        }
+    }
+    return true;
+}
+
+bool PubSubClient::subscribe(const char *topic)
+{
+    (void)topic;
+    return connected();
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload)
+{
+    return publish(topic, (const uint8_t *)payload, (unsigned int)strlen(payload));
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload, bool retained)
+{
+    (void)retained;
+    return publish(topic, payload);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int plength)
+{
+    if (!connected())
+        return false;
+    if (MQTT_MAX_HEADER_SIZE + 2 + strlen(topic) + plength > bufferSize)
+        return false;
+    std::function<void(const char *, const uint8_t *, size_t)> hook;
+    {
+        std::lock_guard<std::mutex> guard(mqttLock);
+        hook = publishHook;
+    }
+    if (hook)
+        hook(topic, payload, plength);
+    return true;
+}
@@ -0,0 +1,392 @@
+#include "esp_now.h"
+#include "esp_sleep.h"
+#include "WiFi.h"
+#include "host_io.h"
+#include "host_kernel.h"
+
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#define HOST_RADIO_PREAMBLE_US 192   // 1Mbps DSSS 长前导码
+#define HOST_RADIO_OFDM_PREAMBLE_US 20 // 6Mbps 及以上的 OFDM 前导码
+#define HOST_RADIO_FRAME_OVERHEAD 43 // MAC 头 + 厂商动作帧头 + ESP-NOW 元素头 + FCS
+#define HOST_RADIO_TX_QUEUE 8        // 尚未发送完毕的帧超过此数时 esp_now_send 返回 ESP_ERR_ESPNOW_NO_MEM
+
+// --- ESP-NOW ---
+
+static std::mutex radioLock;
+static uint8_t localMac[ESP_NOW_ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static bool espNowInitialized = false;
+static esp_now_send_cb_t sendCallback = nullptr;
+static esp_now_recv_cb_t recvCallback = nullptr;
+static std::set<std::string> peers;
+static HostRadioMedium_t radioMedium;
+static uint64_t radioBusyUntilUs = 0; // 本机发送队列排空的时间
+static int radioPendingFrames = 0;
+static uint32_t radioBitrateKbps = 1000;
+static bool radioAsleep = false;      // 浅睡眠中: 射频关闭，到达的帧丢失
+
+static std::string macKey(const uint8_t *mac)
+{
+    return std::string((const char *)mac, ESP_NOW_ETH_ALEN);
+}
+
+void hostRadioSetMac(const uint8_t mac[6])
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    memcpy(localMac, mac, ESP_NOW_ETH_ALEN);
+}
+
+void hostRadioSetMedium(HostRadioMedium_t medium)
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    radioMedium = std::move(medium);
+}
+
+void hostRadioSetBitrateKbps(uint32_t kbps)
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    radioBitrateKbps = kbps > 0 ? kbps : 1000;
+}
+
+static uint32_t airtimeLocked(size_t len)
+{
+    uint32_t preambleUs = radioBitrateKbps >= 6000 ? HOST_RADIO_OFDM_PREAMBLE_US : HOST_RADIO_PREAMBLE_US;
+    uint64_t bits = (uint64_t)(len + HOST_RADIO_FRAME_OVERHEAD) * 8;
+    return preambleUs + (uint32_t)((bits * 1000 + radioBitrateKbps - 1) / radioBitrateKbps);
+}
+
+uint32_t hostRadioAirtimeUs(size_t len)
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    return airtimeLocked(len);
+}
+
+void hostRadioDeliver(uint64_t atUs, const uint8_t srcMac[6], const uint8_t *data, size_t len, int8_t rssi)
+{
+    std::vector<uint8_t> frame(data, data + len);
+    std::vector<uint8_t> src(srcMac, srcMac + ESP_NOW_ETH_ALEN);
+    hostPost(atUs, [frame, src, rssi]() {
+        esp_now_recv_cb_t callback;
+        uint8_t destMac[ESP_NOW_ETH_ALEN];
+        {
+            std::lock_guard<std::mutex> guard(radioLock);
+            callback = espNowInitialized && !radioAsleep ? recvCallback : nullptr;
+            memcpy(destMac, localMac, ESP_NOW_ETH_ALEN);
+        }
+        if (callback == nullptr)
+            return;
+        uint8_t srcCopy[ESP_NOW_ETH_ALEN];
+        memcpy(srcCopy, src.data(), ESP_NOW_ETH_ALEN);
+        wifi_pkt_rx_ctrl_t rxCtrl;
+        rxCtrl.rssi = rssi;
+        esp_now_recv_info_t info;
+        info.src_addr = srcCopy;
+        info.des_addr = destMac;
+        info.rx_ctrl = &rxCtrl;
+        callback(&info, frame.data(), (int)frame.size());
+    });
+}
+
+esp_err_t esp_now_init()
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    espNowInitialized = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_deinit()
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    espNowInitialized = false;
+    peers.clear();
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    sendCallback = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    recvCallback = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer)
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    if (!espNowInitialized)
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    if (peer == nullptr)
+        return ESP_ERR_ESPNOW_ARG;
+    if (peers.count(macKey(peer->peer_addr)))
+        return ESP_ERR_ESPNOW_EXIST;
+    if (peers.size() >= ESP_NOW_MAX_TOTAL_PEER_NUM)
+        return ESP_ERR_ESPNOW_FULL;
+    peers.insert(macKey(peer->peer_addr));
+    return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr)
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    if (!espNowInitialized)
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    return peers.erase(macKey(peer_addr)) ? ESP_OK : ESP_ERR_ESPNOW_NOT_FOUND;
+}
+
+bool esp_now_is_peer_exist(const uint8_t *peer_addr)
+{
+    std::lock_guard<std::mutex> guard(radioLock);
+    return peers.count(macKey(peer_addr)) > 0;
+}
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+    HostRadioMedium_t medium;
+    uint64_t txDoneUs;
+    uint8_t dest[ESP_NOW_ETH_ALEN];
+    {
+        std::lock_guard<std::mutex> guard(radioLock);
+        if (!espNowInitialized)
+            return ESP_ERR_ESPNOW_NOT_INIT;
+        if (peer_addr == nullptr || data == nullptr || len == 0 || len > ESP_NOW_MAX_DATA_LEN)
+            return ESP_ERR_ESPNOW_ARG;
+        if (!peers.count(macKey(peer_addr)))
+            return ESP_ERR_ESPNOW_NOT_FOUND;
+        if (radioPendingFrames >= HOST_RADIO_TX_QUEUE)
+            return ESP_ERR_ESPNOW_NO_MEM;
+        uint64_t now = hostNowUs();
+        radioBusyUntilUs = std::max(radioBusyUntilUs, now) + airtimeLocked(len);
+        txDoneUs = radioBusyUntilUs;
+        radioPendingFrames++;
+        medium = radioMedium;
+        memcpy(dest, peer_addr, ESP_NOW_ETH_ALEN);
+    }
+
+    bool acked = medium ? medium(dest, data, len, txDoneUs) : false;
+    // 广播帧没有 ACK，发出即报告成功 (与设备相同)
+    static const uint8_t broadcastMac[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    bool isBroadcast = memcmp(dest, broadcastMac, ESP_NOW_ETH_ALEN) == 0;
+    esp_now_send_status_t status = (acked || isBroadcast) ? ESP_NOW_SEND_SUCCESS : ESP_NOW_SEND_FAIL;
+    std::vector<uint8_t> destCopy(dest, dest + ESP_NOW_ETH_ALEN);
+    hostPost(txDoneUs, [destCopy, status]() {
+        esp_now_send_cb_t callback;
+        {
+            std::lock_guard<std::mutex> guard(radioLock);
+            radioPendingFrames--;
+            callback = sendCallback;
+        }
+        if (callback != nullptr)
+            callback(destCopy.data(), status);
+    });
+    return ESP_OK;
+}
+
+esp_err_t esp_now_set_wake_window(uint16_t window)
+{
+    (void)window;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+    (void)ifx;
+    std::lock_guard<std::mutex> guard(radioLock);
+    memcpy(mac, localMac, ESP_NOW_ETH_ALEN);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    (void)type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connectionless_module_set_wake_interval(uint16_t wake_interval)
+{
+    (void)wake_interval;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_channel(uint8_t *primary, int *second)
+{
+    if (primary)
+        *primary = 1;
+    if (second)
+        *second = 0;
+    return ESP_OK;
+}
+
+// --- WiFi ---
+
+static bool wifiAvailable = false;
+static wl_status_t wifiStatus = WL_DISCONNECTED;
+
+void hostWifiSetAvailable(bool available)
+{
+    wifiAvailable = available;
+    if (!available)
+        wifiStatus = WL_DISCONNECTED;
+}
+
+WiFiClass WiFi;
+
+String IPAddress::toString() const
+{
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buffer);
+}
+
+size_t IPAddress::printTo(Print &p) const
+{
+    return p.print(toString());
+}
+
+bool WiFiClass::mode(int m)
+{
+    (void)m;
+    return true;
+}
+
+bool WiFiClass::disconnect(bool wifioff)
+{
+    (void)wifioff;
+    wifiStatus = WL_DISCONNECTED;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *pass)
+{
+    (void)ssid;
+    (void)pass;
+    wifiStatus = wifiAvailable ? WL_CONNECTED : WL_NO_SSID_AVAIL;
+    return wifiStatus;
+}
+
+wl_status_t WiFiClass::status()
+{
+    return wifiStatus;
+}
+
+IPAddress WiFiClass::localIP()
+{
+    return wifiStatus == WL_CONNECTED ? IPAddress(192, 168, 4, 2) : IPAddress();
+}
+
+String WiFiClass::macAddress()
+{
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    esp_wifi_get_mac(WIFI_IF_STA, mac);
+    char buffer[18];
+    snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(buffer);
+}
+
+int WiFiClass::channel()
+{
+    return 1;
+}
+
+// --- 睡眠 ---
+
+static uint64_t sleepTimerUs = 0;
+static bool sleepGpioWakeup = false;
+static esp_sleep_wakeup_cause_t wakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us)
+{
+    sleepTimerUs = time_in_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup()
+{
+    sleepGpioWakeup = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level)
+{
+    (void)gpio_num;
+    (void)level;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t io_mask, esp_sleep_ext1_wakeup_mode_t level_mode)
+{
+    (void)io_mask;
+    (void)level_mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_wifi_wakeup()
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_wakeup_cause_t source)
+{
+    if (source == ESP_SLEEP_WAKEUP_ALL || source == ESP_SLEEP_WAKEUP_TIMER)
+        sleepTimerUs = 0;
+    if (source == ESP_SLEEP_WAKEUP_ALL || source == ESP_SLEEP_WAKEUP_GPIO)
+        sleepGpioWakeup = false;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    (void)gpio_num;
+    (void)intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause()
+{
+    return wakeupCause;
+}
+
+// 只有调用任务睡眠，其他任务照常按虚拟时间运行 (设备上整颗芯片都停下)；睡眠期间到达的 ESP-NOW 帧丢失
+esp_err_t esp_light_sleep_start()
+{
+    {
+        std::lock_guard<std::mutex> guard(radioLock);
+        radioAsleep = true;
+    }
+    uint64_t now = hostNowUs();
+    uint64_t timerWake = sleepTimerUs > 0 ? now + sleepTimerUs : HOST_TIME_NEVER;
+    uint64_t touchWake = sleepGpioWakeup ? hostTouchNextDownUs(now) : HOST_TIME_NEVER;
+    if (touchWake <= timerWake && touchWake != HOST_TIME_NEVER)
+    {
+        hostSleepUntilUs(touchWake);
+        wakeupCause = ESP_SLEEP_WAKEUP_GPIO;
+    }
+    else
+    {
+        hostSleepUntilUs(timerWake);
+        wakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+    }
+    std::lock_guard<std::mutex> guard(radioLock);
+    radioAsleep = false;
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start()
+{
+    Serial.flush();
+    hostHalt("deep sleep");
+}
@@ -0,0 +1,563 @@
+#include "TFT_eSPI.h"
+#include "host_io.h"
+
+static TFT_eSPI *screen = nullptr; // 第一个创建的 TFT_eSPI 即屏幕 (固件中的 tft)
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h)
+    : _init_width(w), _init_height(h), _width(w), _height(h), textColor(TFT_WHITE),
+      textBgColor(TFT_WHITE), textDatum(TL_DATUM), textSize(1), textFont(1), cursorX(0), cursorY(0), drawCallCount(0)
+{
+    memset(pixels, 0, sizeof(pixels));
+    resetViewport();
+    winX0 = winY0 = winX = winY = 0;
+    winX1 = winY1 = -1;
+    if (screen == nullptr)
+        screen = this;
+}
+
+void TFT_eSPI::init(uint8_t tc)
+{
+    (void)tc;
+    memset(pixels, 0, sizeof(pixels));
+    resetViewport();
+}
+
+// 旋转只改变逻辑尺寸；帧缓冲始终按当前方向存放，足以覆盖固件启动时设置一次方向的用法
+void TFT_eSPI::setRotation(uint8_t r)
+{
+    if (r & 1)
+    {
+        _width = _init_height;
+        _height = _init_width;
+    }
+    else
+    {
+        _width = _init_width;
+        _height = _init_height;
+    }
+    resetViewport();
+}
+
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum)
+{
+    vpX = std::max<int32_t>(x, 0);
+    vpY = std::max<int32_t>(y, 0);
+    vpW = std::max<int32_t>(std::min<int32_t>(x + w, _width) - vpX, 0);
+    vpH = std::max<int32_t>(std::min<int32_t>(y + h, _height) - vpY, 0);
+    originX = vpDatum ? x : 0;
+    originY = vpDatum ? y : 0;
+}
+
+void TFT_eSPI::resetViewport()
+{
+    vpX = 0;
+    vpY = 0;
+    vpW = _width;
+    vpH = _height;
+    originX = 0;
+    originY = 0;
+}
+
+void TFT_eSPI::plot(int32_t x, int32_t y, uint16_t color)
+{
+    x += originX;
+    y += originY;
+    if (x < vpX || y < vpY || x >= vpX + vpW || y >= vpY + vpH)
+        return;
+    pixels[y * _width + x] = color;
+}
+
+void TFT_eSPI::fillSpan(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    for (int32_t row = y; row < y + h; row++)
+        for (int32_t col = x; col < x + w; col++)
+            plot(col, row, color);
+}
+
+void TFT_eSPI::fillScreen(uint32_t color)
+{
+    drawCallCount++;
+    fillSpan(0, 0, _width, _height, (uint16_t)color);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color)
+{
+    drawCallCount++;
+    plot(x, y, (uint16_t)color);
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y)
+{
+    x += originX;
+    y += originY;
+    if (x < 0 || y < 0 || x >= _width || y >= _height)
+        return 0;
+    return pixels[y * _width + x];
+}
+
+// 与 TFT_eSPI::drawLine 相同的 Bresenham 步进 (库中把连续像素合并成快速线段，画出的像素一致)
+void TFT_eSPI::drawLine(int32_t xs, int32_t ys, int32_t xe, int32_t ye, uint32_t color)
+{
+    drawCallCount++;
+    bool steep = abs(ye - ys) > abs(xe - xs);
+    if (steep)
+    {
+        std::swap(xs, ys);
+        std::swap(xe, ye);
+    }
+    if (xs > xe)
+    {
+        std::swap(xs, xe);
+        std::swap(ys, ye);
+    }
+    int32_t dx = xe - xs, dy = abs(ye - ys);
+    int32_t err = dx >> 1, ystep = ys < ye ? 1 : -1;
+    for (; xs <= xe; xs++)
+    {
+        if (steep)
+            plot(ys, xs, (uint16_t)color);
+        else
+            plot(xs, ys, (uint16_t)color);
+        err -= dy;
+        if (err < 0)
+        {
+            ys += ystep;
+            err += dx;
+        }
+    }
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color)
+{
+    drawCallCount++;
+    fillSpan(x, y, 1, h, (uint16_t)color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color)
+{
+    drawCallCount++;
+    fillSpan(x, y, w, 1, (uint16_t)color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+    drawCallCount++;
+    fillSpan(x, y, w, h, (uint16_t)color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+    drawCallCount++;
+    fillSpan(x, y, w, 1, (uint16_t)color);
+    fillSpan(x, y + h - 1, w, 1, (uint16_t)color);
+    fillSpan(x, y + 1, 1, h - 2, (uint16_t)color);
+    fillSpan(x + w - 1, y + 1, 1, h - 2, (uint16_t)color);
+}
+
+// 以下圆形算法与 Adafruit GFX / TFT_eSPI 相同
+void TFT_eSPI::circleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t corners, uint16_t color)
+{
+    int32_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+        if (corners & 0x4)
+        {
+            plot(x0 + x, y0 + y, color);
+            plot(x0 + y, y0 + x, color);
+        }
+        if (corners & 0x2)
+        {
+            plot(x0 + x, y0 - y, color);
+            plot(x0 + y, y0 - x, color);
+        }
+        if (corners & 0x8)
+        {
+            plot(x0 - y, y0 + x, color);
+            plot(x0 - x, y0 + y, color);
+        }
+        if (corners & 0x1)
+        {
+            plot(x0 - y, y0 - x, color);
+            plot(x0 - x, y0 - y, color);
+        }
+    }
+}
+
+void TFT_eSPI::fillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t corners, int32_t delta, uint16_t color)
+{
+    int32_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+        if (corners & 0x1)
+        {
+            fillSpan(x0 + x, y0 - y, 1, 2 * y + 1 + delta, color);
+            fillSpan(x0 + y, y0 - x, 1, 2 * x + 1 + delta, color);
+        }
+        if (corners & 0x2)
+        {
+            fillSpan(x0 - x, y0 - y, 1, 2 * y + 1 + delta, color);
+            fillSpan(x0 - y, y0 - x, 1, 2 * x + 1 + delta, color);
+        }
+    }
+}
+
+void TFT_eSPI::drawCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color)
+{
+    drawCallCount++;
+    plot(x0, y0 + r, (uint16_t)color);
+    plot(x0, y0 - r, (uint16_t)color);
+    plot(x0 + r, y0, (uint16_t)color);
+    plot(x0 - r, y0, (uint16_t)color);
+    circleHelper(x0, y0, r, 0xF, (uint16_t)color);
+}
+
+void TFT_eSPI::fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color)
+{
+    drawCallCount++;
+    fillSpan(x0, y0 - r, 1, 2 * r + 1, (uint16_t)color);
+    fillCircleHelper(x0, y0, r, 0x3, 0, (uint16_t)color);
+}
+
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color)
+{
+    drawCallCount++;
+    fillSpan(x + r, y, w - 2 * r, 1, (uint16_t)color);
+    fillSpan(x + r, y + h - 1, w - 2 * r, 1, (uint16_t)color);
+    fillSpan(x, y + r, 1, h - 2 * r, (uint16_t)color);
+    fillSpan(x + w - 1, y + r, 1, h - 2 * r, (uint16_t)color);
+    circleHelper(x + r, y + r, r, 1, (uint16_t)color);
+    circleHelper(x + w - r - 1, y + r, r, 2, (uint16_t)color);
+    circleHelper(x + w - r - 1, y + h - r - 1, r, 4, (uint16_t)color);
+    circleHelper(x + r, y + h - r - 1, r, 8, (uint16_t)color);
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color)
+{
+    drawCallCount++;
+    fillSpan(x + r, y, w - 2 * r, h, (uint16_t)color);
+    fillCircleHelper(x + w - r - 1, y + r, r, 1, h - 2 * r - 1, (uint16_t)color);
+    fillCircleHelper(x + r, y + r, r, 2, h - 2 * r - 1, (uint16_t)color);
+}
+
+// 角度与 TFT_eSPI 相同: 0 度在正下方，顺时针增加
+void TFT_eSPI::drawArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle,
+                       uint32_t fg_color, uint32_t bg_color, bool smoothArc)
+{
+    (void)bg_color;
+    (void)smoothArc;
+    drawCallCount++;
+    startAngle %= 361;
+    endAngle %= 361;
+    for (int32_t dy = -r; dy <= r; dy++)
+    {
+        for (int32_t dx = -r; dx <= r; dx++)
+        {
+            int32_t d2 = dx * dx + dy * dy;
+            if (d2 > r * r || d2 < ir * ir)
+                continue;
+            double angle = atan2((double)-dx, (double)dy) * 180.0 / M_PI;
+            if (angle < 0)
+                angle += 360.0;
+            bool inside = startAngle <= endAngle ? (angle >= startAngle && angle <= endAngle)
+                                                 : (angle >= startAngle || angle <= endAngle);
+            if (inside)
+                plot(x + dx, y + dy, (uint16_t)fg_color);
+        }
+    }
+}
+
+void TFT_eSPI::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t fgcolor)
+{
+    drawCallCount++;
+    int32_t rowBytes = (w + 7) / 8;
+    for (int32_t j = 0; j < h; j++)
+        for (int32_t i = 0; i < w; i++)
+            if (bitmap[j * rowBytes + i / 8] & (0x80 >> (i & 7)))
+                plot(x + i, y + j, fgcolor);
+}
+
+void TFT_eSPI::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t fgcolor,
+                          uint16_t bgcolor)
+{
+    drawCallCount++;
+    int32_t rowBytes = (w + 7) / 8;
+    for (int32_t j = 0; j < h; j++)
+        for (int32_t i = 0; i < w; i++)
+            plot(x + i, y + j, (bitmap[j * rowBytes + i / 8] & (0x80 >> (i & 7))) ? fgcolor : bgcolor);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+{
+    drawCallCount++;
+    for (int32_t j = 0; j < h; j++)
+        for (int32_t i = 0; i < w; i++)
+            plot(x + i, y + j, data[j * w + i]);
+}
+
+void TFT_eSPI::readRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data)
+{
+    for (int32_t j = 0; j < h; j++)
+        for (int32_t i = 0; i < w; i++)
+            data[j * w + i] = readPixel(x + i, y + j);
+}
+
+void TFT_eSPI::setWindow(int32_t xs, int32_t ys, int32_t xe, int32_t ye)
+{
+    winX0 = winX = xs;
+    winY0 = winY = ys;
+    winX1 = xe;
+    winY1 = ye;
+    (void)winY0;
+}
+
+void TFT_eSPI::pushColor(uint16_t color, uint32_t len)
+{
+    drawCallCount++;
+    while (len-- > 0 && winY <= winY1)
+    {
+        plot(winX, winY, color);
+        if (++winX > winX1)
+        {
+            winX = winX0;
+            winY++;
+        }
+    }
+}
+
+void TFT_eSPI::pushColors(const uint16_t *data, uint32_t len, bool swap)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        uint16_t color = swap ? (uint16_t)((data[i] >> 8) | (data[i] << 8)) : data[i];
+        pushColor(color, 1);
+    }
+}
+
+// --- 文字 ---
+
+void TFT_eSPI::setTextColor(uint16_t color)
+{
+    textColor = color;
+    textBgColor = color; // 与库相同: 只给前景色时不画背景
+}
+
+void TFT_eSPI::setTextColor(uint16_t fgcolor, uint16_t bgcolor, bool bgfill)
+{
+    (void)bgfill;
+    textColor = fgcolor;
+    textBgColor = bgcolor;
+}
+
+void TFT_eSPI::setCursor(int16_t x, int16_t y)
+{
+    cursorX = x;
+    cursorY = y;
+}
+
+void TFT_eSPI::setCursor(int16_t x, int16_t y, uint8_t font)
+{
+    setCursor(x, y);
+    textFont = font;
+}
+
+// 内置字体的平均字宽 (GLCD 字体为等宽 6 像素)
+int TFT_eSPI::charWidth(uint8_t font) const
+{
+    switch (font)
+    {
+    case 2:
+        return 8;
+    case 4:
+        return 14;
+    case 6:
+        return 24;
+    case 7:
+        return 32;
+    case 8:
+        return 55;
+    default:
+        return 6;
+    }
+}
+
+int16_t TFT_eSPI::fontHeight(int16_t font)
+{
+    switch (font)
+    {
+    case 2:
+        return 16 * textSize;
+    case 4:
+        return 26 * textSize;
+    case 6:
+    case 7:
+        return 48 * textSize;
+    case 8:
+        return 75 * textSize;
+    default:
+        return 8 * textSize;
+    }
+}
+
+int16_t TFT_eSPI::textWidth(const char *string, uint8_t font)
+{
+    return (int16_t)(strlen(string) * charWidth(font) * textSize);
+}
+
+void TFT_eSPI::drawTextBox(int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    drawCallCount++;
+    if (textBgColor != textColor)
+        fillSpan(x, y, w, h, textBgColor);
+}
+
+int16_t TFT_eSPI::drawString(const char *string, int32_t x, int32_t y, uint8_t font)
+{
+    int32_t w = textWidth(string, font);
+    int32_t h = fontHeight(font);
+    switch (textDatum)
+    {
+    case TC_DATUM:
+    case MC_DATUM:
+    case BC_DATUM:
+        x -= w / 2;
+        break;
+    case TR_DATUM:
+    case MR_DATUM:
+    case BR_DATUM:
+        x -= w;
+        break;
+    default:
+        break;
+    }
+    switch (textDatum)
+    {
+    case ML_DATUM:
+    case MC_DATUM:
+    case MR_DATUM:
+        y -= h / 2;
+        break;
+    case BL_DATUM:
+    case BC_DATUM:
+    case BR_DATUM:
+        y -= h;
+        break;
+    default:
+        break;
+    }
+    drawTextBox(x, y, w, h);
+    return (int16_t)w;
+}
+
+int16_t TFT_eSPI::drawString(const char *string, int32_t x, int32_t y)
+{
+    return drawString(string, x, y, textFont);
+}
+
+int16_t TFT_eSPI::drawString(const String &string, int32_t x, int32_t y, uint8_t font)
+{
+    return drawString(string.c_str(), x, y, font);
+}
+
+int16_t TFT_eSPI::drawString(const String &string, int32_t x, int32_t y)
+{
+    return drawString(string.c_str(), x, y, textFont);
+}
+
+void TFT_eSPI::drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size)
+{
+    (void)c;
+    drawCallCount++;
+    if (bg != color)
+        fillSpan(x, y, 6 * size, 8 * size, (uint16_t)bg);
+}
+
+int16_t TFT_eSPI::drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font)
+{
+    char text[2] = {(char)uniCode, 0};
+    uint8_t datum = textDatum;
+    textDatum = TL_DATUM;
+    int16_t w = drawString(text, x, y, font);
+    textDatum = datum;
+    return w;
+}
+
+size_t TFT_eSPI::write(uint8_t c)
+{
+    if (c == '\n')
+    {
+        cursorY += fontHeight(textFont);
+        cursorX = 0;
+        return 1;
+    }
+    if (c == '\r')
+        return 1;
+    int32_t w = charWidth(textFont) * textSize;
+    drawTextBox(cursorX, cursorY, w, fontHeight(textFont));
+    cursorX += w;
+    return 1;
+}
+
+uint16_t TFT_eSPI::color565(uint8_t red, uint8_t green, uint8_t blue)
+{
+    return (uint16_t)(((red & 0xF8) << 8) | ((green & 0xFC) << 3) | (blue >> 3));
+}
+
+// --- 主机接口 ---
+
+const uint16_t *hostTftFramebuffer()
+{
+    return screen ? screen->framebuffer() : nullptr;
+}
+
+int hostTftWidth()
+{
+    return screen ? screen->width() : 0;
+}
+
+int hostTftHeight()
+{
+    return screen ? screen->height() : 0;
+}
+
+uint32_t hostTftDrawCalls()
+{
+    return screen ? screen->drawCalls() : 0;
+}
+
+bool hostTftWritePpm(const char *path)
+{
+    if (screen == nullptr)
+        return false;
+    FILE *f = fopen(path, "wb");
+    if (f == nullptr)
+        return false;
+    int w = screen->width(), h = screen->height();
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    const uint16_t *fb = screen->framebuffer();
+    for (int i = 0; i < w * h; i++)
+    {
+        uint16_t c = fb[i];
+        uint8_t rgb[3] = {(uint8_t)(((c >> 11) & 0x1F) * 255 / 31), (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+                          (uint8_t)((c & 0x1F) * 255 / 31)};
+        fwrite(rgb, 1, 3, f);
+    }
+    return fclose(f) == 0;
+}
@@ -0,0 +1,110 @@
+#include "XPT2046_Touchscreen.h"
+#include "host_io.h"
+#include "host_kernel.h"
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+typedef struct HostTouchEvent_s
+{
+    uint64_t atUs;
+    TS_Point point;
+} HostTouchEvent_t;
+
+static std::mutex touchLock;
+static std::vector<HostTouchEvent_t> touchScript; // 按时间排序
+static uint8_t touchIrqPin = 255;
+
+void hostTouchAdd(uint64_t atUs, int16_t x, int16_t y, int16_t z)
+{
+    std::lock_guard<std::mutex> guard(touchLock);
+    touchScript.push_back(HostTouchEvent_t{atUs, TS_Point(x, y, z)});
+}
+
+bool hostTouchLoadScript(const char *path, uint64_t offsetUs)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        double ms;
+        int x, y, z;
+        if (fields >> ms >> x >> y >> z)
+            hostTouchAdd(offsetUs + (uint64_t)(ms * 1000.0), (int16_t)x, (int16_t)y, (int16_t)z);
+    }
+    return true;
+}
+
+// 虚拟时间 atUs 时的读数 (脚本开始之前为抬笔)
+static TS_Point pointAt(uint64_t atUs)
+{
+    std::lock_guard<std::mutex> guard(touchLock);
+    auto it = std::upper_bound(touchScript.begin(), touchScript.end(), atUs,
+                               [](uint64_t t, const HostTouchEvent_t &e) { return t < e.atUs; });
+    return it == touchScript.begin() ? TS_Point() : (it - 1)->point;
+}
+
+uint64_t hostTouchNextDownUs(uint64_t afterUs)
+{
+    if (pointAt(afterUs).z > 0)
+        return afterUs;
+    std::lock_guard<std::mutex> guard(touchLock);
+    for (const HostTouchEvent_t &event : touchScript)
+    {
+        if (event.atUs > afterUs && event.point.z > 0)
+            return event.atUs;
+    }
+    return HOST_TIME_NEVER;
+}
+
+bool hostTouchIsDown()
+{
+    return pointAt(hostNowUs()).z > 0;
+}
+
+bool hostTouchIrqPin(uint8_t pin)
+{
+    return pin == touchIrqPin && pin != 255;
+}
+
+XPT2046_Touchscreen::XPT2046_Touchscreen(uint8_t cspin, uint8_t tirq) : rotation(1)
+{
+    (void)cspin;
+    touchIrqPin = tirq;
+}
+
+bool XPT2046_Touchscreen::begin(SPIClass &wspi)
+{
+    (void)wspi;
+    return true;
+}
+
+TS_Point XPT2046_Touchscreen::getPoint()
+{
+    return pointAt(hostNowUs());
+}
+
+bool XPT2046_Touchscreen::tirqTouched()
+{
+    return hostTouchIsDown();
+}
+
+bool XPT2046_Touchscreen::touched()
+{
+    return getPoint().z >= XPT2046_HOST_Z_THRESHOLD;
+}
+
+void XPT2046_Touchscreen::readData(uint16_t *x, uint16_t *y, uint8_t *z)
+{
+    TS_Point p = getPoint();
+    *x = (uint16_t)p.x;
+    *y = (uint16_t)p.y;
+    *z = (uint8_t)std::min<int16_t>(p.z, 255);
+}
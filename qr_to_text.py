@@ -1,9 +1,20 @@
-from PIL import Image
-from pyzbar.pyzbar import decode as decode_qr
-import qrcode
+import sys
+
+# 固件中使用的二维码: (C 标识符前缀, 'E'/'.' 文本文件)
+# 生成的 src/qr_bitmaps.h 供 ui_manager.cpp 逐个矩形 fillRect 绘制 (见 drawQrRects)
+QR_BITMAPS = [
+    ("QR_ALIPAY", "alipay_qr.txt"),
+    ("QR_WECHAT", "wechat_qr.txt"),
+    ("QR_BLOG", "shapaper_blog.txt"),
+    ("QR_AUTHOR", "原作者空间.txt"),
+]
+QR_BITMAP_SCALE = 2 # 每个二维码模块在屏幕上占 2x2 像素
+QR_BITMAP_HEADER = "src/qr_bitmaps.h"
 
 def decode_qr_from_image(image_path):
     """Decodes QR code from an image and returns the data."""
+    from PIL import Image
+    from pyzbar.pyzbar import decode as decode_qr
     try:
         img = Image.open(image_path)
         decoded_objects = decode_qr(img)
@@ -24,6 +35,7 @@ def text_to_char_qr(text_data, output_path):
     if not text_data:
         return
 
+    import qrcode
     try:
         # Generate QR code object
         qr = qrcode.QRCode(
@@ -57,7 +69,96 @@ def text_to_char_qr(text_data, output_path):
         print(f"An error occurred while generating text QR for data '{text_data[:30]}...': {e}")
 
 
+def char_qr_to_rects(txt_path, scale):
+    """Reads an 'E'/'.' text QR and returns (width, height, rects) scaled by `scale`.
+
+    Dark modules are merged into horizontal runs, and a run with the same x/width as the run directly above
+    it extends that rectangle downwards, so each rectangle is one fillRect() (a single address window) on the device.
+    """
+    with open(txt_path, 'r', encoding='utf-8') as f:
+        rows = [line.strip() for line in f if line.strip()]
+
+    modules = len(rows)
+    for row_str in rows:
+        if len(row_str) != modules:
+            raise ValueError(f"'{txt_path}' is not square: row of {len(row_str)} modules, expected {modules}")
+
+    rects = []       # [x, y, w, h] in modules
+    open_runs = {}   # (x, w) -> rect ending on the previous row
+    for y, row_str in enumerate(rows):
+        runs = []
+        x = 0
+        while x < modules:
+            if row_str[x] != 'E':
+                x += 1
+                continue
+            start = x
+            while x < modules and row_str[x] == 'E':
+                x += 1
+            runs.append((start, x - start))
+        next_open = {}
+        for run in runs:
+            rect = open_runs.get(run)
+            if rect is not None:
+                rect[3] += 1
+            else:
+                rect = [run[0], y, run[1], 1]
+                rects.append(rect)
+            next_open[run] = rect
+        open_runs = next_open
+
+    scaled = [[v * scale for v in rect] for rect in rects]
+    return modules * scale, modules * scale, scaled
+
+
+def write_bitmap_header(entries, output_path, scale):
+    """Packs every text QR in `entries` into a C++ header of constexpr rectangle lists."""
+    lines = [
+        "// 此文件由 qr_to_text.py 自动生成，请勿手动修改",
+        "// 二维码已按 QR_BITMAP_SCALE 预缩放，深色模块合并为矩形 (同一行相邻的模块合成一段，",
+        "// 与上一行位置相同的段向下延伸)，每个矩形在设备上是一次 fillRect (一个地址窗口)。",
+        "// 背景不在这里绘制: 调用方先用弹窗背景色填充。",
+        "#ifndef QR_BITMAPS_H",
+        "#define QR_BITMAPS_H",
+        "",
+        "#include <cstdint>",
+        "",
+        f"#define QR_BITMAP_SCALE {scale}",
+        "",
+        "typedef struct QrRect_s",
+        "{",
+        "    uint8_t x; // 相对二维码左上角 (像素)",
+        "    uint8_t y;",
+        "    uint8_t w;",
+        "    uint8_t h;",
+        "} QrRect_t;",
+    ]
+    for prefix, txt_path in entries:
+        width, height, rects = char_qr_to_rects(txt_path, scale)
+        lines.append("")
+        lines.append(f"// {txt_path}")
+        lines.append(f"constexpr int16_t {prefix}_WIDTH = {width};")
+        lines.append(f"constexpr int16_t {prefix}_HEIGHT = {height};")
+        lines.append(f"constexpr QrRect_t {prefix}_RECTS[] = {{")
+        for i in range(0, len(rects), 6):
+            row = " ".join("{%d, %d, %d, %d}," % tuple(r) for r in rects[i:i + 6])
+            lines.append(f"    {row}")
+        lines.append("};")
+        lines.append(f"constexpr int {prefix}_RECT_COUNT = {len(rects)};")
+    lines.append("")
+    lines.append("#endif // QR_BITMAPS_H")
+
+    with open(output_path, 'w', encoding='utf-8') as f:
+        f.write("\n".join(lines) + "\n")
+    print(f"Successfully wrote {len(entries)} QR rectangle lists to '{output_path}'")
+
+
 if __name__ == "__main__":
+    # --header-only: 仅根据现有的 .txt 文件重新生成 src/qr_bitmaps.h (无需 Pillow/pyzbar/qrcode)
+    if "--header-only" in sys.argv:
+        write_bitmap_header(QR_BITMAPS, QR_BITMAP_HEADER, QR_BITMAP_SCALE)
+        sys.exit(0)
+
     images_to_process = {
         "shapaper blog.png": "shapaper_blog.txt",
         "原作者空间.png": "原作者空间.txt",
@@ -82,3 +183,5 @@ if __name__ == "__main__":
             text_to_char_qr(decoded_text, txt_file)
         else:
             print(f"Skipping text QR generation for '{img_file}' due to decoding failure.")
+
+    write_bitmap_header(QR_BITMAPS, QR_BITMAP_HEADER, QR_BITMAP_SCALE)
@@ -0,0 +1,141 @@
+#include "alloc_audit.h"
+#include "config.h"
+
+#if ALLOC_AUDIT
+
+#include <new>
+#include <stdlib.h>
+
+static portMUX_TYPE auditMux = portMUX_INITIALIZER_UNLOCKED;
+static AllocAuditSite_t sites[ALLOC_AUDIT_SITES]; // 按首次出现的顺序填充
+static AllocAuditSite_t otherSites = {0, 0, 0};   // 表满之后新出现的调用点
+static uint32_t totalFrees = 0;
+
+static void recordAllocation(void *returnAddress, size_t size)
+{
+    uintptr_t site = (uintptr_t)returnAddress;
+#ifdef __XTENSA__
+    site = (site & 0x3FFFFFFF) | 0x40000000; // 窗口寄存器调用的返回地址高 2 位是窗口增量，换成指令地址
+#endif
+    portENTER_CRITICAL(&auditMux);
+    AllocAuditSite_t *entry = &otherSites;
+    for (int i = 0; i < ALLOC_AUDIT_SITES; i++)
+    {
+        if (sites[i].site == site || sites[i].site == 0)
+        {
+            entry = &sites[i];
+            entry->site = site;
+            break;
+        }
+    }
+    entry->count++;
+    entry->bytes += size;
+    portEXIT_CRITICAL(&auditMux);
+}
+
+static void *auditedAlloc(size_t size, void *returnAddress)
+{
+    void *ptr = malloc(size != 0 ? size : 1);
+    if (ptr != nullptr)
+        recordAllocation(returnAddress, size);
+    return ptr;
+}
+
+static void auditedFree(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+    portENTER_CRITICAL(&auditMux);
+    totalFrees++;
+    portEXIT_CRITICAL(&auditMux);
+    free(ptr);
+}
+
+static void *auditedAllocOrThrow(size_t size, void *returnAddress)
+{
+    void *ptr = auditedAlloc(size, returnAddress);
+    if (ptr == nullptr)
+    {
+#if __cpp_exceptions
+        throw std::bad_alloc();
+#else
+        abort();
+#endif
+    }
+    return ptr;
+}
+
+void *operator new(size_t size) { return auditedAllocOrThrow(size, __builtin_return_address(0)); }
+void *operator new[](size_t size) { return auditedAllocOrThrow(size, __builtin_return_address(0)); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return auditedAlloc(size, __builtin_return_address(0)); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return auditedAlloc(size, __builtin_return_address(0)); }
+void operator delete(void *ptr) noexcept { auditedFree(ptr); }
+void operator delete[](void *ptr) noexcept { auditedFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept { auditedFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { auditedFree(ptr); }
+
+void allocAuditReset()
+{
+    portENTER_CRITICAL(&auditMux);
+    memset(sites, 0, sizeof(sites));
+    otherSites = {0, 0, 0};
+    totalFrees = 0;
+    portEXIT_CRITICAL(&auditMux);
+}
+
+void allocAuditPrint(Print &out)
+{
+    AllocAuditSite_t copy[ALLOC_AUDIT_SITES];
+    AllocAuditSite_t other;
+    uint32_t frees;
+    portENTER_CRITICAL(&auditMux);
+    memcpy(copy, sites, sizeof(copy));
+    other = otherSites;
+    frees = totalFrees;
+    portEXIT_CRITICAL(&auditMux);
+
+    // 按分配次数从多到少排序 (插入排序，最多 ALLOC_AUDIT_SITES 项)
+    int used = 0;
+    while (used < ALLOC_AUDIT_SITES && copy[used].site != 0)
+        used++;
+    for (int i = 1; i < used; i++)
+    {
+        AllocAuditSite_t item = copy[i];
+        int j = i - 1;
+        while (j >= 0 && copy[j].count < item.count)
+        {
+            copy[j + 1] = copy[j];
+            j--;
+        }
+        copy[j + 1] = item;
+    }
+
+    uint32_t totalCount = other.count, totalBytes = other.bytes;
+    out.println("site        allocs      bytes");
+    for (int i = 0; i < used; i++)
+    {
+        out.printf("0x%08lx %8lu %10lu\n", (unsigned long)copy[i].site, (unsigned long)copy[i].count,
+                   (unsigned long)copy[i].bytes);
+        totalCount += copy[i].count;
+        totalBytes += copy[i].bytes;
+    }
+    if (other.count > 0)
+        out.printf("other      %8lu %10lu\n", (unsigned long)other.count, (unsigned long)other.bytes);
+    out.printf("total %lu allocs (%lu bytes), %lu frees; heap free %lu, min %lu, largest block %lu\n",
+               (unsigned long)totalCount, (unsigned long)totalBytes, (unsigned long)frees,
+               (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(), (unsigned long)ESP.getMaxAllocHeap());
+}
+
+#else // ALLOC_AUDIT
+
+void allocAuditReset()
+{
+}
+
+void allocAuditPrint(Print &out)
+{
+    out.printf("allocation audit disabled (set ALLOC_AUDIT to 1 in config.h); heap free %lu, min %lu, largest block %lu\n",
+               (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(), (unsigned long)ESP.getMaxAllocHeap());
+}
+
+#endif // ALLOC_AUDIT
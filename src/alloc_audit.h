@@ -0,0 +1,29 @@
+#ifndef ALLOC_AUDIT_H
+#define ALLOC_AUDIT_H
+
+#include <Arduino.h>
+
+// 堆分配审计 (串口命令 "alloc")
+// ALLOC_AUDIT 为 1 时替换全局 operator new / new[] / delete，按调用点 (operator new 的返回地址) 统计分配次数和字节数。
+// 容器扩容显示为模板实例中的地址 (如 std::vector<TouchData_t>::_M_realloc_insert)，足以认出是哪个容器。
+// String 和 C 库直接调用 malloc，不经过这里，所以热路径上已不再使用 String。
+// 用法: 启动稳定后输入 "alloc reset"，画几笔、让对端同步、打开对端信息界面，再输入 "alloc" 列出这段时间内分配过的
+// 调用点，用 xtensa-esp32-elf-addr2line -pfiaC -e FireNote-ESP32.ino.elf <地址> 换算为源码位置。
+// 稳态下应只剩绘图历史的增长 (DrawingHistory 的新分块、StrokeTileIndex 和区域重绘的笔划列表)。
+
+#define ALLOC_AUDIT_SITES 48 // 记录的调用点数，之后新出现的调用点合并为一行 "other"
+
+typedef struct AllocAuditSite_s
+{
+    uintptr_t site;  // 调用点地址 (0 表示空槽)
+    uint32_t count;  // 分配次数
+    uint32_t bytes;  // 分配的总字节数
+} AllocAuditSite_t;
+
+// 清空统计 (之后只统计新的分配)
+void allocAuditReset();
+
+// 按分配次数从多到少打印各调用点，以及总分配/释放次数和当前空闲堆
+void allocAuditPrint(Print &out);
+
+#endif // ALLOC_AUDIT_H
@@ -0,0 +1,53 @@
+#include "cached_text.h"
+#include <cstring> // For memset
+
+extern TFT_eSPI tft; // 定义于 FireNote-ESP32.ino
+
+void cachedTextInit(CachedText_t &field, int16_t x, int16_t y, uint8_t width, uint16_t fgColor, uint16_t bgColor)
+{
+    field.x = x;
+    field.y = y;
+    field.width = width > CACHED_TEXT_MAX_CHARS ? CACHED_TEXT_MAX_CHARS : width;
+    field.fgColor = fgColor;
+    field.bgColor = bgColor;
+    cachedTextInvalidate(field);
+}
+
+void cachedTextInvalidate(CachedText_t &field)
+{
+    // '\0' 不会出现在补齐后的文本中，因此每个字形格都会被判定为已变化
+    memset(field.shown, 0, sizeof(field.shown));
+}
+
+void cachedTextDraw(CachedText_t &field, const char *text)
+{
+    bool textEnded = false;
+    bool inTransaction = false;
+
+    for (uint8_t i = 0; i < field.width; i++)
+    {
+        char c = ' ';
+        if (!textEnded)
+        {
+            if (text[i] == '\0')
+                textEnded = true;
+            else
+                c = text[i];
+        }
+
+        if (field.shown[i] == c)
+            continue;
+
+        if (!inTransaction) // 只有确实有字形需要重绘时才占用 SPI 总线
+        {
+            tft.startWrite();
+            inTransaction = true;
+        }
+        // 带背景色绘制整个 6x8 字形格，旧字形被直接覆盖
+        tft.drawChar(field.x + i * CACHED_TEXT_CELL_W, field.y, c, field.fgColor, field.bgColor, 1);
+        field.shown[i] = c;
+    }
+
+    if (inTransaction)
+        tft.endWrite();
+}
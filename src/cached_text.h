@@ -0,0 +1,35 @@
+#ifndef CACHED_TEXT_H
+#define CACHED_TEXT_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+// 缓存文本字段 (增量文本渲染)
+// 每个字段记住上次画到屏幕上的内容，更新时逐字符比较，
+// 只重绘发生变化的字形格 (带背景色绘制，无需先 fillRect 清除)，避免整块清屏造成的闪烁。
+// 仅支持 1 号字体 (GLCD 6x8)、字号 1。
+
+#define CACHED_TEXT_MAX_CHARS 52 // 单个字段最多字符数 (SCREEN_WIDTH / 6 ≈ 53)
+#define CACHED_TEXT_CELL_W 6     // 1 号字体字形格宽度 (像素，含 1 像素字间距)
+#define CACHED_TEXT_CELL_H 8     // 1 号字体字形格高度 (像素)
+
+typedef struct CachedText_s
+{
+    int16_t x;           // 字段左上角 X 坐标
+    int16_t y;           // 字段左上角 Y 坐标
+    uint8_t width;       // 字段宽度 (字符数)，文本不足时以空格 (背景色) 补齐，超出时截断
+    uint16_t fgColor;    // 文本颜色
+    uint16_t bgColor;    // 背景颜色
+    char shown[CACHED_TEXT_MAX_CHARS + 1]; // 当前屏幕上显示的内容，'\0' 表示该格内容未知
+} CachedText_t;
+
+// 初始化字段位置、宽度和颜色，并标记为需要完整重绘
+void cachedTextInit(CachedText_t &field, int16_t x, int16_t y, uint8_t width, uint16_t fgColor, uint16_t bgColor);
+
+// 将字段更新为 text，只重绘与上次内容不同的字形格
+void cachedTextDraw(CachedText_t &field, const char *text);
+
+// 屏幕上的字段区域已被其他内容覆盖 (例如清屏或弹窗)，下次绘制时重绘所有字形格
+void cachedTextInvalidate(CachedText_t &field);
+
+#endif // CACHED_TEXT_H
@@ -0,0 +1,158 @@
+#include "canvas_framebuffer.h"
+#include "memory_tier.h"
+#include "raster_sync.h" // rasterRenderRange
+#include "raster_base.h" // 底图画在历史之下
+#include <TFT_eSPI.h>
+#include <algorithm> // std::min, std::max
+
+extern TFT_eSPI tft; // 定义于 FireNote-ESP32.ino
+
+static RasterCanvas_t canvas = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, nullptr};
+static size_t renderedCount = 0;             // 已绘制的历史点数
+static uint32_t renderedRevision = 0;        // 绘制时历史的 revision (不同则从头绘制)
+static uint32_t renderedBaseRevision = 0;    // 绘制时底图的 revision (同上)
+static bool renderedAny = false;             // 还没有绘制过 (第一次追赶时从头绘制)
+static bool sawReset = false;
+static CanvasFramebufferStats_t stats;
+
+bool canvasFramebufferInit()
+{
+    if (!memoryTierHasPsram())
+        return false;
+    canvas.pixels = (uint16_t *)memoryTierAlloc(sizeof(uint16_t) * SCREEN_WIDTH * SCREEN_HEIGHT, MEMORY_TIER_PSRAM, false);
+    if (canvas.pixels == nullptr)
+    {
+        Serial.println("画布帧缓冲: PSRAM 分配失败，重绘照常逐点重播");
+        return false;
+    }
+    memset(canvas.pixels, 0, sizeof(uint16_t) * SCREEN_WIDTH * SCREEN_HEIGHT);
+    stats.enabled = true;
+    return true;
+}
+
+bool canvasFramebufferCatchUp(const DrawingHistory &history, size_t budget)
+{
+    if (canvas.pixels == nullptr)
+        return false;
+    if (!renderedAny || renderedRevision != history.revision() || renderedBaseRevision != rasterBaseRevision() ||
+        renderedCount > history.size())
+    {
+        // 历史被清空或重写、或底图变化: 从底图开始重新绘制
+        memset(canvas.pixels, 0, sizeof(uint16_t) * SCREEN_WIDTH * SCREEN_HEIGHT);
+        rasterBaseDrawToCanvas(canvas);
+        renderedCount = 0;
+        renderedRevision = history.revision();
+        renderedBaseRevision = rasterBaseRevision();
+        sawReset = false;
+        if (renderedAny)
+            stats.rebuilds++;
+        renderedAny = true;
+    }
+    size_t end = history.size();
+    if (end - renderedCount > budget)
+        end = renderedCount + budget;
+    if (rasterRenderRange(history, renderedCount, end, canvas))
+        sawReset = true;
+    renderedCount = end;
+    stats.rendered = renderedCount;
+    return renderedCount == history.size();
+}
+
+bool canvasFramebufferSawReset()
+{
+    return sawReset;
+}
+
+void canvasFramebufferPush(int x, int y, int w, int h)
+{
+    uint32_t startUs = micros();
+    int right = std::min(x + w, SCREEN_WIDTH);
+    int bottom = std::min(y + h, SCREEN_HEIGHT);
+    x = std::max(x, 0);
+    y = std::max(y, 0);
+    tft.startWrite();
+    for (int row = y; row < bottom; row++)
+    {
+        const uint16_t *line = canvas.pixels + row * SCREEN_WIDTH;
+        int column = x;
+        while (column < right)
+        {
+            uint16_t color = line[column];
+            int runStart = column;
+            while (column < right && line[column] == color)
+                column++;
+            if (color != TFT_BLACK)
+                tft.drawFastHLine(runStart, row, column - runStart, color);
+        }
+    }
+    tft.endWrite();
+    stats.pushes++;
+    stats.lastPushUs = micros() - startUs;
+}
+
+void canvasFramebufferBeforeCompact(const DrawingHistory &history, const HistoryCompactJob_t &job)
+{
+    // 压缩删除的点已经画在缓冲里 (与屏幕上一致)，只需让下一个要绘制的点指向压缩后的位置
+    if (canvas.pixels == nullptr || !renderedAny || renderedRevision != history.revision())
+        return;
+    renderedCount = historyCompactRemapIndex(job, renderedCount);
+    renderedRevision = history.revision() + 1; // retain 之后的 revision
+    stats.rendered = renderedCount;
+}
+
+void canvasFramebufferBeforeFlatten(const DrawingHistory &history, size_t cut)
+{
+    // 展平前后画面相同: 已绘制的点在底图里，只需把位置前移
+    if (canvas.pixels == nullptr || !renderedAny || renderedRevision != history.revision() ||
+        renderedBaseRevision != rasterBaseRevision() || renderedCount < cut)
+        return;
+    renderedCount -= cut;
+    renderedRevision = history.revision() + 1;      // drop_front 之后的 revision
+    renderedBaseRevision = rasterBaseRevision() + 1; // rasterFlattenCommit 之后的 revision
+    stats.rendered = renderedCount;
+}
+
+void canvasFramebufferRedrawRegion(const DrawingHistory &history, int x, int y, int w, int h)
+{
+    static uint16_t tilePixels[RASTER_TILE_PIXELS]; // 逐个图块绘制，再拷贝到缓冲
+    static std::vector<uint32_t> strokes;           // 复用，避免每次撤销都分配
+    if (canvas.pixels == nullptr)
+        return;
+    int right = std::min(x + w, SCREEN_WIDTH);
+    int bottom = std::min(y + h, SCREEN_HEIGHT);
+    x = std::max(x, 0);
+    y = std::max(y, 0);
+    const StrokeTileIndex &index = history.strokes();
+    bool drawBase = rasterBaseVisible(history);
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+    {
+        // 图块与区域的交集作为画布: 先画底图，再按时间顺序画与它相交的笔划 (已撤销的点被跳过)
+        RasterCanvas_t part;
+        rasterTileRect(tile, part.x, part.y, part.w, part.h);
+        int partRight = std::min(part.x + part.w, right);
+        int partBottom = std::min(part.y + part.h, bottom);
+        part.x = std::max(part.x, x);
+        part.y = std::max(part.y, y);
+        part.w = partRight - part.x;
+        part.h = partBottom - part.y;
+        if (part.w <= 0 || part.h <= 0)
+            continue;
+        part.pixels = tilePixels;
+        memset(tilePixels, 0, sizeof(uint16_t) * part.w * part.h); // TFT_BLACK
+        if (drawBase)
+            rasterBaseDrawToCanvas(part);
+        index.strokesInRect(part.x, part.y, part.w, part.h, strokes);
+        for (uint32_t stroke : strokes)
+            rasterRenderRange(history, index.strokeStart(stroke), index.strokeEnd(stroke), part);
+        for (int row = 0; row < part.h; row++)
+        {
+            memcpy(canvas.pixels + (part.y + row) * SCREEN_WIDTH + part.x, tilePixels + row * part.w,
+                   sizeof(uint16_t) * part.w);
+        }
+    }
+}
+
+void canvasFramebufferGetStats(CanvasFramebufferStats_t &out)
+{
+    out = stats;
+}
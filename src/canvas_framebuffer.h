@@ -0,0 +1,50 @@
+#ifndef CANVAS_FRAMEBUFFER_H
+#define CANVAS_FRAMEBUFFER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "drawing_history.h" // DrawingHistory
+#include "history_compact.h" // HistoryCompactJob_t
+
+// 画布帧缓冲 (只在有 PSRAM 时启用)
+// SCREEN_WIDTH x SCREEN_HEIGHT 的 RGB565 缓冲 (150KB) 放在 PSRAM，内容是光栅底图和最后一个复位点之后的笔迹 (黑色为空白)，
+// 按 raster_sync 的规则从历史增量绘制: 主循环空闲时每次最多 CANVAS_FB_CATCHUP_POINTS 个点，重播前补齐剩余部分。
+// 全屏重播和局部重绘直接把缓冲中的非黑游程推到屏幕，耗时只与屏幕面积有关，与历史长度无关，
+// 所以 PSRAM 中放得下的几十万个点的历史也不会拖慢重绘。
+// 历史清空或重写、或光栅底图变化后从底图开始重绘；压缩和展平时把已绘制的位置换算到之后的位置，不必重绘；
+// 撤销/重做只重新绘制目标笔划所在的区域。
+// 以下函数都要求调用方持有 historyLock (canvasFramebufferInit 除外)。
+
+typedef struct CanvasFramebufferStats_s
+{
+    bool enabled;         // 缓冲已分配
+    uint32_t rendered;    // 已绘制的历史点数
+    uint32_t rebuilds;    // 因历史清空/重写而从头绘制的次数
+    uint32_t pushes;      // 从缓冲推到屏幕的次数 (代替逐点重播)
+    uint32_t lastPushUs;  // 最近一次推送的耗时 (微秒)
+} CanvasFramebufferStats_t;
+
+// setup: memoryTierInit 之后调用，有 PSRAM 时分配缓冲，返回是否启用
+bool canvasFramebufferInit();
+
+// 最多绘制 budget 个新的历史点，返回缓冲是否已与历史一致 (没有缓冲时返回 false，调用方照常逐点重播)
+bool canvasFramebufferCatchUp(const DrawingHistory &history, size_t budget);
+
+// 已绘制的历史中有复位点 (全屏重播时应先清屏并绘制主界面，与逐点重播时遇到复位点的效果相同)
+bool canvasFramebufferSawReset();
+
+// 把区域内的非黑像素推到屏幕 (不擦除背景，与 replayRegion 相同)，须先 canvasFramebufferCatchUp 追上历史
+void canvasFramebufferPush(int x, int y, int w, int h);
+
+// 历史压缩 (historyCompactApply) 之前调用: 把已绘制的位置换算为压缩后的位置
+void canvasFramebufferBeforeCompact(const DrawingHistory &history, const HistoryCompactJob_t &job);
+
+// 展平 (rasterFlattenCommit 和删除历史前缀 [0, cut)) 之前调用: 已绘制的位置前移 cut
+void canvasFramebufferBeforeFlatten(const DrawingHistory &history, size_t cut);
+
+// 撤销/重做之后调用 (须先 canvasFramebufferCatchUp 追上历史): 按底图和笔划索引重新绘制区域内的像素
+void canvasFramebufferRedrawRegion(const DrawingHistory &history, int x, int y, int w, int h);
+
+void canvasFramebufferGetStats(CanvasFramebufferStats_t &out);
+
+#endif // CANVAS_FRAMEBUFFER_H
@@ -0,0 +1,511 @@
+#include "canvas_store.h"
+#include "config.h"
+#include "esp_now_handler.h" // allDrawingHistory, replayAllDrawings, 同步状态
+#include "ui_manager.h"      // drawMainInterface
+#include "raster_base.h"     // 光栅底图
+#include <LittleFS.h>
+#include <freertos/semphr.h>
+
+#define CANVAS_LOG_PATH "/canvas.log"
+#define CANVAS_SNAPSHOT_PATH "/canvas.snap"
+#define CANVAS_SNAPSHOT_TMP_PATH "/canvas.tmp"
+#define CANVAS_BASE_PATH "/canvas.base"
+#define CANVAS_BASE_TMP_PATH "/canvas.btmp"
+#define CANVAS_SNAPSHOT_MAGIC 0x534E4346 // "FCNS"
+#define CANVAS_LOG_MAGIC 0x4C4E4346      // "FCNL"
+#define CANVAS_BASE_MAGIC 0x424E4346     // "FCNB"
+#define CANVAS_STORE_VERSION 1
+#define CANVAS_IO_CHUNK 64 // 读取/压缩时每次处理的记录数
+
+static bool mounted = false;
+static SemaphoreHandle_t storeMutex = nullptr; // 保护下面的缓存和统计 (网络任务写入 vs 深度睡眠前的 canvasStoreSnapshot)
+
+static CanvasRecord_t pendingRecords[CANVAS_STORE_BATCH_POINTS]; // 尚未写入日志的点
+static size_t pendingCount = 0;
+static unsigned long firstPendingMs = 0; // 缓存中最早一个点的时间
+static unsigned long lastAppendMs = 0;   // 最近一次追加的时间 (判断笔划结束)
+
+static uint32_t generation = 0;     // 当前日志的代号
+static bool logExists = false;      // 当前代号的日志文件是否已创建
+static bool needCompaction = false; // 清屏或日志损坏后尽快重写快照
+static uint32_t writtenBaseRevision = 0; // 底图文件对应的底图 revision
+static bool baseFileValid = false;      // 底图文件与 writtenBaseRevision 时的底图一致 (读取不完整时为 false)
+
+static CanvasStoreStats_t stats;
+
+static void toRecord(const TouchData_t &point, CanvasRecord_t &record)
+{
+    memset(&record, 0, sizeof(record));
+    record.x = (int16_t)point.x;
+    record.y = (int16_t)point.y;
+    record.timestamp = (uint32_t)point.timestamp;
+    record.color = point.color;
+    record.flags = point.isReset ? CANVAS_RECORD_FLAG_RESET : 0;
+}
+
+static void fromRecord(const CanvasRecord_t &record, TouchData_t &point)
+{
+    point.x = record.x;
+    point.y = record.y;
+    point.timestamp = record.timestamp;
+    point.color = record.color;
+    point.isReset = false;
+}
+
+static bool headerValid(const CanvasFileHeader_t &header, uint32_t magic)
+{
+    return header.magic == magic && header.version == CANVAS_STORE_VERSION && header.recordSize == sizeof(CanvasRecord_t);
+}
+
+// 底图文件中每段数据的段头 (之后是 length 字节的编码数据)
+typedef struct CanvasBaseChunk_s
+{
+    uint16_t tileIndex;
+    uint16_t pixelOffset;
+    uint16_t length;
+} CanvasBaseChunk_t;
+
+// --- 启动恢复 (网络任务启动前，只有 setup 访问历史) ---
+
+// 读取光栅底图 (在快照之前读取，画在历史之下)，文件无效或不完整时返回 false
+static bool readBase()
+{
+    File file = LittleFS.open(CANVAS_BASE_PATH, FILE_READ);
+    if (!file)
+        return true;
+
+    CanvasFileHeader_t header;
+    if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || header.magic != CANVAS_BASE_MAGIC ||
+        header.version != CANVAS_STORE_VERSION || header.recordSize != sizeof(CanvasBaseChunk_t))
+    {
+        Serial.println("画布底图无效，已忽略");
+        file.close();
+        return false;
+    }
+
+    uint8_t data[RASTER_BASE_CHUNK_BYTES];
+    for (uint32_t i = 0; i < header.count; i++)
+    {
+        CanvasBaseChunk_t chunk;
+        if (file.read((uint8_t *)&chunk, sizeof(chunk)) != sizeof(chunk) || chunk.length > sizeof(data) ||
+            file.read(data, chunk.length) != chunk.length ||
+            !rasterBaseAppendChunk(chunk.tileIndex, chunk.pixelOffset, data, chunk.length))
+        {
+            Serial.println("画布底图不完整，已读取的部分照常使用");
+            file.close();
+            return false;
+        }
+    }
+    file.close();
+    return true;
+}
+
+// 读取快照，返回接在快照后面的日志代号 (没有有效快照时为 0)
+static uint32_t readSnapshot()
+{
+    File file = LittleFS.open(CANVAS_SNAPSHOT_PATH, FILE_READ);
+    if (!file)
+        return 0;
+
+    CanvasFileHeader_t header;
+    if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || !headerValid(header, CANVAS_SNAPSHOT_MAGIC) ||
+        file.size() < sizeof(header) + (size_t)header.count * sizeof(CanvasRecord_t))
+    {
+        Serial.println("画布快照无效，已忽略");
+        file.close();
+        return 0;
+    }
+
+    CanvasRecord_t records[CANVAS_IO_CHUNK];
+    uint32_t remaining = header.count;
+    while (remaining > 0)
+    {
+        size_t n = remaining < CANVAS_IO_CHUNK ? remaining : CANVAS_IO_CHUNK;
+        size_t got = file.read((uint8_t *)records, n * sizeof(CanvasRecord_t)) / sizeof(CanvasRecord_t);
+        for (size_t i = 0; i < got; i++)
+        {
+            TouchData_t point;
+            fromRecord(records[i], point);
+            allDrawingHistory.push_back(point);
+        }
+        if (got < n)
+        {
+            // 读取失败: 只保留完整读到的记录，稍后重写快照 (点数与睡前不一致时深度睡眠醒来也会改为全量同步)
+            Serial.println("画布快照读取不完整，已读取的部分照常使用，稍后重写快照");
+            needCompaction = true;
+            break;
+        }
+        remaining -= n;
+    }
+    file.close();
+    return header.generation;
+}
+
+// 读取与快照代号一致的日志，按顺序重放其中的点和复位记录
+static void readLog(uint32_t snapshotGeneration)
+{
+    generation = snapshotGeneration;
+    File file = LittleFS.open(CANVAS_LOG_PATH, FILE_READ);
+    if (!file)
+        return;
+
+    CanvasFileHeader_t header;
+    if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || !headerValid(header, CANVAS_LOG_MAGIC) ||
+        header.generation != snapshotGeneration)
+    {
+        // 压缩后删除旧日志前掉电，或文件损坏: 其内容已在快照中 (或无法使用)
+        file.close();
+        LittleFS.remove(CANVAS_LOG_PATH);
+        return;
+    }
+
+    size_t payloadBytes = file.size() - sizeof(header);
+    if (payloadBytes % sizeof(CanvasRecord_t) != 0)
+    {
+        Serial.println("画布日志末尾有不完整的记录 (写入时掉电)，稍后重写快照");
+        needCompaction = true;
+    }
+
+    CanvasRecord_t records[CANVAS_IO_CHUNK];
+    size_t remaining = payloadBytes / sizeof(CanvasRecord_t);
+    while (remaining > 0)
+    {
+        size_t n = remaining < CANVAS_IO_CHUNK ? remaining : CANVAS_IO_CHUNK;
+        size_t got = file.read((uint8_t *)records, n * sizeof(CanvasRecord_t)) / sizeof(CanvasRecord_t);
+        for (size_t i = 0; i < got; i++)
+        {
+            if (records[i].flags & CANVAS_RECORD_FLAG_RESET)
+            {
+                allDrawingHistory.clear();
+                if (!rasterBaseEmpty())
+                {
+                    rasterBaseClear(); // 清屏后尚未重写快照时掉电，底图文件还在，稍后删除
+                    baseFileValid = false;
+                    needCompaction = true;
+                }
+                continue;
+            }
+            TouchData_t point;
+            fromRecord(records[i], point);
+            allDrawingHistory.push_back(point);
+        }
+        if (got < n)
+        {
+            // 读取失败: 重放停在最后一条完整的记录
+            Serial.println("画布日志读取不完整，重放到最后一条完整的记录为止，稍后重写快照");
+            needCompaction = true;
+            break;
+        }
+        remaining -= n;
+    }
+    logExists = true;
+    stats.logBytes = file.size();
+    file.close();
+}
+
+void canvasStoreBootRestore()
+{
+    memset(&stats, 0, sizeof(stats));
+    storeMutex = xSemaphoreCreateMutex();
+
+    unsigned long startMs = millis();
+    mounted = LittleFS.begin(true); // 首次使用 (或分区损坏) 时格式化
+    stats.mounted = mounted;
+    stats.mountMs = millis() - startMs;
+
+    if (mounted)
+    {
+        startMs = millis();
+        baseFileValid = readBase();
+        needCompaction = needCompaction || !baseFileValid; // 重写底图文件
+        readLog(readSnapshot());
+        writtenBaseRevision = rasterBaseRevision();
+        stats.readMs = millis() - startMs;
+        stats.restoredPoints = allDrawingHistory.size();
+    }
+    else
+    {
+        Serial.println("LittleFS 挂载失败，画布不会保存到闪存");
+    }
+
+    startMs = millis();
+    drawMainInterface(); // 来自 ui_manager.cpp
+    replayAllDrawings(); // 来自 esp_now_handler.cpp
+    stats.renderMs = millis() - startMs;
+    stats.bootToCanvasMs = millis();
+
+    Serial.printf("画布恢复: %lu 个点，挂载 %lums，读取 %lums，绘制 %lums，启动到画布可用 %lums\n",
+                  (unsigned long)stats.restoredPoints, (unsigned long)stats.mountMs, (unsigned long)stats.readMs,
+                  (unsigned long)stats.renderMs, (unsigned long)stats.bootToCanvasMs);
+}
+
+// --- 运行时写入 (持有 storeMutex) ---
+
+// 把缓存中的点追加到日志 (日志不存在时先写文件头)
+static void writePendingLocked()
+{
+    if (pendingCount == 0)
+        return;
+    if (!mounted)
+    {
+        pendingCount = 0;
+        return;
+    }
+
+    File file = LittleFS.open(CANVAS_LOG_PATH, logExists ? FILE_APPEND : FILE_WRITE);
+    if (!file)
+    {
+        stats.writeErrors++;
+        pendingCount = 0; // 这批点仍在内存历史中，下次压缩时写入快照
+        needCompaction = true;
+        return;
+    }
+
+    size_t expected = 0;
+    size_t written = 0;
+    if (!logExists)
+    {
+        CanvasFileHeader_t header = {CANVAS_LOG_MAGIC, CANVAS_STORE_VERSION, sizeof(CanvasRecord_t), generation, 0};
+        expected += sizeof(header);
+        written += file.write((const uint8_t *)&header, sizeof(header));
+        logExists = true;
+    }
+    expected += pendingCount * sizeof(CanvasRecord_t);
+    written += file.write((const uint8_t *)pendingRecords, pendingCount * sizeof(CanvasRecord_t));
+    file.close();
+
+    stats.flushes++;
+    stats.pointsWritten += pendingCount;
+    stats.bytesWritten += written;
+    stats.logBytes += written;
+    if (written != expected)
+    {
+        stats.writeErrors++; // 闪存已满等，日志末尾可能不完整，用快照重写
+        needCompaction = true;
+    }
+    pendingCount = 0;
+}
+
+// 底图变化后重写底图文件 (底图为空时删除)，成功时返回 true。
+// 在快照之前写入: 两者之间掉电时旧快照中还有已展平的点，恢复后画在底图上面，画面相同，下次展平时合并
+static bool writeBaseLocked()
+{
+    uint32_t revision = rasterBaseRevision();
+    if (baseFileValid && revision == writtenBaseRevision)
+        return true;
+    if (rasterBaseEmpty())
+    {
+        LittleFS.remove(CANVAS_BASE_PATH);
+        writtenBaseRevision = revision;
+        baseFileValid = true;
+        return true;
+    }
+
+    File file = LittleFS.open(CANVAS_BASE_TMP_PATH, FILE_WRITE);
+    if (!file)
+    {
+        stats.writeErrors++;
+        return false;
+    }
+    CanvasFileHeader_t header = {CANVAS_BASE_MAGIC, CANVAS_STORE_VERSION, sizeof(CanvasBaseChunk_t), 0, rasterBaseChunkCount()};
+    size_t expected = sizeof(header);
+    size_t written = file.write((const uint8_t *)&header, sizeof(header));
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+    {
+        size_t cursor = 0;
+        CanvasBaseChunk_t chunk = {tile, 0, 0};
+        const uint8_t *data;
+        while (rasterBaseNextChunk(tile, cursor, chunk.pixelOffset, chunk.length, data))
+        {
+            expected += sizeof(chunk) + chunk.length;
+            written += file.write((const uint8_t *)&chunk, sizeof(chunk));
+            written += file.write(data, chunk.length);
+        }
+    }
+    file.close();
+    stats.bytesWritten += written;
+
+    if (written != expected)
+    {
+        stats.writeErrors++;
+        LittleFS.remove(CANVAS_BASE_TMP_PATH);
+        return false;
+    }
+    if (!LittleFS.rename(CANVAS_BASE_TMP_PATH, CANVAS_BASE_PATH))
+    {
+        LittleFS.remove(CANVAS_BASE_PATH);
+        LittleFS.rename(CANVAS_BASE_TMP_PATH, CANVAS_BASE_PATH);
+    }
+    writtenBaseRevision = revision;
+    baseFileValid = true;
+    return true;
+}
+
+// 用当前内存历史 (和底图) 重写快照，然后以新代号重新开始日志，成功时返回 true
+static bool compactLocked()
+{
+    if (!mounted)
+        return false;
+    if (!writeBaseLocked())
+        return false;
+
+    uint32_t nextGeneration = generation + 1;
+    size_t count = allDrawingHistory.size(); // 网络任务是历史的唯一写入者，它读取不需要加锁；其他任务调用时先 historyLock()
+    File file = LittleFS.open(CANVAS_SNAPSHOT_TMP_PATH, FILE_WRITE);
+    if (!file)
+    {
+        stats.writeErrors++;
+        return false;
+    }
+
+    CanvasFileHeader_t header = {CANVAS_SNAPSHOT_MAGIC, CANVAS_STORE_VERSION, sizeof(CanvasRecord_t), nextGeneration, (uint32_t)count};
+    size_t written = file.write((const uint8_t *)&header, sizeof(header));
+    CanvasRecord_t records[CANVAS_IO_CHUNK];
+    for (size_t i = 0; i < count; i += CANVAS_IO_CHUNK)
+    {
+        size_t n = count - i < CANVAS_IO_CHUNK ? count - i : CANVAS_IO_CHUNK;
+        for (size_t j = 0; j < n; j++)
+        {
+            toRecord(allDrawingHistory[i + j], records[j]);
+        }
+        written += file.write((const uint8_t *)records, n * sizeof(CanvasRecord_t));
+    }
+    file.close();
+    stats.bytesWritten += written;
+
+    if (written != sizeof(header) + count * sizeof(CanvasRecord_t))
+    {
+        stats.writeErrors++;
+        LittleFS.remove(CANVAS_SNAPSHOT_TMP_PATH); // 保留旧快照和日志
+        return false;
+    }
+    if (!LittleFS.rename(CANVAS_SNAPSHOT_TMP_PATH, CANVAS_SNAPSHOT_PATH))
+    {
+        LittleFS.remove(CANVAS_SNAPSHOT_PATH);
+        LittleFS.rename(CANVAS_SNAPSHOT_TMP_PATH, CANVAS_SNAPSHOT_PATH);
+    }
+    LittleFS.remove(CANVAS_LOG_PATH); // 此前掉电也没关系: 旧日志代号与新快照不一致，恢复时会被忽略
+
+    generation = nextGeneration;
+    logExists = false;
+    pendingCount = 0; // 缓存中的点已在历史中，随快照写入
+    needCompaction = false;
+    stats.logBytes = 0;
+    stats.compactions++;
+    return true;
+}
+
+void canvasStoreAppend(const TouchData_t &point)
+{
+    if (!mounted)
+        return;
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    if (pendingCount == CANVAS_STORE_BATCH_POINTS)
+    {
+        writePendingLocked();
+    }
+    unsigned long now = millis();
+    if (pendingCount == 0)
+    {
+        firstPendingMs = now;
+    }
+    toRecord(point, pendingRecords[pendingCount++]);
+    lastAppendMs = now;
+    xSemaphoreGive(storeMutex);
+}
+
+void canvasStoreClear()
+{
+    if (!mounted)
+        return;
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    pendingCount = 0; // 清屏前尚未写入的点不再需要
+    TouchData_t reset;
+    memset(&reset, 0, sizeof(reset));
+    reset.isReset = true;
+    toRecord(reset, pendingRecords[pendingCount++]);
+    writePendingLocked(); // 复位记录立即写入，掉电后不会恢复出已清除的画布
+    needCompaction = true; // 稍后写一个空快照并删除日志，释放空间
+    xSemaphoreGive(storeMutex);
+}
+
+void canvasStoreHistoryRewritten()
+{
+    if (!mounted)
+        return;
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    needCompaction = true;
+    xSemaphoreGive(storeMutex);
+}
+
+void canvasStoreFlushIfDue()
+{
+    if (!mounted)
+        return;
+    unsigned long now = millis();
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    if (pendingCount > 0 &&
+        (now - lastAppendMs >= CANVAS_STORE_STROKE_IDLE_MS || now - firstPendingMs >= CANVAS_STORE_MAX_DELAY_MS))
+    {
+        writePendingLocked();
+    }
+    // 同步进行中历史还在变化 (接收方先清空再逐点加入)，等同步结束再压缩
+    if ((needCompaction || stats.logBytes >= CANVAS_STORE_COMPACT_BYTES) && !isReceivingDrawingData && !iamRequestingAllData)
+    {
+        compactLocked();
+    }
+    xSemaphoreGive(storeMutex);
+}
+
+bool canvasStoreSnapshot(size_t &count)
+{
+    if (!mounted)
+        return false;
+    historyLock(); // 可能在主循环中调用，期间网络任务不能修改历史
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    bool ok = compactLocked();
+    count = allDrawingHistory.size();
+    xSemaphoreGive(storeMutex);
+    historyUnlock();
+    return ok;
+}
+
+void canvasStoreSync()
+{
+    if (!mounted)
+        return;
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    writePendingLocked();
+    xSemaphoreGive(storeMutex);
+}
+
+void canvasStoreGetStats(CanvasStoreStats_t &out)
+{
+    if (storeMutex == nullptr)
+    {
+        memset(&out, 0, sizeof(out));
+        return;
+    }
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    out = stats;
+    xSemaphoreGive(storeMutex);
+}
+
+void canvasStorePrintStats(Print &out)
+{
+    CanvasStoreStats_t s;
+    canvasStoreGetStats(s);
+    if (!s.mounted)
+    {
+        out.println("canvas store: filesystem not mounted");
+        return;
+    }
+    out.printf("boot restore   %lu points, mount %lums, read %lums, render %lums, boot-to-canvas %lums\n",
+               (unsigned long)s.restoredPoints, (unsigned long)s.mountMs, (unsigned long)s.readMs,
+               (unsigned long)s.renderMs, (unsigned long)s.bootToCanvasMs);
+    out.printf("log            %lu bytes, %lu flushes, %lu points written\n", (unsigned long)s.logBytes,
+               (unsigned long)s.flushes, (unsigned long)s.pointsWritten);
+    out.printf("compactions    %lu, total written %lu bytes, write errors %lu\n", (unsigned long)s.compactions,
+               (unsigned long)s.bytesWritten, (unsigned long)s.writeErrors);
+    out.printf("littlefs       %lu / %lu bytes used\n", (unsigned long)LittleFS.usedBytes(), (unsigned long)LittleFS.totalBytes());
+}
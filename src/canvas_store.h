@@ -0,0 +1,83 @@
+#ifndef CANVAS_STORE_H
+#define CANVAS_STORE_H
+
+#include <Arduino.h>
+#include "drawing_history.h" // TouchData_t, DrawingHistory
+
+// 画布持久化 (LittleFS)
+// /canvas.log  追加写入的日志 (文件头 + 每个点一条定长记录)，清屏写入一条复位记录
+// /canvas.snap 压缩后的快照 (文件头 + 全部点)，日志超过 CANVAS_STORE_COMPACT_BYTES 时由当前历史重写，
+//              之后删除日志、以新的代号重新开始。恢复时只读取代号与快照一致的日志 (删除旧日志前掉电也不会重复恢复)
+// /canvas.base 光栅底图 (历史超出内存预算后展平的较早笔划)，随快照一起在底图变化后重写，恢复时画在历史之下
+// 点先缓存在内存中，笔划结束 (CANVAS_STORE_STROKE_IDLE_MS 内没有新点)、缓存满或缓存太久时才一次写入，
+// 减少对同一个闪存块的反复改写。掉电最多丢失尚未写入的一笔。
+// 追加和写入由网络任务 (绘图历史的唯一写入者) 调用；启动恢复在网络任务启动前于 setup 中调用。
+
+// 快照和日志的文件头
+typedef struct CanvasFileHeader_s
+{
+    uint32_t magic;      // CANVAS_SNAPSHOT_MAGIC / CANVAS_LOG_MAGIC
+    uint16_t version;    // CANVAS_STORE_VERSION
+    uint16_t recordSize; // sizeof(CanvasRecord_t)
+    uint32_t generation; // 快照: 接在它后面的日志代号；日志: 本日志的代号
+    uint32_t count;      // 快照中的点数 (日志中不使用，按文件长度计算)
+} CanvasFileHeader_t;
+
+// 闪存中的点记录 (与 TouchData_t 解耦，固定 16 字节)
+typedef struct CanvasRecord_s
+{
+    int16_t x;
+    int16_t y;
+    uint32_t timestamp;
+    uint32_t color;
+    uint8_t flags;       // CANVAS_RECORD_FLAG_*
+    uint8_t reserved[3];
+} CanvasRecord_t;
+
+#define CANVAS_RECORD_FLAG_RESET 0x01 // 清屏: 恢复时丢弃之前的所有点
+
+// 运行统计
+typedef struct CanvasStoreStats_s
+{
+    bool mounted;              // 文件系统是否可用
+    uint32_t restoredPoints;   // 启动时恢复的点数
+    uint32_t mountMs;          // 挂载耗时
+    uint32_t readMs;           // 读取快照和日志耗时
+    uint32_t renderMs;         // 重绘恢复的画布耗时
+    uint32_t bootToCanvasMs;   // 从上电 (millis() 起点) 到画布可用的时间
+    uint32_t flushes;          // 写入日志的次数
+    uint32_t pointsWritten;    // 写入日志的点数
+    uint32_t bytesWritten;     // 写入的总字节数 (含快照)
+    uint32_t compactions;      // 压缩次数
+    uint32_t writeErrors;      // 写入失败次数
+    uint32_t logBytes;         // 当前日志长度
+} CanvasStoreStats_t;
+
+// setup 中、ESP-NOW 启动前调用: 挂载文件系统，恢复绘图历史，绘制主界面并重绘恢复的画布
+void canvasStoreBootRestore();
+
+// 网络任务调用: 记录一个新加入历史的点
+void canvasStoreAppend(const TouchData_t &point);
+
+// 网络任务调用: 历史已清空
+void canvasStoreClear();
+
+// 网络任务循环中调用: 笔划结束或缓存到期时写入日志，日志过长时压缩为快照
+void canvasStoreFlushIfDue();
+
+// 网络任务调用: 历史被原地压缩 (点被删除)，日志已与历史不一致，下次 canvasStoreFlushIfDue 时重写快照
+void canvasStoreHistoryRewritten();
+
+// 立即写入缓存中的点 (任意任务)
+void canvasStoreSync();
+
+// 立即把当前历史压缩为快照 (深度睡眠前调用，任意任务)，醒来时只需读取一个文件
+// 成功时返回 true，count 为快照中的点数
+bool canvasStoreSnapshot(size_t &count);
+
+void canvasStoreGetStats(CanvasStoreStats_t &out);
+
+// 打印启动恢复耗时、写入统计和文件系统用量
+void canvasStorePrintStats(Print &out);
+
+#endif // CANVAS_STORE_H
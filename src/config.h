@@ -54,6 +54,16 @@
 #define CUSTOM_COLOR_BUTTON_W COLOR_BUTTON_WIDTH                      // 自定义颜色按钮宽度 (与普通颜色按钮相同)
 #define CUSTOM_COLOR_BUTTON_H COLOR_BUTTON_HEIGHT                     // 自定义颜色按钮高度 (与普通颜色按钮相同)
 
+// 撤销 ("<") / 重做 (">") 按钮位置和大小 (自定义颜色按钮下方)
+#define UNDO_BUTTON_X CUSTOM_COLOR_BUTTON_X                                  // 撤销按钮 X 坐标 (与自定义颜色按钮对齐)
+#define UNDO_BUTTON_Y (CUSTOM_COLOR_BUTTON_Y + CUSTOM_COLOR_BUTTON_H + 2)    // 撤销按钮 Y 坐标
+#define UNDO_BUTTON_W COLOR_BUTTON_WIDTH                                     // 撤销按钮宽度
+#define UNDO_BUTTON_H COLOR_BUTTON_HEIGHT                                    // 撤销按钮高度
+#define REDO_BUTTON_X UNDO_BUTTON_X                                          // 重做按钮 X 坐标
+#define REDO_BUTTON_Y (UNDO_BUTTON_Y + UNDO_BUTTON_H + 2)                    // 重做按钮 Y 坐标 (撤销按钮下方)
+#define REDO_BUTTON_W UNDO_BUTTON_W                                          // 重做按钮宽度
+#define REDO_BUTTON_H UNDO_BUTTON_H                                          // 重做按钮高度
+
 // 返回按钮 (调色界面中使用) 位置和大小
 #define BACK_BUTTON_X (SCREEN_WIDTH - COLOR_BUTTON_WIDTH - 4)     // 返回按钮 X 坐标 (屏幕右侧)
 #define BACK_BUTTON_Y (SCREEN_HEIGHT - COLOR_BUTTON_HEIGHT - 4) // 返回按钮 Y 坐标 (屏幕右下角)
@@ -81,9 +91,19 @@
 // UI 更新相关常量
 #define DEBUG_INFO_UPDATE_INTERVAL 200      // 调试信息更新间隔 (毫秒)
 
+// 调试信息框位置和大小 (屏幕左下角)
+#define DEBUG_INFO_LINES 7                                          // 调试信息行数
+#define DEBUG_INFO_LINE_HEIGHT 10                                   // 调试信息行高
+#define DEBUG_INFO_X 2                                              // 调试信息框 X 坐标
+#define DEBUG_INFO_W 120                                            // 调试信息框宽度
+#define DEBUG_INFO_H (DEBUG_INFO_LINES * DEBUG_INFO_LINE_HEIGHT + 2) // 调试信息框高度
+#define DEBUG_INFO_Y (SCREEN_HEIGHT - DEBUG_INFO_H)                 // 调试信息框 Y 坐标
+
 // 调色界面相关常量
 #define COLOR_SLIDER_WIDTH 20                               // 颜色滑块宽度
 #define COLOR_SLIDER_HEIGHT ((SCREEN_HEIGHT - 10) / 3)      // 单个颜色滑块高度
+#define COLOR_PICKER_AREA_X (SCREEN_WIDTH - COLOR_SLIDER_WIDTH - 4 - 40) // 调色界面覆盖的一列 (数值文字、滑块、预览框、返回按钮)
+#define COLOR_PICKER_AREA_W (SCREEN_WIDTH - COLOR_PICKER_AREA_X)
 
 // LED 调光相关常量 (息屏状态下)
 #define BLUE_LED_DIM_DUTY_CYCLE 14 // 蓝色 LED 息屏时亮度 (PWM duty cycle, 0-255), 约 5% (14/255)
@@ -93,13 +113,117 @@
 // 小于此间隔的触摸/绘制事件被视为连续笔划的一部分
 #define TOUCH_STROKE_INTERVAL 50
 
+// 触摸采样相关常量
+#define TOUCH_PRESSURE_THRESHOLD 200   // 压力阈值，低于此值视为飞点/抬笔
+
+// 触摸点滤波 (One Euro) 默认参数，运行时可用串口命令 "filter <mincutoff> <beta> <dcutoff>" 修改 (不保存)
+// 坐标为原始 ADC 单位 (约 11 个 ADC 值/像素)，可用 tools/touch_filter_replay.cpp 回放录制的轨迹调参
+#define TOUCH_FILTER_MIN_CUTOFF 5.0f   // 静止时截止频率 (Hz)
+#define TOUCH_FILTER_BETA 0.002f       // 速度系数 (每 ADC 值/秒 提高的截止频率)
+#define TOUCH_FILTER_D_CUTOFF 1.0f     // 速度估计截止频率 (Hz)
+
+// 触摸轨迹二进制录制/回放 (串口命令 "trace"，格式见 touch_trace.h)
+#define TOUCH_TRACE_MAX_SAMPLES 2048   // 内存中最多保存的样本数 (每个 12 字节，第一次使用时分配)，200Hz 下约 10 秒书写
+#define TOUCH_TRACE_SETTLE_MS 1000     // 回放结束后等待队列排空再出报告 (毫秒)
+
+// 触摸采样任务 (固定频率读取触摸屏，经无锁队列交给主循环)
+// 输入和绘制在核心 1 (采样任务 + Arduino loop())，网络/同步任务和 WiFi 协议栈在核心 0；
+// 采样任务优先级高于 loop()，重绘耗时不影响采样节拍
+#define TOUCH_TASK_PERIOD_MS 5         // 采样周期 (毫秒)，即 200Hz
+#define TOUCH_TASK_CORE 1              // 采样任务所在核心
+#define TOUCH_TASK_PRIORITY 3          // 采样任务优先级 (高于 loopTask 的 1)
+#define TOUCH_TASK_STACK_SIZE 3072     // 采样任务栈大小 (字节)
+#define TOUCH_QUEUE_SIZE 64            // 样本队列容量 (2 的幂)，约 320ms 的样本
+#define TOUCH_STATS_WINDOW_MS 1000     // 采样节拍统计窗口 (毫秒)
+
+// 网络/同步任务 (ESP-NOW 消息处理、同步状态机、分批发送历史，绘图历史的唯一写入者)
+#define NETWORK_TASK_CORE 0            // 与 WiFi 协议栈同核
+#define NETWORK_TASK_PRIORITY 2        // 高于 loopTask 的 1，低于 WiFi 任务
+#define NETWORK_TASK_STACK_SIZE 8192   // 任务栈大小 (字节)，同步状态机里有较多 Serial/String 操作
+#define NETWORK_OP_QUEUE_SIZE 128      // 主循环 -> 网络任务的操作队列容量 (2 的幂)
+#define RADIO_RX_QUEUE_SIZE 64         // ESP-NOW 接收回调 -> 网络任务的消息队列容量 (2 的幂)
+#define HISTORY_SEND_BATCH 50          // 分批发送历史时每批的点数 (每批之后处理一次收到的消息)
+#define HISTORY_SEND_POINT_DELAY_MS 5  // 分批发送历史时每个点之间的间隔 (毫秒)
+
+// 光栅同步 (raster_sync.cpp): 历史很长时改为发送画布有内容图块的游程编码，比逐点发送更小时自动选用
+#define RASTER_TILE_SIZE 32                        // 图块边长 (像素)，网络任务中的图块缓冲为 32x32x2 = 2KB
+#define RASTER_SYNC_MIN_POINTS 2000                // 历史少于此点数时直接逐点发送，不做光栅化估算
+#define RASTER_CHUNK_DELAY_MS 20                   // 每段图块数据之间的间隔 (毫秒)，请求方要把每段还原为历史点并绘制
+#define RASTER_RX_QUEUE_SIZE 16                    // 接收回调 -> 网络任务的图块数据队列容量 (2 的幂)
+#define RASTER_RUN_TIMESTAMP_BASE 0xC0000000UL     // 还原出的历史点的时间戳起点，远离 millis() 的取值，不会与实时点连线
+
+// 笔划空间索引 (stroke_index.cpp): 局部重绘 (关闭弹窗、调色盘) 只重播与区域相交的笔划
+#define STROKE_INDEX_TILE_SIZE 16                  // 索引网格边长 (像素)，320x240 屏幕共 20x15 格
+
+// 画布帧缓冲 (canvas_framebuffer.cpp，只在有 PSRAM 时启用): 重绘时推送缓冲，不再逐点重播
+#define CANVAS_FB_CATCHUP_INTERVAL_MS 100          // 主循环把新的历史点画进缓冲的周期 (毫秒)
+#define CANVAS_FB_CATCHUP_POINTS 2048              // 每次最多绘制的点数 (持有历史锁的时间有上限)
+
+// 绘图历史压缩 (history_compact.cpp): 网络任务空闲时分步化简笔划、删除被完全覆盖的笔划，重播画面逐像素不变
+#define HISTORY_COMPACT_MIN_NEW_POINTS 1000        // 距上次压缩新增至少这么多点才再次压缩
+#define HISTORY_COMPACT_IDLE_MS 2000UL             // 最近这么久没有新点 (没人在画) 才开始/继续压缩 (毫秒)
+#define HISTORY_COMPACT_SLICE_POINTS 512           // 每一步处理的点数
+#define HISTORY_COMPACT_SLICE_INTERVAL_MS 10       // 两步之间网络任务让出 CPU 的时间 (毫秒)
+
+// 历史内存预算 (raster_base.cpp): 超出时把较早的笔划展平为光栅底图，长期运行的历史占用有上限
+#define HISTORY_BUDGET_INTERNAL_BYTES (128UL * 1024) // 没有 PSRAM 时历史和底图的预算 (字节)，约 6000 个点
+#define HISTORY_BUDGET_PSRAM_BYTES (2048UL * 1024)   // 有 PSRAM 时的预算 (字节)
+#define HISTORY_FLATTEN_KEEP_PERCENT 50              // 展平后保留为矢量笔划的点数 (占展平前的百分比)
+#define HISTORY_FLATTEN_RETRY_MS 5000UL              // 展平被放弃 (分配失败等) 后多久再试 (毫秒)
+
+// 撤销/重做 (drawing_history.h): 撤销本机最近画的笔划，以撤销记录加入历史并通过 ESP-NOW / MQTT 通知对端
+#define HISTORY_UNDO_DEPTH 16                        // 本机可连续撤销 (及重做) 的笔划数
+#define HISTORY_UNDO_WINDOW 64                       // 撤销记录只在最近这么多笔划中查找目标；压缩和展平不改动这些笔划
+
+// 画布持久化 (canvas_store.cpp，LittleFS 使用分区表中的 spiffs 分区)
+#define CANVAS_STORE_BATCH_POINTS 256          // 内存中缓存的点数上限 (256 x 16 字节 = 一个 4KB 闪存扇区)
+#define CANVAS_STORE_STROKE_IDLE_MS 500UL      // 超过此时间没有新点视为笔划结束，写入日志 (毫秒)
+#define CANVAS_STORE_MAX_DELAY_MS 5000UL       // 连续作画/同步时，缓存的点最多等待多久写入 (毫秒)
+#define CANVAS_STORE_COMPACT_BYTES (64UL * 1024) // 日志超过此长度时压缩为快照 (字节)
+
 // ESP-NOW 同步逻辑相关常量
 #define MIN_UPTIME_DIFF_FOR_NEW_SYNC_TARGET 200UL // 选择新的同步目标时，对端设备最小原始运行时间差异 (毫秒) - 用于迟滞判断
 #define EFFECTIVE_UPTIME_SYNC_THRESHOLD 1000UL    // 有效运行时间同步阈值 (毫秒) - 在此阈值内的差异不触发新的同步以避免抖动
+#define SYNC_RECEIVE_TIMEOUT_MS 5000UL            // 请求方等待 SYNC_START 或两条同步数据之间的最长时间 (毫秒)，超过则放弃本次同步
+
+// 接收校验 (ESP-NOW 和 MQTT 收到的点)
+#define REMOTE_POINT_MARGIN 64 // 远端点坐标可超出屏幕的像素数 (本机触摸映射也会略超出屏幕)，更远的点被丢弃
+#define MAX_TRACKED_PEERS 32   // 最多记录的对端数 (对端列表、睡眠标记)，伪造 MAC 的消息不会让它们无限增长
 
 // 心跳包相关常量
 #define HEARTBEAT_SEND_INTERVAL_MS 5000UL // 心跳包发送间隔 (毫秒)
 #define HEARTBEAT_TIMEOUT_MS 10000UL      // 心跳超时时间 (毫秒)，10秒
+#define HEARTBEAT_CHECK_INTERVAL_MS 1000UL // 心跳超时检查间隔 (毫秒)
+
+// 深度睡眠醒来后的增量同步
+#define SLEEP_SYNC_MAX_PEERS 4             // RTC 内存中最多记录的睡前对端数
+#define SLEEP_SYNC_SETTLE_MS 100           // 广播 SLEEP_NOTICE 后等待网络任务处理完在途消息再写快照 (毫秒)
+#define DELTA_WAIT_FOR_PEER_MS 15000UL     // 醒来后等待睡前对端出现的最长时间 (毫秒)，超过则回到全量同步流程
+#define DELTA_RESPONSE_TIMEOUT_MS 5000UL   // 发出 REQUEST_DELTA 后 (或两个补发点之间) 的最长等待时间 (毫秒)
+
+// 主循环调度器中各轮询任务的周期 (毫秒)，触摸和 ESP-NOW 接收由事件唤醒，不在此列
+#define MQTT_POLL_INTERVAL_MS 20           // MQTT 客户端轮询 (仅 WiFi 已连接时)
+#define BOOT_BUTTON_POLL_INTERVAL_MS 20    // BOOT 按钮状态轮询
+#define SERIAL_CONSOLE_POLL_INTERVAL_MS 50 // 串口命令行轮询
+#define LED_UPDATE_INTERVAL_MS 10          // 息屏指示灯和呼吸灯更新
+#define SCREEN_IDLE_CHECK_INTERVAL_MS 1000 // 自动息屏检查
+
+// 运行时性能计数器 (perf_counters.cpp)
+#define PERF_WINDOW_MS 1000                 // 速率 (每秒次数) 和帧耗时的统计窗口 (毫秒)
+#define PERF_MQTT_INTERVAL_MS 10000         // WiFi 连接时发布计数器快照的周期 (毫秒)
+#define PERF_MQTT_TOPIC_PREFIX "firenote/stats/" // 发布主题前缀，后接本机 MAC (不含冒号)
+#define ALLOC_AUDIT 0                       // 设为 1 时替换全局 operator new/delete，按调用点统计堆分配 (串口命令 "alloc")
+
+// 自动息屏与浅睡眠待机 (power_manager.cpp)
+// 息屏且空闲后以 "睡 LIGHT_SLEEP_INTERVAL_MS / 醒 LIGHT_SLEEP_LISTEN_WINDOW_MS" 的占空比运行，
+// 醒着的窗口内接收 ESP-NOW 消息、发送心跳；触摸 (XPT2046_IRQ) 和 BOOT 按钮随时唤醒。WiFi 联网 (MQTT) 时不进入浅睡眠。
+// 睡着时错过的点在退出待机后通过增量同步补回 (见 esp_now_handler.h 的 dozeSyncBegin/dozeSyncEnd)。
+#define SCREEN_IDLE_OFF_MS 300000UL          // 无本地操作多久后自动息屏 (毫秒)，0 表示不自动息屏
+#define LIGHT_SLEEP_ENABLED 1                // 设为 0 时息屏后保持全速运行 (与旧版本一致)
+#define LIGHT_SLEEP_IDLE_MS 5000UL           // 息屏后无本地操作多久开始浅睡眠 (毫秒)
+#define LIGHT_SLEEP_INTERVAL_MS 1000UL       // 每次浅睡眠的时长 (毫秒)，由定时器唤醒
+#define LIGHT_SLEEP_LISTEN_WINDOW_MS 60UL    // 定时唤醒后保持清醒的监听窗口 (毫秒)
+#define LIGHT_SLEEP_ACTIVITY_HOLD_MS 10000UL // 收到对端绘制/同步消息后保持清醒的时间 (毫秒)，对端连续作画时不再错过笔迹
 
 // 调试信息切换按钮位置和大小
 #define DEBUG_TOGGLE_BUTTON_X 2                     // 按钮 X 坐标 (左下角)
@@ -121,8 +245,14 @@
 // 项目信息按钮 (调试界面上方)
 #define INFO_BUTTON_W 15
 #define INFO_BUTTON_H 15
-#define INFO_BUTTON_X (2 + 120 - INFO_BUTTON_W - 2) // 调试信息框 (startX=2, width=120) 右上角
-#define INFO_BUTTON_Y (SCREEN_HEIGHT - 42 - INFO_BUTTON_H - 2) // 调试信息框 (startY=SCREEN_HEIGHT-42) 上方
+#define INFO_BUTTON_X (DEBUG_INFO_X + DEBUG_INFO_W - INFO_BUTTON_W - 2) // 调试信息框右上角
+#define INFO_BUTTON_Y (DEBUG_INFO_Y - INFO_BUTTON_H - 2)                 // 调试信息框上方
+
+// 项目信息 / "Coffee" 弹窗区域
+#define POPUP_X 10
+#define POPUP_Y 10
+#define POPUP_W (SCREEN_WIDTH - 2 * POPUP_X)
+#define POPUP_H (SCREEN_HEIGHT - 2 * POPUP_Y)
 
 // "Coffee" 按钮 (调试按钮上方)
 #define COFFEE_BUTTON_X DEBUG_TOGGLE_BUTTON_X      // 与调试按钮 X 坐标相同
@@ -141,8 +271,15 @@
 #define WIFI_BUTTON_W 15
 #define WIFI_BUTTON_H 10
 
+// WiFi 设置界面 "Connect with Default" 按钮
+#define WIFI_CONNECT_BUTTON_X 60
+#define WIFI_CONNECT_BUTTON_Y 100
+#define WIFI_CONNECT_BUTTON_W 200
+#define WIFI_CONNECT_BUTTON_H 50
+
 // 增大 PubSubClient 的缓冲区大小以发送更大的批量数据
 #define MQTT_MAX_PACKET_SIZE 1024
+#define MQTT_STROKE_RESERVE_POINTS 128 // 启动时为 MQTT 整笔发送的笔画缓冲预留的点数 (一条消息大约能装下这么多点)
 
 
 #endif // CONFIG_H
@@ -4,6 +4,10 @@
 #include <vector>
 #include "config.h" // 假设 config.h 中没有 TouchData_t 的定义，但可能包含其他相关常量
 #include <cstdint> // For uint32_t
+#include <cstddef> // For size_t
+#include <cstring> // memcpy
+#include "memory_tier.h" // 分块放在内部 SRAM 或 PSRAM
+#include "stroke_index.h" // 笔划空间索引 (局部重绘用)
 // #include "esp_now_handler.h" // TouchData_t 的定义已移到此处
 
 // ESP-NOW 相关数据结构定义 (从 esp_now_handler.h 移动到此处)
@@ -13,57 +17,373 @@ typedef struct TouchData_s // 使用 _s 后缀表示 struct，_t 用于 typedef
     int y;                   // 映射到屏幕的Y坐标 (用于绘图)
     unsigned long timestamp; // 绘图动作的时间戳 (本地绘制时的 millis())
     bool isReset;            // 如果此操作是清屏重置，则为 true
+    uint16_t strokeLink;     // 只在历史中有意义: 与之连线的上一点往前的距离 (0 为笔划的第一个点)，加入历史时按
+                             // history_continues_stroke 算出 (占用原来的填充字节，消息中的值被忽略)
     uint32_t color;          // 绘图颜色
 } TouchData_t;
 
+// color 的低 16 位是 RGB565 颜色，高位是撤销/重做的标记 (只在历史、闪存记录和同步消息中出现，不参与绘制)
+#define HISTORY_COLOR_MASK 0xFFFFUL
+#define HISTORY_FLAG_HIDDEN 0x10000UL    // 所在笔划已被撤销 (重播、光栅化时跳过)；撤销/重做记录也总是带有此标记
+#define HISTORY_FLAG_TOMBSTONE 0x20000UL // 撤销/重做记录 (墓碑)，不是绘制点: x/y 与颜色为目标笔划的第一个点，
+                                         // timestamp 为目标笔划最后一个点 (低 16 位 x，高 16 位 y)
+#define HISTORY_FLAG_REDO 0x40000UL      // 与 HISTORY_FLAG_TOMBSTONE 一起: 重做 (恢复目标笔划)
 
-// 定义每个内部 vector 的最大容量
+// 不绘制的元素: 已撤销笔划的点和撤销/重做记录
+static inline bool history_point_hidden(const TouchData_t& point) {
+    return (point.color & HISTORY_FLAG_HIDDEN) != 0;
+}
+
+static inline bool history_is_tombstone(const TouchData_t& point) {
+    return (point.color & HISTORY_FLAG_TOMBSTONE) != 0;
+}
+
+// 笔划连线规则 (全量重播、局部重绘、远端点的实时绘制、光栅化、压缩和撤销共用):
+// 每个点只与它之前最近的同色点 previous (跳过撤销/重做记录，不越过复位点，最多往前 HISTORY_STROKE_LINK_MAX 个元素) 比较，
+// 时间戳间隔不超过 TOUCH_STROKE_INTERVAL 时两点属于同一笔划、连线，否则开始新笔划。几台设备同时作画时各自的点在历史中
+// 交错，按颜色找上一点与交错方式无关。隐藏标记不参与判断 (撤销/重做只改变是否绘制，不改变笔划的划分)
+#define HISTORY_STROKE_LINK_MAX 0xFFFF // strokeLink 能表示的最大距离 (50 毫秒内不可能有这么多个点)
+
+static inline bool history_continues_stroke(const TouchData_t& point, const TouchData_t& previous) {
+    return (point.color & HISTORY_COLOR_MASK) == (previous.color & HISTORY_COLOR_MASK) &&
+           point.timestamp - previous.timestamp <= TOUCH_STROKE_INTERVAL;
+}
+
+// 需要重绘的区域 (屏幕坐标)
+typedef struct HistoryRect_s
+{
+    int x;
+    int y;
+    int w;
+    int h;
+} HistoryRect_t;
+
+
+// 定义每个内部分块的最大容量
+// 每个分块第一次写入时一次性分配满容量，之后不再因扩容而反复分配/拷贝 (避免在堆上留下大小不一的空洞)
 #define MAX_VECTOR_SIZE 2048
 
+// 历史分块: 正在写入的最后一块在内部 SRAM；写满后如有 PSRAM 就整块搬到 PSRAM (只读，重播/同步时才访问)，
+// 内部 SRAM 的缓冲留给下一块继续写入。除最后一块外每块都是满的。
+typedef struct HistoryChunk_s
+{
+    TouchData_t* points; // MAX_VECTOR_SIZE 个点的存储，nullptr 表示尚未分配
+    size_t count;        // 已写入的点数
+    bool cold;           // 存储在 PSRAM 中
+} HistoryChunk_t;
+
 // 自定义绘图历史数据结构
+// 撤销/重做不删除点: 记录 (墓碑) 与点一样按顺序追加，加入时就地修改目标笔划各点的隐藏标记 (元素位置和 revision 不变)，
+// 持久化、全量/增量同步时随历史一起保存和发送，恢复或收到时按顺序重新应用。
 class DrawingHistory {
 private:
-    std::vector<std::vector<TouchData_t>> history_vectors;
+    std::vector<HistoryChunk_t> history_chunks;
+    StrokeTileIndex stroke_index; // 随 push_back 增量更新，clear/retain 后重建
+    uint32_t history_revision = 0; // clear/retain/drop_front 后加一 (已有元素的位置可能变化)
+
+    // 按当前内容重新计算各点的连线并重建笔划索引 (隐藏标记随点保留，撤销/重做记录不再重新应用)
+    void rebuild_stroke_index() {
+        stroke_index.clear();
+        size_t total = size();
+        for (size_t index = 0; index < total; ++index) {
+            index_point(index);
+        }
+    }
+
+    // 算出第 index 个元素的连线并加入笔划索引
+    void index_point(size_t index) {
+        TouchData_t& data = at(index);
+        if (history_is_tombstone(data)) {
+            data.strokeLink = 0;
+            stroke_index.skip(index);
+            return;
+        }
+        data.strokeLink = data.isReset ? 0 : find_stroke_link(index);
+        const TouchData_t& previous = (*this)[index - data.strokeLink];
+        stroke_index.add(index, data.x, data.y, data.isReset, data.strokeLink, previous.x, previous.y);
+    }
+
+    // 按 history_continues_stroke 找第 index 个点之前最近的同色点，连线时返回往前的距离，否则返回 0
+    uint16_t find_stroke_link(size_t index) const {
+        const TouchData_t& point = (*this)[index];
+        size_t limit = index > HISTORY_STROKE_LINK_MAX ? index - HISTORY_STROKE_LINK_MAX : 0;
+        for (size_t i = index; i > limit; --i) {
+            const TouchData_t& previous = (*this)[i - 1];
+            if (previous.isReset) {
+                return 0;
+            }
+            if (history_is_tombstone(previous) ||
+                (previous.color & HISTORY_COLOR_MASK) != (point.color & HISTORY_COLOR_MASK)) {
+                continue;
+            }
+            return history_continues_stroke(point, previous) ? static_cast<uint16_t>(index - (i - 1)) : 0;
+        }
+        return 0;
+    }
+
+    TouchData_t& at(size_t index) {
+        return history_chunks[index / MAX_VECTOR_SIZE].points[index % MAX_VECTOR_SIZE];
+    }
+
+    // 从笔划的第一个点 first 开始沿连线找出整条笔划 (几台设备同时作画时同一笔划的点在历史中不一定相邻)，
+    // 对每个点调用 visit(index)，返回最后一个点的位置。与末端连线的只可能是它之后第一个同色点，遇到不连线的同色点即结束
+    template <typename Visit>
+    size_t walk_stroke(size_t first, Visit visit) const {
+        size_t last = first;
+        uint32_t color = (*this)[first].color & HISTORY_COLOR_MASK;
+        visit(first);
+        size_t total = size();
+        for (size_t i = first + 1; i < total && i - last <= HISTORY_STROKE_LINK_MAX; ++i) {
+            const TouchData_t& point = (*this)[i];
+            if (point.isReset) {
+                break;
+            }
+            if (history_is_tombstone(point) || (point.color & HISTORY_COLOR_MASK) != color) {
+                continue;
+            }
+            if (point.strokeLink == 0 || i - point.strokeLink != last) {
+                break;
+            }
+            visit(i);
+            last = i;
+        }
+        return last;
+    }
+
+    // index 是否与不早于 first 的点连线: 没有时 index 是笔划的第一个点
+    // (同一毫秒采到的重复点等情况下，坐标相同的点不一定是笔划的开头)
+    bool continues_earlier_point(size_t index, size_t first) const {
+        const TouchData_t& point = (*this)[index];
+        return point.strokeLink != 0 && index - point.strokeLink >= first;
+    }
+
+    // 隐藏或恢复从 first 开始的笔划的全部点，返回笔划的外接矩形 (笔划的划分与隐藏标记无关，可以边走边改)
+    HistoryRect_t set_stroke_hidden(size_t first, bool hidden) {
+        int min_x = at(first).x, max_x = min_x, min_y = at(first).y, max_y = min_y;
+        walk_stroke(first, [&](size_t index) {
+            TouchData_t& point = at(index);
+            point.color = hidden ? (point.color | HISTORY_FLAG_HIDDEN) : (point.color & ~HISTORY_FLAG_HIDDEN);
+            min_x = point.x < min_x ? point.x : min_x;
+            max_x = point.x > max_x ? point.x : max_x;
+            min_y = point.y < min_y ? point.y : min_y;
+            max_y = point.y > max_y ? point.y : max_y;
+        });
+        return HistoryRect_t{min_x, min_y, max_x - min_x + 1, max_y - min_y + 1};
+    }
+
+    // 应用撤销/重做记录: 在撤销窗口中从新到旧查找指纹相同、且可见性与操作相反的笔划
+    // (撤销找可见的，重做找已撤销的)，找到时隐藏/恢复它
+    bool apply_tombstone(const TouchData_t& record, HistoryRect_t* changed) {
+        bool redo = (record.color & HISTORY_FLAG_REDO) != 0;
+        size_t first = undo_window_start();
+        for (size_t index = size(); index > first; --index) {
+            const TouchData_t& point = (*this)[index - 1];
+            if (point.x != record.x || point.y != record.y || history_is_tombstone(point) || point.isReset ||
+                history_point_hidden(point) != redo ||
+                (point.color & HISTORY_COLOR_MASK) != (record.color & HISTORY_COLOR_MASK) ||
+                continues_earlier_point(index - 1, first)) {
+                continue;
+            }
+            TouchData_t key;
+            stroke_tombstone(index - 1, redo, key);
+            if (key.timestamp != record.timestamp) {
+                continue; // 最后一个点不同: 从同一位置开始的另一条笔划
+            }
+            HistoryRect_t rect = set_stroke_hidden(index - 1, !redo);
+            if (changed != nullptr) {
+                *changed = rect;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // 为分块分配存储，首选层不足时退回另一层
+    static bool allocate_chunk(HistoryChunk_t& chunk, MemoryTier_t tier) {
+        MemoryTier_t other = tier == MEMORY_TIER_INTERNAL ? MEMORY_TIER_PSRAM : MEMORY_TIER_INTERNAL;
+        chunk.points = static_cast<TouchData_t*>(memoryTierAlloc(sizeof(TouchData_t) * MAX_VECTOR_SIZE, tier, false));
+        chunk.cold = tier == MEMORY_TIER_PSRAM;
+        if (chunk.points == nullptr) {
+            chunk.points = static_cast<TouchData_t*>(memoryTierAlloc(sizeof(TouchData_t) * MAX_VECTOR_SIZE, other, false));
+            chunk.cold = other == MEMORY_TIER_PSRAM;
+        }
+        return chunk.points != nullptr;
+    }
+
+    // 元素已前移到 [0, new_size)，释放多余分块 (最后一块保留满容量，继续写入) 并重建索引
+    void shrink_to(size_t new_size) {
+        size_t chunk_count = new_size == 0 ? 1 : (new_size + MAX_VECTOR_SIZE - 1) / MAX_VECTOR_SIZE;
+        for (size_t i = chunk_count; i < history_chunks.size(); ++i) {
+            free_chunk(history_chunks[i]);
+        }
+        history_chunks.resize(chunk_count);
+        for (auto& chunk : history_chunks) {
+            chunk.count = MAX_VECTOR_SIZE;
+        }
+        history_chunks.back().count = new_size - (chunk_count - 1) * MAX_VECTOR_SIZE;
+        promote_chunk(history_chunks.back()); // 先释放多余分块，腾出的内部缓冲正好给最后一块
+        rebuild_stroke_index();
+        ++history_revision;
+    }
+
+    static void free_chunk(HistoryChunk_t& chunk) {
+        memoryTierFree(chunk.points);
+        chunk.points = nullptr;
+        chunk.count = 0;
+        chunk.cold = false;
+    }
+
+    // 把写满的内部 SRAM 分块搬到 PSRAM，返回腾出的内部缓冲 (没有 PSRAM、PSRAM 不足或已在 PSRAM 时返回 nullptr)
+    static TouchData_t* demote_chunk(HistoryChunk_t& chunk) {
+        if (chunk.cold || !memoryTierHasPsram()) {
+            return nullptr;
+        }
+        void* cold = memoryTierAlloc(sizeof(TouchData_t) * MAX_VECTOR_SIZE, MEMORY_TIER_PSRAM, false);
+        if (cold == nullptr) {
+            return nullptr;
+        }
+        memcpy(cold, chunk.points, sizeof(TouchData_t) * chunk.count);
+        TouchData_t* hot = chunk.points;
+        chunk.points = static_cast<TouchData_t*>(cold);
+        chunk.cold = true;
+        return hot;
+    }
+
+    // 最后一块在 PSRAM 时 (压缩后或内部 SRAM 曾经不足) 尽量搬回内部 SRAM
+    static void promote_chunk(HistoryChunk_t& chunk) {
+        if (!chunk.cold) {
+            return;
+        }
+        void* hot = memoryTierAlloc(sizeof(TouchData_t) * MAX_VECTOR_SIZE, MEMORY_TIER_INTERNAL, false);
+        if (hot == nullptr) {
+            return;
+        }
+        memcpy(hot, chunk.points, sizeof(TouchData_t) * chunk.count);
+        memoryTierFree(chunk.points);
+        chunk.points = static_cast<TouchData_t*>(hot);
+        chunk.cold = false;
+    }
 
 public:
     DrawingHistory() {
-        // 初始创建一个 vector
-        history_vectors.push_back(std::vector<TouchData_t>());
+        // 初始创建一个 (尚未分配存储的) 分块
+        history_chunks.push_back(HistoryChunk_t{nullptr, 0, false});
     }
 
-    // 添加元素
-    void push_back(const TouchData_t& data) {
-        // 获取最后一个 vector 的引用
-        std::vector<TouchData_t>& last_vector = history_vectors.back();
+    ~DrawingHistory() {
+        for (auto& chunk : history_chunks) {
+            free_chunk(chunk);
+        }
+    }
+
+    DrawingHistory(const DrawingHistory&) = delete;
+    DrawingHistory& operator=(const DrawingHistory&) = delete;
 
-        // 如果最后一个 vector 已满，则创建一个新的 vector
-        if (last_vector.size() >= MAX_VECTOR_SIZE) {
-            history_vectors.push_back(std::vector<TouchData_t>());
-            // 更新 last_vector 引用到新的 vector
-            // 注意：这里不需要更新 last_vector 引用，因为 back() 返回的是引用，
-            // push_back 会使之前的引用失效，需要重新获取
-            // std::vector<TouchData_t>& new_last_vector = history_vectors.back();
-            // last_vector = new_last_vector; // 这行是错误的逻辑
+    // 添加元素，返回是否加入 (存储分配失败时丢弃该点)。
+    // 撤销/重做记录先隐藏/恢复目标笔划，找不到目标时不加入；changed 不为空时写入目标笔划的外接矩形
+    bool push_back(const TouchData_t& data, HistoryRect_t* changed = nullptr) {
+        bool tombstone = history_is_tombstone(data);
+        if (tombstone && !apply_tombstone(data, changed)) {
+            return false;
+        }
+        if (history_chunks.back().count >= MAX_VECTOR_SIZE) {
+            // 最后一块已满: 搬到 PSRAM 并复用它的内部缓冲，否则新分配
+            TouchData_t* hot = demote_chunk(history_chunks.back());
+            history_chunks.push_back(HistoryChunk_t{hot, 0, false});
         }
 
-        // 将数据添加到当前（最后一个）vector
-        history_vectors.back().push_back(data); // 直接使用 back() 获取最新的 vector
+        HistoryChunk_t& tail = history_chunks.back();
+        if (tail.points == nullptr && !allocate_chunk(tail, MEMORY_TIER_INTERNAL)) {
+            return false; // 整块分配 (新分块、清空后的第一个点)
+        }
+        tail.points[tail.count++] = data;
+        if (tombstone) {
+            tail.points[tail.count - 1].color |= HISTORY_FLAG_HIDDEN;
+        }
+        index_point(size() - 1);
+        return true;
     }
 
-    // 清空所有历史记录
+    // 清空所有历史记录 (保留最后一块的内部 SRAM 缓冲继续写入，其余分块释放)
     void clear() {
-        history_vectors.clear();
-        // 清空后至少保留一个空的 vector
-        history_vectors.push_back(std::vector<TouchData_t>());
+        HistoryChunk_t tail = history_chunks.back();
+        history_chunks.pop_back();
+        for (auto& chunk : history_chunks) {
+            free_chunk(chunk);
+        }
+        if (tail.cold) {
+            free_chunk(tail);
+        }
+        tail.count = 0;
+        history_chunks.clear();
+        history_chunks.push_back(tail);
+        stroke_index.clear();
+        ++history_revision;
+    }
+
+    // 原地删除前 keep.size() 个元素中 keep[i] 为 false 的元素 (之后的元素全部保留)，
+    // 并释放压缩后多出来的分块 (最后一块保留满容量，继续写入)，返回删除的元素数
+    size_t retain(const std::vector<bool>& keep) {
+        size_t total = size();
+        size_t write_index = 0;
+        for (size_t read_index = 0; read_index < total; ++read_index) {
+            if (read_index < keep.size() && !keep[read_index]) {
+                continue;
+            }
+            if (write_index != read_index) {
+                history_chunks[write_index / MAX_VECTOR_SIZE].points[write_index % MAX_VECTOR_SIZE] =
+                    history_chunks[read_index / MAX_VECTOR_SIZE].points[read_index % MAX_VECTOR_SIZE];
+            }
+            ++write_index;
+        }
+
+        shrink_to(write_index);
+        return total - write_index;
+    }
+
+    // 删除前 count 个元素 (已展平到光栅底图)，之后的元素前移，释放多出来的分块
+    void drop_front(size_t count) {
+        size_t total = size();
+        if (count > total) {
+            count = total;
+        }
+        for (size_t read_index = count; read_index < total; ++read_index) {
+            size_t write_index = read_index - count;
+            history_chunks[write_index / MAX_VECTOR_SIZE].points[write_index % MAX_VECTOR_SIZE] =
+                history_chunks[read_index / MAX_VECTOR_SIZE].points[read_index % MAX_VECTOR_SIZE];
+        }
+        shrink_to(total - count);
     }
 
-    // 获取总元素数量
+    // 获取总元素数量 (除最后一块外都是满的)
     size_t size() const {
-        size_t total_size = 0;
-        for (const auto& vec : history_vectors) {
-            total_size += vec.size();
+        return (history_chunks.size() - 1) * MAX_VECTOR_SIZE + history_chunks.back().count;
+    }
+
+    // clear/retain/drop_front 的次数，调用方据此判断按位置缓存的结果是否失效
+    uint32_t revision() const {
+        return history_revision;
+    }
+
+    // 存储在 PSRAM 中的分块数和全部分块数
+    size_t cold_chunk_count() const {
+        size_t cold = 0;
+        for (const auto& chunk : history_chunks) {
+            cold += chunk.cold ? 1 : 0;
+        }
+        return cold;
+    }
+    size_t chunk_count() const {
+        return history_chunks.size();
+    }
+
+    // 分块存储 (按满容量计) 和笔划索引占用的内存 (字节)，与内存预算比较
+    size_t memory_bytes() const {
+        size_t bytes = stroke_index.memoryBytes();
+        for (const auto& chunk : history_chunks) {
+            bytes += chunk.points != nullptr ? sizeof(TouchData_t) * MAX_VECTOR_SIZE : 0;
         }
-        return total_size;
+        return bytes;
     }
 
     // 检查是否为空
@@ -74,12 +394,12 @@ public:
     // 访问元素 (需要实现迭代器或索引访问)
     // 为了简化，先实现一个简单的索引访问，但需要考虑如何映射全局索引到内部 vector 的索引
     const TouchData_t& operator[](size_t index) const {
-        // 计算元素所在的内部 vector 索引和其在内部 vector 中的索引
+        // 计算元素所在的分块索引和其在分块中的索引
         size_t vector_index = index / MAX_VECTOR_SIZE;
         size_t element_index = index % MAX_VECTOR_SIZE;
 
         // 检查索引是否越界
-        if (vector_index >= history_vectors.size() || element_index >= history_vectors[vector_index].size()) {
+        if (vector_index >= history_chunks.size() || element_index >= history_chunks[vector_index].count) {
             // 处理越界错误，这里简单地抛出异常或返回默认值
             // 在嵌入式环境中，抛出异常可能不合适，可以考虑其他错误处理方式
             // 为了示例，这里使用 assert
@@ -91,7 +411,57 @@ public:
              // 这里暂时假设索引是有效的
         }
 
-        return history_vectors[vector_index][element_index];
+        return history_chunks[vector_index].points[element_index];
+    }
+
+    // 笔划空间索引 (只覆盖最后一个复位点之后的点)
+    const StrokeTileIndex& strokes() const {
+        return stroke_index;
+    }
+
+    // 绘制第 index 个点时的连线起点 (所有绘制路径共用): 按 history_continues_stroke 与之连线的上一点，
+    // 该点是笔划的第一个点或上一点已撤销时返回 nullptr (只画这一个点)
+    const TouchData_t* stroke_previous(size_t index) const {
+        const TouchData_t& point = (*this)[index];
+        if (point.strokeLink == 0) {
+            return nullptr;
+        }
+        const TouchData_t& previous = (*this)[index - point.strokeLink];
+        return history_point_hidden(previous) ? nullptr : &previous;
+    }
+
+    // 最近 HISTORY_UNDO_WINDOW 笔划中第一笔的起点 (笔划不足时为最后一个复位点之后的起点)。
+    // 之后的笔划还可能被本机或对端撤销/重做，压缩和展平只改动之前的部分
+    size_t undo_window_start() const {
+        size_t count = stroke_index.strokeCount();
+        return count > HISTORY_UNDO_WINDOW ? stroke_index.strokeStart(count - HISTORY_UNDO_WINDOW) : stroke_index.visibleStart();
+    }
+
+    // 在撤销窗口中从新到旧查找本机画的、还未撤销的笔划的第一个点 (坐标和时间戳相同)，找不到时返回 size()
+    size_t find_visible_point(int x, int y, unsigned long timestamp) const {
+        size_t first = undo_window_start();
+        for (size_t index = size(); index > first; --index) {
+            const TouchData_t& point = (*this)[index - 1];
+            if (point.x == x && point.y == y && point.timestamp == timestamp && !history_point_hidden(point) &&
+                !point.isReset && !continues_earlier_point(index - 1, first)) {
+                return index - 1;
+            }
+        }
+        return size();
+    }
+
+    // 生成撤销 (redo 为 false) 或重做从 first 开始的笔划的记录。以笔划首尾两点和颜色作为指纹:
+    // 压缩化简时首尾点总是保留，各设备上同一笔划的坐标和颜色相同 (时间戳不一定，MQTT 收到的点用到达时间)
+    void stroke_tombstone(size_t first, bool redo, TouchData_t& record) const {
+        const TouchData_t& start = (*this)[first];
+        const TouchData_t& last = (*this)[walk_stroke(first, [](size_t) {})];
+        memset(&record, 0, sizeof(record));
+        record.x = start.x;
+        record.y = start.y;
+        record.timestamp = (uint32_t)(uint16_t)last.x | ((uint32_t)(uint16_t)last.y << 16);
+        record.isReset = false;
+        record.color = (start.color & HISTORY_COLOR_MASK) | HISTORY_FLAG_TOMBSTONE | HISTORY_FLAG_HIDDEN |
+                       (redo ? HISTORY_FLAG_REDO : 0);
     }
 
     // TODO: 实现迭代器以支持范围for循环和其他算法
@@ -6,8 +6,20 @@
 #include <cstring>      // For memcpy, memset, snprintf
 #include <TFT_eSPI.h> // 需要 TFT_eSPI::color565 等，以及 tft 对象
 #include "touch_handler.h" // For TS_Point type
-#include <vector> // 用于 getPeerInfoList 返回值
-#include <map> // 用于 std::map
+#include <algorithm> // 用于 std::min
+#include "latency_stats.h" // 远端绘制延迟统计
+#include "spsc_queue.h" // 接收回调 / 主循环 -> 网络任务的无锁队列
+#include "render_queue.h" // 网络任务 -> 主循环的绘制命令
+#include "wifi_manager.h" // isWifiConnected()
+#include <freertos/semphr.h> // 历史记录和对端列表的互斥锁
+#include "power_manager.h" // 对端活动时推迟浅睡眠
+#include "canvas_store.h" // 历史记录写入闪存
+#include <esp_sleep.h> // 判断是否从深度睡眠醒来
+#include "raster_sync.h" // 光栅同步的图块绘制与游程编码
+#include "history_compact.h" // 空闲时压缩绘图历史
+#include "perf_counters.h" // 按消息类型的收发帧计数
+#include "canvas_framebuffer.h" // 有 PSRAM 时重播改为推送画布帧缓冲
+#include "raster_base.h" // 超出内存预算时把较早的笔划展平为光栅底图
 
 // TFT_eSPI tft 对象和 drawMainInterface 函数在 Project-ESPNow.ino 中定义
 // 通过 extern 声明来在此文件中使用它们
@@ -19,16 +31,19 @@ extern void clearScreenAndCache();
 // 定义在 esp_now_handler.h 中声明的全局变量
 esp_now_peer_info_t broadcastPeerInfo;
 uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}; // ESP-NOW 广播地址
-std::queue<SyncMessage_t> incomingMessageQueue;                    // ESP-NOW 接收消息队列
-DrawingHistory allDrawingHistory;                        // 所有绘图操作的历史记录
-std::set<String> macSet;                                           // 已发现的对端设备 MAC 地址
-std::map<String, unsigned long> peerLastHeartbeat; // 存储每个对端的最后心跳时间
+DrawingHistory allDrawingHistory;                        // 所有绘图操作的历史记录 (只由网络任务写入)
 
-// PeerInfo_t 结构体定义已移至 esp_now_handler.h
-// 已移除重复的 PeerInfo_s 结构体定义和 PeerInfo_t typedef
-
-// 新增：存储所有已知对端详细信息的 map
-std::map<String, PeerInfo_t> peerInfoMap;
+// 已发现的对端 (按 MAC 升序排列的定长表，受 peerMutex 保护；只由网络任务增删)
+typedef struct PeerEntry_s
+{
+    uint8_t mac[6];
+    unsigned long lastHeartbeat; // 最后一次收到该对端消息的时间
+    bool hasInfo;                // 收到过带运行时间/内存信息的消息 (旧版 MAC 广播没有)
+    PeerInfo_t info;
+} PeerEntry_t;
+static PeerEntry_t peerTable[MAX_TRACKED_PEERS];
+static size_t peerTableCount = 0;
+static size_t peerTableInfoCount = 0;
 
 
 unsigned long lastKnownPeerUptime = 0;
@@ -41,17 +56,124 @@ bool isAwaitingSyncStartResponse = false;
 bool isReceivingDrawingData = false; // 修正：这里之前少了一个 bool 关键字
 bool isSendingDrawingData = false;
 size_t currentHistorySendIndex = 0; // 定义新增的全局变量
+size_t historySendEndIndex = 0;
 long relativeBootTimeOffset = 0;
 unsigned long uptimeOfLastPeerSyncedFrom = 0;
 unsigned long timeRequestSentForAllDrawings = 0; // 新增：记录请求所有绘图数据的时间戳
 
 // 用于接收进度条的变量
 static size_t receivedHistoryPointCount = 0;
-static uint16_t totalPointsExpectedFromPeer = 0;
+static uint32_t totalPointsExpectedFromPeer = 0;
+
+// --- 网络任务与队列 ---
+static SpscQueue<ReceivedMessage_t, RADIO_RX_QUEUE_SIZE> radioRxQueue; // ESP-NOW 接收回调 (WiFi 任务) -> 网络任务
+static SpscQueue<NetworkOp_t, NETWORK_OP_QUEUE_SIZE> networkOpQueue;   // 主循环 -> 网络任务
+static TaskHandle_t networkTaskHandle = nullptr;
+static SemaphoreHandle_t historyMutex = nullptr; // 保护 allDrawingHistory (网络任务写入 vs 主循环重播/读取)
+static SemaphoreHandle_t peerMutex = nullptr;    // 保护对端列表 (网络任务写入 vs 主循环遍历)
+static NetworkTaskStats_t networkStats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// --- 光栅同步 ---
+static SpscQueue<RasterTileMessage_t, RASTER_RX_QUEUE_SIZE> rasterRxQueue; // 接收回调 -> 网络任务的图块数据
+// 响应方 (只由网络任务访问)
+static bool isSendingRaster = false;                     // 本次全量发送使用光栅同步 (isSendingDrawingData 同时为 true)
+static bool rasterTileMarked[RASTER_TILE_COUNT];         // 要发送的图块
+static uint16_t rasterSendTile = 0;                      // 下一个要发送的图块
+static size_t rasterSendStart = 0;                       // 历史中最后一个复位点之后的起点
+static uint32_t rasterChunksTotal = 0;
+static uint32_t rasterChunksSent = 0;
+static uint16_t rasterTilePixels[RASTER_TILE_PIXELS];    // 图块绘制缓冲
+static_assert(RASTER_BASE_CHUNK_BYTES == RASTER_CHUNK_DATA_BYTES, "底图的数据段原样作为图块消息发送");
+static bool rasterSendBase = false;                      // 发送的是光栅底图，之后逐点发送历史
+static uint32_t rasterSendBaseRevision = 0;              // 开始发送时底图的 revision (期间清屏则提前结束)
+static size_t historySendProgressOffset = 0;             // 逐点发送的进度接在已发送的底图数据段之后
+static size_t rasterSendEnd = 0;                         // 光栅化到此为止 (撤销窗口的起点)，之后的历史逐点发送
+static size_t historySendStartIndex = 0;                 // 逐点发送的起点 (光栅同步之后为 rasterSendEnd)
+// 请求方 (只由网络任务访问)
+static bool isReceivingRaster = false;                   // 当前接收的全量同步是光栅方式
+static unsigned long lastSyncTrafficMs = 0;              // 请求方最近一次发出请求或收到同步数据的时间
+static unsigned long rasterRunTimestamp = 0;             // 上一个还原游程的时间戳
+
+// --- 历史压缩 (只由网络任务访问，统计由主循环读取) ---
+static HistoryCompactJob_t compactJob = {}; // phase 为 COMPACT_IDLE
+static size_t historySizeAfterCompact = 0;    // 上次压缩后的历史长度
+static unsigned long lastHistoryAppendMs = 0; // 最近一次加入历史的时间
+static unsigned long compactStartMs = 0;
+static volatile bool compactRequested = false; // 串口命令要求立即压缩 (不等新增点数达到阈值)
+static HistoryCompactStats_t compactStats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// --- 历史内存预算 (只由网络任务访问，统计由主循环读取) ---
+static RasterFlattenJob_t flattenJob; // 约 5KB 的图块和编码缓冲，静态分配
+static unsigned long flattenStartMs = 0;
+static unsigned long flattenAbortMs = 0;
+static bool flattenEverAborted = false;
+static volatile size_t historyBudgetOverride = 0; // 串口命令设置的预算，0 表示默认
+static HistoryBudgetStats_t budgetStats = {0, 0, 0, 0};
+
+// --- 撤销/重做 (只由网络任务访问) ---
+// 本机最近画的笔划以第一个点识别 (压缩保留笔划首尾两点)，撤销时在历史的撤销窗口中查找其中最新的、还未撤销的笔划，
+// 沿时间戳找出整条笔划 (DrawingHistory::stroke_tombstone)
+typedef struct OwnStroke_s
+{
+    int x;
+    int y;
+    unsigned long timestamp;
+} OwnStroke_t;
+static OwnStroke_t ownStrokes[HISTORY_UNDO_DEPTH]; // 环形缓冲，ownStrokeNext 之前的是最新的
+static size_t ownStrokeNext = 0;
+static size_t ownStrokeCount = 0;
+static TouchData_t redoRecords[HISTORY_UNDO_DEPTH]; // 撤销后可重做的记录 (栈顶为最近撤销的笔划)
+static size_t redoCount = 0;
+
+// --- 深度睡眠前后的增量同步 ---
+#define SLEEP_SYNC_MAGIC 0x534C5046 // "FPLS"
+
+// 睡前保存在 RTC 内存中的同步元数据 (深度睡眠期间保持，复位/断电后失效)
+typedef struct SleepSyncState_s
+{
+    uint32_t magic;                         // SLEEP_SYNC_MAGIC，醒来读取后清零 (只使用一次)
+    unsigned long effectiveUptimeAtSleep;   // 睡前的有效运行时间 (millis() + relativeBootTimeOffset)
+    uint32_t historyCount;                  // 写入闪存快照的点数 (本机的序号)，与醒来时恢复的点数核对
+    uint8_t peerCount;                      // 睡前在线的对端数
+    uint8_t peerMacs[SLEEP_SYNC_MAX_PEERS][6];
+} SleepSyncState_t;
+RTC_DATA_ATTR static SleepSyncState_t sleepSyncState;
+
+// 醒来后请求增量的状态 (setup 中设置，之后只由网络任务访问)
+enum DeltaRequestState_e
+{
+    DELTA_IDLE,             // 没有进行中的增量同步 (正常同步流程)
+    DELTA_WAITING_FOR_PEER, // 等待睡前的对端重新出现
+    DELTA_REQUESTED,        // 已发送 REQUEST_DELTA，接收补发的点
+};
+typedef enum DeltaRequestState_e DeltaRequestState_t;
+static DeltaRequestState_t deltaRequestState = DELTA_IDLE;
+static unsigned long deltaStateSinceMs = 0; // 进入当前状态 (或最近收到补发点) 的时间
+static uint32_t deltaPointsReceived = 0;
+
+// 浅睡眠待机 (网络任务): 开始时像深度睡眠前一样广播 SLEEP_NOTICE，结束后向待机前的对端请求增量，
+// 补回射频关闭期间错过的点。待机的监听窗口内收到的点会在补发中再出现一次，按 dozeHistoryStart 之后的历史去重
+static bool dozeNoticeSent = false;
+static size_t dozeHistoryStart = 0;      // 待机开始时的历史长度
+static bool deltaSkipDuplicates = false; // 本次增量是待机后请求的，补发的点须去重
+
+// 对端睡前本机的历史位置 (响应方，只由网络任务访问)
+typedef struct SleepMark_s
+{
+    size_t historyIndex; // 收到 SLEEP_NOTICE 时本机的历史长度
+    bool resetSince;     // 此后本机清过屏，须先让对端清屏再从头补发
+    uint8_t mac[6];
+} SleepMark_t;
+static SleepMark_t sleepMarks[MAX_TRACKED_PEERS]; // 定长表，只由网络任务访问
+static size_t sleepMarkCount = 0;
+
+// 正在为醒来的对端补发的增量 (响应方)
+static bool isSendingDelta = false;
+static uint8_t deltaTargetMac[6];
+static size_t deltaSendStartIndex = 0;
+static size_t deltaSendIndex = 0;
+static size_t deltaSendEndIndex = 0;
 
-// 触摸点处理相关 (用于远程点绘制)
-TS_Point lastRemotePoint = {0, 0, 0}; // 远程最后一点
-unsigned long lastRemoteDrawTime = 0; // 远程最后绘制时间
 // unsigned long touchInterval = 50;     // 触摸笔划间隔阈值 (毫秒) -> 已移至 config.h 作为 TOUCH_STROKE_INTERVAL
 
 // ESP-NOW 初始化函数
@@ -102,48 +224,206 @@ void OnSyncDataSent(const uint8_t *mac_addr, esp_now_send_status_t status)
     }
 }
 
-// ESP-NOW 数据接收回调函数
-void OnSyncDataRecv(const esp_now_recv_info *info, const uint8_t *incomingDataPtr, int len)
+bool remotePointInRange(const TouchData_t &point)
 {
-    if (len == sizeof(SyncMessage_t))
-    {
-        SyncMessage_t receivedMsg;
-        memcpy(&receivedMsg, incomingDataPtr, sizeof(receivedMsg));
-        memcpy(lastPeerMac, info->src_addr, 6); // 更新最后通信的对端 MAC
-
-        char macStr[18];
-        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-                 info->src_addr[0], info->src_addr[1], info->src_addr[2],
-                 info->src_addr[3], info->src_addr[4], info->src_addr[5]);
-        macSet.insert(String(macStr)); // 添加到 MAC 地址集合中用于计数
-        peerLastHeartbeat[String(macStr)] = millis(); // 更新对端的最后心跳时间
+    return point.x >= -REMOTE_POINT_MARGIN && point.x < SCREEN_WIDTH + REMOTE_POINT_MARGIN &&
+           point.y >= -REMOTE_POINT_MARGIN && point.y < SCREEN_HEIGHT + REMOTE_POINT_MARGIN;
+}
 
-        // 更新或添加对端详细信息
-        peerInfoMap[String(macStr)].macAddress = String(macStr);
-        peerInfoMap[String(macStr)].effectiveUptime = receivedMsg.senderUptime + receivedMsg.senderOffset;
-        peerInfoMap[String(macStr)].usedMemory = receivedMsg.usedMemory;
-        peerInfoMap[String(macStr)].totalMemory = receivedMsg.totalMemory;
+// 校验收到的同步消息 (接收回调中，入队前)。对端的帧不可信: 类型未知或点坐标越界 (远端连线的绘制量与线段长度成正比)
+// 时返回 false；isReset 按字节读出后规范为 0/1，对端写入其他值时直接读 bool 是未定义行为
+static_assert(sizeof(MessageType_t) == sizeof(int), "消息类型按 int 从帧中读出");
+static_assert(sizeof(unsigned long) != 4 || sizeof(SyncMessage_t) == 44, "totalPointsForSync 加宽不能改变设备上的消息大小");
 
+// 计数写入 SyncMessage_t::totalPointsForSync: 设备上 size_t 就是 32 位；主机上超出 32 位时饱和，不静默截断
+static uint32_t syncCountField(size_t count)
+{
+    return (uint64_t)count > UINT32_MAX ? UINT32_MAX : (uint32_t)count;
+}
+static bool sanitizeSyncMessage(int rawType, SyncMessage_t &msg)
+{
+    if (rawType < MSG_TYPE_UPTIME_INFO || rawType > MSG_TYPE_STROKE_TOMBSTONE || rawType == MSG_TYPE_RASTER_TILE)
+        return false;
+    uint8_t resetByte;
+    memcpy(&resetByte, &msg.touch_data.isReset, sizeof(resetByte));
+    msg.touch_data.isReset = resetByte != 0;
+    // 颜色的高位只保留与消息类型相符的标记: 点不能带撤销/重做记录的标记，记录总是带有
+    uint32_t &color = msg.touch_data.color;
+    if (rawType == MSG_TYPE_DRAW_POINT)
+        color &= HISTORY_COLOR_MASK | HISTORY_FLAG_HIDDEN;
+    else if (rawType == MSG_TYPE_STROKE_TOMBSTONE)
+    {
+        color = (color & (HISTORY_COLOR_MASK | HISTORY_FLAG_REDO)) | HISTORY_FLAG_TOMBSTONE | HISTORY_FLAG_HIDDEN;
+        msg.touch_data.isReset = false;
+    }
+    return (rawType != MSG_TYPE_DRAW_POINT && rawType != MSG_TYPE_STROKE_TOMBSTONE) || remotePointInRange(msg.touch_data);
+}
 
-        incomingMessageQueue.push(receivedMsg); // 将消息放入队列等待处理
+// ESP-NOW 数据接收回调函数 (运行在 WiFi 任务中，只拷贝消息并唤醒网络任务)
+void OnSyncDataRecv(const esp_now_recv_info *info, const uint8_t *incomingDataPtr, int len)
+{
+    ReceivedMessage_t received;
+    int rawType = -1; // 消息类型 (两种消息的第一个字段)，按整数读出再与枚举比较
+    if (len >= (int)sizeof(rawType))
+        memcpy(&rawType, incomingDataPtr, sizeof(rawType));
+    if (len == sizeof(SyncMessage_t))
+    {
+        received.receivedMicros = micros(); // 远端绘制延迟统计的起点
+        memcpy(&received.msg, incomingDataPtr, sizeof(received.msg));
+        received.macOnly = false;
+        if (!sanitizeSyncMessage(rawType, received.msg))
+        {
+            networkStats.rxMalformed++;
+            perfCountFrame(PERF_FRAME_DROPPED, rawType);
+            return;
+        }
+    }
+    else if (len == sizeof(RasterTileMessage_t))
+    {
+        // 光栅同步的图块数据走单独的队列，不占用普通消息队列的空间
+        if (rawType != MSG_TYPE_RASTER_TILE)
+        {
+            networkStats.rxMalformed++;
+            perfCountFrame(PERF_FRAME_DROPPED, PERF_MSG_TYPE_OTHER);
+            return;
+        }
+        RasterTileMessage_t tileMsg;
+        memcpy(&tileMsg, incomingDataPtr, sizeof(tileMsg));
+        if (!rasterRxQueue.push(tileMsg))
+        {
+            networkStats.rxDropped++;
+            perfCountFrame(PERF_FRAME_DROPPED, MSG_TYPE_RASTER_TILE);
+            return;
+        }
+        perfCountFrame(PERF_FRAME_RX, MSG_TYPE_RASTER_TILE);
+        if (networkTaskHandle != nullptr)
+            xTaskNotifyGive(networkTaskHandle);
+        return;
     }
     else if (len == strlen("XX:XX:XX:XX:XX:XX") && incomingDataPtr[0] != '{')
     {
-        // 处理旧版或特定的 MAC 地址广播 (如果项目中有这种逻辑)
-        char macStr[18];
-        memcpy(macStr, incomingDataPtr, len);
-        macStr[len] = '\0';
-        macSet.insert(String(macStr));
-        peerLastHeartbeat[String(macStr)] = millis(); // 更新对端的最后心跳时间
-        // 对于旧版消息，我们没有内存信息，只更新心跳
+        // 处理旧版或特定的 MAC 地址广播 (如果项目中有这种逻辑)，只更新对端列表
+        received.receivedMicros = micros();
+        memset(&received.msg, 0, sizeof(received.msg));
+        received.macOnly = true;
     }
     else
     {
+        perfCountFrame(PERF_FRAME_DROPPED, PERF_MSG_TYPE_OTHER);
         Serial.print("收到意外长度的数据: ");
         Serial.print(len);
         Serial.print(", 期望长度: ");
         Serial.println(sizeof(SyncMessage_t));
+        return;
+    }
+    memcpy(received.srcMac, info->src_addr, 6);
+
+    int perfType = received.macOnly ? PERF_MSG_TYPE_OTHER : rawType; // 旧版 MAC 广播计入 "其他"
+    if (!radioRxQueue.push(received))
+    {
+        networkStats.rxDropped++; // 网络任务处理不过来
+        perfCountFrame(PERF_FRAME_DROPPED, perfType);
+        return;
+    }
+    perfCountFrame(PERF_FRAME_RX, perfType);
+    if (networkTaskHandle != nullptr)
+        xTaskNotifyGive(networkTaskHandle);
+}
+
+static void formatMac(const uint8_t *mac, char macStr[18])
+{
+    snprintf(macStr, 18, "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+// 在按 MAC 升序排列的表中查找，找不到时返回应插入的位置并置 found 为 false
+static size_t findPeerSlot(const uint8_t *mac, bool &found)
+{
+    size_t low = 0, high = peerTableCount;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        int order = memcmp(peerTable[mid].mac, mac, 6);
+        if (order == 0)
+        {
+            found = true;
+            return mid;
+        }
+        if (order < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    found = false;
+    return low;
+}
+
+// 更新对端列表和心跳时间 (网络任务)
+static void recordPeer(const ReceivedMessage_t &received)
+{
+    xSemaphoreTake(peerMutex, portMAX_DELAY);
+    bool found;
+    size_t slot = findPeerSlot(received.srcMac, found);
+    if (!found)
+    {
+        if (peerTableCount >= MAX_TRACKED_PEERS)
+        {
+            xSemaphoreGive(peerMutex); // 列表已满 (超时的对端移除后才记录新对端)，消息照常处理
+            return;
+        }
+        memmove(&peerTable[slot + 1], &peerTable[slot], (peerTableCount - slot) * sizeof(PeerEntry_t));
+        peerTableCount++;
+        PeerEntry_t &entry = peerTable[slot];
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.mac, received.srcMac, 6);
+        formatMac(received.srcMac, entry.info.macAddress);
+    }
+    PeerEntry_t &entry = peerTable[slot];
+    entry.lastHeartbeat = millis(); // 更新对端的最后心跳时间
+    if (!received.macOnly) // 对于旧版消息，我们没有内存信息，只更新心跳
+    {
+        // 更新或添加对端详细信息
+        if (!entry.hasInfo)
+            peerTableInfoCount++;
+        entry.hasInfo = true;
+        entry.info.effectiveUptime = received.msg.senderUptime + received.msg.senderOffset;
+        entry.info.usedMemory = received.msg.usedMemory;
+        entry.info.totalMemory = received.msg.totalMemory;
     }
+    xSemaphoreGive(peerMutex);
+}
+
+// 退出浅睡眠待机时调用: 待机期间只有监听窗口能收到心跳，把所有对端的心跳时间重置为现在，重新计时
+static void refreshPeerHeartbeats()
+{
+    unsigned long currentTime = millis();
+    xSemaphoreTake(peerMutex, portMAX_DELAY);
+    for (size_t i = 0; i < peerTableCount; i++)
+    {
+        peerTable[i].lastHeartbeat = currentTime;
+    }
+    xSemaphoreGive(peerMutex);
+}
+
+size_t peerCount()
+{
+    return peerTableCount;
+}
+
+size_t peerInfoCount()
+{
+    return peerTableInfoCount;
+}
+
+// 睡眠标记表 (网络任务): 查找对端的标记，没有时返回 nullptr
+static SleepMark_t *findSleepMark(const uint8_t *mac)
+{
+    for (size_t i = 0; i < sleepMarkCount; i++)
+    {
+        if (memcmp(sleepMarks[i].mac, mac, 6) == 0)
+            return &sleepMarks[i];
+    }
+    return nullptr;
 }
 
 // 发送同步消息的辅助函数
@@ -151,6 +431,7 @@ void sendSyncMessage(const SyncMessage_t *msg)
 {
     // 调用前应确保 msg->senderUptime 和 msg->senderOffset 已正确设置
     esp_err_t result = esp_now_send(broadcastAddress, (uint8_t *)msg, sizeof(SyncMessage_t));
+    perfCountFrame(result == ESP_OK ? PERF_FRAME_TX : PERF_FRAME_DROPPED, msg->type);
     if (result != ESP_OK)
     {
         Serial.print("发送 SyncMessage 类型 ");
@@ -160,17 +441,458 @@ void sendSyncMessage(const SyncMessage_t *msg)
     }
 }
 
-// 处理接收到的消息队列
-void processIncomingMessages()
+// 单播给指定对端 (增量同步)，需要时先把对端加入 ESP-NOW 对端表
+static void sendSyncMessageTo(const uint8_t *mac, const SyncMessage_t *msg)
+{
+    if (!esp_now_is_peer_exist(mac))
+    {
+        esp_now_peer_info_t peerInfo;
+        memset(&peerInfo, 0, sizeof(peerInfo));
+        memcpy(peerInfo.peer_addr, mac, 6);
+        peerInfo.channel = 0;
+        peerInfo.ifidx = WIFI_IF_STA;
+        peerInfo.encrypt = false;
+        if (esp_now_add_peer(&peerInfo) != ESP_OK)
+        {
+            Serial.println("添加单播对端失败");
+            return;
+        }
+    }
+    esp_err_t result = esp_now_send(mac, (const uint8_t *)msg, sizeof(SyncMessage_t));
+    perfCountFrame(result == ESP_OK ? PERF_FRAME_TX : PERF_FRAME_DROPPED, msg->type);
+    if (result != ESP_OK)
+    {
+        Serial.print("单播 SyncMessage 类型 ");
+        Serial.print(msg->type);
+        Serial.print(" 错误: ");
+        Serial.println(esp_err_to_name(result));
+    }
+}
+
+// 向主循环提交一条不带参数的渲染命令
+static void pushRenderCommand(RenderCommandType_t type, bool notifyScreenOff = false)
+{
+    RenderCommand_t command;
+    memset(&command, 0, sizeof(command));
+    command.type = type;
+    command.notifyScreenOff = notifyScreenOff;
+    renderQueuePush(command);
+}
+
+static void pushProgressCommand(RenderCommandType_t type, int current, int total)
+{
+    RenderCommand_t command;
+    memset(&command, 0, sizeof(command));
+    command.type = type;
+    command.current = current;
+    command.total = total;
+    renderQueuePush(command);
+}
+
+// 加入历史并记录到闪存日志 (网络任务)，返回新点是否与之前的点连线 (DrawingHistory::stroke_previous)；
+// previous 不为空时写入连线的起点
+static bool appendHistory(const TouchData_t &point, TouchData_t *previous = nullptr)
+{
+    bool linked = false;
+    historyLock();
+    if (allDrawingHistory.push_back(point))
+    {
+        const TouchData_t *found = allDrawingHistory.stroke_previous(allDrawingHistory.size() - 1);
+        linked = found != nullptr;
+        if (linked && previous != nullptr)
+            *previous = *found;
+    }
+    historyUnlock();
+    canvasStoreAppend(point);
+    lastHistoryAppendMs = millis();
+    return linked;
+}
+
+// 撤销/重做记录: 加入历史 (隐藏/恢复目标笔划)，交给主循环重绘目标笔划所在的区域。
+// 找不到目标笔划 (已被撤销/重做、或不在撤销窗口中) 时不加入，返回 false
+static bool acceptTombstone(const TouchData_t &record, bool publishMqtt)
+{
+    HistoryRect_t changed;
+    historyLock();
+    bool applied = allDrawingHistory.push_back(record, &changed);
+    historyUnlock();
+    if (!applied)
+        return false;
+    canvasStoreAppend(record);
+    lastHistoryAppendMs = millis();
+
+    RenderCommand_t command;
+    memset(&command, 0, sizeof(command));
+    command.type = RENDER_CMD_REDRAW_REGION;
+    command.point = record;
+    command.region = changed;
+    command.publishMqtt = publishMqtt;
+    command.notifyScreenOff = true;
+    renderQueuePush(command);
+    return true;
+}
+
+// 远端点 (ESP-NOW 和 MQTT): 加入历史并交给主循环绘制，连线的起点按历史中的笔划连线规则确定 (与重播相同)
+static void acceptRemotePoint(const TouchData_t &point, uint32_t receivedMicros)
+{
+    if (history_is_tombstone(point))
+    {
+        acceptTombstone(point, false);
+        return;
+    }
+    TouchData_t previous;
+    bool linked = appendHistory(point, &previous);
+    if (history_point_hidden(point))
+        return; // 同步收到的已撤销笔划的点: 只加入历史
+
+    RenderCommand_t command;
+    memset(&command, 0, sizeof(command));
+    command.type = RENDER_CMD_REMOTE_POINT;
+    command.point = point;
+    command.linked = linked;
+    command.previousX = linked ? previous.x : 0;
+    command.previousY = linked ? previous.y : 0;
+    command.receivedMicros = receivedMicros;
+    command.notifyScreenOff = true;
+    renderQueuePush(command);
+}
+
+static void clearHistory()
+{
+    if (compactJob.phase != COMPACT_IDLE)
+    {
+        historyCompactAbort(compactJob); // 分析的是清空前的历史
+        compactStats.aborted++;
+    }
+    if (flattenJob.active)
+    {
+        rasterFlattenAbort(flattenJob);
+        budgetStats.aborted++;
+    }
+    historySizeAfterCompact = 0;
+    dozeHistoryStart = 0;
+    ownStrokeCount = 0;
+    redoCount = 0;
+    historyLock();
+    allDrawingHistory.clear();
+    rasterBaseClear();
+    historyUnlock();
+    canvasStoreClear();
+
+    // 睡眠中的对端错过了这次清屏，醒来时须先清屏再从头补发
+    for (size_t i = 0; i < sleepMarkCount; i++)
+    {
+        sleepMarks[i].historyIndex = 0;
+        sleepMarks[i].resetSince = true;
+    }
+}
+
+static void drainNetworkOps();
+
+// 估算光栅同步: 绘制并编码每个有内容的图块，统计数据段数 (不发送)。
+// 编码后的字节数不小于逐点发送、或估算期间本机复位清空了历史时返回 false (改为逐点发送)
+static bool measureRasterSync(size_t start, size_t end, uint32_t &chunks)
+{
+    const uint32_t pointStreamBytes = end * sizeof(SyncMessage_t);
+    uint8_t scratch[RASTER_CHUNK_DATA_BYTES];
+    chunks = 0;
+    rasterMarkTiles(allDrawingHistory, start, end, rasterTileMarked);
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+    {
+        if (!rasterTileMarked[tile])
+            continue;
+        if (!rasterRenderTile(allDrawingHistory, start, end, tile, rasterTilePixels))
+        {
+            rasterTileMarked[tile] = false; // 线段外接矩形经过，但没有画到像素
+            continue;
+        }
+        uint16_t offset = 0, chunkOffset, length;
+        while (rasterEncodeChunk(tile, rasterTilePixels, offset, scratch, RASTER_CHUNK_DATA_BYTES, chunkOffset, length, offset))
+        {
+            chunks++;
+        }
+        if (chunks * sizeof(RasterTileMessage_t) >= pointStreamBytes)
+            return false;
+
+        drainNetworkOps(); // 每个图块要遍历一遍历史，期间照常处理本地点
+        if (allDrawingHistory.size() < end)
+            return false;
+    }
+    return true;
+}
+
+// 开始分批发送全部历史 (收到 REQUEST_ALL_DRAWINGS 或压力测试)
+// peerAcceptsRaster: 请求方能接收光栅同步，历史较长且图块编码更小时改为发送画布图块
+static void beginHistorySend(bool peerAcceptsRaster)
+{
+    historySendEndIndex = allDrawingHistory.size(); // 之后新画的点照常实时广播，不计入本次发送
+    isSendingDrawingData = true; // 估算期间 drainNetworkOps 不会再开始一次全量发送
+    isSendingRaster = false;
+    rasterSendBase = false;
+    historySendProgressOffset = 0;
+    historySendStartIndex = 0;
+
+    if (rasterBaseVisible(allDrawingHistory))
+    {
+        if (peerAcceptsRaster)
+        {
+            // 较早的内容已展平为底图: 先发送底图的数据段 (已编码，不必绘制)，再逐点发送之后的历史
+            uint32_t baseChunks = rasterBaseChunkCount();
+            SyncMessage_t rasterStartMsg;
+            memset(&rasterStartMsg, 0, sizeof(rasterStartMsg));
+            rasterStartMsg.type = MSG_TYPE_RASTER_SYNC_START;
+            rasterStartMsg.senderUptime = millis();
+            rasterStartMsg.senderOffset = relativeBootTimeOffset;
+            rasterStartMsg.totalPointsForSync = syncCountField(baseChunks + historySendEndIndex);
+            sendSyncMessage(&rasterStartMsg);
+            Serial.printf("  发送 MSG_TYPE_RASTER_SYNC_START (底图 %lu 段，之后 %lu 个点)\n", (unsigned long)baseChunks,
+                          (unsigned long)historySendEndIndex);
+
+            isSendingRaster = true;
+            rasterSendBase = true;
+            rasterSendBaseRevision = rasterBaseRevision();
+            rasterSendTile = 0;
+            rasterChunksTotal = baseChunks + historySendEndIndex;
+            rasterChunksSent = 0;
+            pushProgressCommand(RENDER_CMD_SEND_PROGRESS, 0, rasterChunksTotal);
+            return;
+        }
+        Serial.println("  对端不能接收光栅同步，只逐点发送底图之上的历史 (较早展平的内容对端收不到)");
+    }
+
+    uint32_t rasterChunks = 0;
+    // 撤销窗口中的笔划还可能被撤销/重做，不光栅化，在图块之后逐点发送
+    rasterSendEnd = std::min(allDrawingHistory.undo_window_start(), historySendEndIndex);
+    if (peerAcceptsRaster && rasterSendEnd >= RASTER_SYNC_MIN_POINTS)
+    {
+        unsigned long measureStartMs = millis();
+        rasterSendStart = rasterVisibleStart(allDrawingHistory, rasterSendEnd);
+        isSendingRaster = measureRasterSync(rasterSendStart, rasterSendEnd, rasterChunks);
+        Serial.printf("  光栅同步估算: %lu 段 (%lu 字节)，逐点发送 %lu 字节，耗时 %lums，%s\n",
+                      (unsigned long)rasterChunks, (unsigned long)(rasterChunks * sizeof(RasterTileMessage_t)),
+                      (unsigned long)(rasterSendEnd * sizeof(SyncMessage_t)), millis() - measureStartMs,
+                      isSendingRaster ? "使用光栅同步" : "逐点发送");
+    }
+    if (isSendingRaster)
+    {
+        SyncMessage_t rasterStartMsg;
+        memset(&rasterStartMsg, 0, sizeof(rasterStartMsg));
+        rasterStartMsg.type = MSG_TYPE_RASTER_SYNC_START;
+        rasterStartMsg.senderUptime = millis();
+        rasterStartMsg.senderOffset = relativeBootTimeOffset;
+        rasterStartMsg.totalPointsForSync = syncCountField(rasterChunks + (historySendEndIndex - rasterSendEnd));
+        sendSyncMessage(&rasterStartMsg);
+        Serial.printf("  发送 MSG_TYPE_RASTER_SYNC_START (将分批发送画布图块，之后 %lu 个点)\n",
+                      (unsigned long)(historySendEndIndex - rasterSendEnd));
+
+        rasterSendTile = 0;
+        rasterChunksTotal = rasterChunks + (historySendEndIndex - rasterSendEnd);
+        rasterChunksSent = 0;
+        if (rasterChunksTotal > 0)
+            pushProgressCommand(RENDER_CMD_SEND_PROGRESS, 0, rasterChunksTotal);
+        else
+            pushRenderCommand(RENDER_CMD_HIDE_SEND_PROGRESS);
+        return;
+    }
+
+    // 发送同步开始信号给请求方，表明本机即将开始发送数据
+    SyncMessage_t syncStartMsgBeforeSending;
+    syncStartMsgBeforeSending.type = MSG_TYPE_SYNC_START;
+    syncStartMsgBeforeSending.senderUptime = millis();
+    syncStartMsgBeforeSending.senderOffset = relativeBootTimeOffset;
+    memset(&syncStartMsgBeforeSending.touch_data, 0, sizeof(TouchData_t));
+    syncStartMsgBeforeSending.totalPointsForSync = syncCountField(historySendEndIndex); // 设置总点数
+    sendSyncMessage(&syncStartMsgBeforeSending);
+    Serial.println("  发送 MSG_TYPE_SYNC_START (准备发送历史数据，将开始分批发送)");
+
+    // 设置状态以开始分批发送，实际发送由网络任务的 sendHistoryBatch 进行
+    if (historySendEndIndex > 0)
+    {
+        pushProgressCommand(RENDER_CMD_SEND_PROGRESS, 0, historySendEndIndex); // 初始化发送进度条
+    }
+    else
+    {
+        pushRenderCommand(RENDER_CMD_HIDE_SEND_PROGRESS); // 如果没有历史记录，则隐藏进度条
+    }
+    isSendingDrawingData = true;
+    currentHistorySendIndex = 0;
+}
+
+// 请求方: 醒来后第一个重新出现的睡前对端，向它单播 REQUEST_DELTA
+static void requestDeltaIfSleptPeer(const uint8_t *mac)
+{
+    for (uint8_t i = 0; i < sleepSyncState.peerCount; i++)
+    {
+        if (memcmp(sleepSyncState.peerMacs[i], mac, 6) != 0)
+            continue;
+
+        SyncMessage_t requestMsg;
+        memset(&requestMsg, 0, sizeof(requestMsg));
+        requestMsg.type = MSG_TYPE_REQUEST_DELTA;
+        requestMsg.senderUptime = millis();
+        requestMsg.senderOffset = relativeBootTimeOffset;
+        requestMsg.totalPointsForSync = sleepSyncState.historyCount;
+        sendSyncMessageTo(mac, &requestMsg);
+
+        deltaRequestState = DELTA_REQUESTED;
+        deltaStateSinceMs = millis();
+        deltaPointsReceived = 0;
+        char macStr[18];
+        formatMac(mac, macStr);
+        Serial.print("向睡前的对端 ");
+        Serial.print(macStr);
+        Serial.println(" 请求睡眠期间的增量");
+        return;
+    }
+}
+
+// 响应方: 开始为醒来的对端补发它睡眠期间本机新增的点 (单播，不影响其他对端)
+static void beginDeltaSend(const uint8_t *mac, const SleepMark_t &mark)
+{
+    memcpy(deltaTargetMac, mac, 6);
+    if (mark.resetSince)
+    {
+        // 对端错过了清屏，先让它清屏并重置同步状态
+        SyncMessage_t resetMsg;
+        memset(&resetMsg, 0, sizeof(resetMsg));
+        resetMsg.type = MSG_TYPE_RESET_CANVAS;
+        resetMsg.senderUptime = millis();
+        resetMsg.senderOffset = relativeBootTimeOffset;
+        resetMsg.touch_data.isReset = true;
+        sendSyncMessageTo(mac, &resetMsg);
+    }
+    deltaSendStartIndex = std::min(mark.historyIndex, allDrawingHistory.size());
+    deltaSendIndex = deltaSendStartIndex;
+    deltaSendEndIndex = allDrawingHistory.size(); // 之后新画的点照常实时广播
+    isSendingDelta = true;
+    char macStr[18];
+    formatMac(mac, macStr);
+    Serial.print("为醒来的对端 ");
+    Serial.print(macStr);
+    Serial.print(" 补发 ");
+    Serial.print(deltaSendEndIndex - deltaSendStartIndex);
+    Serial.println(" 个点");
+}
+
+// 请求方: 等待对端或补发超时后回到原有的全量同步流程
+static void checkDeltaTimeout()
+{
+    unsigned long elapsed = millis() - deltaStateSinceMs;
+    if ((deltaRequestState == DELTA_WAITING_FOR_PEER && elapsed > DELTA_WAIT_FOR_PEER_MS) ||
+        (deltaRequestState == DELTA_REQUESTED && elapsed > DELTA_RESPONSE_TIMEOUT_MS))
+    {
+        Serial.println("增量同步超时，回到全量同步流程");
+        deltaRequestState = DELTA_IDLE;
+        deltaSkipDuplicates = false;
+        initialSyncLogicProcessed = false; // 下一条 UPTIME_INFO 重新做同步决策
+    }
+}
+
+// 请求方: 让主循环画出一个非黑游程 (起点，长度大于 1 时再加同一时间戳的终点，连成水平线)。
+// 游程本身存入光栅底图，不加入历史
+static void drawRasterRun(int x, int y, int length, uint16_t color)
+{
+    rasterRunTimestamp += TOUCH_STROKE_INTERVAL + 1;
+    RenderCommand_t command;
+    memset(&command, 0, sizeof(command));
+    command.type = RENDER_CMD_REMOTE_POINT;
+    command.point.x = x;
+    command.point.y = y;
+    command.point.timestamp = rasterRunTimestamp;
+    command.point.color = color;
+    command.receivedMicros = micros();
+    command.notifyScreenOff = true;
+    renderQueuePush(command);
+    if (length > 1)
+    {
+        command.point.x = x + length - 1;
+        command.linked = true; // 终点只与本游程的起点连线
+        command.previousX = x;
+        command.previousY = y;
+        renderQueuePush(command);
+    }
+}
+
+// 请求方: 处理收到的图块数据 (网络任务)
+static void processRasterTiles()
+{
+    RasterTileMessage_t tileMsg;
+    while (rasterRxQueue.pop(tileMsg))
+    {
+        if (!isReceivingDrawingData || !isReceivingRaster)
+            continue; // 不是本机请求的光栅同步
+        // 图块数据原样存入底图 (画在历史之下，与同步期间收到的实时点的先后无关)，再交给主循环绘制
+        historyLock();
+        bool stored = rasterBaseAppendChunk(tileMsg.tileIndex, tileMsg.pixelOffset, tileMsg.data, tileMsg.length);
+        historyUnlock();
+        if (stored)
+        {
+            rasterDecodeChunk(tileMsg.tileIndex, tileMsg.pixelOffset, tileMsg.data, tileMsg.length, drawRasterRun);
+        }
+        else
+        {
+            Serial.print("  图块数据无效 (图块 ");
+            Serial.print(tileMsg.tileIndex);
+            Serial.println(")，已丢弃");
+        }
+        receivedHistoryPointCount++;
+        lastSyncTrafficMs = millis();
+        pushProgressCommand(RENDER_CMD_RECEIVE_PROGRESS, receivedHistoryPointCount, totalPointsExpectedFromPeer);
+    }
+}
+
+// 请求方: 对端在同步中途消失 (或收到的请求/SYNC_START 是伪造的) 时放弃本次同步。
+// 否则本机会一直忽略实时点 (等待 SYNC_START 时)，也不再发起新的同步
+static void checkSyncReceiveTimeout()
+{
+    if (!(iamRequestingAllData || isReceivingDrawingData) || millis() - lastSyncTrafficMs <= SYNC_RECEIVE_TIMEOUT_MS)
+        return;
+    Serial.println("同步接收超时，放弃本次同步");
+    iamRequestingAllData = false;
+    isReceivingDrawingData = false;
+    isAwaitingSyncStartResponse = false;
+    isReceivingRaster = false;
+    timeRequestSentForAllDrawings = 0;
+    initialSyncLogicProcessed = false; // 下一条 UPTIME_INFO 重新做同步决策
+    pushRenderCommand(RENDER_CMD_HIDE_RECEIVE_PROGRESS);
+}
+
+// 浅睡眠后的增量: 点是否已在待机开始后加入历史 (监听窗口内收到过，或请求前刚收到的实时点)
+static bool receivedSinceDoze(const TouchData_t &point)
 {
-    // 声明外部变量/函数，如果它们在 .ino 或其他模块中定义
-    extern bool isScreenOn;                 // 来自主 .ino 或 power_manager
-    extern bool hasNewUpdateWhileScreenOff; // 来自主 .ino 或 power_manager
+    for (size_t i = std::min(dozeHistoryStart, allDrawingHistory.size()); i < allDrawingHistory.size(); i++)
+    {
+        const TouchData_t &existing = allDrawingHistory[i];
+        if (existing.timestamp == point.timestamp && existing.x == point.x && existing.y == point.y &&
+            existing.color == point.color && existing.isReset == point.isReset)
+            return true;
+    }
+    return false;
+}
 
-    while (!incomingMessageQueue.empty())
+// 处理接收到的消息队列 (网络任务)
+static void processIncomingMessages()
+{
+    ReceivedMessage_t received;
+    while (radioRxQueue.pop(received))
     {
-        SyncMessage_t msg = incomingMessageQueue.front();
-        incomingMessageQueue.pop();
+        recordPeer(received);
+        if (received.macOnly)
+            continue;
+        if (isWifiConnected())
+            continue; // WiFi 连接时改用 MQTT 同步，ESP-NOW 消息只用于对端列表
+
+        const SyncMessage_t &msg = received.msg;
+        uint32_t receivedMicros = received.receivedMicros;
+        memcpy(lastPeerMac, received.srcMac, 6); // 更新最后通信的对端 MAC
+        if (deltaRequestState == DELTA_WAITING_FOR_PEER)
+        {
+            requestDeltaIfSleptPeer(received.srcMac);
+        }
+        if (msg.type != MSG_TYPE_HEARTBEAT && msg.type != MSG_TYPE_UPTIME_INFO)
+        {
+            powerManagerNoteRadioActivity(); // 对端在作画或同步，暂时不进入浅睡眠
+        }
 
         unsigned long localCurrentRawUptime = millis();
         long localCurrentOffset = relativeBootTimeOffset;
@@ -185,6 +907,13 @@ void processIncomingMessages()
         case MSG_TYPE_UPTIME_INFO:
         {
             Serial.println("收到 MSG_TYPE_UPTIME_INFO");
+            if (deltaRequestState != DELTA_IDLE)
+            {
+                // 醒来后的增量同步进行中，完成后再按对端时间校准，此前不做全量同步决策
+                lastKnownPeerUptime = peerRawUptime;
+                lastKnownPeerOffset = peerReceivedOffset;
+                break;
+            }
             if (uptimeOfLastPeerSyncedFrom != 0 && !iamRequestingAllData)
             {
                 unsigned long diffFromLastSyncSource = (peerRawUptime > uptimeOfLastPeerSyncedFrom) ? (peerRawUptime - uptimeOfLastPeerSyncedFrom) : (uptimeOfLastPeerSyncedFrom - peerRawUptime);
@@ -250,7 +979,7 @@ void processIncomingMessages()
                         iamEffectivelyMoreUptimeDevice = false;
                         iamRequestingAllData = true;
                         isAwaitingSyncStartResponse = true; // 等待对方的 SYNC_START
-                        allDrawingHistory.clear();
+                        clearHistory();
                         // tft.fillScreen(TFT_BLACK); // 清屏操作移至收到对方 SYNC_START 后
                         // drawMainInterface();
 
@@ -268,8 +997,10 @@ void processIncomingMessages()
                         requestMsg.senderUptime = localCurrentRawUptime;
                         requestMsg.senderOffset = localCurrentOffset;
                         memset(&requestMsg.touch_data, 0, sizeof(TouchData_t));
+                        requestMsg.touch_data.color = SYNC_CAP_RASTER; // 本机能接收光栅同步
                         sendSyncMessage(&requestMsg);
                         timeRequestSentForAllDrawings = millis(); // 记录发送请求的时间
+                        lastSyncTrafficMs = millis();
                     }
                     else
                     {
@@ -306,7 +1037,7 @@ void processIncomingMessages()
                         iamEffectivelyMoreUptimeDevice = false;
                         iamRequestingAllData = true;
                         isAwaitingSyncStartResponse = true; // 等待对方的 SYNC_START
-                        allDrawingHistory.clear();
+                        clearHistory();
                         // tft.fillScreen(TFT_BLACK); // 清屏操作移至收到对方 SYNC_START 后
                         // drawMainInterface();
 
@@ -324,8 +1055,10 @@ void processIncomingMessages()
                         requestMsg.senderUptime = localCurrentRawUptime;
                         requestMsg.senderOffset = localCurrentOffset;
                         memset(&requestMsg.touch_data, 0, sizeof(TouchData_t));
+                        requestMsg.touch_data.color = SYNC_CAP_RASTER; // 本机能接收光栅同步
                         sendSyncMessage(&requestMsg);
                         timeRequestSentForAllDrawings = millis(); // 记录发送请求的时间
+                        lastSyncTrafficMs = millis();
                     }
                     else
                     { // localEffectiveUptime > peerEffectiveUptime && diff > threshold
@@ -349,54 +1082,42 @@ void processIncomingMessages()
             break;
         }
         case MSG_TYPE_DRAW_POINT:
+        case MSG_TYPE_STROKE_TOMBSTONE: // 撤销/重做记录与点一样按顺序加入历史 (acceptRemotePoint 区分)
         {
             TouchData_t currentPointData = msg.touch_data; // Declare once at the beginning of the case
-            int mapX = currentPointData.x;
-            int mapY = currentPointData.y;
 
-            if (isReceivingDrawingData)
+            if (deltaRequestState == DELTA_WAITING_FOR_PEER)
+            {
+                // 睡前的对端还没收到增量请求，这些点稍后会在补发中一并收到
+            }
+            else if (isReceivingDrawingData && isReceivingRaster)
+            {
+                // 光栅同步期间的点: 底图之后逐点发送的历史，或对端实时画的点 (也计入进度，只是略有偏差)
+                receivedHistoryPointCount++;
+                lastSyncTrafficMs = millis();
+                acceptRemotePoint(currentPointData, receivedMicros);
+                pushProgressCommand(RENDER_CMD_RECEIVE_PROGRESS, receivedHistoryPointCount, totalPointsExpectedFromPeer);
+            }
+            else if (isReceivingDrawingData)
             {
                 // 场景1: 正在进行历史数据同步 (本机是请求方，已收到 SYNC_START)
-                Serial.println("  处理 MSG_TYPE_DRAW_POINT 作为历史同步数据。");
-                allDrawingHistory.push_back(currentPointData); // 存储历史点
                 receivedHistoryPointCount++;
-                updateReceiveProgress(receivedHistoryPointCount, totalPointsExpectedFromPeer);
-                // 绘图逻辑
-                if (currentPointData.timestamp - lastRemoteDrawTime > TOUCH_STROKE_INTERVAL || lastRemotePoint.z == 0)
-                {
-                    tft.drawPixel(mapX, mapY, currentPointData.color);
-                }
-                else
-                {
-                    tft.drawLine(lastRemotePoint.x, lastRemotePoint.y, mapX, mapY, currentPointData.color);
-                }
-                lastRemotePoint.x = mapX;
-                lastRemotePoint.y = mapY;
-                lastRemotePoint.z = 1;
-                lastRemoteDrawTime = currentPointData.timestamp;
-                if (!isScreenOn)
-                    hasNewUpdateWhileScreenOff = true;
+                lastSyncTrafficMs = millis();
+                acceptRemotePoint(currentPointData, receivedMicros); // 存储历史点并交给主循环绘制
+                pushProgressCommand(RENDER_CMD_RECEIVE_PROGRESS, receivedHistoryPointCount, totalPointsExpectedFromPeer);
             }
             else if (!iamRequestingAllData && !isSendingDrawingData && !isAwaitingSyncStartResponse)
             {
-                // 场景2: 接收实时绘制点 (本机不处于任何请求/发送全量数据的状态)
-                Serial.println("  处理 MSG_TYPE_DRAW_POINT 作为实时新笔划。");
-                allDrawingHistory.push_back(currentPointData); // 实时点也需要加入历史
-                // 绘图逻辑
-                if (currentPointData.timestamp - lastRemoteDrawTime > TOUCH_STROKE_INTERVAL || lastRemotePoint.z == 0)
+                // 场景2: 接收实时绘制点 (本机不处于任何请求/发送全量数据的状态)，包括醒来后对端单播补发的点
+                if (!(deltaRequestState == DELTA_REQUESTED && deltaSkipDuplicates && receivedSinceDoze(currentPointData)))
                 {
-                    tft.drawPixel(mapX, mapY, currentPointData.color);
+                    acceptRemotePoint(currentPointData, receivedMicros); // 实时点也需要加入历史
                 }
-                else
+                if (deltaRequestState == DELTA_REQUESTED)
                 {
-                    tft.drawLine(lastRemotePoint.x, lastRemotePoint.y, mapX, mapY, currentPointData.color);
+                    deltaPointsReceived++;
+                    deltaStateSinceMs = millis();
                 }
-                lastRemotePoint.x = mapX;
-                lastRemotePoint.y = mapY;
-                lastRemotePoint.z = 1;
-                lastRemoteDrawTime = currentPointData.timestamp;
-                if (!isScreenOn)
-                    hasNewUpdateWhileScreenOff = true;
             }
             else
             {
@@ -434,33 +1155,10 @@ void processIncomingMessages()
                 Serial.print(allDrawingHistory.size());
                 Serial.println(" 个点。");
                 iamEffectivelyMoreUptimeDevice = true;
-                // isSendingDrawingData = true; // isSendingDrawingData 将在下面设置
                 lastKnownPeerUptime = peerRawUptime;
                 lastKnownPeerOffset = peerReceivedOffset;
                 initialSyncLogicProcessed = true;
-
-                // 发送同步开始信号给请求方，表明本机即将开始发送数据
-                SyncMessage_t syncStartMsgBeforeSending;
-                syncStartMsgBeforeSending.type = MSG_TYPE_SYNC_START;
-                syncStartMsgBeforeSending.senderUptime = localCurrentRawUptime;
-                syncStartMsgBeforeSending.senderOffset = localCurrentOffset;
-                memset(&syncStartMsgBeforeSending.touch_data, 0, sizeof(TouchData_t));
-                syncStartMsgBeforeSending.totalPointsForSync = allDrawingHistory.size(); // 设置总点数
-                sendSyncMessage(&syncStartMsgBeforeSending);
-                Serial.println("  发送 MSG_TYPE_SYNC_START (准备发送历史数据，将开始分批发送)");
-
-                // 设置状态以开始分批发送，实际发送将在 processIncomingMessages 末尾的逻辑中进行
-                if (!allDrawingHistory.empty())
-                {
-                    updateSendProgress(0, allDrawingHistory.size()); // 初始化发送进度条
-                }
-                else
-                {
-                    hideSendProgress(); // 如果没有历史记录，则隐藏进度条
-                }
-                isSendingDrawingData = true;
-                currentHistorySendIndex = 0;
-                // 原有的 for 循环发送逻辑已移除
+                beginHistorySend((msg.touch_data.color & SYNC_CAP_RASTER) != 0);
             }
             else
             {
@@ -476,6 +1174,7 @@ void processIncomingMessages()
         case MSG_TYPE_ALL_DRAWINGS_COMPLETE:
         {
             Serial.println("收到 MSG_TYPE_ALL_DRAWINGS_COMPLETE.");
+            processRasterTiles(); // 先处理在它之前到达的图块数据
             if (isReceivingDrawingData)
             {
                 Serial.println("  同步完成 (本机为较新设备，已接收完数据)。");
@@ -506,7 +1205,7 @@ void processIncomingMessages()
                 timeRequestSentForAllDrawings = 0;
                 uptimeOfLastPeerSyncedFrom = peerRawUptime;
 
-                hideReceiveProgress(); // 在所有状态更新后，显式隐藏接收进度条
+                pushRenderCommand(RENDER_CMD_HIDE_RECEIVE_PROGRESS); // 在所有状态更新后，显式隐藏接收进度条
 
                 Serial.print("  relativeBootTimeOffset 计算并设置为: ");
                 Serial.println(relativeBootTimeOffset);
@@ -552,8 +1251,10 @@ void processIncomingMessages()
                 requestMsgRetry.senderUptime = localCurrentRawUptime; // 使用当前时间
                 requestMsgRetry.senderOffset = localCurrentOffset;
                 memset(&requestMsgRetry.touch_data, 0, sizeof(TouchData_t));
+                requestMsgRetry.touch_data.color = SYNC_CAP_RASTER; // 本机能接收光栅同步
                 sendSyncMessage(&requestMsgRetry);
                 timeRequestSentForAllDrawings = millis(); // 更新请求时间戳
+                lastSyncTrafficMs = millis();
                 Serial.println("  重新发送 MSG_TYPE_REQUEST_ALL_DRAWINGS.");
 
                 // 更新对端信息，因为这仍然是来自对端的最新（尽管可能是异常的）消息
@@ -573,6 +1274,11 @@ void processIncomingMessages()
         case MSG_TYPE_CLEAR_AND_REQUEST_UPDATE:
         {
             Serial.println("收到 MSG_TYPE_CLEAR_AND_REQUEST_UPDATE.");
+            if (deltaRequestState != DELTA_IDLE)
+            {
+                Serial.println("  醒来后的增量同步进行中，忽略。");
+                break;
+            }
             unsigned long effectiveUptimeDifference = (localEffectiveUptime > peerEffectiveUptime) ? (localEffectiveUptime - peerEffectiveUptime) : (peerEffectiveUptime - localEffectiveUptime);
 
             if (localEffectiveUptime < peerEffectiveUptime && effectiveUptimeDifference > EFFECTIVE_UPTIME_SYNC_THRESHOLD)
@@ -589,7 +1295,7 @@ void processIncomingMessages()
                 iamEffectivelyMoreUptimeDevice = false;
                 iamRequestingAllData = true;
                 isAwaitingSyncStartResponse = true;
-                allDrawingHistory.clear();
+                clearHistory();
 
                 SyncMessage_t syncStartMsgBeforeRequest3;
                 syncStartMsgBeforeRequest3.type = MSG_TYPE_SYNC_START;
@@ -604,8 +1310,10 @@ void processIncomingMessages()
                 requestMsg.senderUptime = localCurrentRawUptime;
                 requestMsg.senderOffset = localCurrentOffset;
                 memset(&requestMsg.touch_data, 0, sizeof(TouchData_t));
+                requestMsg.touch_data.color = SYNC_CAP_RASTER; // 本机能接收光栅同步
                 sendSyncMessage(&requestMsg);
                 timeRequestSentForAllDrawings = millis();
+                lastSyncTrafficMs = millis();
                 lastKnownPeerUptime = peerRawUptime;
                 lastKnownPeerOffset = peerReceivedOffset;
                 initialSyncLogicProcessed = true;
@@ -624,8 +1332,7 @@ void processIncomingMessages()
         case MSG_TYPE_RESET_CANVAS:
         {
             Serial.println("收到 MSG_TYPE_RESET_CANVAS.");
-            allDrawingHistory.clear();
-            clearScreenAndCache();
+            clearHistory();
             relativeBootTimeOffset = 0;
             iamEffectivelyMoreUptimeDevice = false;
             iamRequestingAllData = false;
@@ -643,35 +1350,35 @@ void processIncomingMessages()
             memset(&uptimeInfoMsg.touch_data, 0, sizeof(TouchData_t));
             sendSyncMessage(&uptimeInfoMsg);
             Serial.println("  画布已重置。发送了新的 UPTIME_INFO。");
-            if (!isScreenOn)
-                hasNewUpdateWhileScreenOff = true;
+            pushRenderCommand(RENDER_CMD_CLEAR_CANVAS, true);
             break;
         }
         case MSG_TYPE_SYNC_START:
+        case MSG_TYPE_RASTER_SYNC_START:
         {
-            Serial.println("收到 MSG_TYPE_SYNC_START");
+            bool raster = (msg.type == MSG_TYPE_RASTER_SYNC_START);
+            Serial.println(raster ? "收到 MSG_TYPE_RASTER_SYNC_START" : "收到 MSG_TYPE_SYNC_START");
             if (iamRequestingAllData && isAwaitingSyncStartResponse && !iamEffectivelyMoreUptimeDevice)
             {
                 Serial.println("  本机作为请求方，收到响应方的 SYNC_START。准备清空并接收数据。");
-                allDrawingHistory.clear();
-                clearScreenAndCache();
-                lastRemotePoint.x = 0;
-                lastRemotePoint.y = 0;
-                lastRemotePoint.z = 0;
-                lastRemoteDrawTime = 0;
+                clearHistory();
+                pushRenderCommand(RENDER_CMD_CLEAR_CANVAS); // 主循环清屏并重置远端笔划状态
 
                 isAwaitingSyncStartResponse = false;
                 isReceivingDrawingData = true;
+                isReceivingRaster = raster; // 光栅同步时 totalPointsForSync 为图块数据段数
+                lastSyncTrafficMs = millis();
+                rasterRunTimestamp = RASTER_RUN_TIMESTAMP_BASE;
 
                 totalPointsExpectedFromPeer = msg.totalPointsForSync;
                 receivedHistoryPointCount = 0;
                 if (totalPointsExpectedFromPeer > 0)
                 {
-                    updateReceiveProgress(receivedHistoryPointCount, totalPointsExpectedFromPeer);
+                    pushProgressCommand(RENDER_CMD_RECEIVE_PROGRESS, receivedHistoryPointCount, totalPointsExpectedFromPeer);
                 }
                 else
                 {
-                    hideReceiveProgress(); // 如果对方没有点要发送，则隐藏进度条
+                    pushRenderCommand(RENDER_CMD_HIDE_RECEIVE_PROGRESS); // 如果对方没有点要发送，则隐藏进度条
                 }
 
                 lastKnownPeerUptime = peerRawUptime;
@@ -698,9 +1405,77 @@ void processIncomingMessages()
             }
             break;
         }
+        case MSG_TYPE_SLEEP_NOTICE:
+        {
+            char mac[18];
+            formatMac(received.srcMac, mac);
+            SleepMark_t *mark = findSleepMark(received.srcMac);
+            if (mark == nullptr)
+            {
+                if (sleepMarkCount >= MAX_TRACKED_PEERS)
+                {
+                    Serial.println("收到 SLEEP_NOTICE，但睡眠标记已满，忽略 (对端醒来后走全量同步)");
+                    break;
+                }
+                mark = &sleepMarks[sleepMarkCount++];
+                memcpy(mark->mac, received.srcMac, 6);
+            }
+            mark->historyIndex = allDrawingHistory.size();
+            mark->resetSince = false;
+            Serial.print("对端 ");
+            Serial.print(mac);
+            Serial.print(" 即将睡眠或待机 (其历史 ");
+            Serial.print(msg.totalPointsForSync);
+            Serial.print(" 点)，记下本机历史位置 ");
+            Serial.println(allDrawingHistory.size());
+            break;
+        }
+        case MSG_TYPE_REQUEST_DELTA:
+        {
+            char mac[18];
+            formatMac(received.srcMac, mac);
+            SleepMark_t *mark = findSleepMark(received.srcMac);
+            if (mark == nullptr)
+            {
+                Serial.print("收到 ");
+                Serial.print(mac);
+                Serial.println(" 的 REQUEST_DELTA，但没有它的睡眠记录 (本机重启过?)。忽略，对端将回到全量同步。");
+                break;
+            }
+            if (isSendingDelta)
+            {
+                Serial.println("收到 REQUEST_DELTA，但正在为另一个对端补发。忽略，对端将超时重试全量同步。");
+                break;
+            }
+            beginDeltaSend(received.srcMac, *mark);
+            *mark = sleepMarks[--sleepMarkCount]; // 用最后一个标记填补空位
+            break;
+        }
+        case MSG_TYPE_DELTA_COMPLETE:
+        {
+            if (deltaRequestState != DELTA_REQUESTED)
+            {
+                break;
+            }
+            // 与全量同步完成时相同，按对端时间校准有效运行时间，之后对端间的运行时间差在阈值内，不会触发全量同步
+            relativeBootTimeOffset = (long)peerRawUptime + (long)peerReceivedOffset - localCurrentRawUptime;
+            uptimeOfLastPeerSyncedFrom = peerRawUptime;
+            lastKnownPeerUptime = peerRawUptime;
+            lastKnownPeerOffset = peerReceivedOffset;
+            initialSyncLogicProcessed = true;
+            deltaRequestState = DELTA_IDLE;
+            deltaSkipDuplicates = false;
+            Serial.print("增量同步完成: 收到 ");
+            Serial.print(deltaPointsReceived);
+            Serial.print(" / ");
+            Serial.print(msg.totalPointsForSync);
+            Serial.print(" 个点，relativeBootTimeOffset 设置为 ");
+            Serial.println(relativeBootTimeOffset);
+            break;
+        }
         case MSG_TYPE_HEARTBEAT:
         {
-            // 收到心跳包，OnSyncDataRecv 中已经更新了 peerLastHeartbeat，这里可以根据需要添加调试信息
+            // 收到心跳包，recordPeer 中已经更新了对端的心跳时间，这里可以根据需要添加调试信息
             // Serial.print("收到心跳包，来自对端 MAC (最后通信): "); // 调试信息，如果频繁可能会刷屏
             // char macStr[18];
             // snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
@@ -716,69 +1491,364 @@ void processIncomingMessages()
             break;
         }
         } // End of switch (msg.type)
-    } // End of while (!incomingMessageQueue.empty())
+    } // End of while (radioRxQueue.pop(received))
+    processRasterTiles();
+}
 
-    // --- 分批发送历史数据逻辑 ---
-    if (isSendingDrawingData)
-    {
-        const size_t BATCH_SIZE = 50; // 每批发送15个点
-        size_t pointsSentThisCycle = 0;
-        unsigned long batchSendStartTime = millis();        // 用于该批次消息的时间戳
-        unsigned long currentSenderUptimeForMsg = millis(); // 获取一次，用于本批次所有消息
-        long currentSenderOffsetForMsg = relativeBootTimeOffset;
+// 历史元素的消息类型: 撤销/重做记录单独成类型 (旧版本固件按未知类型丢弃，不会当作点绘制)
+static MessageType_t historyMessageType(const TouchData_t &point)
+{
+    return history_is_tombstone(point) ? MSG_TYPE_STROKE_TOMBSTONE : MSG_TYPE_DRAW_POINT;
+}
 
-        while (currentHistorySendIndex < allDrawingHistory.size() && pointsSentThisCycle < BATCH_SIZE)
-        {
-            const auto &drawData = allDrawingHistory[currentHistorySendIndex];
+// 分批发送历史数据 (网络任务)。逐点延时只阻塞网络任务，期间主循环提交的本地点照常处理
+static void sendHistoryBatch()
+{
+    size_t pointsSentThisCycle = 0;
+    unsigned long currentSenderUptimeForMsg = millis(); // 获取一次，用于本批次所有消息
+    long currentSenderOffsetForMsg = relativeBootTimeOffset;
 
-            SyncMessage_t historyPointMsg;
-            historyPointMsg.type = MSG_TYPE_DRAW_POINT;
-            historyPointMsg.senderUptime = currentSenderUptimeForMsg;
-            historyPointMsg.senderOffset = currentSenderOffsetForMsg;
-            historyPointMsg.touch_data = drawData;
+    // 本任务是历史的唯一写入者，读取不需要加锁；期间本机复位会清空历史，所以每个点都重新取结束索引
+    while (currentHistorySendIndex < std::min(historySendEndIndex, allDrawingHistory.size()) &&
+           pointsSentThisCycle < HISTORY_SEND_BATCH)
+    {
+        SyncMessage_t historyPointMsg;
+        historyPointMsg.touch_data = allDrawingHistory[currentHistorySendIndex];
+        historyPointMsg.type = historyMessageType(historyPointMsg.touch_data);
+        historyPointMsg.senderUptime = currentSenderUptimeForMsg;
+        historyPointMsg.senderOffset = currentSenderOffsetForMsg;
+        sendSyncMessage(&historyPointMsg);
+        currentHistorySendIndex++;
+        pointsSentThisCycle++;
+        networkStats.historyPointsSent++;
+
+        vTaskDelay(pdMS_TO_TICKS(HISTORY_SEND_POINT_DELAY_MS)); // 给 ESP-NOW 发送缓冲留出时间
+        drainNetworkOps();
+    }
 
-            sendSyncMessage(&historyPointMsg);
-            delay(5); // 在每个点发送后加入一个小的 delay(1)
+    size_t endIndex = std::min(historySendEndIndex, allDrawingHistory.size());
+    size_t progressStart = std::min(historySendStartIndex, endIndex); // 光栅同步之后从撤销窗口开始逐点发送
+    if (currentHistorySendIndex >= endIndex)
+    {
+        // 所有数据点已发送完毕
+        SyncMessage_t completeMsg;
+        completeMsg.type = MSG_TYPE_ALL_DRAWINGS_COMPLETE;
+        completeMsg.senderUptime = millis();
+        completeMsg.senderOffset = relativeBootTimeOffset;
+        memset(&completeMsg.touch_data, 0, sizeof(TouchData_t));
+        sendSyncMessage(&completeMsg);
+
+        Serial.println("  所有历史绘图数据已分批发送完毕。发送了 ALL_DRAWINGS_COMPLETE。");
+        pushProgressCommand(RENDER_CMD_SEND_PROGRESS, historySendProgressOffset + currentHistorySendIndex - progressStart,
+                            historySendProgressOffset + endIndex - progressStart); // 最后更新一次确保是100%
+        isSendingDrawingData = false;
+        networkStats.fullSyncsSent++;
+    }
+    else if (pointsSentThisCycle > 0)
+    {
+        // 当前批次已发送，但还有更多数据
+        pushProgressCommand(RENDER_CMD_SEND_PROGRESS, historySendProgressOffset + currentHistorySendIndex - progressStart,
+                            historySendProgressOffset + endIndex - progressStart); // 更新发送进度
+        Serial.print("  分批发送：已发送 ");
+        Serial.print(pointsSentThisCycle);
+        Serial.print(" 个点，总计已发送 ");
+        Serial.print(currentHistorySendIndex);
+        Serial.print("/");
+        Serial.print(endIndex);
+        Serial.println(" 个点。");
+    }
+}
 
-            currentHistorySendIndex++;
-            pointsSentThisCycle++;
+// 发送底图: 每次发送一个图块的全部数据段，发完后转为逐点发送历史 (网络任务)
+static void sendRasterBaseBatch()
+{
+    while (rasterSendTile < RASTER_TILE_COUNT && rasterBaseRevision() == rasterSendBaseRevision)
+    {
+        uint16_t tile = rasterSendTile++;
+        RasterTileMessage_t tileMsg;
+        memset(&tileMsg, 0, sizeof(tileMsg));
+        tileMsg.type = MSG_TYPE_RASTER_TILE;
+        tileMsg.tileIndex = tile;
+        size_t cursor = 0;
+        const uint8_t *data;
+        bool sentAny = false;
+        // 期间本机复位会清空底图 (drainNetworkOps)，每段之前重新检查
+        while (rasterBaseRevision() == rasterSendBaseRevision &&
+               rasterBaseNextChunk(tile, cursor, tileMsg.pixelOffset, tileMsg.length, data))
+        {
+            memcpy(tileMsg.data, data, tileMsg.length);
+            esp_err_t result = esp_now_send(broadcastAddress, (const uint8_t *)&tileMsg, sizeof(tileMsg));
+            perfCountFrame(result == ESP_OK ? PERF_FRAME_TX : PERF_FRAME_DROPPED, MSG_TYPE_RASTER_TILE);
+            if (result != ESP_OK)
+            {
+                Serial.print("发送图块数据错误: ");
+                Serial.println(esp_err_to_name(result));
+            }
+            rasterChunksSent++;
+            sentAny = true;
+            vTaskDelay(pdMS_TO_TICKS(RASTER_CHUNK_DELAY_MS));
+            drainNetworkOps();
         }
-
-        if (currentHistorySendIndex >= allDrawingHistory.size())
+        if (sentAny)
         {
-            // 所有数据点已发送完毕
-            SyncMessage_t completeMsg;
-            completeMsg.type = MSG_TYPE_ALL_DRAWINGS_COMPLETE;
-            completeMsg.senderUptime = millis();
-            completeMsg.senderOffset = relativeBootTimeOffset;
-            memset(&completeMsg.touch_data, 0, sizeof(TouchData_t));
-            sendSyncMessage(&completeMsg);
-
-            Serial.println("  所有历史绘图数据已分批发送完毕。发送了 ALL_DRAWINGS_COMPLETE。");
-            updateSendProgress(currentHistorySendIndex, allDrawingHistory.size()); // 最后更新一次确保是100%
-            // hideSendProgress(); // 或者在 updateSendProgress 内部处理完成后的隐藏
-            isSendingDrawingData = false;
-            // currentHistorySendIndex = 0;
+            pushProgressCommand(RENDER_CMD_SEND_PROGRESS, rasterChunksSent, rasterChunksTotal);
+            return;
         }
-        else if (pointsSentThisCycle > 0)
+    }
+
+    Serial.print("  底图已发送完毕 (");
+    Serial.print(rasterChunksSent);
+    Serial.println(" 段)，逐点发送之后的历史。");
+    isSendingRaster = false;
+    rasterSendBase = false;
+    networkStats.rasterSyncsSent++;
+    historySendProgressOffset = rasterChunksSent;
+    currentHistorySendIndex = 0; // 由 sendHistoryBatch 继续，最后发送 ALL_DRAWINGS_COMPLETE
+}
+
+// 光栅同步: 每次绘制并发送一个有内容的图块 (网络任务)
+static void sendRasterBatch()
+{
+    if (rasterSendBase)
+    {
+        sendRasterBaseBatch();
+        return;
+    }
+    while (rasterSendTile < RASTER_TILE_COUNT && !rasterTileMarked[rasterSendTile])
+        rasterSendTile++;
+
+    // 期间本机复位清空了历史时直接结束 (复位消息已广播)
+    if (rasterSendTile < RASTER_TILE_COUNT && allDrawingHistory.size() >= historySendEndIndex)
+    {
+        uint16_t tile = rasterSendTile++;
+        rasterRenderTile(allDrawingHistory, rasterSendStart, rasterSendEnd, tile, rasterTilePixels);
+
+        RasterTileMessage_t tileMsg;
+        memset(&tileMsg, 0, sizeof(tileMsg));
+        tileMsg.type = MSG_TYPE_RASTER_TILE;
+        tileMsg.tileIndex = tile;
+        uint16_t offset = 0;
+        while (rasterEncodeChunk(tile, rasterTilePixels, offset, tileMsg.data, RASTER_CHUNK_DATA_BYTES,
+                                 tileMsg.pixelOffset, tileMsg.length, offset))
         {
-            // 当前批次已发送，但还有更多数据
-            updateSendProgress(currentHistorySendIndex, allDrawingHistory.size()); // 更新发送进度
-            Serial.print("  分批发送：已发送 ");
-            Serial.print(pointsSentThisCycle);
-            Serial.print(" 个点，总计已发送 ");
-            Serial.print(currentHistorySendIndex);
-            Serial.print("/");
-            Serial.print(allDrawingHistory.size());
-            Serial.println(" 个点。");
+            esp_err_t result = esp_now_send(broadcastAddress, (const uint8_t *)&tileMsg, sizeof(tileMsg));
+            perfCountFrame(result == ESP_OK ? PERF_FRAME_TX : PERF_FRAME_DROPPED, MSG_TYPE_RASTER_TILE);
+            if (result != ESP_OK)
+            {
+                Serial.print("发送图块数据错误: ");
+                Serial.println(esp_err_to_name(result));
+            }
+            rasterChunksSent++;
+            vTaskDelay(pdMS_TO_TICKS(RASTER_CHUNK_DELAY_MS)); // 请求方要把每段还原为历史点并绘制
+            drainNetworkOps();
         }
-        // 如果仍在发送过程中 (isSendingDrawingData 仍为 true 且还有数据)，让出CPU
-        if (isSendingDrawingData && currentHistorySendIndex < allDrawingHistory.size())
+        pushProgressCommand(RENDER_CMD_SEND_PROGRESS, rasterChunksSent, rasterChunksTotal);
+        return;
+    }
+
+    if (rasterSendTile >= RASTER_TILE_COUNT && rasterSendEnd < historySendEndIndex &&
+        allDrawingHistory.size() >= historySendEndIndex)
+    {
+        // 撤销窗口中的笔划 (含撤销/重做记录) 逐点发送，对端之后还能撤销/重做它们
+        Serial.print("  画布图块已发送完毕 (");
+        Serial.print(rasterChunksSent);
+        Serial.println(" 段)，逐点发送撤销窗口中的历史。");
+        isSendingRaster = false;
+        networkStats.rasterSyncsSent++;
+        historySendProgressOffset = rasterChunksSent;
+        historySendStartIndex = rasterSendEnd;
+        currentHistorySendIndex = rasterSendEnd; // 由 sendHistoryBatch 继续，最后发送 ALL_DRAWINGS_COMPLETE
+        return;
+    }
+
+    SyncMessage_t completeMsg;
+    memset(&completeMsg, 0, sizeof(completeMsg));
+    completeMsg.type = MSG_TYPE_ALL_DRAWINGS_COMPLETE;
+    completeMsg.senderUptime = millis();
+    completeMsg.senderOffset = relativeBootTimeOffset;
+    sendSyncMessage(&completeMsg);
+    Serial.print("  画布图块已发送完毕 (");
+    Serial.print(rasterChunksSent);
+    Serial.println(" 段)。发送了 ALL_DRAWINGS_COMPLETE。");
+    pushProgressCommand(RENDER_CMD_SEND_PROGRESS, rasterChunksTotal, rasterChunksTotal);
+    isSendingDrawingData = false;
+    isSendingRaster = false;
+    networkStats.fullSyncsSent++;
+    networkStats.rasterSyncsSent++;
+}
+
+// 分批单播补发增量 (网络任务)
+static void sendDeltaBatch()
+{
+    size_t pointsSentThisCycle = 0;
+    while (deltaSendIndex < std::min(deltaSendEndIndex, allDrawingHistory.size()) &&
+           pointsSentThisCycle < HISTORY_SEND_BATCH)
+    {
+        SyncMessage_t pointMsg;
+        memset(&pointMsg, 0, sizeof(pointMsg));
+        pointMsg.touch_data = allDrawingHistory[deltaSendIndex];
+        pointMsg.type = historyMessageType(pointMsg.touch_data);
+        pointMsg.senderUptime = millis();
+        pointMsg.senderOffset = relativeBootTimeOffset;
+        sendSyncMessageTo(deltaTargetMac, &pointMsg);
+        deltaSendIndex++;
+        pointsSentThisCycle++;
+        networkStats.historyPointsSent++;
+
+        vTaskDelay(pdMS_TO_TICKS(HISTORY_SEND_POINT_DELAY_MS));
+        drainNetworkOps();
+    }
+
+    if (deltaSendIndex >= std::min(deltaSendEndIndex, allDrawingHistory.size()))
+    {
+        SyncMessage_t completeMsg;
+        memset(&completeMsg, 0, sizeof(completeMsg));
+        completeMsg.type = MSG_TYPE_DELTA_COMPLETE;
+        completeMsg.senderUptime = millis();
+        completeMsg.senderOffset = relativeBootTimeOffset;
+        completeMsg.totalPointsForSync = syncCountField(deltaSendIndex - deltaSendStartIndex);
+        sendSyncMessageTo(deltaTargetMac, &completeMsg);
+        isSendingDelta = false;
+        networkStats.deltaSyncsSent++;
+        Serial.println("增量补发完毕，发送了 DELTA_COMPLETE");
+    }
+}
+
+// 压缩会改变历史索引，分批发送、接收或增量同步进行中时不能应用
+static bool historyCompactAllowed()
+{
+    return !isSendingDrawingData && !isSendingDelta && !isReceivingDrawingData && !iamRequestingAllData &&
+           deltaRequestState == DELTA_IDLE;
+}
+
+// 空闲时分步压缩历史 (网络任务)，每次调用最多处理 HISTORY_COMPACT_SLICE_POINTS 个点
+static void runHistoryCompaction()
+{
+    if (millis() - lastHistoryAppendMs < HISTORY_COMPACT_IDLE_MS)
+        return; // 有人在画或正在同步，稍后继续
+    if (compactJob.phase == COMPACT_IDLE)
+    {
+        size_t size = allDrawingHistory.size();
+        bool due = size >= historySizeAfterCompact + HISTORY_COMPACT_MIN_NEW_POINTS || (compactRequested && size > 0);
+        if (!due || flattenJob.active || !historyCompactAllowed())
+            return;
+        compactRequested = false;
+        historyCompactBegin(compactJob, allDrawingHistory, size);
+        compactStartMs = millis();
+    }
+    if (!historyCompactStep(compactJob, allDrawingHistory, HISTORY_COMPACT_SLICE_POINTS))
+        return;
+    if (!historyCompactAllowed())
+    {
+        historyCompactAbort(compactJob);
+        compactStats.aborted++;
+        return;
+    }
+
+    // 睡眠对端的增量起点指向本机历史，按删除后的位置调整
+    for (size_t i = 0; i < sleepMarkCount; i++)
+    {
+        sleepMarks[i].historyIndex = historyCompactRemapIndex(compactJob, sleepMarks[i].historyIndex);
+    }
+    dozeHistoryStart = historyCompactRemapIndex(compactJob, dozeHistoryStart);
+    uint32_t before = allDrawingHistory.size();
+    compactStats.lastHidden = compactJob.hiddenPoints;
+    compactStats.lastSimplified = compactJob.simplifiedPoints;
+    compactStats.lastOccluded = compactJob.occludedPoints;
+    compactStats.lastUndone = compactJob.undonePoints;
+    historyLock(); // 主循环重播时不能移动元素
+    canvasFramebufferBeforeCompact(allDrawingHistory, compactJob); // 缓冲已画的部分不必重画
+    size_t removed = historyCompactApply(compactJob, allDrawingHistory);
+    historyUnlock();
+    historySizeAfterCompact = allDrawingHistory.size();
+    if (removed > 0)
+        canvasStoreHistoryRewritten(); // 重写闪存快照
+
+    compactStats.runs++;
+    compactStats.lastBefore = before;
+    compactStats.lastAfter = historySizeAfterCompact;
+    compactStats.lastDurationMs = millis() - compactStartMs;
+    compactStats.totalRemoved += removed;
+    Serial.printf("历史压缩: %lu -> %lu 个点 (复位前 %lu, 化简 %lu, 遮挡 %lu, 已撤销 %lu)，耗时 %lums\n",
+                  (unsigned long)before, (unsigned long)historySizeAfterCompact, (unsigned long)compactStats.lastHidden,
+                  (unsigned long)compactStats.lastSimplified, (unsigned long)compactStats.lastOccluded,
+                  (unsigned long)compactStats.lastUndone, (unsigned long)compactStats.lastDurationMs);
+}
+
+size_t historyBudgetBytes()
+{
+    size_t bytes = historyBudgetOverride;
+    if (bytes == 0)
+        bytes = memoryTierHasPsram() ? HISTORY_BUDGET_PSRAM_BYTES : HISTORY_BUDGET_INTERNAL_BYTES;
+    return bytes;
+}
+
+// 历史和底图当前占用的内存 (字节)
+static size_t historyMemoryBytes()
+{
+    return allDrawingHistory.memory_bytes() + rasterBaseBytes();
+}
+
+// 超出内存预算时分步展平较早的笔划 (网络任务)，每次调用处理一个图块；与压缩一样不在同步进行时执行
+static void runHistoryFlatten()
+{
+    if (!flattenJob.active)
+    {
+        if (compactJob.phase != COMPACT_IDLE || !historyCompactAllowed() || historyMemoryBytes() <= historyBudgetBytes())
+            return;
+        if (allDrawingHistory.chunk_count() <= 1)
+            return; // 正在写入的一块总是保留，展平只能腾出写满的分块 (预算小于一块加底图时不再反复展平)
+        if (flattenEverAborted && millis() - flattenAbortMs < HISTORY_FLATTEN_RETRY_MS)
+            return;
+        size_t keep = allDrawingHistory.size() * HISTORY_FLATTEN_KEEP_PERCENT / 100;
+        if (!rasterFlattenBegin(flattenJob, allDrawingHistory, keep))
+            return; // 没有可展平的笔划边界 (例如只有一笔)
+        flattenStartMs = millis();
+    }
+    if (!historyCompactAllowed())
+        rasterFlattenAbort(flattenJob); // 同步开始后历史索引不能再变化
+    if (!rasterFlattenStep(flattenJob, allDrawingHistory))
+    {
+        if (!flattenJob.active)
         {
-            yield();
+            budgetStats.aborted++;
+            flattenEverAborted = true;
+            flattenAbortMs = millis();
         }
+        return;
+    }
+
+    size_t before = allDrawingHistory.size();
+    size_t cut = flattenJob.cut;
+    historyLock(); // 主循环重播时不能替换底图或移动元素
+    canvasFramebufferBeforeFlatten(allDrawingHistory, cut); // 缓冲中的画面不变，不必重画
+    rasterFlattenCommit(flattenJob);
+    allDrawingHistory.drop_front(cut);
+    historyUnlock();
+    historySizeAfterCompact = historySizeAfterCompact > cut ? historySizeAfterCompact - cut : 0;
+    dozeHistoryStart = dozeHistoryStart > cut ? dozeHistoryStart - cut : 0;
+
+    // 睡眠对端的增量起点落在展平的部分时无法再逐点补发，删除它的记录 (对端醒来后回到全量同步)
+    size_t kept = 0;
+    for (size_t i = 0; i < sleepMarkCount; i++)
+    {
+        if (sleepMarks[i].resetSince || sleepMarks[i].historyIndex < cut)
+            continue;
+        sleepMarks[kept] = sleepMarks[i];
+        sleepMarks[kept].historyIndex -= cut;
+        kept++;
     }
-} // End of processIncomingMessages()
+    sleepMarkCount = kept;
+    canvasStoreHistoryRewritten(); // 重写闪存快照和底图文件
+
+    budgetStats.flattens++;
+    budgetStats.pointsFlattened += cut;
+    budgetStats.lastDurationMs = millis() - flattenStartMs;
+    Serial.printf("历史展平: %lu 个点展平为底图 (%lu 个图块)，保留 %lu 个点，用量 %lu / %lu 字节，耗时 %lums\n",
+                  (unsigned long)cut, (unsigned long)flattenJob.tilesRendered, (unsigned long)(before - cut),
+                  (unsigned long)historyMemoryBytes(), (unsigned long)historyBudgetBytes(),
+                  (unsigned long)budgetStats.lastDurationMs);
+}
 
 // 新增：发送心跳包
 void sendHeartbeat()
@@ -797,61 +1867,76 @@ void sendHeartbeat()
     // Serial.println("发送心跳包."); // 调试信息，如果频繁发送可能会刷屏
 }
 
-// 新增：检查对端心跳超时
-void checkPeerHeartbeatTimeout()
+// 新增：检查对端心跳超时 (网络任务)
+static void checkPeerHeartbeatTimeout()
 {
     unsigned long currentTime = millis();
-    // 使用一个临时的 vector 来存储需要移除的 MAC 地址，避免在迭代时修改 map
-    std::vector<String> macsToRemove;
 
-    for (auto const& [mac, lastHeartbeatTime] : peerLastHeartbeat)
+    // 原地移除超时的对端，保持其余对端的顺序
+    xSemaphoreTake(peerMutex, portMAX_DELAY);
+    size_t kept = 0;
+    for (size_t i = 0; i < peerTableCount; i++)
     {
-        if (currentTime - lastHeartbeatTime > HEARTBEAT_TIMEOUT_MS) // HEARTBEAT_TIMEOUT_MS 定义在 config.h
+        if (currentTime - peerTable[i].lastHeartbeat > HEARTBEAT_TIMEOUT_MS) // HEARTBEAT_TIMEOUT_MS 定义在 config.h
         {
             Serial.print("对端 ");
-            Serial.print(mac);
+            Serial.print(peerTable[i].info.macAddress);
             Serial.println(" 心跳超时，认为已下线。");
-            macsToRemove.push_back(mac);
+            if (peerTable[i].hasInfo)
+                peerTableInfoCount--;
             // TODO: 在 UI 或其他地方显示对端下线的信息
-            // 例如：updatePeerStatus(mac, false);
+            continue;
         }
+        if (kept != i)
+            peerTable[kept] = peerTable[i];
+        kept++;
     }
-
-    // 移除超时的对端
-    for (const auto& mac : macsToRemove)
-    {
-        peerLastHeartbeat.erase(mac);
-        macSet.erase(mac); // 同时从 macSet 中移除
-        peerInfoMap.erase(mac); // 新增：从对端信息 map 中移除
-        // TODO: 如果需要，更新 UI 显示的对端数量
-        // 例如：updatePeerCountDisplay(macSet.size());
-    }
+    peerTableCount = kept;
+    xSemaphoreGive(peerMutex);
 }
 
-// 新增：获取对端信息列表
-std::vector<PeerInfo_t> getPeerInfoList() {
-    std::vector<PeerInfo_t> peerList;
-    int count = 0;
-    for (auto const& [mac, peerInfo] : peerInfoMap) {
-        if (count < MAX_PEERS_TO_DISPLAY) { // 限制返回的数量
-            peerList.push_back(peerInfo);
-            count++;
-        } else {
-            break;
+// 新增：获取对端信息列表 (拷贝到调用方的数组，不分配内存)
+size_t getPeerInfoList(PeerInfo_t *out, size_t maxCount) {
+    size_t count = 0;
+    xSemaphoreTake(peerMutex, portMAX_DELAY); // 网络任务可能正在增删对端
+    for (size_t i = 0; i < peerTableCount && count < maxCount; i++) {
+        if (peerTable[i].hasInfo) {
+            out[count++] = peerTable[i].info;
         }
     }
-    return peerList;
+    xSemaphoreGive(peerMutex);
+    return count;
 }
 
 
+// 画出底图的一个游程 (重播时先于历史绘制)
+static void drawBaseRun(int x, int y, int length, uint16_t color)
+{
+    tft.drawFastHLine(x, y, length, color);
+}
+
 // 重播所有绘图历史 (在屏幕上重新绘制所有点和线)
 void replayAllDrawings()
 {
-    lastRemotePoint.x = 0;
-    lastRemotePoint.y = 0;
-    lastRemotePoint.z = 0;
-    lastRemoteDrawTime = 0;
+    perfNoteDrawn(); // 全屏重播计入本轮主循环的帧耗时
 
+    historyLock(); // 重播期间网络任务的写入会等待
+    if (canvasFramebufferCatchUp(allDrawingHistory, SIZE_MAX))
+    {
+        // 画布帧缓冲已与历史一致: 推送缓冲代替逐点重播 (结果相同)
+        if (canvasFramebufferSawReset())
+        {
+            tft.fillScreen(TFT_BLACK);
+            drawMainInterface();
+        }
+        canvasFramebufferPush(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        historyUnlock();
+        return;
+    }
+    if (rasterBaseVisible(allDrawingHistory))
+    {
+        rasterBaseForEachRun(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, drawBaseRun); // 较早展平的内容在最下层
+    }
     for (size_t i = 0; i < allDrawingHistory.size(); ++i)
     {
         const auto &drawData = allDrawingHistory[i];
@@ -859,25 +1944,543 @@ void replayAllDrawings()
         {
             tft.fillScreen(TFT_BLACK);
             drawMainInterface();
-            lastRemotePoint.x = 0;
-            lastRemotePoint.y = 0;
-            lastRemotePoint.z = 0;
-            lastRemoteDrawTime = drawData.timestamp;
             continue;
         }
-        int mapX = drawData.x;
-        int mapY = drawData.y;
-        if (drawData.timestamp - lastRemoteDrawTime > TOUCH_STROKE_INTERVAL || lastRemotePoint.z == 0)
+        if (history_point_hidden(drawData))
+            continue; // 已撤销的笔划和撤销/重做记录
+        const TouchData_t *previous = allDrawingHistory.stroke_previous(i); // 与实时绘制和区域重播相同的连线规则
+        if (previous == nullptr)
         {
-            tft.drawPixel(mapX, mapY, drawData.color);
+            tft.drawPixel(drawData.x, drawData.y, drawData.color);
         }
         else
         {
-            tft.drawLine(lastRemotePoint.x, lastRemotePoint.y, mapX, mapY, drawData.color);
+            tft.drawLine(previous->x, previous->y, drawData.x, drawData.y, drawData.color);
+        }
+    }
+    historyUnlock();
+}
+
+void redrawUndoneRegion(int x, int y, int w, int h)
+{
+    historyLock();
+    if (canvasFramebufferCatchUp(allDrawingHistory, SIZE_MAX))
+    {
+        canvasFramebufferRedrawRegion(allDrawingHistory, x, y, w, h); // 缓冲中该区域仍是撤销/重做之前的画面
+    }
+    historyUnlock();
+    redrawRegion(x, y, w, h); // 擦除区域并重绘界面和笔划 (有画布帧缓冲时推送缓冲)
+}
+
+void replayRegion(int x, int y, int w, int h)
+{
+    perfNoteDrawn();
+    static std::vector<uint32_t> strokes; // 复用，避免每次重绘都分配
+    int right = x + w - 1;
+    int bottom = y + h - 1;
+
+    historyLock(); // 重播期间网络任务的写入会等待
+    if (canvasFramebufferCatchUp(allDrawingHistory, SIZE_MAX))
+    {
+        canvasFramebufferPush(x, y, w, h); // 画布帧缓冲已与历史一致，不必查索引重播
+        historyUnlock();
+        return;
+    }
+    const StrokeTileIndex &index = allDrawingHistory.strokes();
+    index.strokesInRect(x, y, w, h, strokes);
+    tft.setViewport(x, y, w, h, false); // 坐标仍为屏幕坐标，区域外的像素被裁掉
+    if (rasterBaseVisible(allDrawingHistory))
+    {
+        rasterBaseForEachRun(x, y, w, h, drawBaseRun);
+    }
+    for (uint32_t stroke : strokes)
+    {
+        // 与 replayAllDrawings 相同: 按 stroke_previous 画点或连线；只绘制外接矩形与区域相交的线段
+        size_t end = index.strokeEnd(stroke);
+        for (size_t i = index.strokeStart(stroke); i < end; ++i)
+        {
+            const TouchData_t &drawData = allDrawingHistory[i];
+            if (history_point_hidden(drawData))
+                continue;
+            const TouchData_t *previous = allDrawingHistory.stroke_previous(i);
+            if (previous == nullptr)
+            {
+                if (drawData.x >= x && drawData.x <= right && drawData.y >= y && drawData.y <= bottom)
+                    tft.drawPixel(drawData.x, drawData.y, drawData.color);
+            }
+            else if (std::max(previous->x, drawData.x) >= x && std::min(previous->x, drawData.x) <= right &&
+                     std::max(previous->y, drawData.y) >= y && std::min(previous->y, drawData.y) <= bottom)
+            {
+                tft.drawLine(previous->x, previous->y, drawData.x, drawData.y, drawData.color);
+            }
+        }
+    }
+    tft.resetViewport();
+    historyUnlock();
+}
+
+// --- 网络/同步任务 ---
+
+// 网络任务启动前 (setup 中恢复画布时) 只有主循环访问历史，互斥锁尚未创建，不需要加锁
+void historyLock()
+{
+    if (historyMutex != nullptr)
+        xSemaphoreTake(historyMutex, portMAX_DELAY);
+}
+
+void historyUnlock()
+{
+    if (historyMutex != nullptr)
+        xSemaphoreGive(historyMutex);
+}
+
+bool networkSubmit(const NetworkOp_t &op)
+{
+    if (!networkOpQueue.push(op))
+    {
+        networkStats.opsDropped++;
+        return false;
+    }
+    if (networkTaskHandle != nullptr)
+        xTaskNotifyGive(networkTaskHandle);
+    return true;
+}
+
+// 本机复位: 清空历史、重置同步状态，需要时通知对端清屏
+static void handleLocalReset(const NetworkOp_t &op)
+{
+    clearHistory();
+
+    relativeBootTimeOffset = 0;
+    iamEffectivelyMoreUptimeDevice = false;
+    iamRequestingAllData = false;
+    initialSyncLogicProcessed = false;
+
+    if (op.broadcast)
+    {
+        // 通过ESP-NOW发送复位消息
+        SyncMessage_t resetMsg;
+        resetMsg.type = MSG_TYPE_RESET_CANVAS;
+        resetMsg.senderUptime = op.point.timestamp;
+        resetMsg.senderOffset = relativeBootTimeOffset; // 现在应为0
+        resetMsg.touch_data = op.point;
+        resetMsg.touch_data.isReset = true;
+        sendSyncMessage(&resetMsg);
+    }
+}
+
+// 本机的点加入历史后调用: 不与之前的点连线 (linked 为 false) 时开始了新的笔划，记为本机最近的笔划
+// (之后不能再重做)。不看笔划索引: 对端同时作画时索引中的笔划可能合并了几台设备的笔划
+static void trackOwnStroke(const TouchData_t &point, bool linked)
+{
+    if (linked)
+        return;
+    ownStrokes[ownStrokeNext] = {point.x, point.y, point.timestamp};
+    ownStrokeNext = (ownStrokeNext + 1) % HISTORY_UNDO_DEPTH;
+    ownStrokeCount = std::min<size_t>(ownStrokeCount + 1, HISTORY_UNDO_DEPTH);
+    redoCount = 0;
+}
+
+// 本机的点: 加入历史。主循环画它时只知道本机的上一点，对端同色的点在这期间插入历史时连线会不同
+// (DrawingHistory::stroke_previous)，这时重绘两条线段所在的区域，屏幕与重播的画面一致
+static void acceptLocalPoint(const NetworkOp_t &op)
+{
+    const TouchData_t &point = op.point;
+    TouchData_t previous;
+    bool linked = appendHistory(point, &previous);
+    trackOwnStroke(point, linked);
+    if (linked == op.drawnLinked && (!linked || (previous.x == op.drawnFromX && previous.y == op.drawnFromY)))
+        return;
+
+    int minX = point.x, maxX = point.x, minY = point.y, maxY = point.y;
+    if (linked)
+    {
+        minX = std::min(minX, previous.x);
+        maxX = std::max(maxX, previous.x);
+        minY = std::min(minY, previous.y);
+        maxY = std::max(maxY, previous.y);
+    }
+    if (op.drawnLinked)
+    {
+        minX = std::min(minX, op.drawnFromX);
+        maxX = std::max(maxX, op.drawnFromX);
+        minY = std::min(minY, op.drawnFromY);
+        maxY = std::max(maxY, op.drawnFromY);
+    }
+    RenderCommand_t command;
+    memset(&command, 0, sizeof(command));
+    command.type = RENDER_CMD_REDRAW_REGION;
+    command.region = {minX, minY, maxX - minX + 1, maxY - minY + 1};
+    renderQueuePush(command);
+}
+
+// 本机撤销/重做: 生成记录并加入历史，需要时通过 ESP-NOW 广播 (WiFi 连接时由主循环通过 MQTT 发布)
+static void handleLocalUndo(const NetworkOp_t &op)
+{
+    TouchData_t record;
+    bool found = false;
+    if (op.type == NET_OP_REDO)
+    {
+        // 记录的目标可能已被对端撤销窗口之外的操作改变，找不到时 acceptTombstone 丢弃
+        while (!found && redoCount > 0)
+        {
+            record = redoRecords[--redoCount];
+            found = acceptTombstone(record, !op.broadcast);
+        }
+    }
+    else
+    {
+        // 撤销窗口中本机最新的、还未撤销的笔划
+        for (size_t i = 0; i < ownStrokeCount && !found; i++)
+        {
+            const OwnStroke_t &own = ownStrokes[(ownStrokeNext + HISTORY_UNDO_DEPTH - 1 - i) % HISTORY_UNDO_DEPTH];
+            size_t first = allDrawingHistory.find_visible_point(own.x, own.y, own.timestamp);
+            if (first >= allDrawingHistory.size())
+                continue; // 已撤销，或已移出撤销窗口
+            TouchData_t redoRecord;
+            allDrawingHistory.stroke_tombstone(first, false, record);
+            allDrawingHistory.stroke_tombstone(first, true, redoRecord);
+            found = acceptTombstone(record, !op.broadcast);
+            if (found)
+            {
+                if (redoCount == HISTORY_UNDO_DEPTH)
+                {
+                    memmove(redoRecords, redoRecords + 1, sizeof(TouchData_t) * (HISTORY_UNDO_DEPTH - 1));
+                    redoCount--;
+                }
+                redoRecords[redoCount++] = redoRecord;
+            }
+        }
+    }
+    if (!found)
+    {
+        Serial.println(op.type == NET_OP_REDO ? "没有可重做的笔划" : "撤销窗口中没有本机画的笔划");
+        return;
+    }
+    if (op.broadcast)
+    {
+        SyncMessage_t tombstoneMsg;
+        memset(&tombstoneMsg, 0, sizeof(tombstoneMsg));
+        tombstoneMsg.type = MSG_TYPE_STROKE_TOMBSTONE;
+        tombstoneMsg.senderUptime = millis();
+        tombstoneMsg.senderOffset = relativeBootTimeOffset;
+        tombstoneMsg.touch_data = record;
+        sendSyncMessage(&tombstoneMsg);
+    }
+}
+
+// 记下当前在线的对端 (醒来后向其中第一个重新出现的对端请求增量)
+static void rememberSleepPeers()
+{
+    sleepSyncState.peerCount = 0;
+    xSemaphoreTake(peerMutex, portMAX_DELAY);
+    for (size_t i = 0; i < peerTableCount && sleepSyncState.peerCount < SLEEP_SYNC_MAX_PEERS; i++)
+    {
+        memcpy(sleepSyncState.peerMacs[sleepSyncState.peerCount], peerTable[i].mac, 6);
+        sleepSyncState.peerCount++;
+    }
+    xSemaphoreGive(peerMutex);
+}
+
+// 进入浅睡眠待机: 对端记下各自的历史长度，之后的点在待机结束后补发 (不写快照，RTC 数据不标记为有效)
+static void handleDozeBegin()
+{
+    SyncMessage_t noticeMsg;
+    memset(&noticeMsg, 0, sizeof(noticeMsg));
+    noticeMsg.type = MSG_TYPE_SLEEP_NOTICE;
+    noticeMsg.senderUptime = millis();
+    noticeMsg.senderOffset = relativeBootTimeOffset;
+    noticeMsg.totalPointsForSync = syncCountField(allDrawingHistory.size());
+    sendSyncMessage(&noticeMsg);
+
+    sleepSyncState.historyCount = allDrawingHistory.size();
+    rememberSleepPeers();
+    dozeHistoryStart = allDrawingHistory.size();
+    dozeNoticeSent = true;
+}
+
+// 退出浅睡眠待机: 射频关闭期间对端发出的点已经丢失，像深度睡眠醒来一样等待待机前的对端出现并请求增量
+static void handleDozeEnd()
+{
+    if (!dozeNoticeSent)
+        return;
+    dozeNoticeSent = false;
+    if (sleepSyncState.peerCount == 0 || deltaRequestState != DELTA_IDLE || isReceivingDrawingData || iamRequestingAllData)
+        return;
+    deltaRequestState = DELTA_WAITING_FOR_PEER;
+    deltaStateSinceMs = millis();
+    deltaSkipDuplicates = true;
+    Serial.println("退出浅睡眠待机，等待待机前的对端以请求错过的增量");
+}
+
+// 处理主循环提交的操作 (按提交顺序)
+static void drainNetworkOps()
+{
+    NetworkOp_t op;
+    while (networkOpQueue.pop(op))
+    {
+        switch (op.type)
+        {
+        case NET_OP_LOCAL_POINT:
+            acceptLocalPoint(op);
+            latencyRecordSince(LATENCY_HISTORY, op.sampleMicros);
+            if (op.broadcast)
+            {
+                SyncMessage_t drawMsg;
+                drawMsg.type = MSG_TYPE_DRAW_POINT;
+                drawMsg.senderUptime = op.point.timestamp;
+                drawMsg.senderOffset = relativeBootTimeOffset;
+                drawMsg.touch_data = op.point;
+                sendSyncMessage(&drawMsg);
+                latencyRecordSince(LATENCY_SEND, op.sampleMicros);
+            }
+            break;
+        case NET_OP_REMOTE_POINT:
+            acceptRemotePoint(op.point, op.sampleMicros);
+            break;
+        case NET_OP_LOCAL_RESET:
+            handleLocalReset(op);
+            break;
+        case NET_OP_CLEAR_HISTORY:
+            clearHistory();
+            break;
+        case NET_OP_FULL_SYNC:
+            if (!isSendingDrawingData)
+            {
+                Serial.print("压力测试: 开始发送全部 ");
+                Serial.print(allDrawingHistory.size());
+                Serial.println(" 个历史点。");
+                beginHistorySend(false); // 压力测试的是逐点发送
+            }
+            break;
+        case NET_OP_UNDO:
+        case NET_OP_REDO:
+            handleLocalUndo(op);
+            break;
+        case NET_OP_REMOTE_TOMBSTONE:
+            acceptTombstone(op.point, false);
+            break;
+        case NET_OP_DOZE_BEGIN:
+            handleDozeBegin();
+            break;
+        case NET_OP_DOZE_END:
+            handleDozeEnd();
+            break;
+        }
+    }
+}
+
+static void networkTask(void *param)
+{
+    (void)param;
+    unsigned long lastHeartbeatCheckTime = millis();
+    bool wasDozing = false;
+    for (;;)
+    {
+        // 分批发送历史时不等待；压缩进行中只短暂让出 CPU；否则等待新消息/新操作 (最长到下一次心跳超时检查)
+        TickType_t waitTicks = pdMS_TO_TICKS(HEARTBEAT_CHECK_INTERVAL_MS);
+        if (isSendingDrawingData || isSendingDelta)
+            waitTicks = 0;
+        else if (compactJob.phase != COMPACT_IDLE || flattenJob.active)
+            waitTicks = pdMS_TO_TICKS(HISTORY_COMPACT_SLICE_INTERVAL_MS);
+        ulTaskNotifyTake(pdTRUE, waitTicks);
+
+        drainNetworkOps();
+        processIncomingMessages();
+        if (isSendingDrawingData)
+        {
+            if (isSendingRaster)
+                sendRasterBatch();
+            else
+                sendHistoryBatch();
+        }
+        if (isSendingDelta)
+        {
+            sendDeltaBatch();
+        }
+        if (deltaRequestState != DELTA_IDLE)
+        {
+            checkDeltaTimeout();
         }
-        lastRemotePoint.x = mapX;
-        lastRemotePoint.y = mapY;
-        lastRemotePoint.z = 1;
-        lastRemoteDrawTime = drawData.timestamp;
+        checkSyncReceiveTimeout();
+        runHistoryFlatten();     // 超出内存预算时分步把较早的笔划展平为底图
+        runHistoryCompaction();  // 没人在画时分步压缩历史
+        canvasStoreFlushIfDue(); // 笔划结束后把缓存的点写入闪存，压缩后重写快照
+
+        if (millis() - lastHeartbeatCheckTime >= HEARTBEAT_CHECK_INTERVAL_MS)
+        {
+            if (powerManagerIsDozing())
+            {
+                wasDozing = true; // 浅睡眠待机时收不全对端心跳，暂停超时检查
+            }
+            else
+            {
+                if (wasDozing)
+                {
+                    refreshPeerHeartbeats();
+                    wasDozing = false;
+                }
+                checkPeerHeartbeatTimeout();
+            }
+            lastHeartbeatCheckTime = millis();
+        }
+    }
+}
+
+void networkTaskStart()
+{
+    if (networkTaskHandle != nullptr)
+    {
+        return;
+    }
+    historyMutex = xSemaphoreCreateMutex();
+    peerMutex = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK_SIZE, nullptr,
+                            NETWORK_TASK_PRIORITY, &networkTaskHandle, NETWORK_TASK_CORE);
+}
+
+void historyCompactRequest()
+{
+    compactRequested = true;
+    if (networkTaskHandle != nullptr)
+        xTaskNotifyGive(networkTaskHandle);
+}
+
+void historyCompactPrintStats(Print &out)
+{
+    HistoryCompactStats_t s = compactStats;
+    out.printf("history        %lu points now, %lu runs, %lu aborted, %lu points removed in total%s\n",
+               (unsigned long)allDrawingHistory.size(), (unsigned long)s.runs, (unsigned long)s.aborted,
+               (unsigned long)s.totalRemoved, compactJob.phase != COMPACT_IDLE ? " (running)" : "");
+    if (s.runs > 0)
+    {
+        out.printf("last run       %lu -> %lu points (hidden %lu, simplified %lu, occluded %lu, undone %lu) in %lums\n",
+                   (unsigned long)s.lastBefore, (unsigned long)s.lastAfter, (unsigned long)s.lastHidden,
+                   (unsigned long)s.lastSimplified, (unsigned long)s.lastOccluded, (unsigned long)s.lastUndone,
+                   (unsigned long)s.lastDurationMs);
+        out.printf("reclaimed      %lu bytes of history memory in the last run\n",
+                   (unsigned long)((s.lastBefore - s.lastAfter) * sizeof(TouchData_t)));
+    }
+}
+
+void historyBudgetSet(size_t bytes)
+{
+    historyBudgetOverride = bytes;
+    if (networkTaskHandle != nullptr)
+        xTaskNotifyGive(networkTaskHandle);
+}
+
+void historyBudgetPrintStats(Print &out)
+{
+    historyLock();
+    size_t historyBytes = allDrawingHistory.memory_bytes();
+    size_t points = allDrawingHistory.size();
+    size_t baseBytes = rasterBaseBytes();
+    uint32_t baseChunks = rasterBaseChunkCount();
+    historyUnlock();
+    HistoryBudgetStats_t s = budgetStats;
+    out.printf("budget         %lu bytes%s, in use %lu (history %lu for %lu points, raster base %lu in %lu chunks)\n",
+               (unsigned long)historyBudgetBytes(), historyBudgetOverride != 0 ? " (set over serial)" : "",
+               (unsigned long)(historyBytes + baseBytes), (unsigned long)historyBytes, (unsigned long)points,
+               (unsigned long)baseBytes, (unsigned long)baseChunks);
+    out.printf("flattened      %lu runs, %lu aborted, %lu points in total, last run %lums%s\n", (unsigned long)s.flattens,
+               (unsigned long)s.aborted, (unsigned long)s.pointsFlattened, (unsigned long)s.lastDurationMs,
+               flattenJob.active ? " (running)" : "");
+}
+
+void networkTaskGetStats(NetworkTaskStats_t &out)
+{
+    out = networkStats;
+    out.rxQueueMaxDepth = radioRxQueue.maxSize();
+    out.opQueueMaxDepth = networkOpQueue.maxSize();
+    out.tileQueueMaxDepth = rasterRxQueue.maxSize();
+}
+
+// --- 深度睡眠前后的增量同步 ---
+
+void sleepSyncPrepare()
+{
+    // 1. 通知对端: 它们记下各自当前的历史长度，此后的新点在本机醒来后补发
+    historyLock();
+    size_t historyCount = allDrawingHistory.size();
+    historyUnlock();
+
+    SyncMessage_t noticeMsg;
+    memset(&noticeMsg, 0, sizeof(noticeMsg));
+    noticeMsg.type = MSG_TYPE_SLEEP_NOTICE;
+    noticeMsg.senderUptime = millis();
+    noticeMsg.senderOffset = relativeBootTimeOffset;
+    noticeMsg.totalPointsForSync = syncCountField(historyCount);
+    sendSyncMessage(&noticeMsg);
+
+    // 2. 等网络任务处理完通知之前收到的点，再把历史压缩为快照
+    delay(SLEEP_SYNC_SETTLE_MS);
+    size_t snapshotCount = 0;
+    if (!canvasStoreSnapshot(snapshotCount))
+    {
+        Serial.println("画布快照写入失败，醒来后将进行全量同步");
+        sleepSyncState.magic = 0;
+        return;
     }
+
+    // 3. 同步元数据写入 RTC 内存
+    sleepSyncState.effectiveUptimeAtSleep = millis() + relativeBootTimeOffset;
+    sleepSyncState.historyCount = snapshotCount;
+    rememberSleepPeers();
+    sleepSyncState.magic = SLEEP_SYNC_MAGIC;
+
+    Serial.print("深度睡眠前已保存 ");
+    Serial.print(snapshotCount);
+    Serial.print(" 个点和 ");
+    Serial.print(sleepSyncState.peerCount);
+    Serial.println(" 个对端");
+}
+
+bool sleepSyncRestore()
+{
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    bool wokeFromDeepSleep = cause == ESP_SLEEP_WAKEUP_EXT0 || cause == ESP_SLEEP_WAKEUP_EXT1 || cause == ESP_SLEEP_WAKEUP_TIMER;
+    bool valid = wokeFromDeepSleep && sleepSyncState.magic == SLEEP_SYNC_MAGIC;
+    sleepSyncState.magic = 0; // 只使用一次
+    if (!valid)
+        return false;
+
+    if (allDrawingHistory.size() != sleepSyncState.historyCount)
+    {
+        Serial.println("从闪存恢复的点数与睡前不一致，醒来后进行全量同步");
+        return false;
+    }
+    if (sleepSyncState.peerCount == 0)
+    {
+        Serial.println("从深度睡眠醒来，睡前没有在线的对端");
+        return false;
+    }
+
+    // 睡眠时长没有可靠来源 (RTC 慢时钟误差较大)，先接着睡前的有效运行时间计时:
+    // 本机在对端看来是较新的设备，不会让对端清空画布；增量补发完成后再按对端时间校准
+    relativeBootTimeOffset = (long)sleepSyncState.effectiveUptimeAtSleep - (long)millis();
+    deltaRequestState = DELTA_WAITING_FOR_PEER;
+    deltaStateSinceMs = millis();
+    Serial.print("从深度睡眠醒来，已恢复 ");
+    Serial.print(sleepSyncState.historyCount);
+    Serial.println(" 个点，等待睡前的对端以请求增量");
+    return true;
+}
+
+static void submitDozeOp(NetworkOpType_t type)
+{
+    NetworkOp_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = type;
+    networkSubmit(op);
+}
+
+void dozeSyncBegin()
+{
+    submitDozeOp(NET_OP_DOZE_BEGIN);
+}
+
+void dozeSyncEnd()
+{
+    submitDozeOp(NET_OP_DOZE_END);
 }
@@ -4,10 +4,6 @@
 #include <esp_now.h>
 #include <WiFi.h>
 #include <esp_wifi.h> // 用于 esp_wifi_get_mac()
-#include <queue>
-#include <set>
-#include <map>        // 新增：用于 std::map
-#include <string>     // For std::string if used by macSet, though it's std::set<String>
 #include "config.h"   // 项目配置文件
 #include <TFT_eSPI.h> // 需要 TFT_eSPI::color565 等，以及 tft 对象
 #include "touch_handler.h" // For TS_Point type
@@ -25,7 +21,13 @@ enum MessageType_e // 使用 _e 后缀表示 enum
     MSG_TYPE_CLEAR_AND_REQUEST_UPDATE,
     MSG_TYPE_RESET_CANVAS,
     MSG_TYPE_SYNC_START, // 新增：同步开始信号
-    MSG_TYPE_HEARTBEAT   // 新增：心跳包
+    MSG_TYPE_HEARTBEAT,  // 新增：心跳包
+    MSG_TYPE_SLEEP_NOTICE,  // 即将深度睡眠或浅睡眠待机: 对端记下自己当前的历史长度 (totalPointsForSync 为发送方的点数)
+    MSG_TYPE_REQUEST_DELTA, // 深度睡眠醒来后单播给睡前的对端: 请求补发睡眠期间的点
+    MSG_TYPE_DELTA_COMPLETE, // 补发结束 (单播)，totalPointsForSync 为补发的点数，发送方时间用于校准偏移
+    MSG_TYPE_RASTER_SYNC_START, // 同 SYNC_START，但之后发送的是画布图块 (RasterTileMessage_t)，totalPointsForSync 为数据段数
+    MSG_TYPE_RASTER_TILE,       // 图块数据 (只出现在 RasterTileMessage_t 中)，以 ALL_DRAWINGS_COMPLETE 结束
+    MSG_TYPE_STROKE_TOMBSTONE   // 撤销/重做一个笔划: touch_data 为撤销/重做记录 (格式见 drawing_history.h)，实时广播，也随全量/增量同步发送
 };
 typedef enum MessageType_e MessageType_t; // Typedef for the enum
 
@@ -35,14 +37,78 @@ typedef struct SyncMessage_s
     unsigned long senderUptime;
     long senderOffset;
     TouchData_t touch_data;
-    uint16_t totalPointsForSync; // 新增：用于同步开始时告知总点数
+    uint32_t totalPointsForSync; // 同步开始时告知的总点数/数据段数、睡眠通知和增量同步的历史点数
+                                 // (原为 uint16_t，超过 65535 点会回绕；加宽占用其后的 2 字节填充，设备上结构大小不变。
+                                 // 旧固件不清零填充，收到旧固件的值高 16 位可能无效，只用于进度和日志)
     uint32_t usedMemory;         // 新增：发送方已用内存 (字节)
     uint32_t totalMemory;        // 新增：发送方总内存 (字节)
 } SyncMessage_t;
 
+// REQUEST_ALL_DRAWINGS 不携带点，touch_data.color 用作请求方支持的同步方式 (旧版本固件清零)
+#define SYNC_CAP_RASTER 0x01 // 能接收光栅同步
+
+// 光栅同步的一段图块数据 (编码见 raster_sync.h)
+// 长度与 SyncMessage_t 不同，旧版本固件按意外长度丢弃；ESP-NOW 单条消息最多 250 字节
+#define RASTER_CHUNK_DATA_BYTES 238
+typedef struct RasterTileMessage_s
+{
+    MessageType_t type;   // MSG_TYPE_RASTER_TILE
+    uint16_t tileIndex;   // 图块编号 (行优先)
+    uint16_t pixelOffset; // 本段数据在图块内的起始像素
+    uint16_t length;      // data 中的有效字节数
+    uint8_t data[RASTER_CHUNK_DATA_BYTES];
+} RasterTileMessage_t;
+
+// 接收队列中的消息 (附带接收时间，用于延迟统计)
+typedef struct ReceivedMessage_s {
+    SyncMessage_t msg;
+    uint32_t receivedMicros; // 接收回调中记录的 micros()
+    uint8_t srcMac[6];       // 发送方 MAC
+    bool macOnly;            // 旧版 MAC 地址广播，只更新对端列表，msg 无效
+} ReceivedMessage_t;
+
+// 主循环交给网络任务的操作
+enum NetworkOpType_e {
+    NET_OP_LOCAL_POINT,   // 本机绘制的点: 加入历史，需要时通过 ESP-NOW 广播
+    NET_OP_REMOTE_POINT,  // MQTT 收到的点: 加入历史，再交给主循环绘制 (与 ESP-NOW 的点相同)
+    NET_OP_LOCAL_RESET,   // 本机复位按钮: 清空历史、重置同步状态，需要时广播复位消息
+    NET_OP_CLEAR_HISTORY, // 只清空历史 (MQTT 收到复位)
+    NET_OP_FULL_SYNC,     // 压力测试: 像收到 REQUEST_ALL_DRAWINGS 一样发送全部历史
+    NET_OP_UNDO,          // 撤销本机最近画的、还未撤销的笔划，需要时广播撤销记录
+    NET_OP_REDO,          // 重做最近撤销的笔划 (本机画新笔划后不能再重做)
+    NET_OP_REMOTE_TOMBSTONE, // MQTT 收到的撤销/重做记录: 加入历史并重绘目标笔划所在的区域
+    NET_OP_DOZE_BEGIN,    // 进入浅睡眠待机: 广播 SLEEP_NOTICE
+    NET_OP_DOZE_END,      // 退出浅睡眠待机: 向待机前的对端请求增量
+};
+typedef enum NetworkOpType_e NetworkOpType_t;
+
+typedef struct NetworkOp_s {
+    NetworkOpType_t type;
+    TouchData_t point;     // NET_OP_LOCAL_POINT / NET_OP_REMOTE_POINT / NET_OP_LOCAL_RESET (时间戳和颜色) / NET_OP_REMOTE_TOMBSTONE
+    uint32_t sampleMicros; // NET_OP_LOCAL_POINT: 触摸采样时的 micros() (延迟统计)
+    bool drawnLinked;      // NET_OP_LOCAL_POINT: 主循环画这个点时是否与本机上一点 (drawnFromX, drawnFromY) 连线
+    int drawnFromX;
+    int drawnFromY;
+    bool broadcast;        // 是否通过 ESP-NOW 广播 (WiFi 未连接时)
+} NetworkOp_t;
+
+// 网络任务统计
+typedef struct NetworkTaskStats_s {
+    uint32_t opsDropped;        // 主循环 -> 网络任务队列满而丢弃的操作数
+    uint32_t rxDropped;         // 接收回调 -> 网络任务队列满而丢弃的消息数
+    uint32_t historyPointsSent; // 启动以来分批发送的历史点数
+    uint32_t fullSyncsSent;     // 启动以来完成的全量发送次数
+    uint32_t deltaSyncsSent;    // 启动以来为醒来的对端补发增量的次数
+    uint32_t rasterSyncsSent;   // 全量发送中使用光栅同步的次数
+    uint32_t rxMalformed;       // 因类型未知或坐标越界被丢弃的消息数
+    uint32_t rxQueueMaxDepth;   // 接收队列启动以来的最大深度
+    uint32_t opQueueMaxDepth;   // 操作队列启动以来的最大深度
+    uint32_t tileQueueMaxDepth; // 图块接收队列启动以来的最大深度
+} NetworkTaskStats_t;
+
 // 新增：存储对端详细信息的结构体
 typedef struct PeerInfo_s {
-    String macAddress;
+    char macAddress[18];           // "XX:XX:XX:XX:XX:XX"
     unsigned long effectiveUptime;
     uint32_t usedMemory;
     uint32_t totalMemory;
@@ -52,11 +118,7 @@ typedef struct PeerInfo_s {
 // ESP-NOW 相关全局变量 (声明为 extern)
 extern esp_now_peer_info_t broadcastPeerInfo;
 extern uint8_t broadcastAddress[];
-extern std::queue<SyncMessage_t> incomingMessageQueue;
-extern DrawingHistory allDrawingHistory;
-extern std::set<String> macSet; // 用于设备计数，由 ESP-NOW 填充
-extern std::map<String, unsigned long> peerLastHeartbeat; // 新增：存储每个对端的最后心跳时间
-extern std::map<String, PeerInfo_t> peerInfoMap; // 新增：存储所有已知对端详细信息的 map
+extern DrawingHistory allDrawingHistory; // 只由网络任务写入，其他任务读取前须 historyLock()
 
 extern unsigned long lastKnownPeerUptime;
 extern long lastKnownPeerOffset;
@@ -68,12 +130,10 @@ extern bool isAwaitingSyncStartResponse;
 extern bool isReceivingDrawingData;
 extern bool isSendingDrawingData;
 extern size_t currentHistorySendIndex;   // 新增：用于分批发送历史记录的当前索引
+extern size_t historySendEndIndex;       // 本次全量发送的结束索引 (开始发送时的历史长度)
 extern long relativeBootTimeOffset;
 extern unsigned long uptimeOfLastPeerSyncedFrom;
 
-// 触摸点处理相关 (用于远程点绘制)
-extern TS_Point lastRemotePoint;      // 远程最后一点 (用于以正确的连续性重播历史记录)
-extern unsigned long lastRemoteDrawTime; // 远程最后绘制时间 (用于以正确的时间/连续性重播历史记录)
 // touchInterval 定义已移至 config.h 作为 TOUCH_STROKE_INTERVAL
 
 
@@ -82,11 +142,91 @@ void espNowInit(); // ESP-NOW 初始化
 void OnSyncDataSent(const uint8_t *mac_addr, esp_now_send_status_t status); // 发送回调
 void OnSyncDataRecv(const esp_now_recv_info *info, const uint8_t *incomingDataPtr, int len); // 接收回调
 void sendSyncMessage(const SyncMessage_t *msg); // 发送同步消息的辅助函数
-void processIncomingMessages(); // 处理接收到的消息队列
-void replayAllDrawings();       // 重播所有绘图历史 (需要 tft 对象)
+void replayAllDrawings();       // 重播所有绘图历史 (需要 tft 对象，只在主循环中调用)
+void replayRegion(int x, int y, int w, int h); // 只重播与矩形相交的笔划并裁剪到矩形内 (不擦除背景，只在主循环中调用)
+void redrawUndoneRegion(int x, int y, int w, int h); // 撤销/重做后重绘目标笔划的外接矩形 (含画布帧缓冲，只在主循环中调用)
 void sendHeartbeat(); // 新增：发送心跳包
-void checkPeerHeartbeatTimeout(); // 新增：检查对端心跳超时
-std::vector<PeerInfo_t> getPeerInfoList(); // 新增：获取对端信息列表
+// 对端列表是按 MAC 排序的定长表 (MAX_TRACKED_PEERS)，只由网络任务增删，收到消息时不再分配内存
+size_t peerCount();     // 已发现的对端数 (含只广播 MAC 的旧版本设备)
+size_t peerInfoCount(); // 带有详细信息 (运行时间、内存) 的对端数
+size_t getPeerInfoList(PeerInfo_t *out, size_t maxCount); // 拷贝至多 maxCount 个带详细信息的对端，返回个数
+bool remotePointInRange(const TouchData_t &point); // 远端点坐标是否在屏幕外 REMOTE_POINT_MARGIN 以内 (ESP-NOW 和 MQTT 接收时校验)
+
+// --- 网络/同步任务 ---
+// 固定在核心 0 (与 WiFi 协议栈同核)，负责 ESP-NOW 消息处理、同步状态机、分批发送历史和对端心跳超时检查，
+// 是 allDrawingHistory 和对端列表的唯一写入者。屏幕绘制通过 render_queue 交给主循环。
+// 分批发送历史时的逐点延时只阻塞本任务，主循环的本地绘图不受影响。
+void networkTaskStart();
+
+// 主循环调用: 把操作交给网络任务。队列满时丢弃并计数，返回 false
+bool networkSubmit(const NetworkOp_t &op);
+
+// 读取 allDrawingHistory 前后调用 (网络任务写入时也会持有该锁)
+void historyLock();
+void historyUnlock();
+
+void networkTaskGetStats(NetworkTaskStats_t &out);
+
+// --- 历史压缩 (history_compact.cpp) ---
+// 网络任务在没人作画 (HISTORY_COMPACT_IDLE_MS) 且没有同步进行时分步压缩历史，完成后原地删除点并重写闪存快照。
+
+typedef struct HistoryCompactStats_s {
+    uint32_t runs;           // 完成的压缩次数
+    uint32_t aborted;        // 因清屏或同步开始而放弃的次数
+    uint32_t lastBefore;     // 最近一次压缩前的点数
+    uint32_t lastAfter;      // 最近一次压缩后的点数
+    uint32_t lastHidden;     // 最近一次删除的复位之前的点数
+    uint32_t lastSimplified; // 最近一次化简删除的点数
+    uint32_t lastOccluded;   // 最近一次因被完全遮挡删除的点数
+    uint32_t lastUndone;     // 最近一次删除的已撤销笔划的点数 (含撤销/重做记录)
+    uint32_t lastDurationMs; // 最近一次从开始到完成的时间 (分步执行，含让出 CPU 的时间)
+    uint32_t totalRemoved;   // 启动以来删除的总点数
+} HistoryCompactStats_t;
+
+// 主循环调用: 下次空闲时压缩，不等新增点数达到阈值
+void historyCompactRequest();
+
+// 打印压缩统计
+void historyCompactPrintStats(Print &out);
+
+// --- 历史内存预算 (raster_base.cpp) ---
+// 历史 (分块 + 笔划索引) 与光栅底图占用的内存超出预算时，网络任务把较早的笔划分步展平到底图 (不在同步进行时)，
+// 只保留最近 HISTORY_FLATTEN_KEEP_PERCENT 的点作为矢量笔划，历史不再无限增长。
+// 全量同步时先以光栅同步发送底图，再逐点发送之后的历史。
+
+typedef struct HistoryBudgetStats_s {
+    uint32_t flattens;        // 完成的展平次数
+    uint32_t aborted;         // 因清屏、同步开始或分配失败而放弃的次数
+    uint32_t pointsFlattened; // 启动以来展平到底图的总点数
+    uint32_t lastDurationMs;  // 最近一次从开始到完成的时间 (分步执行)
+} HistoryBudgetStats_t;
+
+// 当前预算 (字节)，默认按有无 PSRAM 取 HISTORY_BUDGET_PSRAM_BYTES / HISTORY_BUDGET_INTERNAL_BYTES
+size_t historyBudgetBytes();
+
+// 主循环调用: 修改预算 (不保存，重启后恢复默认)，0 表示恢复默认
+void historyBudgetSet(size_t bytes);
+
+// 打印预算、当前用量和展平统计
+void historyBudgetPrintStats(Print &out);
+
+// --- 深度睡眠前后的增量同步 ---
+// 睡前: 广播 SLEEP_NOTICE (对端记下各自的历史长度)，把历史压缩为闪存快照，
+//       并在 RTC 内存中保存有效运行时间、历史点数和在线对端的 MAC。
+// 醒来: 从闪存恢复画布后，若 RTC 数据有效且点数一致，则不做全量同步，而是向第一个重新出现的睡前对端
+//       单播 REQUEST_DELTA，只接收睡眠期间的新点；对端没有记录或超时则回到原有的全量同步流程。
+
+// 深度睡眠前调用 (主循环)
+void sleepSyncPrepare();
+
+// setup 中恢复画布之后、espNowInit 之前调用，从深度睡眠醒来并进入增量同步时返回 true
+bool sleepSyncRestore();
+
+// 浅睡眠待机也用同一套增量同步: 定时醒来的监听窗口之外射频关闭，对端这时发出的点会丢失。
+// 进入待机时广播 SLEEP_NOTICE，退出待机后向第一个重新出现的待机前对端请求增量 (与监听窗口内已收到的点去重)。
+// 由 power_manager 在主循环中调用，实际处理交给网络任务
+void dozeSyncBegin();
+void dozeSyncEnd();
 
 // 注意: replayAllDrawings 函数依赖于在 esp_now_handler.cpp 中可访问的全局 tft 对象和 drawMainInterface 函数。
 
@@ -0,0 +1,354 @@
+#include "history_compact.h"
+#include <stdlib.h> // abs
+#include <string.h> // memset
+#include <stdint.h> // SIZE_MAX
+#include <algorithm> // std::swap, std::sort
+
+
+// 段: 连续的、每个点都与紧挨着的上一点连线 (strokeLink 为 1) 的点，撤销/重做记录单独成段，可见性不同的点也不归入同一段。
+// 段内的点只会被段内的下一点连线，段首与之前的点的连线 (DrawingHistory::stroke_previous) 画在段首处
+static bool continuesRun(const DrawingHistory &history, const HistoryCompactJob_t &job, size_t index)
+{
+    if (index <= job.visibleStart)
+        return false;
+    const TouchData_t &point = history[index];
+    return point.strokeLink == 1 && !history_is_tombstone(point) &&
+           history_point_hidden(point) == history_point_hidden(history[index - 1]);
+}
+
+static size_t runEnd(const DrawingHistory &history, const HistoryCompactJob_t &job, size_t start)
+{
+    size_t end = start + 1;
+    while (end < job.end && continuesRun(history, job, end))
+        end++;
+    return end;
+}
+
+static size_t runStart(const DrawingHistory &history, const HistoryCompactJob_t &job, size_t end)
+{
+    size_t start = end - 1;
+    while (start > job.visibleStart && continuesRun(history, job, start))
+        start--;
+    return start;
+}
+
+// start 之前最近的同色点 (跳过撤销/重做记录，与 find_stroke_link 的查找范围相同)，没有时返回 SIZE_MAX
+static size_t previousSameColor(const DrawingHistory &history, const HistoryCompactJob_t &job, size_t start)
+{
+    const TouchData_t &point = history[start];
+    if (point.strokeLink != 0)
+        return start - point.strokeLink;
+    size_t limit = start - job.visibleStart > HISTORY_STROKE_LINK_MAX ? start - HISTORY_STROKE_LINK_MAX : job.visibleStart;
+    for (size_t i = start; i > limit; i--)
+    {
+        const TouchData_t &previous = history[i - 1];
+        if (!history_is_tombstone(previous) && (previous.color & HISTORY_COLOR_MASK) == (point.color & HISTORY_COLOR_MASK))
+            return i - 1;
+    }
+    return SIZE_MAX;
+}
+
+// 遮挡: 已处理部分中该颜色第一个保留的点 (撤销/重做记录除外)，没有时返回 SIZE_MAX
+static size_t nextSurvivor(const HistoryCompactJob_t &job, uint32_t color)
+{
+    for (const HistoryCompactSurvivor_t &survivor : job.survivors)
+    {
+        if (survivor.color == color)
+            return survivor.index;
+    }
+    return SIZE_MAX;
+}
+
+static void setNextSurvivor(HistoryCompactJob_t &job, uint32_t color, size_t index)
+{
+    for (HistoryCompactSurvivor_t &survivor : job.survivors)
+    {
+        if (survivor.color == color)
+        {
+            survivor.index = index;
+            return;
+        }
+    }
+    job.survivors.push_back({color, index});
+}
+
+// 删除段 [start, end) 后其他点的连线是否不变: 删除后原来与段尾连线的点 (只可能是之后第一个保留的同色点 next)
+// 会改为与段首之前最近的同色点比较，所以 next 必须原本就不连线 (与段尾连线时线段会消失)，删除后也不连线
+static bool linksUnchanged(const DrawingHistory &history, const HistoryCompactJob_t &job, size_t start)
+{
+    uint32_t color = history[start].color & HISTORY_COLOR_MASK;
+    size_t next = nextSurvivor(job, color);
+    if (next == SIZE_MAX)
+        return false; // 之后追加的点还可能与段尾连线
+    if (history[next].strokeLink != 0)
+        return false;
+    size_t previous = previousSameColor(history, job, start);
+    return previous == SIZE_MAX || !history_continues_stroke(history[next], history[previous]);
+}
+
+// 与 TFT_eSPI::drawLine 相同的 Bresenham 步进 (同 raster_sync.cpp)，visit 返回 false 时停止
+template <typename Visit>
+static bool visitLine(int x0, int y0, int x1, int y1, Visit visit)
+{
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    int dx = x1 - x0;
+    int dy = abs(y1 - y0);
+    int err = dx >> 1;
+    int ystep = (y0 < y1) ? 1 : -1;
+    for (; x0 <= x1; x0++)
+    {
+        if (!(steep ? visit(y0, x0) : visit(x0, y0)))
+            return false;
+        err -= dy;
+        if (err < 0)
+        {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+    return true;
+}
+
+// 像素坐标打包成一个整数，便于排序比较
+static uint32_t packPixel(int x, int y)
+{
+    return ((uint32_t)(uint16_t)x << 16) | (uint16_t)y;
+}
+
+static void sortUnique(std::vector<uint32_t> &pixels)
+{
+    std::sort(pixels.begin(), pixels.end());
+    pixels.erase(std::unique(pixels.begin(), pixels.end()), pixels.end());
+}
+
+// 直线 a→b 画出的像素集合是否与折线 a→…→b 完全相同 (同一笔划颜色相同，像素集合相同则重播画面相同)
+static bool sameRaster(HistoryCompactJob_t &job, const DrawingHistory &history, size_t a, size_t b)
+{
+    job.linePixels.clear();
+    visitLine(history[a].x, history[a].y, history[b].x, history[b].y, [&job](int x, int y) {
+        job.linePixels.push_back(packPixel(x, y));
+        return true;
+    });
+    sortUnique(job.linePixels);
+
+    job.pathPixels.clear();
+    for (size_t i = a; i < b; i++)
+    {
+        bool onLine = visitLine(history[i].x, history[i].y, history[i + 1].x, history[i + 1].y, [&job](int x, int y) {
+            uint32_t pixel = packPixel(x, y);
+            if (!std::binary_search(job.linePixels.begin(), job.linePixels.end(), pixel))
+                return false; // 折线画到了直线之外的像素
+            job.pathPixels.push_back(pixel);
+            return true;
+        });
+        if (!onLine)
+            return false;
+    }
+    sortUnique(job.pathPixels);
+    return job.pathPixels.size() == job.linePixels.size();
+}
+
+// 化简段 [start, end): 首尾保留，从每个保留点出发尽量向后延伸，只有直线与原折线画出的像素完全相同
+// 且时间间隔不超过 TOUCH_STROKE_INTERVAL (重播时仍连成一笔) 时才删除中间的点，重播画面逐像素不变
+static void simplifyRun(HistoryCompactJob_t &job, const DrawingHistory &history, size_t start, size_t end)
+{
+    if (end - start < 3)
+        return;
+    size_t anchor = start;
+    while (anchor + 2 < end)
+    {
+        size_t next = anchor + 1;
+        for (size_t b = anchor + 2; b < end; b++)
+        {
+            if (history[b].timestamp - history[anchor].timestamp > TOUCH_STROKE_INTERVAL ||
+                !sameRaster(job, history, anchor, b))
+                break;
+            next = b;
+        }
+        for (size_t i = anchor + 1; i < next; i++)
+        {
+            job.keep[i] = false;
+            job.simplifiedPoints++;
+        }
+        anchor = next;
+    }
+}
+
+// 遍历化简后的段 [start, end) 重播时画到的屏幕内像素 (含段首与之前的点的连线)
+template <typename Visit>
+static bool visitRunPixels(const HistoryCompactJob_t &job, const DrawingHistory &history, size_t start, size_t end, Visit visit)
+{
+    auto onScreen = [&visit](int x, int y) {
+        if (x < 0 || y < 0 || x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT)
+            return true; // 屏幕外不绘制
+        return visit(x, y);
+    };
+    const TouchData_t *previous = history.stroke_previous(start);
+    for (size_t i = start; i < end; i++)
+    {
+        if (!job.keep[i])
+            continue;
+        const TouchData_t &point = history[i];
+        bool ok = previous ? visitLine(previous->x, previous->y, point.x, point.y, onScreen) : onScreen(point.x, point.y);
+        if (!ok)
+            return false;
+        previous = &point;
+    }
+    return true;
+}
+
+static bool runCovered(const HistoryCompactJob_t &job, const DrawingHistory &history, size_t start, size_t end)
+{
+    return visitRunPixels(job, history, start, end, [&job](int x, int y) {
+        size_t bit = (size_t)y * SCREEN_WIDTH + x;
+        return (job.coverage[bit >> 3] & (1 << (bit & 7))) != 0;
+    });
+}
+
+static void paintRun(HistoryCompactJob_t &job, const DrawingHistory &history, size_t start, size_t end)
+{
+    visitRunPixels(job, history, start, end, [&job](int x, int y) {
+        size_t bit = (size_t)y * SCREEN_WIDTH + x;
+        job.coverage[bit >> 3] |= (1 << (bit & 7));
+        return true;
+    });
+}
+
+void historyCompactBegin(HistoryCompactJob_t &job, const DrawingHistory &history, size_t end)
+{
+    job.end = end;
+    job.visibleStart = 0;
+    for (size_t i = end; i > 0; i--)
+    {
+        if (history[i - 1].isReset)
+        {
+            job.visibleStart = i;
+            break;
+        }
+    }
+    job.keep.assign(end, true);
+    for (size_t i = 0; i < job.visibleStart; i++)
+        job.keep[i] = false;
+    job.undoStart = history.undo_window_start();
+    job.hiddenPoints = job.visibleStart;
+    job.simplifiedPoints = 0;
+    job.occludedPoints = 0;
+    job.occludedStrokes = 0;
+    job.undonePoints = 0;
+    job.cursor = job.visibleStart;
+    job.survivors.clear();
+    job.phase = COMPACT_SIMPLIFY;
+}
+
+bool historyCompactStep(HistoryCompactJob_t &job, const DrawingHistory &history, size_t budget)
+{
+    size_t processed = 0;
+    if (job.phase == COMPACT_SIMPLIFY)
+    {
+        while (job.cursor < job.end && processed < budget)
+        {
+            size_t end = runEnd(history, job, job.cursor);
+            simplifyRun(job, history, job.cursor, end);
+            processed += end - job.cursor;
+            job.cursor = end;
+        }
+        if (job.cursor < job.end)
+            return false;
+        memset(job.coverage, 0, sizeof(job.coverage));
+        job.cursor = job.end;
+        job.phase = COMPACT_OCCLUDE;
+    }
+
+    if (job.phase == COMPACT_OCCLUDE)
+    {
+        while (job.cursor > job.visibleStart && processed < budget)
+        {
+            size_t end = job.cursor;
+            size_t start = runStart(history, job, end);
+            processed += end - start;
+            job.cursor = start;
+            const TouchData_t &first = history[start];
+
+            if (history_is_tombstone(first))
+            {
+                // 撤销/重做记录不绘制也不参与连线；窗口内的还可能被重做的目标需要，保留
+                if (start < job.undoStart)
+                {
+                    job.keep[start] = false;
+                    job.undonePoints++;
+                }
+                continue;
+            }
+            bool hidden = history_point_hidden(first);
+            // 窗口内的段可能被撤销/重做，保留且不遮挡更早的段。已撤销的段不绘制，删除不影响画面；
+            // 可见的段每个像素 (含与之前的点的连线) 都被后来的段画过时才删除。两种删除都不能改变其他点的连线
+            bool removable = start < job.undoStart && linksUnchanged(history, job, start) &&
+                             (hidden || runCovered(job, history, start, end));
+            if (removable)
+            {
+                for (size_t i = start; i < end; i++)
+                {
+                    if (job.keep[i])
+                    {
+                        job.keep[i] = false;
+                        if (hidden)
+                            job.undonePoints++;
+                        else
+                            job.occludedPoints++;
+                    }
+                }
+                if (!hidden)
+                    job.occludedStrokes++;
+                continue;
+            }
+            if (!hidden && start < job.undoStart)
+                paintRun(job, history, start, end);
+            setNextSurvivor(job, first.color & HISTORY_COLOR_MASK, start);
+        }
+        if (job.cursor > job.visibleStart)
+            return false;
+        job.linePixels.clear();
+        job.pathPixels.clear();
+        job.phase = COMPACT_READY;
+    }
+    return job.phase == COMPACT_READY;
+}
+
+size_t historyCompactRemapIndex(const HistoryCompactJob_t &job, size_t index)
+{
+    size_t prefix = index < job.end ? index : job.end;
+    size_t kept = 0;
+    for (size_t i = 0; i < prefix; i++)
+    {
+        if (job.keep[i])
+            kept++;
+    }
+    return kept + (index - prefix);
+}
+
+size_t historyCompactApply(HistoryCompactJob_t &job, DrawingHistory &history)
+{
+    size_t removed = history.retain(job.keep);
+    historyCompactAbort(job);
+    return removed;
+}
+
+void historyCompactAbort(HistoryCompactJob_t &job)
+{
+    // 保留 keep 和像素缓冲区的容量: 下次压缩时不再分配 (历史没有变长时)，避免在历史分块之间留下空洞
+    job.keep.clear();
+    job.linePixels.clear();
+    job.pathPixels.clear();
+    job.survivors.clear();
+    job.phase = COMPACT_IDLE;
+}
@@ -0,0 +1,72 @@
+#ifndef HISTORY_COMPACT_H
+#define HISTORY_COMPACT_H
+
+#include <stdint.h>
+#include <vector>
+#include "drawing_history.h" // TouchData_t, DrawingHistory
+
+// 绘图历史压缩 (网络任务在空闲时分步执行)
+// 历史在复位前只增不减，其中很多点共线或已被后来的笔划完全盖住。压缩分三步，只处理开始时的历史前缀 [0, end)，
+// 之后新加入的点不受影响:
+//   1. 最后一个复位点及之前的点已被清屏，全部删除；
+//   2. 化简: 在逐点连线的段 (strokeLink 为 1 的连续点) 中只删除去掉后 Bresenham 光栅化结果完全不变的点
+//      (直线与原折线画出相同的像素)，并保证相邻保留点的时间间隔不超过 TOUCH_STROKE_INTERVAL (重播时仍连成一笔)；
+//   3. 遮挡: 从新到旧遍历段，用像素覆盖位图判断化简后的段是否每个像素都被后来的段画过，是则整段删除。
+//      已撤销的段和撤销/重做记录在最近 HISTORY_UNDO_WINDOW 笔划之前时删除 (不会再被重做)；窗口内的段还可能被撤销，
+//      既不遮挡其他段也不被删除。删除段只在其他点按 history_continues_stroke 算出的连线不变时进行。
+// 三步都不改变重播画面 (误差 0 像素)，各节点独立压缩后画布仍一致。
+// 主机上与其他固件模块一起链接 host/mock 中的替身编译 (基准见 tools/history_compact_bench.cpp)。
+
+enum HistoryCompactPhase_e
+{
+    COMPACT_IDLE,     // 没有进行中的压缩
+    COMPACT_SIMPLIFY, // 正向遍历段，化简
+    COMPACT_OCCLUDE,  // 反向遍历段，删除被完全遮挡的段
+    COMPACT_READY,    // 分析完成，等待 historyCompactApply
+};
+typedef enum HistoryCompactPhase_e HistoryCompactPhase_t;
+
+typedef struct HistoryCompactSurvivor_s
+{
+    uint32_t color; // 颜色 (HISTORY_COLOR_MASK)
+    size_t index;   // 该颜色第一个保留的点
+} HistoryCompactSurvivor_t;
+
+#define COMPACT_COVERAGE_BYTES ((SCREEN_WIDTH * SCREEN_HEIGHT + 7) / 8) // 遮挡位图大小 (字节)
+
+typedef struct HistoryCompactJob_s
+{
+    HistoryCompactPhase_t phase;
+    size_t end;                     // 本次处理的历史前缀 [0, end)
+    size_t visibleStart;            // 最后一个复位点之后的起点
+    size_t undoStart;               // 开始时最近 HISTORY_UNDO_WINDOW 笔划的起点 (之后的笔划可能被撤销/重做)
+    size_t cursor;                  // 化简: 下一段的起点；遮挡: 尚未处理的段的结束位置
+    std::vector<HistoryCompactSurvivor_t> survivors; // 遮挡: 已处理部分中每种颜色第一个保留的点 (容量同上)
+    std::vector<bool> keep;         // 前缀中每个点是否保留 (容量在两次压缩之间保留，只随历史增长)
+    std::vector<uint32_t> linePixels; // 化简: 候选直线画到的像素 (容量同上)
+    std::vector<uint32_t> pathPixels; // 化简: 原折线画到的像素 (容量同上)
+    uint8_t coverage[COMPACT_COVERAGE_BYTES]; // 遮挡: 每像素 1 位，后来的笔划画过的像素 (定长，不在堆上反复分配)
+    uint32_t hiddenPoints;          // 删除的复位之前的点数
+    uint32_t simplifiedPoints;      // 化简删除的点数
+    uint32_t occludedPoints;        // 因被完全遮挡删除的点数
+    uint32_t occludedStrokes;       // 被完全遮挡的段数
+    uint32_t undonePoints;          // 删除的已撤销的点数 (含撤销/重做记录)
+} HistoryCompactJob_t;
+
+// 开始分析历史前缀 [0, end)
+void historyCompactBegin(HistoryCompactJob_t &job, const DrawingHistory &history, size_t end);
+
+// 继续分析，大约处理 budget 个点后返回；分析完成 (phase 变为 COMPACT_READY) 时返回 true
+// 调用之间历史只能在 end 之后追加，清空历史前须调用 historyCompactAbort
+bool historyCompactStep(HistoryCompactJob_t &job, const DrawingHistory &history, size_t budget);
+
+// 分析完成后: 原索引在压缩后的位置 (被删除的点映射到它之后第一个保留的点)
+size_t historyCompactRemapIndex(const HistoryCompactJob_t &job, size_t index);
+
+// 分析完成后: 原地删除不保留的点，返回删除的点数
+size_t historyCompactApply(HistoryCompactJob_t &job, DrawingHistory &history);
+
+// 放弃进行中的压缩
+void historyCompactAbort(HistoryCompactJob_t &job);
+
+#endif // HISTORY_COMPACT_H
@@ -0,0 +1,102 @@
+#include "latency_stats.h"
+#include <algorithm> // 用于 std::min
+
+// 各分桶上界 (微秒)，最后一个桶 (溢出桶) 没有上界
+static const uint32_t bucketUpperUs[LATENCY_BUCKET_COUNT - 1] = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000};
+
+static const char *const stageNames[LATENCY_STAGE_COUNT] = {
+    "filter", "history", "render", "send", "remote_render"};
+
+static LatencyHistogram_t histograms[LATENCY_STAGE_COUNT];
+static portMUX_TYPE latencyMux = portMUX_INITIALIZER_UNLOCKED;
+
+void latencyRecord(LatencyStage_t stage, uint32_t latencyUs)
+{
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKET_COUNT - 1 && latencyUs > bucketUpperUs[bucket])
+    {
+        bucket++;
+    }
+
+    portENTER_CRITICAL(&latencyMux);
+    LatencyHistogram_t &h = histograms[stage];
+    h.buckets[bucket]++;
+    h.count++;
+    h.sumUs += latencyUs;
+    if (latencyUs > h.maxUs)
+    {
+        h.maxUs = latencyUs;
+    }
+    portEXIT_CRITICAL(&latencyMux);
+}
+
+void latencyRecordSince(LatencyStage_t stage, uint32_t startMicros)
+{
+    latencyRecord(stage, (uint32_t)micros() - startMicros);
+}
+
+static uint32_t histogramPercentile(const LatencyHistogram_t &h, uint8_t percent)
+{
+    if (h.count == 0)
+    {
+        return 0;
+    }
+
+    uint32_t rank = (uint32_t)(((uint64_t)h.count * percent + 99) / 100); // 向上取整，至少为 1
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    uint32_t cumulative = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKET_COUNT - 1; bucket++)
+    {
+        cumulative += h.buckets[bucket];
+        if (cumulative >= rank)
+        {
+            return std::min(bucketUpperUs[bucket], h.maxUs);
+        }
+    }
+    return h.maxUs;
+}
+
+uint32_t latencyPercentile(LatencyStage_t stage, uint8_t percent)
+{
+    portENTER_CRITICAL(&latencyMux);
+    LatencyHistogram_t h = histograms[stage];
+    portEXIT_CRITICAL(&latencyMux);
+    return histogramPercentile(h, percent);
+}
+
+void latencyReset()
+{
+    portENTER_CRITICAL(&latencyMux);
+    memset(histograms, 0, sizeof(histograms));
+    portEXIT_CRITICAL(&latencyMux);
+}
+
+const char *latencyStageName(LatencyStage_t stage)
+{
+    return stageNames[stage];
+}
+
+void latencyPrint(Print &out)
+{
+    LatencyHistogram_t snapshot[LATENCY_STAGE_COUNT];
+    portENTER_CRITICAL(&latencyMux);
+    memcpy(snapshot, histograms, sizeof(snapshot));
+    portEXIT_CRITICAL(&latencyMux);
+
+    out.println("stage          count     p50(us)   p90(us)   p99(us)   max(us)   mean(us)");
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+    {
+        const LatencyHistogram_t &h = snapshot[stage];
+        out.printf("%-14s %-9lu %-9lu %-9lu %-9lu %-9lu %lu\n",
+                   stageNames[stage], (unsigned long)h.count,
+                   (unsigned long)histogramPercentile(h, 50),
+                   (unsigned long)histogramPercentile(h, 90),
+                   (unsigned long)histogramPercentile(h, 99),
+                   (unsigned long)h.maxUs,
+                   (unsigned long)(h.count ? h.sumUs / h.count : 0));
+    }
+}
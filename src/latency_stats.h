@@ -0,0 +1,51 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <Arduino.h>
+
+// 触摸到屏幕 (touch-to-photon) 延迟统计
+// 每个阶段一个固定分桶直方图 (1-2-5 分桶，50us ~ 1s)，记录从源头时间戳到该阶段完成的耗时。
+// 本地路径以触摸采样任务的采样时间为起点，远端路径以收到消息 (ESP-NOW 接收回调 / MQTT 回调) 为起点。
+// 对端屏幕上的端到端延迟 ≈ 本机 LATENCY_SEND + 对端 LATENCY_REMOTE_RENDER (两台设备时钟未精确同步，不直接相减)。
+// 主循环和网络任务都会记录 (历史/发送阶段在网络任务中完成)，更新和读取都在自旋锁内进行。
+
+#define LATENCY_BUCKET_COUNT 15 // 14 个有上界的分桶 + 1 个溢出桶
+
+enum LatencyStage_e
+{
+    LATENCY_FILTER,        // 采样 -> 滤波完成
+    LATENCY_HISTORY,       // 采样 -> 加入绘图历史
+    LATENCY_RENDER,        // 采样 -> 本机屏幕绘制完成
+    LATENCY_SEND,          // 采样 -> 交给网络发送 (ESP-NOW 每点发送 / MQTT 提笔时整笔发送)
+    LATENCY_REMOTE_RENDER, // 收到对端消息 -> 本机屏幕绘制完成
+    LATENCY_STAGE_COUNT
+};
+typedef enum LatencyStage_e LatencyStage_t;
+
+typedef struct LatencyHistogram_s
+{
+    uint32_t buckets[LATENCY_BUCKET_COUNT];
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t sumUs;
+} LatencyHistogram_t;
+
+// 记录一次延迟 (微秒)
+void latencyRecord(LatencyStage_t stage, uint32_t latencyUs);
+
+// 记录从 startMicros (micros() 的取值) 到现在的延迟
+void latencyRecordSince(LatencyStage_t stage, uint32_t startMicros);
+
+// 估算百分位延迟 (微秒，返回所在分桶的上界；落在溢出桶时返回最大值)。没有样本时返回 0
+uint32_t latencyPercentile(LatencyStage_t stage, uint8_t percent);
+
+// 清空所有直方图
+void latencyReset();
+
+// 打印各阶段的样本数、p50/p90/p99、最大值和平均值
+void latencyPrint(Print &out);
+
+// 阶段名称 (用于串口输出)
+const char *latencyStageName(LatencyStage_t stage);
+
+#endif // LATENCY_STATS_H
@@ -0,0 +1,48 @@
+#include "memory_tier.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+static bool psramAvailable = false;
+
+void memoryTierInit()
+{
+    psramAvailable = psramFound();
+    if (psramAvailable)
+        Serial.printf("PSRAM: %u KB, cold history chunks and canvas framebuffer go there\n", (unsigned)(ESP.getPsramSize() / 1024));
+    else
+        Serial.println("PSRAM: not found, everything stays in internal SRAM");
+}
+
+bool memoryTierHasPsram()
+{
+    return psramAvailable;
+}
+
+static void *allocFrom(size_t bytes, MemoryTier_t tier)
+{
+    if (tier == MEMORY_TIER_PSRAM)
+        return psramAvailable ? heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : nullptr;
+    return heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+void *memoryTierAlloc(size_t bytes, MemoryTier_t tier, bool fallback)
+{
+    void *ptr = allocFrom(bytes, tier);
+    if (ptr == nullptr && fallback)
+        ptr = allocFrom(bytes, tier == MEMORY_TIER_PSRAM ? MEMORY_TIER_INTERNAL : MEMORY_TIER_PSRAM);
+    return ptr;
+}
+
+void memoryTierFree(void *ptr)
+{
+    heap_caps_free(ptr);
+}
+
+void memoryTierGetStats(MemoryTierStats_t &out)
+{
+    out.internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    out.internalMaxBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    out.psramSize = psramAvailable ? ESP.getPsramSize() : 0;
+    out.psramFree = psramAvailable ? heap_caps_get_free_size(MALLOC_CAP_SPIRAM) : 0;
+    out.psramMaxBlock = psramAvailable ? heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) : 0;
+}
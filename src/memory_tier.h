@@ -0,0 +1,74 @@
+#ifndef MEMORY_TIER_H
+#define MEMORY_TIER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
+
+// 内存分层 (内部 SRAM / PSRAM)
+// 带 PSRAM 的板子 (ESP32-WROVER 等，4-8MB) 启动时检测到后，冷数据 (写满的绘图历史分块、笔划索引、触摸轨迹缓冲、
+// 画布帧缓冲) 放到 PSRAM；热数据 (正在写入的历史分块、各队列、对端表) 明确从内部 SRAM 分配。
+// 注意 Arduino 打开 PSRAM 后普通 malloc 的大块分配也可能落到 PSRAM，所以热数据必须用 MEMORY_TIER_INTERNAL 分配。
+// 没有 PSRAM 时所有分配都在内部 SRAM，行为与之前相同。
+// 头文件不依赖 Arduino，可在主机上编译 (主机用 --psram 模拟 PSRAM)。
+
+enum MemoryTier_e
+{
+    MEMORY_TIER_INTERNAL, // 内部 SRAM (快，容量小)
+    MEMORY_TIER_PSRAM,    // 外部 PSRAM (经过缓存，容量大)
+};
+typedef enum MemoryTier_e MemoryTier_t;
+
+// 启动时检测 PSRAM (setup 中最先调用，之后才分配冷数据)
+void memoryTierInit();
+bool memoryTierHasPsram();
+
+// 从指定层分配；fallback 为 true 时该层不可用或不足则退回另一层。失败返回 nullptr
+void *memoryTierAlloc(size_t bytes, MemoryTier_t tier, bool fallback = true);
+void memoryTierFree(void *ptr);
+
+// 两层的总量、空闲和最大可分配块 (字节)，没有 PSRAM 时 PSRAM 各项为 0
+typedef struct MemoryTierStats_s
+{
+    uint32_t internalFree;
+    uint32_t internalMaxBlock;
+    uint32_t psramSize;
+    uint32_t psramFree;
+    uint32_t psramMaxBlock;
+} MemoryTierStats_t;
+
+void memoryTierGetStats(MemoryTierStats_t &out);
+
+// 放在 PSRAM (没有时退回内部 SRAM) 的 STL 分配器，用于只随历史增长、访问不频繁的容器
+template <typename T>
+struct PsramAllocator
+{
+    typedef T value_type;
+
+    PsramAllocator() = default;
+    template <typename U>
+    PsramAllocator(const PsramAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        void *ptr = memoryTierAlloc(n * sizeof(T), MEMORY_TIER_PSRAM);
+        if (ptr == nullptr)
+        {
+#if __cpp_exceptions
+            throw std::bad_alloc();
+#else
+            abort();
+#endif
+        }
+        return static_cast<T *>(ptr);
+    }
+    void deallocate(T *ptr, size_t) { memoryTierFree(ptr); }
+
+    template <typename U>
+    bool operator==(const PsramAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const PsramAllocator<U> &) const { return false; }
+};
+
+#endif // MEMORY_TIER_H
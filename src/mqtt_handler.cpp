@@ -15,12 +15,12 @@
 #include "touch_handler.h"
 #include <Arduino.h>
 #include <TFT_eSPI.h>
+#include "latency_stats.h"
+#include "esp_now_handler.h" // networkSubmit (历史由网络任务写入)
+#include "perf_counters.h"   // mqttPublishStats
 
 // External variables
 extern TFT_eSPI tft;
-extern TS_Point lastRemotePoint;
-extern unsigned long lastRemoteDrawTime;
-extern DrawingHistory allDrawingHistory;
 
 // MQTT client
 WiFiClient espClient;
@@ -28,8 +28,9 @@ PubSubClient client(espClient);
 
 // Forward declarations
 void mqttCallback(char* topic, byte* payload, unsigned int length);
-void processStroke(const JsonObject& stroke);
+void processStroke(const JsonObject& stroke, uint32_t receivedMicros);
 void processReset();
+void processTombstone(const JsonObject& control);
 void mqttReconnect();
 
 void mqttInit(const char* server, int port) {
@@ -96,45 +97,121 @@ void sendResetMessage() {
     }
 }
 
+// 撤销/重做: {"op":"undo"|"redo","s":[x, y, 最后一点 x, 最后一点 y, 颜色]} (记录格式见 drawing_history.h)
+void sendTombstoneMessage(const TouchData_t& record) {
+    if (!client.connected()) {
+        return;
+    }
+    StaticJsonDocument<128> doc;
+    doc["op"] = (record.color & HISTORY_FLAG_REDO) ? "redo" : "undo";
+    JsonArray target = doc.createNestedArray("s");
+    target.add(record.x);
+    target.add(record.y);
+    target.add((int16_t)(record.timestamp & 0xFFFF));
+    target.add((int16_t)(record.timestamp >> 16));
+    target.add(record.color & HISTORY_COLOR_MASK);
+
+    char buffer[128];
+    size_t n = serializeJson(doc, buffer);
+    client.publish("firenote/control", buffer, n);
+}
+
+void mqttPublishStats() {
+    if (!client.connected()) {
+        return;
+    }
+    uint8_t mac[6];
+    esp_wifi_get_mac(WIFI_IF_STA, mac);
+    char id[13];
+    snprintf(id, sizeof(id), "%02X%02X%02X%02X%02X%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    char topic[sizeof(PERF_MQTT_TOPIC_PREFIX) + sizeof(id)];
+    snprintf(topic, sizeof(topic), "%s%s", PERF_MQTT_TOPIC_PREFIX, id);
+
+    PerfSnapshot_t snapshot;
+    char payload[PERF_LINE_MAX];
+    perfGetSnapshot(snapshot);
+    size_t n = perfFormatJson(snapshot, id, payload, sizeof(payload));
+    if (!client.publish(topic, (const uint8_t*)payload, n)) {
+        Serial.println("MQTT stats publish failed.");
+    }
+}
+
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
+    uint32_t receivedMicros = micros(); // 远端绘制延迟统计的起点
     if (strcmp(topic, "firenote/strokes") == 0) {
         StaticJsonDocument<MQTT_MAX_PACKET_SIZE> doc;
         deserializeJson(doc, payload, length);
-        processStroke(doc.as<JsonObject>());
+        processStroke(doc.as<JsonObject>(), receivedMicros);
     } else if (strcmp(topic, "firenote/control") == 0) {
         if (length == 5 && strncmp((char*)payload, "reset", 5) == 0) {
             processReset();
+        } else if (length > 0 && payload[0] == '{') {
+            StaticJsonDocument<256> doc;
+            if (!deserializeJson(doc, payload, length)) {
+                processTombstone(doc.as<JsonObject>());
+            }
         }
     }
 }
 
-void processStroke(const JsonObject& stroke) {
+void processStroke(const JsonObject& stroke, uint32_t receivedMicros) {
     uint16_t color = stroke["c"];
     JsonArray points = stroke["p"];
 
-    for (size_t i = 0; i < points.size(); i += 2) {
+    for (size_t i = 0; i + 1 < points.size(); i += 2) { // 奇数长度时忽略最后一个坐标
         TouchData_t data;
         data.x = points[i];
         data.y = points[i+1];
         data.color = color;
         data.timestamp = millis(); // Use arrival time for remote points
         data.isReset = false;
-
-        allDrawingHistory.push_back(data);
-
-        if (i == 0 || (data.timestamp - lastRemoteDrawTime > TOUCH_STROKE_INTERVAL)) {
-            tft.drawPixel(data.x, data.y, data.color);
-        } else {
-            tft.drawLine(lastRemotePoint.x, lastRemotePoint.y, data.x, data.y, data.color);
+        data.strokeLink = 0;
+        if (!remotePointInRange(data)) { // 越界的点 (或非整数坐标) 丢弃
+            continue;
         }
 
-        lastRemotePoint.x = data.x;
-        lastRemotePoint.y = data.y;
-        lastRemotePoint.z = 1;
-        lastRemoteDrawTime = data.timestamp;
+        NetworkOp_t op;
+        op.type = NET_OP_REMOTE_POINT;
+        op.point = data;
+        op.sampleMicros = receivedMicros;
+        op.broadcast = false;
+        networkSubmit(op); // 网络任务加入历史后交给主循环绘制 (与 ESP-NOW 的点按同一规则连线)
     }
 }
 
 void processReset() {
     clearScreenAndCache();
+
+    NetworkOp_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = NET_OP_CLEAR_HISTORY;
+    networkSubmit(op);
+}
+
+void processTombstone(const JsonObject& control) {
+    const char* opName = control["op"];
+    JsonArray target = control["s"];
+    if (opName == nullptr || target.size() != 5 || (strcmp(opName, "undo") != 0 && strcmp(opName, "redo") != 0)) {
+        return;
+    }
+    TouchData_t record;
+    memset(&record, 0, sizeof(record));
+    record.x = target[0];
+    record.y = target[1];
+    int lastX = target[2];
+    int lastY = target[3];
+    TouchData_t last = {lastX, lastY, 0, false, 0, 0};
+    if (!remotePointInRange(record) || !remotePointInRange(last)) {
+        return; // 坐标越界的笔划不会在历史中
+    }
+    record.timestamp = (uint32_t)(uint16_t)lastX | ((uint32_t)(uint16_t)lastY << 16);
+    record.isReset = false;
+    record.color = ((uint32_t)target[4] & HISTORY_COLOR_MASK) | HISTORY_FLAG_TOMBSTONE | HISTORY_FLAG_HIDDEN |
+                   (strcmp(opName, "redo") == 0 ? HISTORY_FLAG_REDO : 0);
+
+    NetworkOp_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = NET_OP_REMOTE_TOMBSTONE;
+    op.point = record;
+    networkSubmit(op); // 网络任务应用后交回主循环重绘目标笔划的区域
 }
@@ -13,5 +13,7 @@ void mqttLoop();
 bool isMqttConnected();
 void sendStroke(const std::vector<TouchData_t>& stroke);
 void sendResetMessage();
+void sendTombstoneMessage(const TouchData_t& record); // 发布撤销/重做记录到 firenote/control
+void mqttPublishStats(); // 发布性能计数器快照 (JSON) 到 PERF_MQTT_TOPIC_PREFIX<MAC>
 
 #endif // MQTT_HANDLER_H
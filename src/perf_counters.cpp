@@ -0,0 +1,213 @@
+#include "perf_counters.h"
+#include "config.h"
+#include "touch_handler.h"   // touchTaskGetStats
+#include "esp_now_handler.h" // networkTaskGetStats
+#include "render_queue.h"    // renderQueueGetStats
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+
+static std::atomic<uint32_t> counters[PERF_COUNTER_COUNT];
+static std::atomic<uint32_t> frameCounts[PERF_FRAME_DIR_COUNT][PERF_MSG_TYPE_SLOTS];
+
+// 窗口累计量和上一个窗口的结果 (只由主循环访问)
+static bool drawnThisPass = false;
+static uint32_t windowFrameSumUs = 0;
+static uint32_t windowFrameMaxUs = 0;
+static uint32_t windowFrames = 0;
+static unsigned long windowStartMs = 0;
+static uint32_t windowStartCounts[PERF_COUNTER_COUNT];
+static uint32_t lastRates[PERF_COUNTER_COUNT];
+static uint32_t lastFrameAvgUs = 0;
+static uint32_t lastFrameMaxUs = 0;
+
+// 快照中标量字段的登记表: 串口行和 JSON 都按此顺序输出，新增字段只需在这里登记
+typedef struct PerfField_s
+{
+    const char *key;
+    size_t offset; // 在 PerfSnapshot_t 中的偏移 (uint32_t 字段)
+} PerfField_t;
+
+static const PerfField_t perfFields[] = {
+    {"up", offsetof(PerfSnapshot_t, uptimeS)},
+    {"loop", offsetof(PerfSnapshot_t, rates[PERF_LOOP_ITERATIONS])},
+    {"touch", offsetof(PerfSnapshot_t, rates[PERF_TOUCH_POINTS])},
+    {"remote", offsetof(PerfSnapshot_t, rates[PERF_REMOTE_POINTS])},
+    {"fps", offsetof(PerfSnapshot_t, rates[PERF_FRAMES])},
+    {"frame_us", offsetof(PerfSnapshot_t, frameAvgUs)},
+    {"frame_max_us", offsetof(PerfSnapshot_t, frameMaxUs)},
+    {"heap", offsetof(PerfSnapshot_t, heapFree)},
+    {"heap_min", offsetof(PerfSnapshot_t, heapMinFree)},
+    {"heap_block", offsetof(PerfSnapshot_t, heapMaxBlock)},
+    {"psram", offsetof(PerfSnapshot_t, psramFree)},
+    {"q_touch", offsetof(PerfSnapshot_t, touchQueueMax)},
+    {"q_rx", offsetof(PerfSnapshot_t, rxQueueMax)},
+    {"q_op", offsetof(PerfSnapshot_t, opQueueMax)},
+    {"q_tile", offsetof(PerfSnapshot_t, tileQueueMax)},
+    {"q_render", offsetof(PerfSnapshot_t, renderQueueMax)},
+    {"touch_drop", offsetof(PerfSnapshot_t, touchDropped)},
+    {"op_drop", offsetof(PerfSnapshot_t, opsDropped)},
+    {"render_wait", offsetof(PerfSnapshot_t, renderWaits)},
+};
+
+static const char *const frameDirKeys[PERF_FRAME_DIR_COUNT] = {"tx", "rx", "drop"};
+
+void perfCount(PerfCounter_t counter, uint32_t n)
+{
+    counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void perfCountFrame(PerfFrameDir_t dir, int messageType)
+{
+    int slot = messageType >= 0 && messageType < PERF_MSG_TYPE_OTHER ? messageType : PERF_MSG_TYPE_OTHER;
+    frameCounts[dir][slot].fetch_add(1, std::memory_order_relaxed);
+}
+
+void perfNoteDrawn()
+{
+    drawnThisPass = true;
+}
+
+void perfLoopPassEnd(uint32_t passUs)
+{
+    perfCount(PERF_LOOP_ITERATIONS);
+    if (!drawnThisPass)
+        return;
+    drawnThisPass = false;
+    perfCount(PERF_FRAMES);
+    windowFrames++;
+    windowFrameSumUs += passUs;
+    if (passUs > windowFrameMaxUs)
+        windowFrameMaxUs = passUs;
+}
+
+void perfWindowTick()
+{
+    unsigned long now = millis();
+    unsigned long elapsedMs = now - windowStartMs;
+    if (elapsedMs == 0)
+        return;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        uint32_t count = counters[i].load(std::memory_order_relaxed);
+        lastRates[i] = (uint32_t)((uint64_t)(count - windowStartCounts[i]) * 1000 / elapsedMs);
+        windowStartCounts[i] = count;
+    }
+    lastFrameAvgUs = windowFrames > 0 ? windowFrameSumUs / windowFrames : 0;
+    lastFrameMaxUs = windowFrameMaxUs;
+    windowFrames = 0;
+    windowFrameSumUs = 0;
+    windowFrameMaxUs = 0;
+    windowStartMs = now;
+}
+
+void perfGetSnapshot(PerfSnapshot_t &out)
+{
+    out.uptimeS = millis() / 1000;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+        out.rates[i] = lastRates[i];
+    out.frameAvgUs = lastFrameAvgUs;
+    out.frameMaxUs = lastFrameMaxUs;
+
+    out.heapFree = ESP.getFreeHeap();
+    out.heapMinFree = ESP.getMinFreeHeap();
+    out.heapMaxBlock = ESP.getMaxAllocHeap();
+    out.psramFree = ESP.getFreePsram();
+
+    TouchTaskStats_t touchStats;
+    NetworkTaskStats_t networkStats;
+    RenderQueueStats_t renderStats;
+    touchTaskGetStats(touchStats);
+    networkTaskGetStats(networkStats);
+    renderQueueGetStats(renderStats);
+    out.touchQueueMax = touchStats.queueMaxDepth;
+    out.rxQueueMax = networkStats.rxQueueMaxDepth;
+    out.opQueueMax = networkStats.opQueueMaxDepth;
+    out.tileQueueMax = networkStats.tileQueueMaxDepth;
+    out.renderQueueMax = renderStats.maxDepth;
+    out.touchDropped = touchStats.droppedSamples;
+    out.opsDropped = networkStats.opsDropped;
+    out.renderWaits = renderStats.producerWaits;
+
+    for (int dir = 0; dir < PERF_FRAME_DIR_COUNT; dir++)
+    {
+        for (int slot = 0; slot < PERF_MSG_TYPE_SLOTS; slot++)
+            out.frames[dir][slot] = frameCounts[dir][slot].load(std::memory_order_relaxed);
+    }
+}
+
+// 追加格式化文本，缓冲区不足时截断 (length 不超过 size - 1)
+static void append(char *buffer, size_t size, size_t &length, const char *format, ...)
+{
+    if (length + 1 >= size)
+        return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+    if (n > 0)
+        length = length + n < size ? length + n : size - 1;
+}
+
+static uint32_t fieldValue(const PerfSnapshot_t &snapshot, const PerfField_t &field)
+{
+    return *(const uint32_t *)((const uint8_t *)&snapshot + field.offset);
+}
+
+size_t perfFormatLine(const PerfSnapshot_t &snapshot, char *buffer, size_t size)
+{
+    size_t length = 0;
+    buffer[0] = '\0';
+    append(buffer, size, length, "PERF");
+    for (const PerfField_t &field : perfFields)
+        append(buffer, size, length, " %s=%lu", field.key, (unsigned long)fieldValue(snapshot, field));
+    // 按消息类型的帧数只列出非零项: tx=类型:数量,类型:数量
+    for (int dir = 0; dir < PERF_FRAME_DIR_COUNT; dir++)
+    {
+        append(buffer, size, length, " %s=", frameDirKeys[dir]);
+        bool first = true;
+        for (int slot = 0; slot < PERF_MSG_TYPE_SLOTS; slot++)
+        {
+            if (snapshot.frames[dir][slot] == 0)
+                continue;
+            append(buffer, size, length, "%s%d:%lu", first ? "" : ",", slot, (unsigned long)snapshot.frames[dir][slot]);
+            first = false;
+        }
+    }
+    return length;
+}
+
+size_t perfFormatJson(const PerfSnapshot_t &snapshot, const char *id, char *buffer, size_t size)
+{
+    size_t length = 0;
+    buffer[0] = '\0';
+    append(buffer, size, length, "{");
+    if (id != nullptr && id[0] != '\0')
+        append(buffer, size, length, "\"id\":\"%s\",", id);
+    for (const PerfField_t &field : perfFields)
+        append(buffer, size, length, "\"%s\":%lu,", field.key, (unsigned long)fieldValue(snapshot, field));
+    for (int dir = 0; dir < PERF_FRAME_DIR_COUNT; dir++)
+    {
+        append(buffer, size, length, "\"%s\":{", frameDirKeys[dir]);
+        bool first = true;
+        for (int slot = 0; slot < PERF_MSG_TYPE_SLOTS; slot++)
+        {
+            if (snapshot.frames[dir][slot] == 0)
+                continue;
+            append(buffer, size, length, "%s\"%d\":%lu", first ? "" : ",", slot, (unsigned long)snapshot.frames[dir][slot]);
+            first = false;
+        }
+        append(buffer, size, length, dir + 1 < PERF_FRAME_DIR_COUNT ? "}," : "}");
+    }
+    append(buffer, size, length, "}");
+    return length;
+}
+
+void perfPrint(Print &out)
+{
+    PerfSnapshot_t snapshot;
+    char line[PERF_LINE_MAX];
+    perfGetSnapshot(snapshot);
+    perfFormatLine(snapshot, line, sizeof(line));
+    out.println(line);
+}
@@ -0,0 +1,81 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <Arduino.h>
+
+// 运行时性能计数器
+// 热路径上只做一次原子加法 (perfCount / perfCountFrame)；队列高水位由各模块在自己的 *GetStats 中给出。
+// 主循环每 PERF_WINDOW_MS 把计数的差值换算为每秒速率，并记录窗口内的帧耗时 ("帧" 指画过屏幕的一轮主循环)。
+// perfGetSnapshot 汇总这些速率、各模块的队列/丢弃统计和堆信息；快照的每个字段在 perf_counters.cpp 的
+// 登记表中有一个短键名，串口命令 "perf" 打印为一行 "PERF 键=值 ..."，WiFi 连接时以 JSON 发布到
+// PERF_MQTT_TOPIC_PREFIX<MAC> (见 mqttPublishStats)。
+
+#define PERF_MSG_TYPE_SLOTS 16                          // 按消息类型分别计数的槽数
+#define PERF_MSG_TYPE_OTHER (PERF_MSG_TYPE_SLOTS - 1)   // 类型未知的帧 (长度不对、类型越界、旧版 MAC 广播)
+#define PERF_LINE_MAX 768                               // 串口行 / MQTT 负载的最大长度 (含结尾 '\0')
+
+// 按窗口换算为每秒速率的事件
+enum PerfCounter_e
+{
+    PERF_LOOP_ITERATIONS, // 主循环轮数
+    PERF_TOUCH_POINTS,    // 本机画出的触摸点
+    PERF_REMOTE_POINTS,   // 画出的远端点 (ESP-NOW 和 MQTT)
+    PERF_FRAMES,          // 画过屏幕的主循环轮数
+    PERF_COUNTER_COUNT
+};
+typedef enum PerfCounter_e PerfCounter_t;
+
+// ESP-NOW 帧的计数方向
+enum PerfFrameDir_e
+{
+    PERF_FRAME_TX,      // 交给 esp_now_send 成功
+    PERF_FRAME_RX,      // 收到并放入网络任务队列
+    PERF_FRAME_DROPPED, // 发送出错，或接收时因队列满/格式错误丢弃
+    PERF_FRAME_DIR_COUNT
+};
+typedef enum PerfFrameDir_e PerfFrameDir_t;
+
+typedef struct PerfSnapshot_s
+{
+    uint32_t uptimeS;                       // 运行时间 (秒)
+    uint32_t rates[PERF_COUNTER_COUNT];     // 最近一个窗口的每秒次数
+    uint32_t frameAvgUs;                    // 最近一个窗口的平均帧耗时 (微秒)
+    uint32_t frameMaxUs;                    // 最近一个窗口的最长帧耗时 (微秒)
+    uint32_t heapFree;                      // 当前空闲堆 (字节)
+    uint32_t heapMinFree;                   // 启动以来空闲堆的最低值 (字节)
+    uint32_t heapMaxBlock;                  // 当前最大可分配块 (字节)
+    uint32_t psramFree;                     // 空闲 PSRAM (字节，没有 PSRAM 时为 0)
+    uint32_t touchQueueMax;                 // 各队列启动以来的最大深度
+    uint32_t rxQueueMax;
+    uint32_t opQueueMax;
+    uint32_t tileQueueMax;
+    uint32_t renderQueueMax;
+    uint32_t touchDropped;                  // 启动以来各队列满而丢弃的样本/操作数
+    uint32_t opsDropped;
+    uint32_t renderWaits;                   // 渲染队列满时网络任务等待的次数
+    uint32_t frames[PERF_FRAME_DIR_COUNT][PERF_MSG_TYPE_SLOTS]; // 启动以来按消息类型的 ESP-NOW 帧数
+} PerfSnapshot_t;
+
+// 计数 (任意任务，包括 WiFi 接收回调)
+void perfCount(PerfCounter_t counter, uint32_t n = 1);
+void perfCountFrame(PerfFrameDir_t dir, int messageType);
+
+// 主循环: 本轮绘制了屏幕 (下一次 perfLoopPassEnd 把这一轮计为一帧)
+void perfNoteDrawn();
+
+// 主循环: 每轮结束时调用，passUs 为本轮执行任务和重绘的耗时 (不含阻塞等待)
+void perfLoopPassEnd(uint32_t passUs);
+
+// 主循环周期任务 (PERF_WINDOW_MS): 结束当前窗口，换算速率
+void perfWindowTick();
+
+void perfGetSnapshot(PerfSnapshot_t &out);
+
+// 把快照格式化为一行 "PERF 键=值 ..." 或 JSON 对象 (id 非空时加入 "id" 字段)，返回写入的长度
+size_t perfFormatLine(const PerfSnapshot_t &snapshot, char *buffer, size_t size);
+size_t perfFormatJson(const PerfSnapshot_t &snapshot, const char *id, char *buffer, size_t size);
+
+// 打印当前快照 (串口命令 "perf")
+void perfPrint(Print &out);
+
+#endif // PERF_COUNTERS_H
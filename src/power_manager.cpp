@@ -1,7 +1,11 @@
 #include "power_manager.h"
 #include "config.h"
 #include <Arduino.h> // 用于 pinMode, digitalWrite, analogWrite, millis, Serial 等
-// ui_manager.h 和 esp_now_handler.h 通过 power_manager.h 包含以获取 extern 声明
+#include <esp_sleep.h>     // 浅睡眠及唤醒源
+#include <esp_timer.h>     // 统计睡眠时长
+#include <driver/gpio.h>   // gpio_wakeup_enable / gpio_set_intr_type
+#include "wifi_manager.h"  // WiFi 联网时不进入浅睡眠
+// ui_manager.h 和 esp_now_handler.h 通过 power_manager.h 包含以获取 extern 声明 (含深度睡眠前后的 sleepSyncPrepare/Restore)
 
 // --- 在此定义的全局状态变量 ---
 bool isScreenOn = true;
@@ -16,6 +20,19 @@ static unsigned long lastBreathTime = 0;
 // BOOT 按钮处理
 static unsigned long pressStartTime = 0;
 
+// 自动息屏与浅睡眠 (活动时间戳可能由网络任务写入，32 位写入是原子的)
+static volatile unsigned long lastUserActivityMs = 0;
+static volatile unsigned long lastRadioActivityMs = 0;
+static volatile bool dozing = false;       // 浅睡眠待机中 (只由主循环写入)
+static unsigned long listenUntilMs = 0;    // 当前监听窗口的结束时间
+
+// 浅睡眠统计
+static uint32_t sleepCount = 0;
+static uint32_t wakeByTouchCount = 0;
+static uint32_t wakeByButtonCount = 0;
+static uint64_t sleptUs = 0;
+static unsigned long sleepStatsStartMs = 0;
+
 // --- 函数实现 ---
 
 void powerManagerInit() {
@@ -42,6 +59,9 @@ void powerManagerInit() {
     // 初始时点亮屏幕
     digitalWrite(TFT_BL, HIGH);
     isScreenOn = true;
+
+    lastUserActivityMs = millis();
+    sleepStatsStartMs = millis();
 }
 
 void updateBreathLED() {
@@ -77,6 +97,7 @@ void toggleScreen() {
         isScreenOn = false;
     } else {
         Serial.println("打开屏幕");
+        powerManagerNoteUserActivity(); // 重新开始自动息屏计时
         digitalWrite(TFT_BL, HIGH);
         isScreenOn = true;
         analogWrite(GREEN_LED, 255); // 如果呼吸灯亮着则将其关闭
@@ -87,17 +108,33 @@ void toggleScreen() {
     }
 }
 
+// 深度睡眠: 内存丢失，先保存画布快照和同步元数据，醒来后从闪存恢复画布并只向对端请求增量
+static void enterDeepSleep() {
+    sleepSyncPrepare(); // 来自 esp_now_handler.cpp (通知对端、写快照、保存 RTC 数据)
+
+    digitalWrite(TFT_BL, LOW);
+    while (digitalRead(BUTTON_IO0) == LOW) { // 等待松开，否则会被按钮立即唤醒
+        delay(10);
+    }
+
+    // 清除浅睡眠用的定时器/GPIO 唤醒源，改为 BOOT 按钮 (RTC_GPIO11) 或触摸屏 IRQ (RTC_GPIO0) 唤醒
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)BUTTON_IO0, 0);
+    esp_sleep_enable_ext1_wakeup(1ULL << XPT2046_IRQ, ESP_EXT1_WAKEUP_ALL_LOW);
+    Serial.flush();
+    esp_deep_sleep_start();
+}
+
 void handleBootButton() {
     if (digitalRead(BUTTON_IO0) == LOW) { // 按钮按下
         if (pressStartTime == 0) { // 首次检测到按下
             pressStartTime = millis();
+            powerManagerNoteUserActivity();
         }
 
         if (millis() - pressStartTime >= 2000) { // 长按 (2秒)
             Serial.println("检测到长按IO0按钮，进入深度睡眠模式...");
-            // 如有必要，执行任何睡眠前清理工作
-            // 例如：tft.fillScreen(TFT_BLACK); digitalWrite(TFT_BL, LOW);
-            esp_deep_sleep_start();
+            enterDeepSleep();
             // 代码执行在此处停止以进入深度睡眠
         }
     } else { // 按钮未按下 (已释放或从未按下)
@@ -118,7 +155,7 @@ void manageScreenStateLEDs() {
         }
 
         // 蓝色LED用于ESP-NOW连接指示
-        if (macSet.size() > 0) { // macSet 是来自 esp_now_handler 的 extern 变量
+        if (peerCount() > 0) { // 来自 esp_now_handler.cpp
             analogWrite(BLUE_LED, 255 - BLUE_LED_DIM_DUTY_CYCLE); // 调暗蓝色LED
         } else {
             analogWrite(BLUE_LED, 255); // 蓝色LED熄灭
@@ -133,3 +170,114 @@ void manageScreenStateLEDs() {
         analogWrite(RED_LED, 255);   // 熄灭
     }
 }
+
+void powerManagerNoteUserActivity() {
+    lastUserActivityMs = millis();
+}
+
+void powerManagerNoteRadioActivity() {
+    lastRadioActivityMs = millis();
+}
+
+void powerManagerCheckIdle() {
+    if (SCREEN_IDLE_OFF_MS > 0 && isScreenOn && millis() - lastUserActivityMs >= SCREEN_IDLE_OFF_MS) {
+        Serial.println("长时间无操作，自动息屏");
+        toggleScreen();
+    }
+}
+
+bool powerManagerIsDozing() {
+    return dozing;
+}
+
+// 是否可以浅睡眠: 息屏、未联网、无本地操作和对端活动、没有正在进行的同步、按钮和触摸屏都未按下
+static bool canLightSleep(unsigned long now) {
+    if (isScreenOn || isWifiConnected()) {
+        return false;
+    }
+    if (now - lastUserActivityMs < LIGHT_SLEEP_IDLE_MS || now - lastRadioActivityMs < LIGHT_SLEEP_ACTIVITY_HOLD_MS) {
+        return false;
+    }
+    if (iamRequestingAllData || isReceivingDrawingData || isSendingDrawingData) { // 来自 esp_now_handler
+        return false;
+    }
+    return digitalRead(BUTTON_IO0) == HIGH && digitalRead(XPT2046_IRQ) == HIGH;
+}
+
+static void setDozing(bool value) {
+    if (dozing == value) {
+        return;
+    }
+    dozing = value;
+    Serial.println(value ? "进入浅睡眠待机" : "退出浅睡眠待机");
+    if (value) {
+        dozeSyncBegin(); // 对端记下历史位置 (来自 esp_now_handler)
+    } else {
+        dozeSyncEnd();   // 请求待机期间错过的点
+    }
+}
+
+bool powerManagerLightSleep() {
+#if LIGHT_SLEEP_ENABLED
+    unsigned long now = millis();
+    if (!canLightSleep(now)) {
+        setDozing(false);
+        return false;
+    }
+    if (!dozing) {
+        setDozing(true);
+        listenUntilMs = now + LIGHT_SLEEP_LISTEN_WINDOW_MS; // 先醒一个窗口，让网络任务在睡前发出 SLEEP_NOTICE
+    }
+    if ((long)(listenUntilMs - now) > 0) {
+        return false; // 监听窗口内，继续处理 ESP-NOW 消息和到期任务
+    }
+
+    // 睡眠期间 LEDC 停止输出，先熄灭指示灯 (监听窗口内由 manageScreenStateLEDs 重新点亮，表现为短闪)
+    analogWrite(GREEN_LED, 255);
+    analogWrite(BLUE_LED, 255);
+    analogWrite(RED_LED, 255);
+
+    // 触摸屏 IRQ 和 BOOT 按钮按下时为低电平
+    gpio_wakeup_enable((gpio_num_t)XPT2046_IRQ, GPIO_INTR_LOW_LEVEL);
+    gpio_wakeup_enable((gpio_num_t)BUTTON_IO0, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup(LIGHT_SLEEP_INTERVAL_MS * 1000ULL);
+    Serial.flush(); // 睡眠期间 UART 停止，先发完缓冲区
+
+    int64_t sleepStartUs = esp_timer_get_time();
+    esp_light_sleep_start();
+    sleptUs += esp_timer_get_time() - sleepStartUs;
+    sleepCount++;
+
+    gpio_wakeup_disable((gpio_num_t)XPT2046_IRQ);
+    gpio_wakeup_disable((gpio_num_t)BUTTON_IO0);
+    gpio_set_intr_type((gpio_num_t)XPT2046_IRQ, GPIO_INTR_NEGEDGE); // 恢复触摸库的下降沿中断
+    gpio_set_intr_type((gpio_num_t)BUTTON_IO0, GPIO_INTR_DISABLE);
+
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO) {
+        powerManagerNoteUserActivity();
+        setDozing(false);
+        if (digitalRead(XPT2046_IRQ) == LOW) {
+            // 触摸唤醒: 点亮屏幕。唤醒用掉了 IRQ 下降沿，这次按压不会被采样任务读到，也就不会画点
+            wakeByTouchCount++;
+            toggleScreen();
+        } else {
+            wakeByButtonCount++; // 短按/长按仍由 handleBootButton 处理
+        }
+    } else {
+        listenUntilMs = millis() + LIGHT_SLEEP_LISTEN_WINDOW_MS;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void powerManagerPrintStats(Print &out) {
+    unsigned long elapsedMs = millis() - sleepStatsStartMs;
+    out.printf("screen %s, %s\n", isScreenOn ? "on" : "off", dozing ? "dozing" : "awake");
+    out.printf("light sleeps %lu, asleep %llu ms of %lu ms (%lu%%)\n", (unsigned long)sleepCount,
+               (unsigned long long)(sleptUs / 1000), elapsedMs,
+               elapsedMs > 0 ? (unsigned long)(sleptUs / 10 / elapsedMs) : 0UL);
+    out.printf("woken by touch %lu, by button %lu\n", (unsigned long)wakeByTouchCount, (unsigned long)wakeByButtonCount);
+}
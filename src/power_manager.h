@@ -6,8 +6,8 @@
 
 // --- 电源管理器所需的其他模块的 Extern 全局变量 ---
 // extern TFT_eSPI tft; // 如果电源管理器直接控制 TFT_BL 则需要，但 digitalWrite 是通用的
-// 用于 LED 指示中的 macSet.size():
-#include "esp_now_handler.h" // 提供 extern std::set<String> macSet;
+// 用于 LED 指示中的 peerCount():
+#include "esp_now_handler.h" // 提供 peerCount()
 // 用于 handleBootButton 中的 drawDebugInfo() 和 inCustomColorMode:
 #include "ui_manager.h"      // 提供 extern bool inCustomColorMode; 和 void drawDebugInfo();
 
@@ -37,4 +37,29 @@ void manageScreenStateLEDs();
 // 切换屏幕状态 (亮/灭) - 辅助函数，可能被 handleBootButton 调用
 void toggleScreen();
 
+// --- 自动息屏与浅睡眠待机 ---
+// 无本地操作 SCREEN_IDLE_OFF_MS 后自动息屏；息屏且空闲 LIGHT_SLEEP_IDLE_MS 后进入浅睡眠待机:
+// 每次睡 LIGHT_SLEEP_INTERVAL_MS，醒来后保持 LIGHT_SLEEP_LISTEN_WINDOW_MS 处理 ESP-NOW 消息和到期任务。
+// 浅睡眠保留内存和外设状态，画布与绘图历史不会丢失 (深度睡眠会)。
+// 进入和退出待机时通知网络任务 (dozeSyncBegin/dozeSyncEnd)，退出后补回射频关闭期间对端画的点。
+
+// 记录本地操作 (触摸、按钮)，重置息屏和浅睡眠计时，可在任意任务中调用
+void powerManagerNoteUserActivity();
+
+// 记录对端绘制/同步消息，之后 LIGHT_SLEEP_ACTIVITY_HOLD_MS 内保持清醒，可在任意任务中调用
+void powerManagerNoteRadioActivity();
+
+// 周期调用: 无操作超时后自动息屏
+void powerManagerCheckIdle();
+
+// 主循环空闲时调用: 满足条件时浅睡眠一个周期并返回 true (由触摸、BOOT 按钮或定时器唤醒)，
+// 否则返回 false，由调用方照常 schedulerWaitForWork()
+bool powerManagerLightSleep();
+
+// 是否处于浅睡眠待机 (只有监听窗口能收到消息，网络任务据此暂停心跳超时检查)
+bool powerManagerIsDozing();
+
+// 打印屏幕状态、睡眠次数、睡眠时间占比和唤醒原因
+void powerManagerPrintStats(Print &out);
+
 #endif // POWER_MANAGER_H
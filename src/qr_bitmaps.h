@@ -0,0 +1,155 @@
+// 此文件由 qr_to_text.py 自动生成，请勿手动修改
+// 二维码已按 QR_BITMAP_SCALE 预缩放，深色模块合并为矩形 (同一行相邻的模块合成一段，
+// 与上一行位置相同的段向下延伸)，每个矩形在设备上是一次 fillRect (一个地址窗口)。
+// 背景不在这里绘制: 调用方先用弹窗背景色填充。
+#ifndef QR_BITMAPS_H
+#define QR_BITMAPS_H
+
+#include <cstdint>
+
+#define QR_BITMAP_SCALE 2
+
+typedef struct QrRect_s
+{
+    uint8_t x; // 相对二维码左上角 (像素)
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+} QrRect_t;
+
+// alipay_qr.txt
+constexpr int16_t QR_ALIPAY_WIDTH = 58;
+constexpr int16_t QR_ALIPAY_HEIGHT = 58;
+constexpr QrRect_t QR_ALIPAY_RECTS[] = {
+    {0, 0, 14, 2}, {16, 0, 2, 4}, {26, 0, 8, 2}, {36, 0, 2, 2}, {44, 0, 14, 2}, {0, 2, 2, 10},
+    {12, 2, 2, 10}, {22, 2, 8, 2}, {34, 2, 2, 4}, {38, 2, 2, 2}, {44, 2, 2, 10}, {56, 2, 2, 10},
+    {4, 4, 6, 6}, {16, 4, 4, 2}, {24, 4, 2, 2}, {28, 4, 2, 2}, {38, 4, 4, 2}, {48, 4, 6, 6},
+    {16, 6, 6, 2}, {24, 6, 10, 2}, {36, 6, 4, 2}, {18, 8, 4, 2}, {24, 8, 2, 2}, {30, 8, 8, 2},
+    {40, 8, 2, 2}, {16, 10, 6, 2}, {28, 10, 2, 4}, {32, 10, 8, 2}, {0, 12, 14, 2}, {16, 12, 2, 2},
+    {20, 12, 2, 2}, {24, 12, 2, 2}, {32, 12, 2, 2}, {36, 12, 2, 2}, {40, 12, 2, 6}, {44, 12, 14, 2},
+    {20, 14, 4, 2}, {34, 14, 4, 2}, {0, 16, 4, 2}, {8, 16, 6, 2}, {20, 16, 2, 2}, {24, 16, 2, 2},
+    {32, 16, 4, 2}, {46, 16, 2, 2}, {50, 16, 8, 2}, {0, 18, 8, 2}, {10, 18, 2, 2}, {14, 18, 2, 2},
+    {26, 18, 2, 2}, {30, 18, 2, 2}, {34, 18, 2, 2}, {44, 18, 14, 2}, {0, 20, 2, 2}, {6, 20, 4, 2},
+    {12, 20, 2, 2}, {16, 20, 6, 2}, {30, 20, 6, 2}, {40, 20, 2, 2}, {56, 20, 2, 2}, {8, 22, 4, 2},
+    {16, 22, 4, 2}, {24, 22, 2, 2}, {28, 22, 4, 2}, {34, 22, 2, 2}, {38, 22, 10, 2}, {50, 22, 2, 2},
+    {54, 22, 4, 2}, {0, 24, 4, 2}, {12, 24, 2, 2}, {16, 24, 2, 2}, {22, 24, 2, 2}, {28, 24, 2, 2},
+    {32, 24, 6, 2}, {40, 24, 4, 2}, {54, 24, 2, 2}, {2, 26, 2, 4}, {8, 26, 4, 2}, {14, 26, 8, 2},
+    {24, 26, 4, 2}, {30, 26, 2, 4}, {44, 26, 14, 2}, {8, 28, 2, 2}, {12, 28, 4, 2}, {18, 28, 8, 2},
+    {34, 28, 2, 2}, {40, 28, 4, 2}, {46, 28, 8, 2}, {56, 28, 2, 2}, {4, 30, 2, 2}, {10, 30, 2, 2},
+    {14, 30, 2, 2}, {18, 30, 6, 2}, {28, 30, 4, 2}, {34, 30, 6, 2}, {44, 30, 2, 2}, {48, 30, 2, 2},
+    {54, 30, 4, 2}, {0, 32, 16, 2}, {20, 32, 2, 4}, {24, 32, 2, 2}, {34, 32, 10, 2}, {54, 32, 2, 2},
+    {0, 34, 12, 2}, {14, 34, 2, 2}, {26, 34, 8, 2}, {42, 34, 4, 2}, {48, 34, 4, 2}, {54, 34, 4, 2},
+    {4, 36, 2, 2}, {10, 36, 12, 2}, {26, 36, 2, 2}, {30, 36, 2, 2}, {42, 36, 8, 2}, {52, 36, 2, 2},
+    {56, 36, 2, 2}, {6, 38, 2, 2}, {20, 38, 2, 2}, {24, 38, 2, 2}, {34, 38, 2, 2}, {38, 38, 10, 2},
+    {54, 38, 4, 2}, {0, 40, 6, 2}, {8, 40, 8, 2}, {22, 40, 4, 2}, {32, 40, 6, 2}, {40, 40, 12, 2},
+    {56, 40, 2, 8}, {16, 42, 2, 2}, {20, 42, 2, 2}, {24, 42, 8, 2}, {34, 42, 2, 2}, {38, 42, 4, 4},
+    {48, 42, 2, 2}, {0, 44, 14, 2}, {22, 44, 6, 2}, {30, 44, 6, 2}, {44, 44, 2, 2}, {48, 44, 6, 2},
+    {0, 46, 2, 10}, {12, 46, 2, 10}, {16, 46, 10, 2}, {30, 46, 2, 2}, {34, 46, 4, 2}, {40, 46, 2, 2},
+    {48, 46, 2, 2}, {4, 48, 6, 6}, {16, 48, 2, 2}, {20, 48, 2, 2}, {32, 48, 20, 2}, {54, 48, 4, 2},
+    {18, 50, 2, 4}, {22, 50, 4, 2}, {30, 50, 4, 4}, {40, 50, 4, 4}, {46, 50, 2, 2}, {56, 50, 2, 2},
+    {22, 52, 6, 2}, {36, 52, 2, 2}, {50, 52, 8, 2}, {16, 54, 4, 2}, {22, 54, 4, 2}, {30, 54, 6, 2},
+    {38, 54, 8, 2}, {50, 54, 2, 2}, {54, 54, 4, 2}, {0, 56, 14, 2}, {16, 56, 6, 2}, {24, 56, 2, 2},
+    {30, 56, 8, 2}, {40, 56, 4, 2}, {48, 56, 2, 2}, {54, 56, 2, 2},
+};
+constexpr int QR_ALIPAY_RECT_COUNT = 172;
+
+// wechat_qr.txt
+constexpr int16_t QR_WECHAT_WIDTH = 58;
+constexpr int16_t QR_WECHAT_HEIGHT = 58;
+constexpr QrRect_t QR_WECHAT_RECTS[] = {
+    {0, 0, 14, 2}, {16, 0, 4, 2}, {22, 0, 4, 2}, {30, 0, 2, 2}, {38, 0, 2, 2}, {44, 0, 14, 2},
+    {0, 2, 2, 10}, {12, 2, 2, 10}, {16, 2, 2, 2}, {20, 2, 2, 2}, {26, 2, 4, 2}, {36, 2, 4, 2},
+    {44, 2, 2, 10}, {56, 2, 2, 10}, {4, 4, 6, 6}, {16, 4, 4, 2}, {22, 4, 2, 2}, {30, 4, 10, 2},
+    {48, 4, 6, 6}, {16, 6, 2, 2}, {22, 6, 4, 2}, {28, 6, 2, 2}, {40, 6, 2, 2}, {20, 8, 2, 6},
+    {26, 8, 2, 2}, {30, 8, 2, 2}, {38, 8, 2, 2}, {16, 10, 2, 4}, {32, 10, 8, 2}, {0, 12, 14, 2},
+    {24, 12, 2, 2}, {28, 12, 2, 2}, {32, 12, 2, 2}, {36, 12, 2, 2}, {40, 12, 2, 2}, {44, 12, 14, 2},
+    {18, 14, 2, 2}, {22, 14, 2, 2}, {28, 14, 14, 2}, {0, 16, 4, 2}, {8, 16, 6, 2}, {20, 16, 4, 4},
+    {26, 16, 2, 2}, {32, 16, 2, 2}, {40, 16, 2, 2}, {46, 16, 2, 2}, {50, 16, 8, 2}, {0, 18, 2, 2},
+    {4, 18, 2, 2}, {8, 18, 4, 2}, {16, 18, 2, 2}, {26, 18, 14, 2}, {46, 18, 6, 2}, {54, 18, 4, 2},
+    {2, 20, 14, 2}, {18, 20, 8, 2}, {28, 20, 6, 2}, {40, 20, 4, 2}, {46, 20, 4, 2}, {52, 20, 6, 2},
+    {0, 22, 10, 2}, {16, 22, 4, 2}, {22, 22, 4, 2}, {30, 22, 2, 2}, {34, 22, 2, 2}, {38, 22, 2, 2},
+    {44, 22, 2, 2}, {48, 22, 2, 2}, {54, 22, 4, 2}, {6, 24, 4, 2}, {12, 24, 2, 2}, {22, 24, 6, 2},
+    {38, 24, 6, 2}, {48, 24, 4, 2}, {0, 26, 4, 2}, {10, 26, 2, 2}, {14, 26, 6, 2}, {28, 26, 2, 2},
+    {32, 26, 2, 2}, {42, 26, 2, 2}, {46, 26, 4, 2}, {54, 26, 4, 2}, {0, 28, 2, 2}, {8, 28, 10, 2},
+    {22, 28, 10, 2}, {40, 28, 2, 2}, {44, 28, 10, 2}, {56, 28, 2, 2}, {6, 30, 4, 2}, {20, 30, 2, 2},
+    {24, 30, 2, 4}, {32, 30, 4, 2}, {38, 30, 2, 6}, {42, 30, 2, 4}, {54, 30, 4, 2}, {2, 32, 2, 2},
+    {10, 32, 12, 2}, {30, 32, 2, 2}, {34, 32, 2, 2}, {46, 32, 2, 2}, {50, 32, 2, 2}, {56, 32, 2, 2},
+    {0, 34, 6, 2}, {26, 34, 4, 2}, {32, 34, 2, 2}, {48, 34, 2, 2}, {54, 34, 4, 2}, {4, 36, 16, 2},
+    {22, 36, 4, 2}, {28, 36, 4, 4}, {36, 36, 2, 2}, {42, 36, 2, 2}, {46, 36, 2, 4}, {50, 36, 4, 2},
+    {56, 36, 2, 2}, {4, 38, 2, 2}, {8, 38, 4, 2}, {16, 38, 2, 2}, {20, 38, 2, 2}, {24, 38, 2, 2},
+    {34, 38, 10, 2}, {50, 38, 2, 2}, {0, 40, 4, 2}, {10, 40, 4, 2}, {16, 40, 6, 2}, {38, 40, 14, 2},
+    {54, 40, 2, 2}, {16, 42, 2, 2}, {26, 42, 12, 2}, {40, 42, 2, 4}, {48, 42, 2, 6}, {52, 42, 6, 2},
+    {0, 44, 14, 2}, {22, 44, 4, 4}, {30, 44, 4, 2}, {36, 44, 2, 2}, {44, 44, 2, 2}, {52, 44, 2, 2},
+    {56, 44, 2, 4}, {0, 46, 2, 10}, {12, 46, 2, 10}, {16, 46, 2, 4}, {28, 46, 2, 2}, {32, 46, 4, 2},
+    {38, 46, 4, 2}, {4, 48, 6, 6}, {28, 48, 4, 2}, {38, 48, 12, 2}, {54, 48, 2, 2}, {20, 50, 2, 2},
+    {26, 50, 2, 2}, {32, 50, 2, 2}, {40, 50, 4, 2}, {46, 50, 2, 2}, {50, 50, 8, 2}, {18, 52, 2, 2},
+    {22, 52, 2, 4}, {30, 52, 2, 2}, {34, 52, 4, 2}, {40, 52, 2, 2}, {44, 52, 4, 2}, {52, 52, 6, 2},
+    {16, 54, 2, 2}, {28, 54, 2, 4}, {34, 54, 2, 2}, {38, 54, 6, 2}, {46, 54, 6, 2}, {54, 54, 4, 2},
+    {0, 56, 14, 2}, {16, 56, 8, 2}, {32, 56, 2, 2}, {40, 56, 2, 2}, {44, 56, 8, 2}, {54, 56, 2, 2},
+};
+constexpr int QR_WECHAT_RECT_COUNT = 174;
+
+// shapaper_blog.txt
+constexpr int16_t QR_BLOG_WIDTH = 50;
+constexpr int16_t QR_BLOG_HEIGHT = 50;
+constexpr QrRect_t QR_BLOG_RECTS[] = {
+    {0, 0, 14, 2}, {18, 0, 2, 2}, {28, 0, 2, 2}, {32, 0, 2, 2}, {36, 0, 14, 2}, {0, 2, 2, 10},
+    {12, 2, 2, 10}, {16, 2, 4, 2}, {22, 2, 4, 2}, {28, 2, 6, 2}, {36, 2, 2, 10}, {48, 2, 2, 10},
+    {4, 4, 6, 6}, {18, 4, 6, 2}, {30, 4, 4, 2}, {40, 4, 6, 6}, {16, 6, 4, 2}, {22, 6, 2, 2},
+    {26, 6, 6, 2}, {20, 8, 2, 6}, {24, 8, 2, 2}, {32, 8, 2, 2}, {16, 10, 2, 4}, {30, 10, 4, 2},
+    {0, 12, 14, 2}, {24, 12, 2, 4}, {28, 12, 2, 2}, {32, 12, 2, 2}, {36, 12, 14, 2}, {28, 14, 6, 2},
+    {0, 16, 10, 2}, {12, 16, 10, 2}, {24, 16, 4, 2}, {34, 16, 2, 2}, {38, 16, 2, 4}, {42, 16, 2, 2},
+    {46, 16, 2, 4}, {0, 18, 4, 4}, {6, 18, 6, 2}, {14, 18, 2, 2}, {18, 18, 2, 4}, {26, 18, 2, 2},
+    {32, 18, 2, 2}, {12, 20, 2, 2}, {22, 20, 14, 2}, {40, 20, 4, 2}, {46, 20, 4, 2}, {8, 22, 2, 2},
+    {14, 22, 10, 2}, {30, 22, 2, 2}, {36, 22, 2, 2}, {48, 22, 2, 2}, {4, 24, 2, 2}, {10, 24, 4, 2},
+    {18, 24, 2, 2}, {22, 24, 2, 2}, {26, 24, 4, 2}, {34, 24, 4, 2}, {40, 24, 2, 2}, {44, 24, 6, 2},
+    {0, 26, 2, 8}, {4, 26, 4, 4}, {10, 26, 2, 2}, {20, 26, 2, 2}, {24, 26, 2, 2}, {28, 26, 2, 2},
+    {32, 26, 2, 2}, {38, 26, 2, 2}, {42, 26, 2, 2}, {46, 26, 2, 2}, {10, 28, 6, 2}, {28, 28, 4, 2},
+    {34, 28, 2, 2}, {38, 28, 6, 2}, {46, 28, 4, 2}, {6, 30, 6, 2}, {16, 30, 2, 2}, {24, 30, 2, 2},
+    {30, 30, 6, 2}, {38, 30, 4, 2}, {48, 30, 2, 2}, {8, 32, 2, 2}, {12, 32, 2, 2}, {16, 32, 4, 4},
+    {24, 32, 18, 2}, {44, 32, 2, 2}, {26, 34, 2, 2}, {30, 34, 4, 2}, {40, 34, 4, 2}, {0, 36, 14, 2},
+    {16, 36, 2, 2}, {20, 36, 10, 2}, {32, 36, 2, 4}, {36, 36, 2, 2}, {40, 36, 2, 2}, {44, 36, 6, 2},
+    {0, 38, 2, 10}, {12, 38, 2, 10}, {22, 38, 2, 2}, {28, 38, 2, 2}, {40, 38, 4, 2}, {48, 38, 2, 2},
+    {4, 40, 6, 6}, {16, 40, 2, 2}, {20, 40, 22, 2}, {44, 40, 2, 2}, {16, 42, 6, 4}, {24, 42, 2, 2},
+    {28, 42, 10, 2}, {40, 42, 10, 2}, {32, 44, 2, 2}, {42, 44, 4, 2}, {48, 44, 2, 4}, {16, 46, 2, 4},
+    {20, 46, 4, 2}, {30, 46, 14, 2}, {0, 48, 14, 2}, {22, 48, 6, 2}, {30, 48, 2, 2}, {34, 48, 2, 2},
+    {38, 48, 12, 2},
+};
+constexpr int QR_BLOG_RECT_COUNT = 121;
+
+// 原作者空间.txt
+constexpr int16_t QR_AUTHOR_WIDTH = 58;
+constexpr int16_t QR_AUTHOR_HEIGHT = 58;
+constexpr QrRect_t QR_AUTHOR_RECTS[] = {
+    {0, 0, 14, 2}, {16, 0, 2, 2}, {22, 0, 4, 2}, {28, 0, 6, 2}, {36, 0, 2, 2}, {40, 0, 2, 2},
+    {44, 0, 14, 2}, {0, 2, 2, 10}, {12, 2, 2, 10}, {18, 2, 4, 2}, {32, 2, 4, 2}, {38, 2, 2, 2},
+    {44, 2, 2, 10}, {56, 2, 2, 10}, {4, 4, 6, 6}, {20, 4, 2, 2}, {24, 4, 2, 4}, {30, 4, 4, 2},
+    {36, 4, 4, 2}, {48, 4, 6, 6}, {30, 6, 2, 2}, {34, 6, 2, 2}, {38, 6, 4, 2}, {18, 8, 2, 2},
+    {22, 8, 2, 2}, {28, 8, 2, 2}, {34, 8, 6, 2}, {20, 10, 2, 4}, {24, 10, 2, 4}, {32, 10, 2, 4},
+    {36, 10, 2, 4}, {0, 12, 14, 2}, {16, 12, 2, 4}, {28, 12, 2, 2}, {40, 12, 2, 2}, {44, 12, 14, 2},
+    {20, 14, 4, 2}, {26, 14, 2, 4}, {30, 14, 4, 2}, {38, 14, 2, 2}, {0, 16, 4, 2}, {6, 16, 4, 2},
+    {12, 16, 2, 2}, {18, 16, 6, 2}, {30, 16, 2, 2}, {34, 16, 2, 2}, {44, 16, 2, 2}, {56, 16, 2, 2},
+    {0, 18, 8, 2}, {14, 18, 2, 2}, {18, 18, 2, 2}, {24, 18, 4, 2}, {30, 18, 10, 2}, {46, 18, 4, 2},
+    {52, 18, 4, 2}, {6, 20, 8, 2}, {20, 20, 4, 2}, {26, 20, 2, 2}, {30, 20, 2, 2}, {52, 20, 2, 2},
+    {2, 22, 4, 2}, {14, 22, 14, 2}, {32, 22, 4, 2}, {42, 22, 10, 2}, {56, 22, 2, 4}, {0, 24, 2, 2},
+    {6, 24, 2, 2}, {12, 24, 4, 2}, {18, 24, 2, 2}, {22, 24, 6, 2}, {40, 24, 8, 2}, {0, 26, 6, 2},
+    {8, 26, 2, 4}, {26, 26, 6, 2}, {34, 26, 4, 2}, {44, 26, 14, 2}, {2, 28, 4, 2}, {12, 28, 16, 2},
+    {30, 28, 4, 2}, {38, 28, 2, 2}, {46, 28, 4, 2}, {52, 28, 2, 4}, {56, 28, 2, 4}, {0, 30, 12, 2},
+    {14, 30, 4, 2}, {20, 30, 4, 2}, {32, 30, 2, 4}, {38, 30, 4, 2}, {48, 30, 2, 2}, {0, 32, 2, 4},
+    {4, 32, 2, 4}, {8, 32, 6, 2}, {16, 32, 2, 2}, {20, 32, 2, 2}, {28, 32, 2, 2}, {36, 32, 2, 2},
+    {40, 32, 2, 2}, {46, 32, 2, 2}, {50, 32, 2, 2}, {10, 34, 2, 2}, {14, 34, 20, 2}, {36, 34, 6, 2},
+    {48, 34, 2, 2}, {52, 34, 4, 2}, {0, 36, 4, 2}, {6, 36, 2, 2}, {10, 36, 4, 2}, {20, 36, 4, 2},
+    {30, 36, 2, 2}, {38, 36, 2, 2}, {42, 36, 10, 2}, {56, 36, 2, 2}, {0, 38, 6, 4}, {10, 38, 2, 2},
+    {16, 38, 4, 2}, {24, 38, 2, 2}, {28, 38, 2, 2}, {38, 38, 4, 2}, {44, 38, 2, 2}, {48, 38, 6, 2},
+    {8, 40, 10, 2}, {20, 40, 2, 2}, {24, 40, 8, 2}, {34, 40, 4, 2}, {40, 40, 16, 2}, {16, 42, 4, 2},
+    {28, 42, 6, 4}, {40, 42, 2, 2}, {48, 42, 4, 4}, {0, 44, 14, 2}, {20, 44, 2, 2}, {24, 44, 2, 2},
+    {36, 44, 6, 2}, {44, 44, 2, 2}, {0, 46, 2, 10}, {12, 46, 2, 10}, {18, 46, 2, 2}, {28, 46, 2, 2},
+    {32, 46, 4, 2}, {38, 46, 4, 2}, {48, 46, 2, 2}, {56, 46, 2, 2}, {4, 48, 6, 6}, {16, 48, 2, 2},
+    {20, 48, 22, 2}, {44, 48, 2, 2}, {50, 48, 2, 2}, {54, 48, 2, 2}, {16, 50, 6, 4}, {24, 50, 2, 2},
+    {28, 50, 10, 2}, {40, 50, 10, 2}, {52, 50, 2, 8}, {56, 50, 2, 8}, {32, 52, 2, 2}, {42, 52, 4, 2},
+    {48, 52, 2, 4}, {16, 54, 2, 4}, {20, 54, 4, 2}, {30, 54, 14, 2}, {0, 56, 14, 2}, {22, 56, 6, 2},
+    {30, 56, 2, 2}, {34, 56, 2, 2}, {38, 56, 12, 2},
+};
+constexpr int QR_AUTHOR_RECT_COUNT = 165;
+
+#endif // QR_BITMAPS_H
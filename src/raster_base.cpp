@@ -0,0 +1,281 @@
+#include "raster_base.h"
+#include "memory_tier.h"
+#include <algorithm> // std::min, std::max
+
+#define RASTER_BASE_CHUNK_HEADER 4 // pixelOffset + length
+
+static RasterBaseTile_t baseTiles[RASTER_TILE_COUNT];
+static size_t baseBytes = 0;
+static uint32_t baseChunks = 0;
+static uint32_t baseRevision = 0;
+
+static void freeTile(RasterBaseTile_t &tile)
+{
+    memoryTierFree(tile.data);
+    tile.data = nullptr;
+    tile.bytes = 0;
+}
+
+// 重新统计底图的字节数和数据段数
+static void recount()
+{
+    baseBytes = 0;
+    baseChunks = 0;
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+    {
+        baseBytes += baseTiles[tile].bytes;
+        size_t cursor = 0;
+        uint16_t pixelOffset, length;
+        const uint8_t *data;
+        while (rasterBaseNextChunk(tile, cursor, pixelOffset, length, data))
+            baseChunks++;
+    }
+}
+
+static void writeChunkHeader(uint8_t *out, uint16_t pixelOffset, uint16_t length)
+{
+    out[0] = pixelOffset & 0xFF;
+    out[1] = pixelOffset >> 8;
+    out[2] = length & 0xFF;
+    out[3] = length >> 8;
+}
+
+static bool tileIntersects(uint16_t tile, int x, int y, int w, int h)
+{
+    int tileX, tileY, tileW, tileH;
+    rasterTileRect(tile, tileX, tileY, tileW, tileH);
+    return tileX < x + w && x < tileX + tileW && tileY < y + h && y < tileY + tileH;
+}
+
+static void ignoreRun(int x, int y, int length, uint16_t color)
+{
+    (void)x;
+    (void)y;
+    (void)length;
+    (void)color;
+}
+
+void rasterBaseClear()
+{
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+        freeTile(baseTiles[tile]);
+    baseBytes = 0;
+    baseChunks = 0;
+    baseRevision++;
+}
+
+bool rasterBaseEmpty()
+{
+    return baseChunks == 0;
+}
+
+size_t rasterBaseBytes()
+{
+    return baseBytes;
+}
+
+uint32_t rasterBaseChunkCount()
+{
+    return baseChunks;
+}
+
+uint32_t rasterBaseRevision()
+{
+    return baseRevision;
+}
+
+bool rasterBaseVisible(const DrawingHistory &history)
+{
+    return baseChunks > 0 && history.strokes().visibleStart() == 0;
+}
+
+bool rasterBaseAppendChunk(uint16_t tileIndex, uint16_t pixelOffset, const uint8_t *data, uint16_t length)
+{
+    if (tileIndex >= RASTER_TILE_COUNT || length == 0 || length > RASTER_BASE_CHUNK_BYTES ||
+        !rasterDecodeChunk(tileIndex, pixelOffset, data, length, ignoreRun))
+        return false;
+    RasterBaseTile_t &tile = baseTiles[tileIndex];
+    size_t bytes = tile.bytes + RASTER_BASE_CHUNK_HEADER + length;
+    if (bytes > RASTER_BASE_TILE_MAX_BYTES)
+        return false; // 重复收到的数据，正常编码不会超过
+
+    uint8_t *grown = (uint8_t *)memoryTierAlloc(bytes, MEMORY_TIER_PSRAM);
+    if (grown == nullptr)
+        return false;
+    if (tile.bytes > 0)
+        memcpy(grown, tile.data, tile.bytes);
+    writeChunkHeader(grown + tile.bytes, pixelOffset, length);
+    memcpy(grown + tile.bytes + RASTER_BASE_CHUNK_HEADER, data, length);
+    memoryTierFree(tile.data);
+    tile.data = grown;
+    tile.bytes = bytes;
+    baseBytes += RASTER_BASE_CHUNK_HEADER + length;
+    baseChunks++;
+    baseRevision++;
+    return true;
+}
+
+bool rasterBaseNextChunk(uint16_t tileIndex, size_t &cursor, uint16_t &pixelOffset, uint16_t &length, const uint8_t *&data)
+{
+    const RasterBaseTile_t &tile = baseTiles[tileIndex];
+    if (cursor + RASTER_BASE_CHUNK_HEADER > tile.bytes)
+        return false;
+    const uint8_t *header = tile.data + cursor;
+    pixelOffset = header[0] | (header[1] << 8);
+    length = header[2] | (header[3] << 8);
+    data = header + RASTER_BASE_CHUNK_HEADER;
+    cursor += RASTER_BASE_CHUNK_HEADER + length;
+    return true;
+}
+
+void rasterBaseForEachRun(int x, int y, int w, int h, RasterRunFn emit)
+{
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+    {
+        if (baseTiles[tile].data == nullptr || !tileIntersects(tile, x, y, w, h))
+            continue;
+        size_t cursor = 0;
+        uint16_t pixelOffset, length;
+        const uint8_t *data;
+        while (rasterBaseNextChunk(tile, cursor, pixelOffset, length, data))
+            rasterDecodeChunk(tile, pixelOffset, data, length, emit);
+    }
+}
+
+void rasterBaseDrawToCanvas(const RasterCanvas_t &canvas)
+{
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+    {
+        if (baseTiles[tile].data == nullptr || !tileIntersects(tile, canvas.x, canvas.y, canvas.w, canvas.h))
+            continue;
+        size_t cursor = 0;
+        uint16_t pixelOffset, length;
+        const uint8_t *data;
+        while (rasterBaseNextChunk(tile, cursor, pixelOffset, length, data))
+            rasterDecodeChunkToCanvas(tile, pixelOffset, data, length, canvas);
+    }
+}
+
+// --- 展平 ---
+
+bool rasterFlattenBegin(RasterFlattenJob_t &job, const DrawingHistory &history, size_t keepPoints)
+{
+    size_t size = history.size();
+    if (size <= keepPoints)
+        return false;
+    size_t target = std::min(size - keepPoints, history.undo_window_start()); // 最近的笔划还可能被撤销，保留为矢量
+
+    // 分界取不晚于 target 的最后一个笔划起点: 没有连线跨过索引中笔划的边界，删除前缀不改变保留的点的绘制结果。
+    // 索引只覆盖最后一个复位点之后，复位点及之前的点总是可以展平 (它们已被清屏)
+    const StrokeTileIndex &index = history.strokes();
+    size_t low = 0, high = index.strokeCount();
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (index.strokeStart(middle) <= target)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    size_t cut = index.visibleStart();
+    if (low > 0)
+        cut = std::max(cut, index.strokeStart(low - 1));
+    if (cut == 0)
+        return false;
+
+    job.cut = cut;
+    job.renderStart = rasterVisibleStart(history, cut);
+    job.dropBase = job.renderStart > 0;
+    job.historyRevision = history.revision();
+    job.baseRevision = baseRevision;
+    job.nextTile = 0;
+    job.tilesRendered = 0;
+    memset(job.tiles, 0, sizeof(job.tiles));
+    rasterMarkTiles(history, job.renderStart, cut, job.tileMarked);
+    if (job.dropBase)
+    {
+        // 旧底图被前缀中的复位点清屏: 有内容的图块都要重新生成 (多半变为全黑)
+        for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+            job.tileMarked[tile] = job.tileMarked[tile] || baseTiles[tile].data != nullptr;
+    }
+    job.active = true;
+    return true;
+}
+
+bool rasterFlattenStep(RasterFlattenJob_t &job, const DrawingHistory &history)
+{
+    if (!job.active)
+        return false;
+    if (history.revision() != job.historyRevision || baseRevision != job.baseRevision)
+    {
+        rasterFlattenAbort(job); // 期间历史被清空/压缩，或底图被替换
+        return false;
+    }
+    while (job.nextTile < RASTER_TILE_COUNT && !job.tileMarked[job.nextTile])
+        job.nextTile++;
+    if (job.nextTile >= RASTER_TILE_COUNT)
+        return true;
+
+    uint16_t tile = job.nextTile++;
+    RasterCanvas_t canvas;
+    rasterTileRect(tile, canvas.x, canvas.y, canvas.w, canvas.h);
+    canvas.pixels = job.pixels;
+    memset(job.pixels, 0, sizeof(job.pixels)); // TFT_BLACK
+    if (!job.dropBase)
+    {
+        size_t cursor = 0;
+        uint16_t pixelOffset, length;
+        const uint8_t *data;
+        while (rasterBaseNextChunk(tile, cursor, pixelOffset, length, data))
+            rasterDecodeChunkToCanvas(tile, pixelOffset, data, length, canvas);
+    }
+    rasterRenderRange(history, job.renderStart, job.cut, canvas);
+
+    size_t bytes = 0;
+    uint16_t offset = 0, chunkOffset, length;
+    while (bytes + RASTER_BASE_CHUNK_HEADER + 3 <= RASTER_BASE_TILE_MAX_BYTES)
+    {
+        uint16_t capacity = std::min<size_t>(RASTER_BASE_CHUNK_BYTES, RASTER_BASE_TILE_MAX_BYTES - bytes - RASTER_BASE_CHUNK_HEADER);
+        if (!rasterEncodeChunk(tile, job.pixels, offset, job.scratch + bytes + RASTER_BASE_CHUNK_HEADER, capacity,
+                               chunkOffset, length, offset) ||
+            length == 0)
+            break;
+        writeChunkHeader(job.scratch + bytes, chunkOffset, length);
+        bytes += RASTER_BASE_CHUNK_HEADER + length;
+    }
+    if (bytes > 0)
+    {
+        job.tiles[tile].data = (uint8_t *)memoryTierAlloc(bytes, MEMORY_TIER_PSRAM);
+        if (job.tiles[tile].data == nullptr)
+        {
+            rasterFlattenAbort(job);
+            return false;
+        }
+        memcpy(job.tiles[tile].data, job.scratch, bytes);
+        job.tiles[tile].bytes = bytes;
+    }
+    job.tilesRendered++;
+    return false;
+}
+
+void rasterFlattenCommit(RasterFlattenJob_t &job)
+{
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+    {
+        if (!job.tileMarked[tile])
+            continue;
+        freeTile(baseTiles[tile]);
+        baseTiles[tile] = job.tiles[tile];
+        job.tiles[tile] = {nullptr, 0};
+    }
+    recount();
+    baseRevision++;
+    job.active = false;
+}
+
+void rasterFlattenAbort(RasterFlattenJob_t &job)
+{
+    for (uint16_t tile = 0; tile < RASTER_TILE_COUNT; tile++)
+        freeTile(job.tiles[tile]);
+    job.active = false;
+}
@@ -0,0 +1,80 @@
+#ifndef RASTER_BASE_H
+#define RASTER_BASE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "drawing_history.h" // DrawingHistory
+#include "raster_sync.h"     // 图块划分与游程编码
+
+// 光栅底图: 绘图历史超出内存预算后，把较早的笔划展平成的画布图像
+// 按光栅同步的图块划分存放，每个图块是若干段游程编码数据 (格式见 raster_sync.h，每段不超过 RASTER_BASE_CHUNK_BYTES，
+// 可原样作为光栅同步的图块消息发送)，画满的 320x240 画布也只有几十 KB，有 PSRAM 时放在 PSRAM。
+// 底图画在历史之下: 重播时先画底图，再按顺序重播历史；历史中有复位点时底图已被清屏，不再显示。
+// 只有网络任务修改底图，修改时持有 historyLock；主循环重播时持锁读取。
+
+#define RASTER_BASE_CHUNK_BYTES 238 // 与 RASTER_CHUNK_DATA_BYTES 相同
+#define RASTER_BASE_TILE_MAX_BYTES (RASTER_TILE_PIXELS * 3 + 256) // 一个图块编码后的上限 (每像素最多 3 字节，加各段的段头)
+
+// 一个图块的数据: 若干段 [pixelOffset (2 字节), length (2 字节), 编码数据]，nullptr 表示图块全黑
+typedef struct RasterBaseTile_s
+{
+    uint8_t *data;
+    uint16_t bytes;
+} RasterBaseTile_t;
+
+// 展平历史前缀的分步任务 (网络任务在超出预算时执行，每步处理一个图块，新图块在提交前与底图并存)
+typedef struct RasterFlattenJob_s
+{
+    bool active;
+    size_t cut;                                 // 展平历史前缀 [0, cut)，cut 是笔划起点
+    size_t renderStart;                         // 前缀中最后一个复位点之后的起点
+    bool dropBase;                              // 前缀中有复位点: 旧底图已被清屏
+    uint32_t historyRevision;                   // 开始时历史和底图的 revision，期间变化则放弃
+    uint32_t baseRevision;
+    uint16_t nextTile;                          // 下一个要处理的图块
+    uint16_t tilesRendered;
+    bool tileMarked[RASTER_TILE_COUNT];         // 前缀画到的图块
+    RasterBaseTile_t tiles[RASTER_TILE_COUNT];  // 重新编码的图块 (只对标记的图块有效)
+    uint16_t pixels[RASTER_TILE_PIXELS];        // 图块绘制缓冲
+    uint8_t scratch[RASTER_BASE_TILE_MAX_BYTES]; // 编码缓冲
+} RasterFlattenJob_t;
+
+// 清空底图 (历史清空时)
+void rasterBaseClear();
+bool rasterBaseEmpty();
+
+// 底图占用的内存 (字节) 和编码数据段数
+size_t rasterBaseBytes();
+uint32_t rasterBaseChunkCount();
+
+// 底图每次变化后加一，按内容缓存的结果 (画布帧缓冲、闪存中的底图文件) 据此判断是否失效
+uint32_t rasterBaseRevision();
+
+// 底图非空且历史中没有复位点 (重播时要先画底图)
+bool rasterBaseVisible(const DrawingHistory &history);
+
+// 追加一段编码数据 (光栅同步接收、启动恢复)，数据无效或分配失败时返回 false
+bool rasterBaseAppendChunk(uint16_t tileIndex, uint16_t pixelOffset, const uint8_t *data, uint16_t length);
+
+// 逐段读取: cursor 从 0 开始，返回 false 表示该图块已读完
+bool rasterBaseNextChunk(uint16_t tileIndex, size_t &cursor, uint16_t &pixelOffset, uint16_t &length, const uint8_t *&data);
+
+// 把与矩形相交的图块中的非黑游程交给 emit (不裁剪到矩形，调用方用视口裁剪)
+void rasterBaseForEachRun(int x, int y, int w, int h, RasterRunFn emit);
+
+// 把底图画到画布上 (只写落在画布内的像素)
+void rasterBaseDrawToCanvas(const RasterCanvas_t &canvas);
+
+// 开始展平: 选择不晚于 history.size() - keepPoints (也不晚于撤销窗口) 的最后一个笔划起点作为分界，没有可展平的前缀时返回 false
+bool rasterFlattenBegin(RasterFlattenJob_t &job, const DrawingHistory &history, size_t keepPoints);
+
+// 处理下一个标记的图块，全部处理完时返回 true；历史或底图在期间变化、或分配失败时放弃任务并返回 false
+bool rasterFlattenStep(RasterFlattenJob_t &job, const DrawingHistory &history);
+
+// 全部处理完后: 用新图块替换底图 (调用方持有 historyLock，之后删除历史前缀 [0, job.cut))
+void rasterFlattenCommit(RasterFlattenJob_t &job);
+
+// 放弃进行中的展平，释放新图块
+void rasterFlattenAbort(RasterFlattenJob_t &job);
+
+#endif // RASTER_BASE_H
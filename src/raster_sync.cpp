@@ -0,0 +1,260 @@
+#include "raster_sync.h"
+#include <algorithm> // std::min, std::max, std::swap
+
+#define RASTER_RUN_MAX 128        // 一个编码字节最多表示的像素数
+#define RASTER_RUN_COLOR_FLAG 0x80
+
+void rasterTileRect(uint16_t tileIndex, int &x, int &y, int &w, int &h)
+{
+    x = (tileIndex % RASTER_TILES_X) * RASTER_TILE_SIZE;
+    y = (tileIndex / RASTER_TILES_X) * RASTER_TILE_SIZE;
+    w = std::min(RASTER_TILE_SIZE, SCREEN_WIDTH - x);
+    h = std::min(RASTER_TILE_SIZE, SCREEN_HEIGHT - y);
+}
+
+size_t rasterVisibleStart(const DrawingHistory &history, size_t end)
+{
+    for (size_t i = end; i > 0; i--)
+    {
+        if (history[i - 1].isReset)
+            return i;
+    }
+    return 0;
+}
+
+uint16_t rasterMarkTiles(const DrawingHistory &history, size_t start, size_t end, bool tileMarked[RASTER_TILE_COUNT])
+{
+    memset(tileMarked, 0, sizeof(bool) * RASTER_TILE_COUNT);
+    uint16_t marked = 0;
+    for (size_t i = start; i < end; i++)
+    {
+        const TouchData_t &point = history[i];
+        if (point.isReset || history_point_hidden(point))
+            continue; // 复位点、已撤销的笔划和撤销/重做记录不绘制
+        int minX = point.x, maxX = point.x, minY = point.y, maxY = point.y;
+        const TouchData_t *previous = history.stroke_previous(i);
+        if (previous != nullptr)
+        {
+            minX = std::min(minX, previous->x);
+            maxX = std::max(maxX, previous->x);
+            minY = std::min(minY, previous->y);
+            maxY = std::max(maxY, previous->y);
+        }
+
+        if (maxX < 0 || maxY < 0 || minX >= SCREEN_WIDTH || minY >= SCREEN_HEIGHT)
+            continue; // 完全在屏幕外
+        int firstColumn = std::max(minX, 0) / RASTER_TILE_SIZE;
+        int lastColumn = std::min(maxX, SCREEN_WIDTH - 1) / RASTER_TILE_SIZE;
+        int firstRow = std::max(minY, 0) / RASTER_TILE_SIZE;
+        int lastRow = std::min(maxY, SCREEN_HEIGHT - 1) / RASTER_TILE_SIZE;
+        for (int row = firstRow; row <= lastRow; row++)
+        {
+            for (int column = firstColumn; column <= lastColumn; column++)
+            {
+                bool &slot = tileMarked[row * RASTER_TILES_X + column];
+                if (!slot)
+                {
+                    slot = true;
+                    marked++;
+                }
+            }
+        }
+    }
+    return marked;
+}
+
+static inline void plotPixel(const RasterCanvas_t &canvas, int x, int y, uint16_t color)
+{
+    x -= canvas.x;
+    y -= canvas.y;
+    if (x >= 0 && y >= 0 && x < canvas.w && y < canvas.h)
+        canvas.pixels[y * canvas.w + x] = color;
+}
+
+// 与 TFT_eSPI::drawLine 相同的 Bresenham 步进，只写入落在画布内的像素
+static void plotLine(const RasterCanvas_t &canvas, int x0, int y0, int x1, int y1, uint16_t color)
+{
+    if (std::max(x0, x1) < canvas.x || std::min(x0, x1) >= canvas.x + canvas.w ||
+        std::max(y0, y1) < canvas.y || std::min(y0, y1) >= canvas.y + canvas.h)
+        return; // 线段外接矩形与画布不相交
+
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    int dx = x1 - x0;
+    int dy = abs(y1 - y0);
+    int err = dx >> 1;
+    int ystep = (y0 < y1) ? 1 : -1;
+    for (; x0 <= x1; x0++)
+    {
+        if (steep)
+            plotPixel(canvas, y0, x0, color);
+        else
+            plotPixel(canvas, x0, y0, color);
+        err -= dy;
+        if (err < 0)
+        {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+bool rasterRenderRange(const DrawingHistory &history, size_t start, size_t end, const RasterCanvas_t &canvas)
+{
+    bool sawReset = false;
+    for (size_t i = start; i < end; i++)
+    {
+        const TouchData_t &point = history[i];
+        if (point.isReset)
+        {
+            memset(canvas.pixels, 0, sizeof(uint16_t) * canvas.w * canvas.h); // TFT_BLACK
+            sawReset = true;
+            continue;
+        }
+        if (history_point_hidden(point))
+            continue;
+        uint16_t color = (uint16_t)point.color;
+        const TouchData_t *previous = history.stroke_previous(i);
+        if (previous != nullptr)
+            plotLine(canvas, previous->x, previous->y, point.x, point.y, color);
+        else
+            plotPixel(canvas, point.x, point.y, color);
+    }
+    return sawReset;
+}
+
+bool rasterRenderTile(const DrawingHistory &history, size_t start, size_t end, uint16_t tileIndex, uint16_t *pixels)
+{
+    RasterCanvas_t tile;
+    rasterTileRect(tileIndex, tile.x, tile.y, tile.w, tile.h);
+    tile.pixels = pixels;
+    memset(pixels, 0, sizeof(uint16_t) * tile.w * tile.h); // TFT_BLACK
+    rasterRenderRange(history, start, end, tile);
+
+    for (int i = 0; i < tile.w * tile.h; i++)
+    {
+        if (pixels[i] != 0)
+            return true;
+    }
+    return false;
+}
+
+bool rasterEncodeChunk(uint16_t tileIndex, const uint16_t *pixels, uint16_t pixelOffset, uint8_t *out, uint16_t capacity,
+                       uint16_t &chunkOffset, uint16_t &length, uint16_t &nextOffset)
+{
+    int x, y, w, h;
+    rasterTileRect(tileIndex, x, y, w, h);
+    const uint16_t total = w * h;
+
+    uint16_t p = pixelOffset;
+    while (p < total && pixels[p] == 0)
+        p++;
+    if (p >= total)
+        return false;
+
+    chunkOffset = p;
+    length = 0;
+    while (p < total)
+    {
+        uint16_t color = pixels[p];
+        if (color == 0)
+        {
+            // 黑色: 后面还有非黑像素才编码，否则本段到此结束
+            uint16_t q = p;
+            while (q < total && pixels[q] == 0)
+                q++;
+            if (q >= total)
+            {
+                p = total;
+                break;
+            }
+            uint16_t bytes = (q - p + RASTER_RUN_MAX - 1) / RASTER_RUN_MAX;
+            if (length + bytes + 3 > capacity)
+                break; // 放不下黑色游程和之后的一个颜色游程，下一段从这里开始
+            while (p < q)
+            {
+                uint16_t run = std::min<uint16_t>(q - p, RASTER_RUN_MAX);
+                out[length++] = run - 1;
+                p += run;
+            }
+            continue;
+        }
+
+        uint16_t run = 1;
+        while (p + run < total && run < RASTER_RUN_MAX && pixels[p + run] == color)
+            run++;
+        if (length + 3 > capacity)
+            break;
+        out[length++] = RASTER_RUN_COLOR_FLAG | (run - 1);
+        out[length++] = color & 0xFF;
+        out[length++] = color >> 8;
+        p += run;
+    }
+    nextOffset = p;
+    return true;
+}
+
+// 解码一段数据，对每个非黑游程 (已按行拆分) 调用 emit(x, y, length, color)
+template <typename Emit>
+static bool decodeChunk(uint16_t tileIndex, uint16_t chunkOffset, const uint8_t *data, uint16_t length, Emit emit)
+{
+    if (tileIndex >= RASTER_TILE_COUNT)
+        return false;
+    int x, y, w, h;
+    rasterTileRect(tileIndex, x, y, w, h);
+    const uint16_t total = w * h;
+
+    uint16_t p = chunkOffset;
+    uint16_t i = 0;
+    while (i < length)
+    {
+        uint8_t token = data[i++];
+        uint16_t run = (token & ~RASTER_RUN_COLOR_FLAG) + 1;
+        if (p + run > total)
+            return false;
+        if (token & RASTER_RUN_COLOR_FLAG)
+        {
+            if (i + 2 > length)
+                return false;
+            uint16_t color = data[i] | (data[i + 1] << 8);
+            i += 2;
+            // 跨行的游程按行拆开
+            uint16_t q = p;
+            uint16_t left = run;
+            while (left > 0)
+            {
+                int column = q % w;
+                uint16_t n = std::min<uint16_t>(left, w - column);
+                emit(x + column, y + q / w, n, color);
+                q += n;
+                left -= n;
+            }
+        }
+        p += run;
+    }
+    return true;
+}
+
+bool rasterDecodeChunk(uint16_t tileIndex, uint16_t chunkOffset, const uint8_t *data, uint16_t length, RasterRunFn emit)
+{
+    return decodeChunk(tileIndex, chunkOffset, data, length, emit);
+}
+
+bool rasterDecodeChunkToCanvas(uint16_t tileIndex, uint16_t chunkOffset, const uint8_t *data, uint16_t length,
+                               const RasterCanvas_t &canvas)
+{
+    return decodeChunk(tileIndex, chunkOffset, data, length, [&canvas](int x, int y, int n, uint16_t color)
+                       {
+                           for (int i = 0; i < n; i++)
+                               plotPixel(canvas, x + i, y, color);
+                       });
+}
@@ -0,0 +1,59 @@
+#ifndef RASTER_SYNC_H
+#define RASTER_SYNC_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "drawing_history.h" // TouchData_t, DrawingHistory
+
+// 光栅同步: 全量同步的第二种方式 (图块 + 游程编码)
+// 历史有几万个点时逐点重发要几分钟，而画好的 320x240 画布大部分是黑色。响应方把历史 (最后一次复位之后)
+// 按 replayAllDrawings 的规则逐个图块绘制到内存中，只发送有内容的图块；请求方把每个非黑游程还原为
+// 一到两个历史点 (水平线段的两端)，之后的重播、持久化和再次转发都照常进行。
+// 编码: 字节最高位为 0 表示 (低 7 位 + 1) 个黑色像素；为 1 表示 (低 7 位 + 1) 个同色像素，后跟两字节 RGB565 颜色 (小端)。
+// 每段数据从图块内指定的像素位置开始 (行优先)，首尾的黑色像素不编码，丢失一段不影响其他段。
+
+#define RASTER_TILES_X ((SCREEN_WIDTH + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE)
+#define RASTER_TILES_Y ((SCREEN_HEIGHT + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE)
+#define RASTER_TILE_COUNT (RASTER_TILES_X * RASTER_TILES_Y)
+#define RASTER_TILE_PIXELS (RASTER_TILE_SIZE * RASTER_TILE_SIZE)
+
+// 绘制目标: 屏幕上的矩形区域 (一个图块或整个画布)，像素按行存放，行宽为 w
+typedef struct RasterCanvas_s
+{
+    int x, y, w, h;
+    uint16_t *pixels;
+} RasterCanvas_t;
+
+// 还原的游程 (屏幕坐标，已按行拆分)
+typedef void (*RasterRunFn)(int x, int y, int length, uint16_t color);
+
+// 图块在屏幕上的位置和实际大小 (最右列/最下行的图块可能不满)
+void rasterTileRect(uint16_t tileIndex, int &x, int &y, int &w, int &h);
+
+// 历史 [0, end) 中最后一个复位点之后的起点 (之前的点已被清屏)
+size_t rasterVisibleStart(const DrawingHistory &history, size_t end);
+
+// 按线段外接矩形标记历史 [start, end) 可能画到的图块 (偏保守)，返回标记的图块数
+uint16_t rasterMarkTiles(const DrawingHistory &history, size_t start, size_t end, bool tileMarked[RASTER_TILE_COUNT]);
+
+// 把历史 [start, end) 绘制到画布 (不先清空；复位点清空画布)，返回是否遇到复位点。
+// 每个点与 DrawingHistory::stroke_previous 连线 (上一点可以在 start 之前)，分段绘制与一次绘制的结果相同
+bool rasterRenderRange(const DrawingHistory &history, size_t start, size_t end, const RasterCanvas_t &canvas);
+
+// 把历史 [start, end) 绘制到一个图块的像素缓冲 (RGB565，行优先，行宽为图块实际宽度)，返回是否有非黑像素
+bool rasterRenderTile(const DrawingHistory &history, size_t start, size_t end, uint16_t tileIndex, uint16_t *pixels);
+
+// 从 pixelOffset 开始编码一段数据，最多 capacity 字节，只在游程边界截断
+// pixelOffset 之后全是黑色时返回 false；否则 chunkOffset 为本段起点 (跳过了开头的黑色)，
+// length 为编码字节数，nextOffset 为下一段的起点
+bool rasterEncodeChunk(uint16_t tileIndex, const uint16_t *pixels, uint16_t pixelOffset, uint8_t *out, uint16_t capacity,
+                       uint16_t &chunkOffset, uint16_t &length, uint16_t &nextOffset);
+
+// 解码一段数据，对每个非黑游程调用 emit；图块编号或数据越界时返回 false (越界之前的游程已输出)
+bool rasterDecodeChunk(uint16_t tileIndex, uint16_t chunkOffset, const uint8_t *data, uint16_t length, RasterRunFn emit);
+
+// 同上，但把游程写入画布 (只写落在画布内的像素)
+bool rasterDecodeChunkToCanvas(uint16_t tileIndex, uint16_t chunkOffset, const uint8_t *data, uint16_t length,
+                               const RasterCanvas_t &canvas);
+
+#endif // RASTER_SYNC_H
@@ -0,0 +1,101 @@
+#include "render_queue.h"
+#include "config.h"
+#include "spsc_queue.h"
+#include "scheduler.h"     // 放入命令后唤醒主循环
+#include "latency_stats.h" // 远端绘制延迟统计
+#include "ui_manager.h"    // clearScreenAndCache / 进度条
+#include "perf_counters.h" // 远端点速率和帧计数
+#include "esp_now_handler.h" // redrawUndoneRegion
+#include "mqtt_handler.h"    // 本机撤销/重做的记录通过 MQTT 发布
+#include <TFT_eSPI.h>
+
+extern TFT_eSPI tft;
+extern bool isScreenOn;                  // 来自 power_manager.cpp
+extern bool hasNewUpdateWhileScreenOff;  // 来自 power_manager.cpp
+
+static SpscQueue<RenderCommand_t, RENDER_QUEUE_SIZE> renderQueue;
+static RenderQueueStats_t renderStats = {0, 0, 0};
+
+void renderQueuePush(const RenderCommand_t &command)
+{
+    while (!renderQueue.push(command))
+    {
+        renderStats.producerWaits++;
+        schedulerSignal(SCHED_EVENT_RENDER);
+        vTaskDelay(1); // 等主循环取走一些命令
+    }
+    uint32_t depth = renderQueue.size();
+    if (depth > renderStats.maxDepth)
+        renderStats.maxDepth = depth;
+    schedulerSignal(SCHED_EVENT_RENDER);
+}
+
+// 绘制远端点 (ESP-NOW 和 MQTT 共用): 连线的起点由网络任务加入历史时按 stroke_previous 确定，
+// 与重播的画面相同，与几台设备的点交错到达的方式无关
+static void drawRemotePoint(const RenderCommand_t &command)
+{
+    const TouchData_t &point = command.point;
+    if (command.linked)
+    {
+        tft.drawLine(command.previousX, command.previousY, point.x, point.y, point.color);
+    }
+    else
+    {
+        tft.drawPixel(point.x, point.y, point.color);
+    }
+    latencyRecordSince(LATENCY_REMOTE_RENDER, command.receivedMicros);
+    perfCount(PERF_REMOTE_POINTS);
+    perfNoteDrawn();
+}
+
+static void executeCommand(const RenderCommand_t &command)
+{
+    perfNoteDrawn(); // 每种命令都会画屏 (远端点、清屏、进度条、撤销/重做的区域)
+    switch (command.type)
+    {
+    case RENDER_CMD_REMOTE_POINT:
+        drawRemotePoint(command);
+        break;
+    case RENDER_CMD_CLEAR_CANVAS:
+        clearScreenAndCache();
+        break;
+    case RENDER_CMD_SEND_PROGRESS:
+        updateSendProgress(command.current, command.total);
+        break;
+    case RENDER_CMD_RECEIVE_PROGRESS:
+        updateReceiveProgress(command.current, command.total);
+        break;
+    case RENDER_CMD_HIDE_SEND_PROGRESS:
+        hideSendProgress();
+        break;
+    case RENDER_CMD_HIDE_RECEIVE_PROGRESS:
+        hideReceiveProgress();
+        break;
+    case RENDER_CMD_REDRAW_REGION:
+        if (command.publishMqtt)
+            sendTombstoneMessage(command.point);
+        redrawUndoneRegion(command.region.x, command.region.y, command.region.w, command.region.h);
+        break;
+    }
+    if (command.notifyScreenOff && !isScreenOn)
+        hasNewUpdateWhileScreenOff = true;
+}
+
+void renderQueueDrain()
+{
+    RenderCommand_t command;
+    for (int i = 0; i < RENDER_DRAIN_BATCH; i++)
+    {
+        if (!renderQueue.pop(command))
+            return;
+        executeCommand(command);
+        renderStats.executed++;
+    }
+    if (!renderQueue.empty())
+        schedulerSignal(SCHED_EVENT_RENDER); // 先处理触摸和控件重绘，下一轮继续
+}
+
+void renderQueueGetStats(RenderQueueStats_t &out)
+{
+    out = renderStats;
+}
@@ -0,0 +1,58 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <Arduino.h>
+#include "drawing_history.h" // TouchData_t
+
+// 渲染命令队列 (网络任务 -> 主循环)
+// 屏幕只由主循环任务 (Arduino loopTask，核心 1) 绘制。网络任务 (核心 0) 处理同步消息时
+// 不直接调用 tft，而是把要画的远端点、清屏、进度条更新放入本队列，由主循环按顺序执行。
+// 队列满时网络任务等待 (背压)，不会丢弃远端笔迹。
+
+#define RENDER_QUEUE_SIZE 128     // 队列容量 (2 的幂)
+#define RENDER_DRAIN_BATCH 32     // 主循环每轮最多执行的命令数，剩余的下一轮继续 (保证本地触摸优先)
+
+enum RenderCommandType_e
+{
+    RENDER_CMD_REMOTE_POINT,          // 绘制一个远端点 (与历史中同一笔划的上一点连线)
+    RENDER_CMD_CLEAR_CANVAS,          // 清屏并重绘界面骨架
+    RENDER_CMD_SEND_PROGRESS,         // 更新发送进度条
+    RENDER_CMD_RECEIVE_PROGRESS,      // 更新接收进度条
+    RENDER_CMD_HIDE_SEND_PROGRESS,    // 隐藏发送进度条
+    RENDER_CMD_HIDE_RECEIVE_PROGRESS, // 隐藏接收进度条
+    RENDER_CMD_REDRAW_REGION,         // 撤销/重做了一个笔划 (或本机的点在历史中的连线与屏幕上的不同): 重绘它所在的区域
+};
+typedef enum RenderCommandType_e RenderCommandType_t;
+
+typedef struct RenderCommand_s
+{
+    RenderCommandType_t type;
+    TouchData_t point;       // RENDER_CMD_REMOTE_POINT；RENDER_CMD_REDRAW_REGION: 撤销/重做记录
+    bool linked;             // RENDER_CMD_REMOTE_POINT: 是否与 (previousX, previousY) 连线，否则只画一个点
+    int previousX;           // RENDER_CMD_REMOTE_POINT: 网络任务加入历史时取的 DrawingHistory::stroke_previous
+    int previousY;
+    uint32_t receivedMicros; // RENDER_CMD_REMOTE_POINT: 收到消息时的 micros() (远端绘制延迟统计)
+    int current;             // 进度条: 当前值
+    int total;               // 进度条: 总数
+    bool notifyScreenOff;    // 息屏时是否点亮呼吸灯提示有新内容
+    HistoryRect_t region;    // RENDER_CMD_REDRAW_REGION: 要重绘的区域
+    bool publishMqtt;        // RENDER_CMD_REDRAW_REGION: 本机的撤销/重做，主循环通过 MQTT 发布记录
+} RenderCommand_t;
+
+// 渲染队列统计
+typedef struct RenderQueueStats_s
+{
+    uint32_t executed;       // 已执行的命令数
+    uint32_t maxDepth;       // 观察到的最大队列深度
+    uint32_t producerWaits;  // 队列满时网络任务等待的次数
+} RenderQueueStats_t;
+
+// 网络任务调用: 放入命令并唤醒主循环，队列满时阻塞等待
+void renderQueuePush(const RenderCommand_t &command);
+
+// 主循环调用: 执行至多 RENDER_DRAIN_BATCH 条命令
+void renderQueueDrain();
+
+void renderQueueGetStats(RenderQueueStats_t &out);
+
+#endif // RENDER_QUEUE_H
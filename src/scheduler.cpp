@@ -0,0 +1,261 @@
+#include "scheduler.h"
+#include <atomic>
+#include <algorithm> // 用于 std::fill / std::min
+
+static_assert((SCHED_WHEEL_SLOTS & (SCHED_WHEEL_SLOTS - 1)) == 0, "时间轮槽数必须是 2 的幂");
+static_assert(SCHED_MAX_TASKS <= 127, "任务编号使用 int8_t");
+
+enum SchedulerTaskKind_e
+{
+    SCHED_TASK_FREE,     // 空闲表项
+    SCHED_TASK_PERIODIC, // 周期任务 (挂在时间轮上)
+    SCHED_TASK_ONE_SHOT, // 单次任务 (挂在时间轮上)
+    SCHED_TASK_EVENT,    // 事件处理函数 (不在时间轮上)
+};
+
+typedef struct SchedulerTask_s
+{
+    const char *name;
+    SchedulerTaskFn fn;
+    uint8_t kind;         // SchedulerTaskKind_e
+    bool cancelled;       // 已注销的定时任务，等所在的槽被处理时再回收表项
+    int8_t next;          // 同一槽中的下一个任务 (-1 表示链表结束)
+    uint32_t periodTicks; // 周期 (节拍)，仅周期任务
+    uint32_t dueTick;     // 下次到期的节拍
+    uint32_t eventMask;   // 关注的事件，仅事件处理函数
+    SchedulerTaskStats_t stats;
+} SchedulerTask_t;
+
+static SchedulerTask_t tasks[SCHED_MAX_TASKS];
+static int8_t wheel[SCHED_WHEEL_SLOTS];           // 每个槽的任务链表头
+static uint32_t currentTick = 0;                   // 已处理到的节拍
+static uint32_t clockTick = 0;                     // 由 millis() 累加出的当前节拍 (millis() 回绕时也连续)
+static unsigned long clockTickStartMs = 0;         // clockTick 对应的 millis() 起点
+static TaskHandle_t mainTaskHandle = nullptr;      // 被唤醒的主循环任务
+static std::atomic<uint32_t> pendingEvents(0);     // 尚未处理的事件位 (其他任务写入)
+
+// 空闲统计
+static uint64_t idleUs = 0;
+static unsigned long statsStartMs = 0;
+
+// 把 millis() 的增量折算为节拍
+static uint32_t updateClock()
+{
+    unsigned long elapsedMs = millis() - clockTickStartMs;
+    uint32_t elapsedTicks = elapsedMs / SCHED_TICK_MS;
+    clockTick += elapsedTicks;
+    clockTickStartMs += elapsedTicks * SCHED_TICK_MS;
+    return clockTick;
+}
+
+static uint32_t msToTicks(uint32_t ms)
+{
+    uint32_t ticks = (ms + SCHED_TICK_MS - 1) / SCHED_TICK_MS;
+    return ticks == 0 ? 1 : ticks;
+}
+
+static void insertIntoWheel(SchedulerTaskId_t id)
+{
+    uint32_t slot = tasks[id].dueTick & (SCHED_WHEEL_SLOTS - 1);
+    tasks[id].next = wheel[slot];
+    wheel[slot] = id;
+}
+
+static SchedulerTaskId_t allocateTask(const char *name, SchedulerTaskFn fn, uint8_t kind)
+{
+    for (int id = 0; id < SCHED_MAX_TASKS; id++)
+    {
+        SchedulerTask_t &task = tasks[id];
+        if (task.kind != SCHED_TASK_FREE)
+            continue;
+        memset(&task, 0, sizeof(task));
+        task.name = name;
+        task.fn = fn;
+        task.kind = kind;
+        task.next = -1;
+        return (SchedulerTaskId_t)id;
+    }
+    Serial.printf("调度器任务表已满，无法注册 %s\n", name);
+    return SCHED_INVALID_TASK;
+}
+
+static SchedulerTaskId_t addTimer(const char *name, uint8_t kind, uint32_t delayMs, uint32_t periodMs, SchedulerTaskFn fn)
+{
+    SchedulerTaskId_t id = allocateTask(name, fn, kind);
+    if (id == SCHED_INVALID_TASK)
+        return id;
+    tasks[id].periodTicks = msToTicks(periodMs);
+    tasks[id].dueTick = updateClock() + msToTicks(delayMs);
+    insertIntoWheel(id);
+    return id;
+}
+
+static void runTask(SchedulerTask_t &task, uint32_t lateMs)
+{
+    uint32_t startUs = micros();
+    task.fn();
+    uint32_t elapsedUs = micros() - startUs;
+
+    task.stats.runs++;
+    task.stats.totalUs += elapsedUs;
+    task.stats.maxUs = std::max(task.stats.maxUs, elapsedUs);
+    task.stats.maxLateMs = std::max(task.stats.maxLateMs, lateMs);
+}
+
+void schedulerInit()
+{
+    mainTaskHandle = xTaskGetCurrentTaskHandle();
+    std::fill(wheel, wheel + SCHED_WHEEL_SLOTS, (int8_t)-1);
+    clockTickStartMs = millis();
+    clockTick = 0;
+    currentTick = 0;
+    statsStartMs = clockTickStartMs;
+}
+
+SchedulerTaskId_t schedulerAddPeriodic(const char *name, uint32_t periodMs, SchedulerTaskFn fn, uint32_t firstDelayMs)
+{
+    return addTimer(name, SCHED_TASK_PERIODIC, firstDelayMs, periodMs, fn);
+}
+
+SchedulerTaskId_t schedulerAddOneShot(const char *name, uint32_t delayMs, SchedulerTaskFn fn)
+{
+    return addTimer(name, SCHED_TASK_ONE_SHOT, delayMs, 0, fn);
+}
+
+SchedulerTaskId_t schedulerOnEvent(const char *name, uint32_t eventMask, SchedulerTaskFn fn)
+{
+    SchedulerTaskId_t id = allocateTask(name, fn, SCHED_TASK_EVENT);
+    if (id != SCHED_INVALID_TASK)
+        tasks[id].eventMask = eventMask;
+    return id;
+}
+
+void schedulerCancel(SchedulerTaskId_t id)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS || tasks[id].kind == SCHED_TASK_FREE)
+        return;
+    if (tasks[id].kind == SCHED_TASK_EVENT)
+        tasks[id].kind = SCHED_TASK_FREE;
+    else
+        tasks[id].cancelled = true; // 还挂在时间轮上，处理到该槽时回收
+}
+
+void schedulerSignal(uint32_t eventMask)
+{
+    pendingEvents.fetch_or(eventMask, std::memory_order_release);
+    if (mainTaskHandle != nullptr)
+        xTaskNotifyGive(mainTaskHandle);
+}
+
+void schedulerRunPending()
+{
+    // 1. 事件处理函数
+    uint32_t events = pendingEvents.exchange(0, std::memory_order_acquire);
+    if (events != 0)
+    {
+        for (SchedulerTask_t &task : tasks)
+        {
+            if (task.kind == SCHED_TASK_EVENT && (task.eventMask & events) != 0)
+                runTask(task, 0);
+        }
+    }
+
+    // 2. 推进时间轮，逐个节拍处理对应的槽 (落后超过一圈时每个槽只需处理一次)
+    uint32_t targetTick = updateClock();
+    if (targetTick - currentTick > SCHED_WHEEL_SLOTS)
+        currentTick = targetTick - SCHED_WHEEL_SLOTS;
+
+    while (currentTick != targetTick)
+    {
+        currentTick++;
+        uint32_t slot = currentTick & (SCHED_WHEEL_SLOTS - 1);
+        int8_t id = wheel[slot];
+        wheel[slot] = -1;
+
+        while (id != -1)
+        {
+            SchedulerTask_t &task = tasks[id];
+            int8_t next = task.next;
+
+            if (task.cancelled)
+            {
+                task.kind = SCHED_TASK_FREE;
+            }
+            else if ((int32_t)(task.dueTick - currentTick) > 0)
+            {
+                insertIntoWheel(id); // 还没到期，等时间轮再转一圈
+            }
+            else
+            {
+                runTask(task, (targetTick - task.dueTick) * SCHED_TICK_MS);
+                if (task.kind == SCHED_TASK_ONE_SHOT || task.cancelled)
+                {
+                    task.kind = SCHED_TASK_FREE;
+                }
+                else
+                {
+                    task.dueTick += task.periodTicks;
+                    if ((int32_t)(task.dueTick - targetTick) <= 0)
+                        task.dueTick = targetTick + task.periodTicks; // 落后太多时跳过错过的周期，不连续补跑
+                    insertIntoWheel(id);
+                }
+            }
+            id = next;
+        }
+    }
+}
+
+void schedulerWaitForWork()
+{
+    if (pendingEvents.load(std::memory_order_acquire) != 0)
+        return;
+
+    // 向前找第一个非空槽 (可能是还要转几圈的任务，届时提前醒来一次，无害)
+    uint32_t nowTick = updateClock();
+    uint32_t maxTicks = SCHED_MAX_WAIT_MS / SCHED_TICK_MS;
+    uint32_t wakeTick = currentTick + maxTicks;
+    for (uint32_t i = 1; i <= std::min<uint32_t>(maxTicks, SCHED_WHEEL_SLOTS); i++)
+    {
+        if (wheel[(currentTick + i) & (SCHED_WHEEL_SLOTS - 1)] != -1)
+        {
+            wakeTick = currentTick + i;
+            break;
+        }
+    }
+    if ((int32_t)(wakeTick - nowTick) <= 0)
+        return;
+
+    long waitMs = (long)(wakeTick - nowTick) * SCHED_TICK_MS - (long)(millis() - clockTickStartMs);
+    if (waitMs <= 0)
+        return;
+
+    uint32_t startUs = micros();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    idleUs += micros() - startUs;
+}
+
+void schedulerResetStats()
+{
+    for (SchedulerTask_t &task : tasks)
+        memset(&task.stats, 0, sizeof(task.stats));
+    idleUs = 0;
+    statsStartMs = millis();
+}
+
+void schedulerPrintStats(Print &out)
+{
+    unsigned long windowMs = millis() - statsStartMs;
+    out.println("task           runs      avg(us)   max(us)   late(ms)");
+    for (const SchedulerTask_t &task : tasks)
+    {
+        if (task.kind == SCHED_TASK_FREE)
+            continue;
+        unsigned long avgUs = task.stats.runs > 0 ? (unsigned long)(task.stats.totalUs / task.stats.runs) : 0;
+        out.printf("%-14s %-9lu %-9lu %-9lu %lu\n", task.name, (unsigned long)task.stats.runs, avgUs,
+                   (unsigned long)task.stats.maxUs, (unsigned long)task.stats.maxLateMs);
+    }
+    if (windowMs > 0)
+    {
+        out.printf("main loop idle %lu%% over %lus\n", (unsigned long)(idleUs / 10 / windowMs), windowMs / 1000);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// 主循环协作式调度器 (时间轮)
+// 周期任务和单次任务按到期节拍挂在时间轮的槽上，每个节拍只检查当前槽；
+// 其他任务 (触摸采样任务、网络任务) 通过 schedulerSignal() 置事件位并唤醒主循环。
+// 没有到期任务也没有事件时，主循环任务阻塞在任务通知上 (CPU 进入空闲，不再空转)。
+// 所有任务函数都在主循环任务中执行，互相之间不会抢占，不需要加锁。
+
+#define SCHED_TICK_MS 10         // 时间轮节拍 (毫秒)，定时精度
+#define SCHED_WHEEL_SLOTS 64     // 时间轮槽数 (2 的幂)，一圈 640ms，更长的延时多转几圈
+#define SCHED_MAX_TASKS 16       // 定时任务 + 事件处理函数的总数上限
+#define SCHED_MAX_WAIT_MS 1000   // 单次阻塞的最长时间 (毫秒)
+
+typedef void (*SchedulerTaskFn)();
+
+typedef int8_t SchedulerTaskId_t; // 任务编号，注册失败时为 SCHED_INVALID_TASK
+#define SCHED_INVALID_TASK ((SchedulerTaskId_t)-1)
+
+// 事件位 (可按位或组合)
+enum SchedulerEvent_e
+{
+    SCHED_EVENT_TOUCH = 1 << 0, // 触摸采样任务放入了新样本
+    SCHED_EVENT_RENDER = 1 << 1, // 网络任务放入了渲染命令
+};
+typedef enum SchedulerEvent_e SchedulerEvent_t;
+
+// 每个任务的运行统计
+typedef struct SchedulerTaskStats_s
+{
+    uint32_t runs;      // 执行次数
+    uint64_t totalUs;   // 累计耗时 (微秒)
+    uint32_t maxUs;     // 单次最长耗时 (微秒)
+    uint32_t maxLateMs; // 相对计划时间的最大延后 (毫秒，仅定时任务)
+} SchedulerTaskStats_t;
+
+// 在主循环任务中调用一次 (setup 中)，记录要唤醒的任务
+void schedulerInit();
+
+// 注册周期任务，首次在 firstDelayMs 后执行，之后每 periodMs 执行一次
+SchedulerTaskId_t schedulerAddPeriodic(const char *name, uint32_t periodMs, SchedulerTaskFn fn, uint32_t firstDelayMs = 0);
+
+// 注册单次任务，delayMs 后执行一次，执行后自动注销
+SchedulerTaskId_t schedulerAddOneShot(const char *name, uint32_t delayMs, SchedulerTaskFn fn);
+
+// 注册事件处理函数，eventMask 中任一事件发生时执行
+SchedulerTaskId_t schedulerOnEvent(const char *name, uint32_t eventMask, SchedulerTaskFn fn);
+
+// 注销任务 (尚未执行的单次任务不再执行)
+void schedulerCancel(SchedulerTaskId_t id);
+
+// 置事件位并唤醒主循环，可在其他任务中调用 (不可在中断中调用)
+void schedulerSignal(uint32_t eventMask);
+
+// 执行所有已发生事件的处理函数和已到期的定时任务，不阻塞
+void schedulerRunPending();
+
+// 阻塞直到下一个定时任务到期或有事件发生
+void schedulerWaitForWork();
+
+// 打印各任务的执行次数、平均/最长耗时和空闲比例
+void schedulerPrintStats(Print &out);
+
+// 清空运行统计
+void schedulerResetStats();
+
+#endif // SCHEDULER_H
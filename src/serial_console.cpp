@@ -0,0 +1,296 @@
+#include "serial_console.h"
+#include "latency_stats.h"
+#include "scheduler.h"
+#include "stress_test.h"
+#include "power_manager.h"
+#include "canvas_store.h"
+#include "esp_now_handler.h"
+#include "touch_trace.h"
+#include "perf_counters.h"
+#include "alloc_audit.h"
+#include "memory_tier.h"
+#include "canvas_framebuffer.h"
+#include "wifi_manager.h" // undo/redo: WiFi 连接时改由 MQTT 发布
+#include "touch_handler.h" // filter: 触摸点滤波参数
+
+static char lineBuffer[SERIAL_CONSOLE_LINE_MAX + 1];
+static size_t lineLength = 0;
+
+static void commandHelp(const char *args);
+
+// lat        打印延迟直方图
+// lat reset  清空延迟直方图
+static void commandLatency(const char *args)
+{
+    if (strcmp(args, "reset") == 0)
+    {
+        latencyReset();
+        Serial.println("latency histograms cleared");
+        return;
+    }
+    latencyPrint(Serial);
+}
+
+// sched        打印主循环调度器各任务的耗时和空闲比例
+// sched reset  清空调度器统计
+static void commandScheduler(const char *args)
+{
+    if (strcmp(args, "reset") == 0)
+    {
+        schedulerResetStats();
+        Serial.println("scheduler stats cleared");
+        return;
+    }
+    schedulerPrintStats(Serial);
+}
+
+// stress [秒数]  边画边全量同步的压力测试，结束后打印丢弃计数和延迟
+static void commandStress(const char *args)
+{
+    long seconds = atol(args);
+    stressTestStart(seconds > 0 ? (uint32_t)seconds : STRESS_DEFAULT_SECONDS);
+}
+
+// power  打印屏幕状态和浅睡眠统计
+static void commandPower(const char *args)
+{
+    (void)args;
+    powerManagerPrintStats(Serial);
+}
+
+// store  打印画布持久化统计 (启动恢复耗时、写入次数、闪存用量)
+static void commandStore(const char *args)
+{
+    (void)args;
+    canvasStorePrintStats(Serial);
+}
+
+// compact      打印历史压缩统计
+// compact now  下次空闲时立即压缩
+static void commandCompact(const char *args)
+{
+    if (strcmp(args, "now") == 0)
+    {
+        historyCompactRequest();
+        Serial.println("history compaction requested (runs once nobody is drawing)");
+        return;
+    }
+    historyCompactPrintStats(Serial);
+}
+
+// budget       打印历史内存预算、用量和展平统计
+// budget <KB>  修改预算 (不保存)，budget 0 恢复默认
+static void commandBudget(const char *args)
+{
+    if (*args != '\0')
+    {
+        historyBudgetSet((size_t)strtoul(args, nullptr, 10) * 1024);
+        Serial.printf("history budget set to %lu bytes\n", (unsigned long)historyBudgetBytes());
+        return;
+    }
+    historyBudgetPrintStats(Serial);
+}
+
+// undo  撤销本机最近画的笔划 (与撤销按钮相同)
+// redo  重做最近撤销的笔划
+static void commandUndo(const char *args)
+{
+    (void)args;
+    NetworkOp_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = NET_OP_UNDO;
+    op.broadcast = !isWifiConnected(); // WiFi 连接时由主循环通过 MQTT 发布
+    networkSubmit(op);
+}
+
+static void commandRedo(const char *args)
+{
+    (void)args;
+    NetworkOp_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = NET_OP_REDO;
+    op.broadcast = !isWifiConnected();
+    networkSubmit(op);
+}
+
+// filter                             打印触摸点滤波参数
+// filter <mincutoff> <beta> <dcutoff>  修改参数 (不保存)，filter default 恢复默认
+static void commandFilter(const char *args)
+{
+    if (strcmp(args, "default") == 0)
+    {
+        OneEuroParams_t defaults = {TOUCH_FILTER_MIN_CUTOFF, TOUCH_FILTER_BETA, TOUCH_FILTER_D_CUTOFF};
+        touchFilterSetParams(defaults);
+    }
+    else if (*args != '\0')
+    {
+        char *end;
+        OneEuroParams_t params;
+        params.minCutoff = strtof(args, &end);
+        params.beta = strtof(end, &end);
+        params.dCutoff = strtof(end, &end);
+        while (*end == ' ')
+            end++;
+        if (*end != '\0' || !(params.minCutoff > 0.0f) || !(params.beta >= 0.0f) || !(params.dCutoff > 0.0f))
+        {
+            Serial.println("usage: filter <mincutoff Hz > 0> <beta >= 0> <dcutoff Hz > 0>");
+            return;
+        }
+        touchFilterSetParams(params);
+    }
+    Serial.printf("touch filter: mincutoff %.3f Hz, beta %.5f, dcutoff %.3f Hz\n", touchFilterParams.minCutoff,
+                  touchFilterParams.beta, touchFilterParams.dCutoff);
+}
+
+// trace          打印轨迹状态和最近一次回放的结果
+// trace rec      开始录制触摸样本
+// trace stop     结束录制或中止回放
+// trace play     回放轨迹 (代替触摸屏读数)，结束后打印报告
+// trace dump     以 "TRACE,偏移,base64" 行导出
+// trace put [b]  导入一行 base64 (不带参数时开始新的导入)
+// trace save     保存到 LittleFS
+// trace load     从 LittleFS 读取
+static void commandTrace(const char *args)
+{
+    if (strcmp(args, "rec") == 0)
+        touchTraceStartRecording(Serial);
+    else if (strcmp(args, "stop") == 0)
+        touchTraceStop(Serial);
+    else if (strcmp(args, "play") == 0)
+        touchTraceStartReplay(Serial);
+    else if (strcmp(args, "dump") == 0)
+        touchTraceDump(Serial);
+    else if (strncmp(args, "put", 3) == 0 && (args[3] == '\0' || args[3] == ' '))
+        touchTracePut(args[3] == ' ' ? args + 4 : args + 3, Serial);
+    else if (strcmp(args, "save") == 0)
+        touchTraceSave(Serial);
+    else if (strcmp(args, "load") == 0)
+        touchTraceLoad(Serial);
+    else
+        touchTracePrintInfo(Serial);
+}
+
+// perf  打印一行性能计数器快照 (速率、帧耗时、堆、队列高水位、按消息类型的收发帧数)
+static void commandPerf(const char *args)
+{
+    (void)args;
+    perfPrint(Serial);
+}
+
+// mem  打印内部 SRAM / PSRAM 用量、绘图历史分块所在的层和画布帧缓冲状态
+static void commandMemory(const char *args)
+{
+    (void)args;
+    MemoryTierStats_t tiers;
+    CanvasFramebufferStats_t framebuffer;
+    memoryTierGetStats(tiers);
+    historyLock();
+    size_t points = allDrawingHistory.size();
+    size_t chunks = allDrawingHistory.chunk_count();
+    size_t coldChunks = allDrawingHistory.cold_chunk_count();
+    canvasFramebufferGetStats(framebuffer);
+    historyUnlock();
+    Serial.printf("internal: free %lu, largest block %lu\n", (unsigned long)tiers.internalFree, (unsigned long)tiers.internalMaxBlock);
+    if (tiers.psramSize > 0)
+        Serial.printf("psram: size %lu, free %lu, largest block %lu\n", (unsigned long)tiers.psramSize,
+                      (unsigned long)tiers.psramFree, (unsigned long)tiers.psramMaxBlock);
+    else
+        Serial.println("psram: not found");
+    Serial.printf("history: %lu points in %lu chunks (%lu in psram)\n", (unsigned long)points, (unsigned long)chunks,
+                  (unsigned long)coldChunks);
+    if (framebuffer.enabled)
+        Serial.printf("canvas framebuffer: %lu points rendered, %lu rebuilds, %lu pushes (last %lu us)\n",
+                      (unsigned long)framebuffer.rendered, (unsigned long)framebuffer.rebuilds,
+                      (unsigned long)framebuffer.pushes, (unsigned long)framebuffer.lastPushUs);
+    else
+        Serial.println("canvas framebuffer: disabled (needs psram)");
+}
+
+// alloc        按调用点打印堆分配统计 (需 ALLOC_AUDIT 为 1)
+// alloc reset  清空统计
+static void commandAlloc(const char *args)
+{
+    if (strcmp(args, "reset") == 0)
+    {
+        allocAuditReset();
+        Serial.println("allocation audit cleared");
+        return;
+    }
+    allocAuditPrint(Serial);
+}
+
+static const SerialCommand_t commands[] = {
+    {"help", "list commands", commandHelp},
+    {"lat", "print touch-to-photon latency histograms ('lat reset' clears them)", commandLatency},
+    {"sched", "print main loop task costs and idle time ('sched reset' clears them)", commandScheduler},
+    {"perf", "print a one-line counters snapshot (rates, frame time, heap, queue high-water, frames per type)", commandPerf},
+    {"mem", "print internal/psram usage, history chunk placement and canvas framebuffer stats", commandMemory},
+    {"alloc", "print heap allocations per call site ('alloc reset' clears them; needs ALLOC_AUDIT 1)", commandAlloc},
+    {"power", "print screen state and light-sleep statistics", commandPower},
+    {"store", "print canvas persistence stats (boot restore time, flash writes)", commandStore},
+    {"compact", "print history compaction stats ('compact now' runs it at the next idle moment)", commandCompact},
+    {"budget", "print history memory budget and flattening stats ('budget <KB>' changes it until reboot)", commandBudget},
+    {"undo", "undo this device's most recent stroke (same as the '<' button)", commandUndo},
+    {"redo", "redo the most recently undone stroke", commandRedo},
+    {"filter", "print or set the One Euro touch filter ('filter <mincutoff> <beta> <dcutoff>', 'filter default')", commandFilter},
+    {"trace", "record/replay raw touch samples ('trace rec|stop|play|dump|put|save|load')", commandTrace},
+    {"stress", "draw a synthetic stroke during a full sync and report drops ('stress [seconds]')", commandStress},
+};
+
+static void commandHelp(const char *args)
+{
+    (void)args;
+    for (const SerialCommand_t &command : commands)
+    {
+        Serial.printf("%-8s %s\n", command.name, command.help);
+    }
+}
+
+static void executeLine(char *line)
+{
+    size_t length = strlen(line);
+    while (length > 0 && line[length - 1] == ' ')
+        line[--length] = '\0';
+    while (*line == ' ')
+        line++;
+    if (*line == '\0')
+        return;
+
+    char *args = line;
+    while (*args != '\0' && *args != ' ')
+        args++;
+    if (*args == ' ')
+    {
+        *args++ = '\0';
+        while (*args == ' ')
+            args++;
+    }
+
+    for (const SerialCommand_t &command : commands)
+    {
+        if (strcmp(line, command.name) == 0)
+        {
+            command.handler(args);
+            return;
+        }
+    }
+    Serial.printf("unknown command: %s (try 'help')\n", line);
+}
+
+void serialConsolePoll()
+{
+    while (Serial.available() > 0)
+    {
+        char c = (char)Serial.read();
+        if (c == '\r' || c == '\n')
+        {
+            lineBuffer[lineLength] = '\0';
+            executeLine(lineBuffer);
+            lineLength = 0;
+        }
+        else if (lineLength < SERIAL_CONSOLE_LINE_MAX)
+        {
+            lineBuffer[lineLength++] = c;
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+#include <Arduino.h>
+
+// 串口调试命令行
+// 在主循环中调用 serialConsolePoll()，非阻塞地读取串口输入，收到完整一行后执行对应命令。
+// 输入 "help" 列出所有命令。
+
+#define SERIAL_CONSOLE_LINE_MAX 64 // 单行命令最大长度
+
+// 命令处理函数，args 为命令名之后的参数 (已去掉前导空格，可能为空字符串)
+typedef void (*SerialCommandFn)(const char *args);
+
+typedef struct SerialCommand_s
+{
+    const char *name;    // 命令名
+    const char *help;    // 帮助说明
+    SerialCommandFn handler;
+} SerialCommand_t;
+
+// 读取串口输入并执行完整的命令行
+void serialConsolePoll();
+
+#endif // SERIAL_CONSOLE_H
@@ -0,0 +1,64 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// 单生产者单消费者无锁环形队列
+// 只允许一个任务调用 push，另一个任务调用 pop；两端各自只写自己的索引，
+// 通过 acquire/release 内存序发布数据，不需要互斥锁或关中断。
+// Capacity 必须是 2 的幂 (索引用掩码取模)，实际可存放 Capacity 个元素。
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue 容量必须是 2 的幂");
+
+public:
+    SpscQueue() : head(0), tail(0), highWater(0) {}
+
+    // 生产者调用。队列已满时返回 false (元素被丢弃)
+    bool push(const T &item)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if (h - t >= Capacity)
+            return false;
+        buffer[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        if (h + 1 - t > highWater.load(std::memory_order_relaxed))
+            highWater.store(h + 1 - t, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 消费者调用。队列为空时返回 false
+    bool pop(T &item)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        if (t == h)
+            return false;
+        item = buffer[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 当前元素数 (仅供统计，另一端并发修改时只是近似值)
+    size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // 启动以来入队后观察到的最大元素数 (仅供统计)
+    size_t maxSize() const { return highWater.load(std::memory_order_relaxed); }
+
+private:
+    T buffer[Capacity];
+    std::atomic<uint32_t> head; // 下一个写入位置 (只由生产者修改)
+    std::atomic<uint32_t> tail; // 下一个读取位置 (只由消费者修改)
+    std::atomic<uint32_t> highWater; // 最大元素数 (只由生产者修改)
+};
+
+#endif // SPSC_QUEUE_H
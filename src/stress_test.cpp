@@ -0,0 +1,78 @@
+#include "stress_test.h"
+#include "touch_handler.h"   // 合成笔迹、采样丢弃计数
+#include "esp_now_handler.h" // 网络任务操作与统计
+#include "render_queue.h"    // 渲染队列统计
+#include "scheduler.h"       // 分阶段的单次任务、主循环任务耗时
+#include "latency_stats.h"   // 延迟直方图
+
+static bool stressRunning = false;
+static uint32_t stressDurationMs = 0;
+
+// 同步开始时的计数快照
+static TouchTaskStats_t touchAtSync;
+static NetworkTaskStats_t networkAtSync;
+static RenderQueueStats_t renderAtSync;
+
+static void stressReport()
+{
+    TouchTaskStats_t touch;
+    NetworkTaskStats_t network;
+    RenderQueueStats_t render;
+    touchTaskGetStats(touch);
+    networkTaskGetStats(network);
+    renderQueueGetStats(render);
+
+    Serial.println("=== stress test report ===");
+    Serial.printf("duration             %lus drawing during sync\n", (unsigned long)(stressDurationMs / 1000));
+    Serial.printf("touch samples dropped %lu (sample queue full)\n",
+                  (unsigned long)(touch.droppedSamples - touchAtSync.droppedSamples));
+    Serial.printf("points dropped       %lu (network op queue full)\n",
+                  (unsigned long)(network.opsDropped - networkAtSync.opsDropped));
+    Serial.printf("radio rx dropped     %lu, malformed %lu\n", (unsigned long)(network.rxDropped - networkAtSync.rxDropped),
+                  (unsigned long)(network.rxMalformed - networkAtSync.rxMalformed));
+    Serial.printf("history points sent  %lu, full syncs completed %lu (raster %lu)%s\n",
+                  (unsigned long)(network.historyPointsSent - networkAtSync.historyPointsSent),
+                  (unsigned long)(network.fullSyncsSent - networkAtSync.fullSyncsSent),
+                  (unsigned long)(network.rasterSyncsSent - networkAtSync.rasterSyncsSent),
+                  isSendingDrawingData ? " (still sending)" : "");
+    Serial.printf("render commands      %lu, max depth %lu, producer waits %lu\n",
+                  (unsigned long)(render.executed - renderAtSync.executed), (unsigned long)render.maxDepth,
+                  (unsigned long)(render.producerWaits - renderAtSync.producerWaits));
+    Serial.printf("touch sample rate    %luHz, jitter max %luus\n",
+                  (unsigned long)touch.sampleRateHz, (unsigned long)touch.jitterMaxUs);
+    latencyPrint(Serial);
+    schedulerPrintStats(Serial);
+    stressRunning = false;
+}
+
+static void stressBeginSync()
+{
+    latencyReset();
+    schedulerResetStats();
+    touchTaskGetStats(touchAtSync);
+    networkTaskGetStats(networkAtSync);
+    renderQueueGetStats(renderAtSync);
+
+    NetworkOp_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = NET_OP_FULL_SYNC;
+    networkSubmit(op);
+    Serial.printf("stress: full sync started, drawing for %lus more\n", (unsigned long)(stressDurationMs / 1000));
+}
+
+void stressTestStart(uint32_t seconds)
+{
+    if (stressRunning)
+    {
+        Serial.println("stress: a test is already running");
+        return;
+    }
+    stressRunning = true;
+    stressDurationMs = seconds * 1000UL;
+
+    touchTaskSynthesize(STRESS_PREFILL_MS + stressDurationMs);
+    schedulerAddOneShot("stress_sync", STRESS_PREFILL_MS, stressBeginSync);
+    schedulerAddOneShot("stress_report", STRESS_PREFILL_MS + stressDurationMs + STRESS_SETTLE_MS, stressReport);
+    Serial.printf("stress: drawing for %lus to build up history before the sync starts\n",
+                  (unsigned long)(STRESS_PREFILL_MS / 1000));
+}
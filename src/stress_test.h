@@ -0,0 +1,19 @@
+#ifndef STRESS_TEST_H
+#define STRESS_TEST_H
+
+#include <Arduino.h>
+
+// 同步压力测试 (串口命令 "stress [秒数]")
+// 1. 采样任务输出合成笔迹 (屏幕中央画圈)，先画 STRESS_PREFILL_MS 积累历史；
+// 2. 网络任务像收到 REQUEST_ALL_DRAWINGS 一样分批发送全部历史，同时继续画 seconds 秒；
+// 3. 结束后打印各队列丢弃的样本/操作数、发送进度、延迟直方图和主循环各任务耗时。
+// 注意: 附近的对端会收到并绘制这些点。
+
+#define STRESS_DEFAULT_SECONDS 10 // 默认测试时长 (秒)
+#define STRESS_PREFILL_MS 10000   // 开始同步前先画多久 (毫秒)，200Hz 下约 2000 个点
+#define STRESS_SETTLE_MS 1000     // 画完后等待队列排空再出报告 (毫秒)
+
+// 开始测试 (已有测试在进行时忽略)
+void stressTestStart(uint32_t seconds);
+
+#endif // STRESS_TEST_H
@@ -0,0 +1,122 @@
+#include "stroke_index.h"
+#include <algorithm> // std::min, std::max, std::sort, std::unique
+
+StrokeTileIndex::StrokeTileIndex()
+{
+    clear();
+}
+
+void StrokeTileIndex::clear()
+{
+    StrokeIdList_t().swap(strokeStarts);
+    for (int i = 0; i < STROKE_INDEX_TILE_COUNT; i++)
+        StrokeIdList_t().swap(tileStrokes[i]);
+    indexedCount = 0;
+    visibleStartIndex = 0;
+}
+
+void StrokeTileIndex::mergeInto(uint32_t last)
+{
+    while (strokeStarts.size() > last + 1)
+        strokeStarts.pop_back();
+    for (int i = 0; i < STROKE_INDEX_TILE_COUNT; i++)
+    {
+        StrokeIdList_t &strokes = tileStrokes[i];
+        if (strokes.empty() || strokes.back() <= last)
+            continue;
+        while (!strokes.empty() && strokes.back() > last)
+            strokes.pop_back();
+        if (strokes.empty() || strokes.back() != last)
+            strokes.push_back(last);
+    }
+}
+
+void StrokeTileIndex::add(size_t index, int x, int y, bool isReset, size_t link, int linkX, int linkY)
+{
+    indexedCount = index + 1;
+    if (isReset)
+    {
+        // 复位之前的内容已被清屏，不再需要索引
+        StrokeIdList_t().swap(strokeStarts);
+        for (int i = 0; i < STROKE_INDEX_TILE_COUNT; i++)
+            StrokeIdList_t().swap(tileStrokes[i]);
+        visibleStartIndex = index + 1;
+        return;
+    }
+
+    int minX = x, maxX = x, minY = y, maxY = y;
+    if (link != 0 && !strokeStarts.empty())
+    {
+        // 与上一点连线: 线段属于上一点所在的笔划，之后开始的笔划并入它
+        size_t previous = index - link;
+        size_t stroke = strokeStarts.size() - 1;
+        while (stroke > 0 && strokeStarts[stroke] > previous)
+            stroke--;
+        if (stroke + 1 < strokeStarts.size())
+            mergeInto((uint32_t)stroke);
+        minX = std::min(minX, linkX);
+        maxX = std::max(maxX, linkX);
+        minY = std::min(minY, linkY);
+        maxY = std::max(maxY, linkY);
+    }
+    else
+    {
+        strokeStarts.push_back((uint32_t)index);
+    }
+
+    if (maxX < 0 || maxY < 0 || minX >= SCREEN_WIDTH || minY >= SCREEN_HEIGHT)
+        return; // 完全在屏幕外
+    // 按线段外接矩形登记 (触摸采样间距只有几个像素，多登记的格子很少)
+    uint32_t stroke = (uint32_t)(strokeStarts.size() - 1);
+    int firstColumn = std::max(minX, 0) / STROKE_INDEX_TILE_SIZE;
+    int lastColumn = std::min(maxX, SCREEN_WIDTH - 1) / STROKE_INDEX_TILE_SIZE;
+    int firstRow = std::max(minY, 0) / STROKE_INDEX_TILE_SIZE;
+    int lastRow = std::min(maxY, SCREEN_HEIGHT - 1) / STROKE_INDEX_TILE_SIZE;
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        for (int column = firstColumn; column <= lastColumn; column++)
+        {
+            StrokeIdList_t &strokes = tileStrokes[row * STROKE_INDEX_TILES_X + column];
+            if (strokes.empty() || strokes.back() != stroke)
+                strokes.push_back(stroke);
+        }
+    }
+}
+
+void StrokeTileIndex::strokesInRect(int x, int y, int w, int h, std::vector<uint32_t> &strokes) const
+{
+    strokes.clear();
+    int right = std::min(x + w, SCREEN_WIDTH) - 1;
+    int bottom = std::min(y + h, SCREEN_HEIGHT) - 1;
+    x = std::max(x, 0);
+    y = std::max(y, 0);
+    if (x > right || y > bottom)
+        return;
+
+    int firstColumn = x / STROKE_INDEX_TILE_SIZE;
+    int lastColumn = right / STROKE_INDEX_TILE_SIZE;
+    int firstRow = y / STROKE_INDEX_TILE_SIZE;
+    int lastRow = bottom / STROKE_INDEX_TILE_SIZE;
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        for (int column = firstColumn; column <= lastColumn; column++)
+        {
+            const StrokeIdList_t &tile = tileStrokes[row * STROKE_INDEX_TILES_X + column];
+            strokes.insert(strokes.end(), tile.begin(), tile.end());
+        }
+    }
+    // 多个格子的列表合并后按时间顺序去重
+    if (lastColumn > firstColumn || lastRow > firstRow)
+    {
+        std::sort(strokes.begin(), strokes.end());
+        strokes.erase(std::unique(strokes.begin(), strokes.end()), strokes.end());
+    }
+}
+
+size_t StrokeTileIndex::memoryBytes() const
+{
+    size_t bytes = strokeStarts.capacity() * sizeof(uint32_t);
+    for (int i = 0; i < STROKE_INDEX_TILE_COUNT; i++)
+        bytes += tileStrokes[i].capacity() * sizeof(uint32_t);
+    return bytes;
+}
@@ -0,0 +1,64 @@
+#ifndef STROKE_INDEX_H
+#define STROKE_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "config.h"
+#include "memory_tier.h" // PsramAllocator
+
+// 笔划空间索引 (DrawingHistory 在 push_back 时增量维护)
+// 把最后一个复位点之后的历史切分成连续的片段 (下称笔划)，任何连线都不跨过片段的边界: 不与之前的点连线的点开始新片段，
+// 几台设备同时作画、连线跨过了较晚的片段起点时把这些片段并入前面的片段。屏幕划分为 STROKE_INDEX_TILE_SIZE 的网格，
+// 每格按时间顺序记录经过它的笔划编号。局部重绘 (弹窗、调色盘关闭后) 只需按顺序重播与区域相交的格子里的笔划
+// (每个点照常与 DrawingHistory::stroke_previous 连线，连线起点总在同一片段内)，画面与全量重播相同，
+// 耗时取决于区域内的内容而不是历史总长度。撤销/重做不改变片段的划分 (已撤销的点同样登记，重播时跳过)。
+// 索引随历史增长且只在局部重绘时读取，有 PSRAM 时放在 PSRAM。
+// 本模块不依赖 Arduino，可在主机上编译。
+
+#define STROKE_INDEX_TILES_X ((SCREEN_WIDTH + STROKE_INDEX_TILE_SIZE - 1) / STROKE_INDEX_TILE_SIZE)
+#define STROKE_INDEX_TILES_Y ((SCREEN_HEIGHT + STROKE_INDEX_TILE_SIZE - 1) / STROKE_INDEX_TILE_SIZE)
+#define STROKE_INDEX_TILE_COUNT (STROKE_INDEX_TILES_X * STROKE_INDEX_TILES_Y)
+
+typedef std::vector<uint32_t, PsramAllocator<uint32_t>> StrokeIdList_t;
+
+class StrokeTileIndex
+{
+public:
+    StrokeTileIndex();
+
+    // 清空索引 (历史清空或重建前)
+    void clear();
+
+    // 历史追加了第 index 个点 (必须按顺序逐个调用)。link 为与之连线的上一点往前的距离 (0 表示不连线)，
+    // linkX/linkY 为上一点的坐标
+    void add(size_t index, int x, int y, bool isReset, size_t link, int linkX, int linkY);
+
+    // 历史追加的第 index 个元素是撤销/重做记录: 不属于任何笔划，也不打断前后的连线
+    void skip(size_t index) { indexedCount = index + 1; }
+
+    // 与矩形 (屏幕坐标) 相交的格子中的笔划编号，按时间顺序 (即重播顺序) 写入 strokes
+    void strokesInRect(int x, int y, int w, int h, std::vector<uint32_t> &strokes) const;
+
+    // 笔划 stroke 在历史中的范围 [strokeStart, strokeEnd)
+    size_t strokeStart(uint32_t stroke) const { return strokeStarts[stroke]; }
+    size_t strokeEnd(uint32_t stroke) const
+    {
+        return stroke + 1 < strokeStarts.size() ? strokeStarts[stroke + 1] : indexedCount;
+    }
+
+    size_t strokeCount() const { return strokeStarts.size(); }
+    size_t visibleStart() const { return visibleStartIndex; } // 最后一个复位点之后的第一个点
+    size_t memoryBytes() const;                                // 索引占用的堆内存 (近似)
+
+private:
+    // 合并编号大于 last 的笔划到 last (连线跨过了它们的起点)
+    void mergeInto(uint32_t last);
+
+    StrokeIdList_t strokeStarts;                         // 每个笔划第一个点在历史中的位置
+    StrokeIdList_t tileStrokes[STROKE_INDEX_TILE_COUNT]; // 每格经过的笔划编号 (递增)
+    size_t indexedCount;                                    // 已索引的点数 (= 历史长度)
+    size_t visibleStartIndex;
+};
+
+#endif // STROKE_INDEX_H
@@ -0,0 +1,83 @@
+#include "touch_filter.h"
+#include <math.h>
+
+#define TOUCH_FILTER_MIN_DT 0.001f // 两个样本时间戳相同时按 1ms 处理，避免除零
+
+// 一阶低通的平滑系数: alpha = 1 / (1 + tau / dt)，tau = 1 / (2π fc)
+static float smoothingFactor(float cutoffHz, float dt)
+{
+    float tau = 1.0f / (2.0f * (float)M_PI * cutoffHz);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+static float oneEuroStep(OneEuroAxis_t &axis, const OneEuroParams_t &params, float raw, float dt)
+{
+    if (!axis.primed)
+    {
+        axis.value = raw;
+        axis.derivative = 0.0f;
+        axis.primed = true;
+        return raw;
+    }
+
+    // 先平滑速度，再用速度决定本次的截止频率
+    float rawDerivative = (raw - axis.value) / dt;
+    float alphaD = smoothingFactor(params.dCutoff, dt);
+    axis.derivative += alphaD * (rawDerivative - axis.derivative);
+
+    float cutoff = params.minCutoff + params.beta * fabsf(axis.derivative);
+    float alpha = smoothingFactor(cutoff, dt);
+    axis.value += alpha * (raw - axis.value);
+    return axis.value;
+}
+
+// 已有样本的中值 (不足 3 个时取平均)
+static float medianOfHistory(const int16_t *history, uint8_t count)
+{
+    if (count == 1)
+        return history[0];
+    if (count == 2)
+        return (history[0] + history[1]) * 0.5f;
+
+    int16_t a = history[0], b = history[1], c = history[2];
+    if (a > b) { int16_t t = a; a = b; b = t; }
+    if (b > c) { b = c; }
+    return a > b ? a : b;
+}
+
+void touchFilterReset(TouchFilter_t &filter)
+{
+    filter.historyCount = 0;
+    filter.lastTimestamp = 0;
+    filter.axisX.primed = false;
+    filter.axisY.primed = false;
+}
+
+void touchFilterApply(TouchFilter_t &filter, const OneEuroParams_t &params,
+                      int16_t rawX, int16_t rawY, unsigned long timestampMs,
+                      float &outX, float &outY)
+{
+    // 3 点中值: 按时间顺序滑动
+    if (filter.historyCount == 3)
+    {
+        filter.historyX[0] = filter.historyX[1];
+        filter.historyX[1] = filter.historyX[2];
+        filter.historyY[0] = filter.historyY[1];
+        filter.historyY[1] = filter.historyY[2];
+        filter.historyCount = 2;
+    }
+    filter.historyX[filter.historyCount] = rawX;
+    filter.historyY[filter.historyCount] = rawY;
+    filter.historyCount++;
+
+    float medianX = medianOfHistory(filter.historyX, filter.historyCount);
+    float medianY = medianOfHistory(filter.historyY, filter.historyCount);
+
+    float dt = (timestampMs - filter.lastTimestamp) / 1000.0f;
+    if (dt < TOUCH_FILTER_MIN_DT)
+        dt = TOUCH_FILTER_MIN_DT;
+    filter.lastTimestamp = timestampMs;
+
+    outX = oneEuroStep(filter.axisX, params, medianX, dt);
+    outY = oneEuroStep(filter.axisY, params, medianY, dt);
+}
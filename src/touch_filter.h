@@ -0,0 +1,47 @@
+#ifndef TOUCH_FILTER_H
+#define TOUCH_FILTER_H
+
+#include <stdint.h>
+
+// 触摸点滤波 (自适应低通，One Euro 滤波器)
+// 处理流程: 3 点中值 (剔除 XPT2046 偶发的单点尖峰) -> 每轴一个 One Euro 滤波器。
+// One Euro 的截止频率随笔速变化: 慢速时截止频率低 (去抖)，快速时截止频率高 (减少滞后)，
+// 每个样本只需几次乘加，不需要像截尾平均那样攒满窗口再输出。
+// 本模块不依赖 Arduino，可在主机上编译 (见 tools/touch_filter_replay.cpp)。
+
+// 滤波参数 (坐标单位为原始 ADC 值，速度单位为 ADC 值/秒)
+typedef struct OneEuroParams_s
+{
+    float minCutoff; // 静止时的截止频率 (Hz)，越小越平滑、越滞后
+    float beta;      // 速度系数，越大则快速移动时截止频率提高越多 (滞后越小)
+    float dCutoff;   // 速度估计本身的截止频率 (Hz)
+} OneEuroParams_t;
+
+// 单轴 One Euro 滤波器状态
+typedef struct OneEuroAxis_s
+{
+    float value;      // 上一次滤波输出
+    float derivative; // 上一次平滑后的速度
+    bool primed;      // 是否已有初值
+} OneEuroAxis_t;
+
+// 一支笔的完整滤波状态
+typedef struct TouchFilter_s
+{
+    int16_t historyX[3];      // 最近 3 个原始样本 (中值用)
+    int16_t historyY[3];
+    uint8_t historyCount;     // 已有样本数 (最多 3)
+    unsigned long lastTimestamp; // 上一个样本的时间戳 (毫秒)
+    OneEuroAxis_t axisX;
+    OneEuroAxis_t axisY;
+} TouchFilter_t;
+
+// 新笔划开始前调用，清除所有历史
+void touchFilterReset(TouchFilter_t &filter);
+
+// 输入一个原始样本，输出滤波后的坐标 (每个样本都有输出，第一个样本原样输出)
+void touchFilterApply(TouchFilter_t &filter, const OneEuroParams_t &params,
+                      int16_t rawX, int16_t rawY, unsigned long timestampMs,
+                      float &outX, float &outY);
+
+#endif // TOUCH_FILTER_H
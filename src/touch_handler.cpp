@@ -8,12 +8,32 @@
 #include "drawing_history.h" // 包含自定义绘图历史头文件
 #include "wifi_manager.h"     // 用于 isWifiConnected()
 #include "mqtt_handler.h"     // 用于 sendDrawingData()
+#include "ui_widgets.h"       // 用于控件命中检测 (widgetDispatchTouch)
+#include "spsc_queue.h"       // 采样任务与主循环之间的无锁队列
+#include "touch_filter.h"     // One Euro 触摸点滤波
+#include "latency_stats.h"    // 触摸到屏幕延迟统计
+#include "scheduler.h"        // 有新样本时唤醒主循环
+#include "power_manager.h"    // 息屏时触摸点亮屏幕、记录本地操作
+#include "touch_trace.h"      // 轨迹录制/回放 (代替触摸屏读数)
+#include "perf_counters.h"    // 触摸点速率和帧计数
+#include <algorithm>          // 用于 std::min / std::max
+#include <atomic>
+#include <math.h>             // 合成笔迹 (压力测试)
+
+// 压力测试合成笔迹: 屏幕中央的圆 (原始 ADC 坐标)，避开左侧按钮和左下角调试信息框
+#define STRESS_STROKE_CENTER_X 1950
+#define STRESS_STROKE_CENTER_Y 2050
+#define STRESS_STROKE_RADIUS 600
+#define STRESS_STROKE_PERIOD_MS 2000 // 画一圈的时间
+#define STRESS_STROKE_PRESSURE 800
 
 // --- 静态 (文件局部) 全局变量，用于触摸处理状态 ---
 static TS_Point lastLocalPoint = {0, 0, 0};  // 本地最后一次触摸点坐标
 static unsigned long lastLocalTouchTime = 0; // 本地最后一次触摸事件的时间戳
 static bool wasTouching = false; // 用于检测提笔事件
 static std::vector<TouchData_t> currentStroke; // 用于缓存当前笔画
+static bool ignoreUntilPenUp = false; // 息屏时点亮屏幕、或已被按钮/弹窗处理的那次按压，提笔前的其余点都不处理
+static bool contactStarted = false; // 当前接触 (按下到提笔) 已处理过第一个点: 按钮只由接触的第一个点命中
 
 // 彩蛋相关变量，现为本模块局部变量
 static unsigned long lastResetTime = 0;
@@ -21,314 +41,373 @@ static int resetPressCount = 0;
 
 // --- 函数实现 ---
 
+// 复位按钮: 清空本地画布并通知对端 (需要访问本模块的彩蛋计数，因此由本模块注册)
+static void onResetButtonPressed(WidgetId_t id, int x, int y) {
+    (void)id;
+    (void)x;
+    (void)y;
+    unsigned long currentRawUptime = millis();
+    if (currentRawUptime - lastResetTime < 1000) { // 检查快速按下 (彩蛋)
+        resetPressCount++;
+    } else {
+        resetPressCount = 1;
+    }
+    lastResetTime = currentRawUptime;
+
+    if (resetPressCount >= 10) { // 彩蛋触发
+        Serial.println("Kurio Reiko thanks all the recognition and redistribution,");
+        Serial.println("but if someone commercializes this project without declaring Kurio Reiko's originality, then he is a bitch");
+        resetPressCount = 0; // 重置计数器
+    }
+
+    clearScreenAndCache();     // 调用UI管理器的清屏函数
+
+    // 清除本地绘图历史、重置ESP-NOW同步状态并广播复位消息，由网络任务 (历史的唯一写入者) 完成
+    NetworkOp_t resetOp;
+    resetOp.type = NET_OP_LOCAL_RESET;
+    resetOp.point.isReset = true;
+    resetOp.point.timestamp = currentRawUptime;
+    resetOp.point.x = 0; // 与复位无关
+    resetOp.point.y = 0; // 与复位无关
+    resetOp.point.color = currentColor; // currentColor 来自 ui_manager
+    resetOp.sampleMicros = 0;
+    resetOp.broadcast = !isWifiConnected(); // WiFi 连接时改由 MQTT 发送复位消息
+    networkSubmit(resetOp);
+
+    if (isWifiConnected()) {
+        sendResetMessage();
+    }
+
+    // 根据新的逻辑，不再将此复位操作作为点位记录到本地历史中。
+}
+
+// 撤销/重做按钮: 由网络任务在历史中查找本机最近的笔划，WiFi 连接时由主循环通过 MQTT 发布记录
+static void onUndoRedoButtonPressed(WidgetId_t id, int x, int y) {
+    (void)x;
+    (void)y;
+    NetworkOp_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = id == WIDGET_UNDO ? NET_OP_UNDO : NET_OP_REDO;
+    op.broadcast = !isWifiConnected();
+    networkSubmit(op);
+}
+
 void touchHandlerInit() {
-    // 如果将来需要任何触摸相关的特定初始化，则为占位符
-    // 例如：ts.setThreshold(某个值);
+    currentStroke.reserve(MQTT_STROKE_RESERVE_POINTS); // 启动时预留，作画时不再扩容 (笔画超过一条 MQTT 消息时除外)
+    // 复位按钮控件由 uiManagerInit 注册，这里接管其按下行为
+    widgetSetPressHandler(WIDGET_RESET, onResetButtonPressed);
+    widgetSetPressHandler(WIDGET_UNDO, onUndoRedoButtonPressed);
+    widgetSetPressHandler(WIDGET_REDO, onUndoRedoButtonPressed);
+}
+
+// --- 触摸采样任务 ---
+// XPT2046 与 TFT 分别挂在独立的 SPI 总线上 (mySpi / TFT_eSPI)，采样任务读取触摸屏不会与绘图冲突。
+static SpscQueue<RawTouchSample_t, TOUCH_QUEUE_SIZE> touchSampleQueue; // 采样任务 -> 主循环
+static TaskHandle_t touchTaskHandle = nullptr;
+static portMUX_TYPE touchStatsMux = portMUX_INITIALIZER_UNLOCKED;
+static TouchTaskStats_t touchStats = {0, 0, 0, 0, 0, 0, 0}; // 最近一个统计窗口的结果 (受 touchStatsMux 保护)
+
+// 采样任务内部的窗口累计量 (只由采样任务访问)
+static uint32_t windowTicks = 0;
+static uint32_t windowIntervalMinUs = UINT32_MAX;
+static uint32_t windowIntervalMaxUs = 0;
+static uint32_t windowJitterSumUs = 0;
+static uint32_t windowJitterMaxUs = 0;
+static uint32_t droppedSamples = 0;
+
+// 压力测试: 在 [syntheticStartMs, syntheticStartMs + syntheticDurationMs) 内用合成笔迹代替触摸屏读数
+static volatile unsigned long syntheticStartMs = 0;
+static std::atomic<uint32_t> syntheticDurationMs(0);
+
+// 记录一次采样间隔，窗口结束时发布统计结果
+static void recordSampleInterval(uint32_t intervalUs, unsigned long nowMs, unsigned long &windowStartMs) {
+    const uint32_t nominalUs = TOUCH_TASK_PERIOD_MS * 1000UL;
+    uint32_t jitterUs = intervalUs > nominalUs ? intervalUs - nominalUs : nominalUs - intervalUs;
+
+    windowTicks++;
+    windowIntervalMinUs = std::min(windowIntervalMinUs, intervalUs);
+    windowIntervalMaxUs = std::max(windowIntervalMaxUs, intervalUs);
+    windowJitterSumUs += jitterUs;
+    windowJitterMaxUs = std::max(windowJitterMaxUs, jitterUs);
+
+    unsigned long elapsedMs = nowMs - windowStartMs;
+    if (elapsedMs < TOUCH_STATS_WINDOW_MS) {
+        return;
+    }
+
+    portENTER_CRITICAL(&touchStatsMux);
+    touchStats.sampleRateHz = windowTicks * 1000UL / elapsedMs;
+    touchStats.intervalMinUs = windowIntervalMinUs;
+    touchStats.intervalMaxUs = windowIntervalMaxUs;
+    touchStats.jitterMeanUs = windowJitterSumUs / windowTicks;
+    touchStats.jitterMaxUs = windowJitterMaxUs;
+    touchStats.droppedSamples = droppedSamples;
+    portEXIT_CRITICAL(&touchStatsMux);
+
+    windowStartMs = nowMs;
+    windowTicks = 0;
+    windowIntervalMinUs = UINT32_MAX;
+    windowIntervalMaxUs = 0;
+    windowJitterSumUs = 0;
+    windowJitterMaxUs = 0;
 }
 
-// 触摸点平均值计算
-XY_TouchPoint_t averageXY() { // 返回类型已更改为 XY_TouchPoint_t
-    // TS_Point p = ts.getPoint(); // 初始的 getPoint 由于循环似乎是多余的
-    bool fly = false;
-    int cnt = 0;
-    int i, j, k, min_idx, temp_val; // 将 min 重命名为 min_idx，temp 重命名为 temp_val，以避免与潜在函数冲突
-    int tmp[2][10]; // 10个样本的缓冲区
-
-    for (cnt = 0; cnt < 10; cnt++) { // 收集10个样本
-        TS_Point p_sample = ts.getPoint();
-        if (p_sample.z > 200) { // 检查压力阈值
-            tmp[0][cnt] = p_sample.x;
-            tmp[1][cnt] = p_sample.y;
-            delay(2); // 样本之间的小延迟
+// 以固定周期读取触摸屏，把带时间戳的原始样本放入无锁队列
+static void touchSampleTask(void *param) {
+    (void)param;
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t prevUs = micros();
+    unsigned long windowStartMs = millis();
+    bool penDown = false;
+
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(TOUCH_TASK_PERIOD_MS));
+
+        uint32_t nowUs = micros();
+        unsigned long nowMs = millis();
+        recordSampleInterval(nowUs - prevUs, nowMs, windowStartMs);
+        prevUs = nowUs;
+
+        RawTouchSample_t sample;
+        sample.timestamp = nowMs;
+        sample.sampleMicros = nowUs;
+        uint32_t synthDurationMs = syntheticDurationMs.load(std::memory_order_acquire);
+        TouchTraceRecord_t replayed;
+        TouchTraceReplay_t replay = touchTraceReplayNext(nowUs, replayed);
+        if (replay == TRACE_REPLAY_WAIT) { // 回放中，下一个录制样本的时间未到
+            continue;
+        } else if (replay == TRACE_REPLAY_SAMPLE) { // 回放录制的原始样本
+            sample.x = replayed.x;
+            sample.y = replayed.y;
+            sample.z = replayed.z;
+            penDown = replayed.z > 0;
+        } else if (synthDurationMs > 0 && nowMs - syntheticStartMs < synthDurationMs) { // 压力测试合成笔迹
+            float angle = 2.0f * (float)M_PI * ((nowMs - syntheticStartMs) % STRESS_STROKE_PERIOD_MS) / STRESS_STROKE_PERIOD_MS;
+            sample.x = STRESS_STROKE_CENTER_X + (int16_t)(STRESS_STROKE_RADIUS * cosf(angle));
+            sample.y = STRESS_STROKE_CENTER_Y + (int16_t)(STRESS_STROKE_RADIUS * sinf(angle));
+            sample.z = STRESS_STROKE_PRESSURE;
+            penDown = true;
+        } else if (ts.tirqTouched() && ts.touched()) { // 检查IRQ，然后通过压力确认
+            TS_Point p = ts.getPoint();
+            sample.x = p.x;
+            sample.y = p.y;
+            sample.z = p.z;
+            penDown = true;
+        } else if (penDown) { // 抬笔只上报一次
+            sample.x = 0;
+            sample.y = 0;
+            sample.z = 0;
+            penDown = false;
         } else {
-            fly = true; // 无效触摸 (太轻或无触摸)
-            break;
+            continue;
         }
+        touchTraceRecordSample(sample.x, sample.y, sample.z, nowUs);
+
+        if (!touchSampleQueue.push(sample)) {
+            droppedSamples++; // 主循环太久没有取样本，队列已满
+        }
+        schedulerSignal(SCHED_EVENT_TOUCH);
     }
+}
 
-    XY_TouchPoint_t resultXY; // 已更改类型
-    if (fly || cnt < 7) { // 如果标记为飞点或有效样本不足 (例如，平均中间4个点至少需要4个)
-        resultXY.fly = true;
-        return resultXY;
+void touchTaskStart() {
+    if (touchTaskHandle != nullptr) {
+        return;
     }
+    xTaskCreatePinnedToCore(touchSampleTask, "touch", TOUCH_TASK_STACK_SIZE, nullptr,
+                            TOUCH_TASK_PRIORITY, &touchTaskHandle, TOUCH_TASK_CORE);
+}
 
-    // 对样本进行排序以移除异常值 (对于小N使用简单冒泡排序)
-    for (k = 0; k < 2; k++) { // 对于 X (0) 和 Y (1)
-        for (i = 0; i < cnt - 1; i++) {
-            min_idx = i;
-            for (j = i + 1; j < cnt; j++) {
-                if (tmp[k][min_idx] > tmp[k][j]) {
-                    min_idx = j;
-                }
+void touchTaskSynthesize(uint32_t durationMs) {
+    syntheticDurationMs.store(0, std::memory_order_release);
+    syntheticStartMs = millis();
+    syntheticDurationMs.store(durationMs, std::memory_order_release);
+}
+
+void touchTaskGetStats(TouchTaskStats_t &out) {
+    portENTER_CRITICAL(&touchStatsMux);
+    out = touchStats;
+    portEXIT_CRITICAL(&touchStatsMux);
+    out.queueMaxDepth = touchSampleQueue.maxSize();
+}
+
+// --- 样本滤波 ---
+
+// 触摸点滤波 (3 点中值 + One Euro)，参数可在运行时修改
+OneEuroParams_t touchFilterParams = {TOUCH_FILTER_MIN_CUTOFF, TOUCH_FILTER_BETA, TOUCH_FILTER_D_CUTOFF};
+static TouchFilter_t touchFilter;
+static bool touchFilterActive = false; // 当前笔划是否已开始滤波
+
+void touchFilterSetParams(const OneEuroParams_t &params) {
+    touchFilterParams = params;
+    touchFilterActive = false; // 旧参数下的滤波状态作废
+}
+
+// 提笔: 通过 MQTT 发送缓存的整条笔画并重置笔划状态
+static void handlePenUp() {
+    if (wasTouching) { // 如果上一次是触摸状态，说明是提笔事件
+        if (isWifiConnected() && !currentStroke.empty()) {
+            sendStroke(currentStroke); // 发送整条笔画
+            unsigned long sentAt = millis();
+            for (const TouchData_t &point : currentStroke) { // MQTT 整笔发送: 每个点都要等到提笔
+                latencyRecord(LATENCY_SEND, (sentAt - point.timestamp) * 1000UL);
             }
-            // 交换
-            temp_val = tmp[k][i];
-            tmp[k][i] = tmp[k][min_idx];
-            tmp[k][min_idx] = temp_val;
+            currentStroke.clear(); // 清空笔画缓冲区
         }
     }
+    wasTouching = false; // 重置触摸状态
+    lastLocalPoint.z = 0; // 标记为无触摸 (压力 = 0)
+    contactStarted = false; // 下次按下重新命中控件
+    touchFilterActive = false; // 下一笔重新开始滤波
+}
 
-    // 平均中间4个样本 (如果cnt为10且已排序0-9，则索引为3,4,5,6)
-    // 原始代码使用固定索引。如果cnt < 7，这会是个问题。
-    // 假设循环后cnt通常为10。
-    // 为确保稳健性，我们检查cnt。如果我们采集10个样本且不是飞点，则cnt将为10。
-    if (cnt >= 7) { // 确保至少有7个点可供选择中间4个 (例如，如果10个点，则索引为3,4,5,6)
-         resultXY.x = (tmp[0][3] + tmp[0][4] + tmp[0][5] + tmp[0][6]) / 4.0f;
-         resultXY.y = (tmp[1][3] + tmp[1][4] + tmp[1][5] + tmp[1][6]) / 4.0f;
-         resultXY.fly = false;
-    } else { // 特定平均方法所需的点数不足
-        resultXY.fly = true;
+// 处理一个滤波后的触摸点。触发了按钮/弹窗等界面操作时返回 true
+static bool processTouchPoint(const XY_TouchPoint_t &xy1, unsigned long currentRawUptime, uint32_t sampleMicros) {
+    bool pressStart = !contactStarted; // 接触的第一个点
+    contactStarted = true;
+
+    // 首先处理弹窗关闭逻辑 (Coffee 弹窗优先于项目信息弹窗，如果两者都可能存在)
+    if (isCoffeePopupVisible) {
+        hideCoffeePopup(); // 关闭 Coffee 弹窗
+        lastLocalPoint.z = 0; // 标记为无触摸
+        ignoreUntilPenUp = true; // 关闭弹窗的这次按压不再落到按钮或画布上
+        return true; // 操作已处理
+    } else if (isProjectInfoPopupVisible) { // 然后处理项目信息弹窗的关闭逻辑
+        hideProjectInfoPopup(); // 关闭弹窗
+        lastLocalPoint.z = 0; // 标记为无触摸, 避免后续处理
+        ignoreUntilPenUp = true;
+        return true; // 操作已处理
     }
-    return resultXY;
-}
 
+    // 将原始触摸坐标映射到屏幕坐标
+    int mapX = map(xy1.x, TOUCH_MIN_X, TOUCH_MAX_X, 0, SCREEN_WIDTH);
+    int mapY = map(xy1.y, TOUCH_MIN_Y, TOUCH_MAX_Y, 0, SCREEN_HEIGHT);
+
+    // 根据当前 UI 状态处理触摸事件
+    switch (currentUIState) {
+        case UI_STATE_MAIN: // 主绘图界面
+            if (inCustomColorMode) { // 如果处于自定义颜色选择模式
+                handleCustomColorTouch(mapX, mapY); // 传递给UI管理器的自定义颜色处理函数
+                if (!inCustomColorMode) {
+                    ignoreUntilPenUp = true; // 按了返回: 这次按压不再落到主界面的按钮上
+                    return true;
+                }
+            } else { // 正常绘图/按钮模式
+                // 按钮命中检测只在新的按压 (抬笔后的第一个点) 时进行: 一次网格查找，落在画布上时不会逐个比较按钮矩形。
+                // 按钮处理后这次按压的其余点直到提笔都不再处理，按住按钮不会重复触发
+                if (pressStart && widgetDispatchTouch(mapX, mapY)) {
+                    ignoreUntilPenUp = true;
+                    return true; // 操作已由控件处理
+                }
 
-// 处理本地触摸输入
-void handleLocalTouch() {
-    // 来自 ui_manager.h 的依赖项:
-    // extern bool inCustomColorMode;
-    // extern uint32_t currentColor;
-    // extern UIState_t currentUIState; // 新增
-    // ... (其他UI相关函数)
-
-    // 来自 esp_now_handler.h 的依赖项:
-    extern DrawingHistory allDrawingHistory;
-    // extern long relativeBootTimeOffset;
-    // ... (其他ESP-NOW相关函数和变量)
-
-    // tft 和 ts 是来自 touch_handler.h 的 extern 变量 (在 .ino 中定义)
-
-    float x1, y1;
-    bool touched = ts.tirqTouched() && ts.touched(); // 检查IRQ，然后通过压力确认
-    unsigned long currentRawUptime = millis();       // 此触摸事件的本地原始运行时间
-    XY_TouchPoint_t xy1;
-
-    if (touched) {
-        // 首先处理弹窗关闭逻辑 (Coffee 弹窗优先于项目信息弹窗，如果两者都可能存在)
-        if (isCoffeePopupVisible) {
-            xy1 = averageXY(); // 确认是有效触摸
-            if (!xy1.fly) {
-                hideCoffeePopup(); // 关闭 Coffee 弹窗
-                lastLocalPoint.z = 0; // 标记为无触摸
-                return; // 操作已处理
+                // 如果没有按钮被按下，则继续执行绘图逻辑
+                bool drawnLinked = !(currentRawUptime - lastLocalTouchTime > TOUCH_STROKE_INTERVAL || lastLocalPoint.z == 0);
+                TS_Point drawnFrom = lastLocalPoint;
+                if (!drawnLinked) {
+                    // 新的笔划或抬起后的第一个点
+                    tft.drawPixel(mapX, mapY, currentColor); // currentColor 来自 ui_manager
+                } else {
+                    // 继续现有笔划
+                    tft.drawLine(lastLocalPoint.x, lastLocalPoint.y, mapX, mapY, currentColor);
+                }
+                latencyRecordSince(LATENCY_RENDER, sampleMicros);
+                perfCount(PERF_TOUCH_POINTS);
+                perfNoteDrawn();
+
+                // 更新最后本地触摸点状态
+                lastLocalPoint = TS_Point(mapX, mapY, 1); // 存储映射后的坐标
+                lastLocalTouchTime = currentRawUptime;
+
+                // 创建用于历史记录和发送的触摸数据
+                TouchData_t currentDrawPoint;
+                currentDrawPoint.x = mapX;
+                currentDrawPoint.y = mapY;
+                currentDrawPoint.timestamp = currentRawUptime;
+                currentDrawPoint.isReset = false;
+                currentDrawPoint.color = currentColor; // currentColor 来自 ui_manager
+
+                // 根据WiFi连接状态选择发送方式: MQTT 在提笔时整笔发送，ESP-NOW 由网络任务逐点广播
+                bool wifiConnected = isWifiConnected();
+                if (wifiConnected) {
+                    currentStroke.push_back(currentDrawPoint);
+                }
+
+                // 加入历史 (以及 ESP-NOW 广播) 交给网络任务，主循环不等待发送
+                NetworkOp_t pointOp;
+                pointOp.type = NET_OP_LOCAL_POINT;
+                pointOp.point = currentDrawPoint;
+                pointOp.sampleMicros = sampleMicros;
+                pointOp.drawnLinked = drawnLinked; // 对端同色的点插在中间时历史中的连线不同，网络任务据此重绘
+                pointOp.drawnFromX = drawnFrom.x;
+                pointOp.drawnFromY = drawnFrom.y;
+                pointOp.broadcast = !wifiConnected;
+                networkSubmit(pointOp);
             }
-        } else if (isProjectInfoPopupVisible) { // 然后处理项目信息弹窗的关闭逻辑
-            xy1 = averageXY();
-            if (!xy1.fly) {
-                 hideProjectInfoPopup(); // 关闭弹窗
-                 lastLocalPoint.z = 0; // 标记为无触摸, 避免后续处理
-                 return; // 操作已处理
+            break; // End of UI_STATE_MAIN case
+
+        case UI_STATE_COLOR_PICKER: // 颜色选择器界面
+            handleCustomColorTouch(mapX, mapY); // 触摸处理已在 ui_manager 中实现
+            break; // End of UI_STATE_COLOR_PICKER case
+
+        case UI_STATE_POPUP: // 弹窗界面 (项目信息或 Coffee)
+            // 弹窗触摸处理已在 handleLocalTouch 开头处理，这里无需额外逻辑
+            break; // End of UI_STATE_POPUP case
+
+        case UI_STATE_PEER_INFO: // 对端信息界面
+        case UI_STATE_WIFI_SETTINGS: // WiFi 设置界面
+            // 这两个界面只有按钮 (返回、连接)，全部由控件树处理 (每次接触只在按下时命中)
+            if (pressStart && widgetDispatchTouch(mapX, mapY)) {
+                ignoreUntilPenUp = true; // 按钮可能已切换界面，其余点不落到新界面上
+                return true;
             }
+            break;
+
+        default:
+            // 未知状态，可能需要默认行为或错误处理
+            break;
+    }
+    return false;
+}
+
+// 处理本地触摸输入: 取出采样任务积累的全部样本并逐个处理
+void handleLocalTouch() {
+    RawTouchSample_t sample;
+    while (touchSampleQueue.pop(sample)) {
+        if (sample.z == 0) { // 采样任务上报的抬笔
+            ignoreUntilPenUp = false;
+            handlePenUp();
+            continue;
+        }
+        powerManagerNoteUserActivity();
+        if (ignoreUntilPenUp) {
+            continue;
+        }
+        if (!isScreenOn) { // 息屏时触摸只点亮屏幕
+            ignoreUntilPenUp = true;
+            toggleScreen();
+            continue;
         }
 
-        xy1 = averageXY(); // 获取滤波后的触摸点
-        x1 = xy1.x;
-        y1 = xy1.y;
-
-        if (!xy1.fly) { // 如果触摸点有效
-            // 将原始触摸坐标映射到屏幕坐标
-            int mapX = map(x1, TOUCH_MIN_X, TOUCH_MAX_X, 0, SCREEN_WIDTH);
-            int mapY = map(y1, TOUCH_MIN_Y, TOUCH_MAX_Y, 0, SCREEN_HEIGHT);
-
-            // 根据当前 UI 状态处理触摸事件
-            switch (currentUIState) {
-                case UI_STATE_MAIN: // 主绘图界面
-                    if (inCustomColorMode) { // 如果处于自定义颜色选择模式
-                        handleCustomColorTouch(mapX, mapY); // 传递给UI管理器的自定义颜色处理函数
-                    } else { // 正常绘图/按钮模式
-                        // 检查 "Coffee" 按钮
-                        if (showDebugToggleButton && isCoffeeButtonPressed(mapX, mapY)) { // D按钮显示时C按钮才有效
-                            showCoffeePopup();
-                            return; // 操作已处理
-                        }
-
-                        // 检查项目信息按钮
-                        if (isDebugInfoVisible && isInfoButtonPressed(mapX, mapY)) {
-                            showProjectInfoPopup();
-                            return; // 操作已处理
-                        }
-
-                        // 首先检查调试相关按钮的点击
-                        // 注意：Coffee 按钮的检查已在其之前
-                        if (isDebugInfoVisible) {
-                            // 点击调试信息框本身来切换 (InfoButton 和 CoffeeButton 已被优先处理)
-                            if (mapX >= 2 && mapX <= 122 && mapY >= (SCREEN_HEIGHT - 42) && mapY <= SCREEN_HEIGHT) {
-                                if (!isInfoButtonPressed(mapX, mapY)) { // 确保不是误点InfoButton区域
-                                     toggleDebugInfo();
-                                     return; // 操作已处理
-                                }
-                            }
-                        } else if (showDebugToggleButton) { // 如果调试切换按钮可见 (D按钮)
-                            if (isDebugToggleButtonPressed(mapX, mapY)) {
-                                toggleDebugInfo();
-                                return; // 操作已处理
-                            }
-                        }
-
-                        // 检查复位按钮是否按下
-                        if (isResetButtonPressed(mapX, mapY)) {
-                            if (currentRawUptime - lastResetTime < 1000) { // 检查快速按下 (彩蛋)
-                                resetPressCount++;
-                            } else {
-                                resetPressCount = 1;
-                            }
-                            lastResetTime = currentRawUptime;
-
-                            if (resetPressCount >= 10) { // 彩蛋触发
-                                Serial.println("Kurio Reiko thanks all the recognition and redistribution,");
-                                Serial.println("but if someone commercializes this project without declaring Kurio Reiko's originality, then he is a bitch");
-                                resetPressCount = 0; // 重置计数器
-                            }
-
-                            // 清除本地绘图历史 (allDrawingHistory 是来自 esp_now_handler 的 extern 变量)
-                            allDrawingHistory.clear();
-                            clearScreenAndCache();     // 调用UI管理器的清屏函数
-
-                            // 重置ESP-NOW同步状态变量 (来自 esp_now_handler 的 extern 变量)
-                            // 这部分逻辑可能更适合放在 esp_now_handler 内部，
-                            // 由 "local_reset" 事件/标志触发。
-                            relativeBootTimeOffset = 0;
-                            iamEffectivelyMoreUptimeDevice = false; // 这些现在位于 esp_now_handler 中
-                            iamRequestingAllData = false;
-                            initialSyncLogicProcessed = false;
-
-                            // 根据连接状态发送复位消息
-                            if (isWifiConnected()) {
-                                sendResetMessage();
-                            } else {
-                                // 通过ESP-NOW发送复位消息
-                                SyncMessage_t resetMsg;
-                                resetMsg.type = MSG_TYPE_RESET_CANVAS;
-                                resetMsg.senderUptime = currentRawUptime;
-                                resetMsg.senderOffset = relativeBootTimeOffset; // 现在应为0
-                                resetMsg.touch_data.isReset = true;
-                                resetMsg.touch_data.timestamp = currentRawUptime;
-                                resetMsg.touch_data.x = 0; // 与复位无关
-                                resetMsg.touch_data.y = 0; // 与复位无关
-                                resetMsg.touch_data.color = currentColor; // currentColor 来自 ui_manager
-                                sendSyncMessage(&resetMsg); // sendSyncMessage 来自 esp_now_handler
-                            }
-
-                            // 本地绘图历史 (allDrawingHistory) 已被清除。
-                            // 屏幕和UI缓存 (clearScreenAndCache()) 已被清除。
-                            // 复位消息已发送通知对端设备进行清除。
-                            // 根据新的逻辑，不再将此复位操作作为点位记录到本地历史中。
-                            return; // 操作已处理
-                        }
-
-                        uint32_t selectedColorHolder; // 颜色按钮的临时占位符
-                        if (isColorButtonPressed(mapX, mapY, selectedColorHolder)) { // 检查标准颜色按钮
-                            updateCurrentColor(selectedColorHolder); // 在 ui_manager 中更新颜色
-                            redrawStarButton();                      // 用新颜色重绘星星按钮 (ui_manager)
-                            return; // 操作已处理
-                        }
-
-                        // 检查对端信息按钮
-                        if (isPeerInfoButtonPressed(mapX, mapY)) {
-                            showPeerInfoScreen(); // 切换到对端信息界面
-                            return; // 操作已处理
-                        }
-
-                        // 检查WiFi设置按钮
-                        if (isWifiSettingsButtonPressed(mapX, mapY)) {
-                            showWifiSettingsScreen();
-                            return;
-                        }
-
-                        // 检查休眠按钮 (已改为对端信息按钮，此处的逻辑应移除或修改)
-                        // 根据之前的修改，这个按钮现在是对端信息按钮，上面的 if 已经处理了。
-                        // 如果需要一个单独的休眠按钮，需要重新添加UI元素和逻辑。
-                        // 暂时移除此处的 isSleepButtonPressed 检查
-                        /*
-                        if (isSleepButtonPressed(mapX, mapY)) { // 检查休眠按钮
-                            Serial.println("准备进入深度睡眠模式...");
-                            esp_deep_sleep_start(); // ESP32 API 用于深度睡眠
-                            return; // 操作已处理 (尽管设备将休眠)
-                        }
-                        */
-
-                        if (isCustomColorButtonPressed(mapX, mapY)) { // 检查自定义颜色 ("*") 按钮
-                            inCustomColorMode = true;   // 设置UI状态 (ui_manager)
-                            saveScreenArea();           // 保存屏幕区域 (ui_manager)
-                            drawColorSelectors();       // 绘制颜色选择器 (ui_manager)
-                            hideStarButton();           // 隐藏星星按钮 (ui_manager)
-                            return; // 操作已处理
-                        }
-
-                        // 如果没有按钮被按下，则继续执行绘图逻辑
-                        if (currentRawUptime - lastLocalTouchTime > TOUCH_STROKE_INTERVAL || lastLocalPoint.z == 0) {
-                            // 新的笔划或抬起后的第一个点
-                            tft.drawPixel(mapX, mapY, currentColor); // currentColor 来自 ui_manager
-                        } else {
-                            // 继续现有笔划
-                            tft.drawLine(lastLocalPoint.x, lastLocalPoint.y, mapX, mapY, currentColor);
-                        }
-
-                        // 更新最后本地触摸点状态
-                        lastLocalPoint = {mapX, mapY, 1}; // 存储映射后的坐标
-                        lastLocalTouchTime = currentRawUptime;
-
-                        // 创建用于历史记录和发送的触摸数据
-                        TouchData_t currentDrawPoint;
-                        currentDrawPoint.x = mapX;
-                        currentDrawPoint.y = mapY;
-                        currentDrawPoint.timestamp = currentRawUptime;
-                        currentDrawPoint.isReset = false;
-                        currentDrawPoint.color = currentColor; // currentColor 来自 ui_manager
-
-                        allDrawingHistory.push_back(currentDrawPoint); // 添加到本地历史 (esp_now_handler 的 extern 变量)
-
-                        // 根据WiFi连接状态选择发送方式
-                        if (isWifiConnected()) {
-                            currentStroke.push_back(currentDrawPoint);
-                        } else {
-                            // 通过ESP-NOW发送绘图数据
-                            SyncMessage_t drawMsg;
-                            drawMsg.type = MSG_TYPE_DRAW_POINT;
-                            drawMsg.senderUptime = currentRawUptime;
-                            drawMsg.senderOffset = relativeBootTimeOffset; // relativeBootTimeOffset 来自 esp_now_handler
-                            drawMsg.touch_data = currentDrawPoint;
-                            sendSyncMessage(&drawMsg); // sendSyncMessage 来自 esp_now_handler
-                        }
-                    }
-                    break; // End of UI_STATE_MAIN case
-
-                case UI_STATE_COLOR_PICKER: // 颜色选择器界面
-                    handleCustomColorTouch(mapX, mapY); // 触摸处理已在 ui_manager 中实现
-                    break; // End of UI_STATE_COLOR_PICKER case
-
-                case UI_STATE_POPUP: // 弹窗界面 (项目信息或 Coffee)
-                    // 弹窗触摸处理已在 handleLocalTouch 开头处理，这里无需额外逻辑
-                    break; // End of UI_STATE_POPUP case
-
-                case UI_STATE_PEER_INFO: // 对端信息界面
-                    // 检查返回按钮
-                    if (isPeerInfoScreenBackButtonPressed(mapX, mapY)) { // 更正为 isPeerInfoScreenBackButtonPressed
-                        Serial.println("Peer Info Back button pressed. Hiding Peer Info Screen."); // 添加调试输出
-                        hidePeerInfoScreen(); // 返回主界面
-                        return; // 操作已处理
-                    }
-                    // 如果将来对端信息界面有其他可交互元素，可以在这里添加处理逻辑
-                    break; // End of UI_STATE_PEER_INFO case
-                
-                case UI_STATE_WIFI_SETTINGS:
-                    handleWifiSettingsTouch(mapX, mapY);
-                    break;
-
-                default:
-                    // 未知状态，可能需要默认行为或错误处理
-                    break;
-            }
+        wasTouching = true; // 标记处于触摸状态
+        if (sample.z <= TOUCH_PRESSURE_THRESHOLD) { // 无效触摸 (太轻)，丢弃
+            continue;
+        }
+
+        XY_TouchPoint_t xy1;
+        if (!touchFilterActive) {
+            touchFilterReset(touchFilter);
+            touchFilterActive = true;
         }
-        wasTouching = true; // 标记本次循环处理了触摸事件
-    } else { // 当前未检测到触摸
-        if (wasTouching) { // 如果上一次是触摸状态，说明是提笔事件
-            if (isWifiConnected() && !currentStroke.empty()) {
-                sendStroke(currentStroke); // 发送整条笔画
-                currentStroke.clear(); // 清空笔画缓冲区
+        touchFilterApply(touchFilter, touchFilterParams, sample.x, sample.y, sample.timestamp, xy1.x, xy1.y);
+        xy1.fly = false;
+        latencyRecordSince(LATENCY_FILTER, sample.sampleMicros);
+
+        // 按钮/弹窗操作后剩余样本留到下一轮 loop 再处理 (界面可能已切换)
+        if (processTouchPoint(xy1, sample.timestamp, sample.sampleMicros)) {
+            if (!touchSampleQueue.empty()) {
+                schedulerSignal(SCHED_EVENT_TOUCH); // 重绘控件后立即继续处理，不等待下一个样本
             }
+            return;
         }
-        wasTouching = false; // 重置触摸状态
-        lastLocalPoint.z = 0; // 标记为无触摸 (压力 = 0)
     }
 }
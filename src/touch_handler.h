@@ -3,6 +3,7 @@
 #include <TFT_eSPI.h>
 #include "config.h"
 #include <XPT2046_Touchscreen.h> // For TS_Point and XPT2046_Touchscreen object
+#include "touch_filter.h"        // For OneEuroParams_t
 
 // 原始触摸数据结构
 typedef struct XY_structure_s // 已重命名以避免与原始 XY_structure (如果仍在某处) 冲突
@@ -12,12 +13,37 @@ typedef struct XY_structure_s // 已重命名以避免与原始 XY_structure (
     bool fly = false; // 是否为无效触摸点 (飞点)
 } XY_TouchPoint_t;    // 重命名的 typedef
 
+// 触摸采样任务输出的原始样本
+typedef struct RawTouchSample_s
+{
+    int16_t x;               // 原始触摸 X 坐标
+    int16_t y;               // 原始触摸 Y 坐标
+    int16_t z;               // 压力，0 表示抬笔
+    unsigned long timestamp; // 采样时的本地原始运行时间 (millis)
+    uint32_t sampleMicros;   // 采样时的 micros()，作为触摸到屏幕延迟统计的起点
+} RawTouchSample_t;
+
+// 触摸采样任务节拍统计 (每 TOUCH_STATS_WINDOW_MS 更新一次)
+typedef struct TouchTaskStats_s
+{
+    uint32_t sampleRateHz;   // 实际采样频率
+    uint32_t intervalMinUs;  // 最短采样间隔 (微秒)
+    uint32_t intervalMaxUs;  // 最长采样间隔 (微秒)
+    uint32_t jitterMeanUs;   // 采样间隔与标称周期之差的平均绝对值 (微秒)
+    uint32_t jitterMaxUs;    // 采样间隔与标称周期之差的最大绝对值 (微秒)
+    uint32_t droppedSamples; // 启动以来因队列满而丢弃的样本数
+    uint32_t queueMaxDepth;  // 样本队列启动以来的最大深度
+} TouchTaskStats_t;
+
 // --- Extern 全局变量 ---
 // ts 对象定义于 Project-ESPNow.ino
 extern XPT2046_Touchscreen ts; 
 // tft 对象也由 handleLocalTouch 的绘图部分需要，定义于 Project-ESPNow.ino
 extern TFT_eSPI tft; 
 
+// 触摸点滤波参数 (默认值见 config.h 的 TOUCH_FILTER_*)，只读；修改用 touchFilterSetParams
+extern OneEuroParams_t touchFilterParams;
+
 
 // --- 函数声明 ---
 
@@ -29,7 +55,18 @@ void touchHandlerInit();
 // 这些依赖将在 touch_handler.cpp 中包含
 void handleLocalTouch();
 
-// 触摸点平均值计算 (内部辅助函数，也可以不在此声明如果只在 .cpp 中使用)
-XY_TouchPoint_t averageXY(); 
+// 启动触摸采样任务 (须在 ts.begin() 之后调用)
+// 任务以 TOUCH_TASK_PERIOD_MS 为周期读取触摸屏，把原始样本放入无锁队列，
+// handleLocalTouch() 在主循环中取出样本，经 One Euro 滤波后绘图，再把点交给网络任务记录/发送。
+void touchTaskStart();
+
+// 获取最近一个统计窗口内的采样节拍统计
+void touchTaskGetStats(TouchTaskStats_t &out);
+
+// 压力测试: 接下来 durationMs 内采样任务输出合成笔迹 (屏幕中央画圈) 代替触摸屏读数
+void touchTaskSynthesize(uint32_t durationMs);
+
+// 修改触摸点滤波参数 (在主循环中调用)，正在画的笔划从下一个样本起按新参数重新开始滤波
+void touchFilterSetParams(const OneEuroParams_t &params);
 
 #endif // TOUCH_HANDLER_H
@@ -0,0 +1,474 @@
+#include "touch_trace.h"
+#include "config.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <atomic>
+#include "touch_handler.h"   // 采样丢弃计数
+#include "esp_now_handler.h" // 绘图历史长度
+#include "canvas_store.h"    // 文件系统是否已挂载
+#include "latency_stats.h"   // 回放前清空、回放后打印延迟直方图
+#include "scheduler.h"       // 回放报告
+#include "memory_tier.h"     // 轨迹缓冲放在 PSRAM
+
+#define TOUCH_TRACE_PATH "/touch.trace"
+#define TOUCH_TRACE_DUMP_BYTES 48 // 每行导出的字节数 (64 个 base64 字符)
+#define TOUCH_TRACE_IO_CHUNK 64   // 读写文件时每次处理的字节数
+
+enum TouchTraceState_e
+{
+    TRACE_IDLE,
+    TRACE_RECORDING, // 采样任务写入 records
+    TRACE_REPLAYING, // 采样任务读取 records
+};
+
+// 状态只由主循环在 TRACE_IDLE 与其他状态之间切换 (录满或回放结束时采样任务切回 TRACE_IDLE)。
+// 采样任务与主循环同在核心 1 且优先级更高，一个采样节拍不会被串口命令打断。
+static std::atomic<uint8_t> traceState{TRACE_IDLE};
+static TouchTraceRecord_t *records = nullptr; // 第一次使用时分配，之后保留
+static std::atomic<uint32_t> recordCount{0};
+static uint32_t recordFirstUs = 0;
+static bool recordFull = false; // 录制因缓冲区满而停止
+
+// 回放 (TRACE_REPLAYING 期间只由采样任务修改)
+static uint32_t replayIndex = 0;
+static uint32_t replayBaseUs = 0;   // 轨迹时间 0 对应的 micros()
+static uint32_t replayFirstUs = 0;  // 输出第一个样本时的 micros()
+static std::atomic<uint32_t> replayElapsedUs{0}; // 回放结束时写入: 从第一个到最后一个样本的实际用时
+static bool replayPenDown = false;
+static std::atomic<uint32_t> replayedSamples{0};
+
+// 回放报告
+static long replayHistoryStart = 0;
+static uint32_t replayDroppedStart = 0;
+static bool replayReportValid = false;
+static uint32_t lastReplaySamples = 0;
+static long lastReplayPoints = 0;
+static uint32_t lastReplayElapsedUs = 0;
+
+// 导入 (串口 "trace put" 或 LittleFS)，按字节顺序拼接成轨迹文件
+static TouchTraceHeader_t importHeader;
+static uint32_t importBytes = 0;
+static bool importActive = false;
+
+static const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static size_t base64Encode(const uint8_t *src, size_t len, char *dst)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < len)
+            v |= (uint32_t)src[i + 1] << 8;
+        if (i + 2 < len)
+            v |= src[i + 2];
+        dst[n++] = base64Alphabet[(v >> 18) & 0x3F];
+        dst[n++] = base64Alphabet[(v >> 12) & 0x3F];
+        dst[n++] = i + 1 < len ? base64Alphabet[(v >> 6) & 0x3F] : '=';
+        dst[n++] = i + 2 < len ? base64Alphabet[v & 0x3F] : '=';
+    }
+    dst[n] = '\0';
+    return n;
+}
+
+static int base64Value(char c)
+{
+    const char *p = strchr(base64Alphabet, c);
+    return (c != '\0' && p != nullptr) ? (int)(p - base64Alphabet) : -1;
+}
+
+// 解码失败 (非法字符或长度不是 4 的倍数) 返回 -1
+static int base64Decode(const char *src, uint8_t *dst, size_t capacity)
+{
+    size_t len = strlen(src);
+    if (len % 4 != 0)
+        return -1;
+    size_t n = 0;
+    for (size_t i = 0; i < len; i += 4)
+    {
+        uint32_t v = 0;
+        int pad = 0;
+        for (size_t k = 0; k < 4; k++)
+        {
+            int d = 0;
+            if (src[i + k] == '=' && i + 4 == len && k >= 2)
+                pad++;
+            else if (pad > 0 || (d = base64Value(src[i + k])) < 0)
+                return -1;
+            v = (v << 6) | (uint32_t)d;
+        }
+        for (int k = 0; k < 3 - pad; k++)
+        {
+            if (n >= capacity)
+                return -1;
+            dst[n++] = (uint8_t)(v >> (16 - 8 * k));
+        }
+    }
+    return (int)n;
+}
+
+static bool ensureBuffer(Print &out)
+{
+    if (records == nullptr)
+        records = (TouchTraceRecord_t *)memoryTierAlloc(TOUCH_TRACE_MAX_SAMPLES * sizeof(TouchTraceRecord_t), MEMORY_TIER_PSRAM); // 有 PSRAM 时放在 PSRAM
+    if (records == nullptr)
+        out.printf("trace: cannot allocate %u bytes\n", (unsigned)(TOUCH_TRACE_MAX_SAMPLES * sizeof(TouchTraceRecord_t)));
+    return records != nullptr;
+}
+
+static bool requireIdle(Print &out)
+{
+    uint8_t state = traceState.load(std::memory_order_acquire);
+    if (state == TRACE_IDLE)
+        return true;
+    out.println(state == TRACE_RECORDING ? "trace: recording, 'trace stop' first" : "trace: replaying, 'trace stop' first");
+    return false;
+}
+
+static void fillHeader(TouchTraceHeader_t &header)
+{
+    header.magic = TOUCH_TRACE_MAGIC;
+    header.version = TOUCH_TRACE_VERSION;
+    header.recordSize = sizeof(TouchTraceRecord_t);
+    header.count = recordCount.load(std::memory_order_acquire);
+    header.periodUs = TOUCH_TASK_PERIOD_MS * 1000UL;
+}
+
+// 读取轨迹文件镜像 (文件头 + 记录) 中 [offset, offset + len) 的字节，返回实际读取的字节数
+static size_t readImage(uint32_t offset, uint8_t *dst, size_t len)
+{
+    TouchTraceHeader_t header;
+    fillHeader(header);
+    uint32_t total = sizeof(header) + header.count * sizeof(TouchTraceRecord_t);
+    size_t n = 0;
+    while (n < len && offset + n < total)
+    {
+        uint32_t pos = offset + n;
+        dst[n++] = pos < sizeof(header) ? ((const uint8_t *)&header)[pos]
+                                        : ((const uint8_t *)records)[pos - sizeof(header)];
+    }
+    return n;
+}
+
+static void importBegin()
+{
+    importActive = true;
+    importBytes = 0;
+    recordCount.store(0, std::memory_order_release);
+    replayReportValid = false;
+}
+
+// 追加导入的字节。出错时打印原因、放弃本次导入并返回 false
+static bool importWrite(const uint8_t *src, size_t len, Print &out)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (importBytes < sizeof(importHeader))
+        {
+            ((uint8_t *)&importHeader)[importBytes++] = src[i];
+            if (importBytes < sizeof(importHeader))
+                continue;
+            const char *error = nullptr;
+            if (importHeader.magic != TOUCH_TRACE_MAGIC || importHeader.version != TOUCH_TRACE_VERSION)
+                error = "not a touch trace";
+            else if (importHeader.recordSize != sizeof(TouchTraceRecord_t))
+                error = "record size mismatch";
+            else if (importHeader.count > TOUCH_TRACE_MAX_SAMPLES)
+                error = "too many samples (TOUCH_TRACE_MAX_SAMPLES)";
+            if (error != nullptr || !ensureBuffer(out))
+            {
+                if (error != nullptr)
+                    out.printf("trace: %s\n", error);
+                importActive = false;
+                return false;
+            }
+            continue;
+        }
+        uint32_t pos = importBytes - sizeof(importHeader);
+        if (pos >= importHeader.count * sizeof(TouchTraceRecord_t))
+        {
+            out.println("trace: more data than the header announced");
+            importActive = false;
+            return false;
+        }
+        ((uint8_t *)records)[pos] = src[i];
+        importBytes++;
+    }
+    return true;
+}
+
+// 导入完成时设置记录数并返回 true
+static bool importFinish(Print &out)
+{
+    if (!importActive || importBytes < sizeof(importHeader) ||
+        importBytes != sizeof(importHeader) + importHeader.count * sizeof(TouchTraceRecord_t))
+        return false;
+    importActive = false;
+    recordCount.store(importHeader.count, std::memory_order_release);
+    recordFull = false;
+    out.printf("trace: loaded %lu samples\n", (unsigned long)importHeader.count);
+    return true;
+}
+
+// --- 采样任务 ---
+
+void touchTraceRecordSample(int16_t x, int16_t y, int16_t z, uint32_t sampleMicros)
+{
+    if (traceState.load(std::memory_order_acquire) != TRACE_RECORDING)
+        return;
+    uint32_t n = recordCount.load(std::memory_order_relaxed);
+    if (n == 0 && z == 0)
+        return; // 开始录制前按下的笔划的抬笔
+    if (n >= TOUCH_TRACE_MAX_SAMPLES)
+    {
+        recordFull = true;
+        traceState.store(TRACE_IDLE, std::memory_order_release);
+        return;
+    }
+    if (n == 0)
+        recordFirstUs = sampleMicros;
+    TouchTraceRecord_t &record = records[n];
+    record.timeUs = sampleMicros - recordFirstUs;
+    record.x = x;
+    record.y = y;
+    record.z = z;
+    record.reserved = 0;
+    recordCount.store(n + 1, std::memory_order_release);
+}
+
+TouchTraceReplay_t touchTraceReplayNext(uint32_t nowUs, TouchTraceRecord_t &out)
+{
+    if (traceState.load(std::memory_order_acquire) != TRACE_REPLAYING)
+        return TRACE_REPLAY_OFF;
+
+    uint32_t count = recordCount.load(std::memory_order_acquire);
+    if (replayIndex >= count)
+    {
+        replayElapsedUs.store(nowUs - replayFirstUs, std::memory_order_relaxed);
+        traceState.store(TRACE_IDLE, std::memory_order_release);
+        if (!replayPenDown)
+            return TRACE_REPLAY_OFF;
+        memset(&out, 0, sizeof(out)); // 轨迹在笔划中间结束，补发抬笔
+        replayPenDown = false;
+        return TRACE_REPLAY_SAMPLE;
+    }
+
+    const TouchTraceRecord_t &record = records[replayIndex];
+    if (replayIndex == 0)
+    {
+        replayBaseUs = nowUs - record.timeUs;
+        replayFirstUs = nowUs;
+    }
+    // 记录时间与节拍对齐到半个周期以内即输出
+    int32_t early = (int32_t)(record.timeUs - (nowUs - replayBaseUs));
+    if (early > (int32_t)(TOUCH_TASK_PERIOD_MS * 1000UL / 2))
+        return TRACE_REPLAY_WAIT;
+    if (early < -(int32_t)(TOUCH_TASK_PERIOD_MS * 1000UL))
+        replayBaseUs = nowUs - record.timeUs; // 节拍延迟，之后的样本整体顺延
+
+    out = record;
+    replayPenDown = record.z > 0;
+    replayIndex++;
+    replayedSamples.fetch_add(1, std::memory_order_relaxed);
+    return TRACE_REPLAY_SAMPLE;
+}
+
+// --- 主循环 ---
+
+static long historyLength()
+{
+    historyLock();
+    long length = (long)allDrawingHistory.size();
+    historyUnlock();
+    return length;
+}
+
+static void replayReport()
+{
+    TouchTaskStats_t touch;
+    touchTaskGetStats(touch);
+    bool running = traceState.load(std::memory_order_acquire) == TRACE_REPLAYING;
+    uint32_t count = recordCount.load(std::memory_order_acquire);
+
+    lastReplaySamples = replayedSamples.load(std::memory_order_relaxed);
+    lastReplayPoints = historyLength() - replayHistoryStart;
+    lastReplayElapsedUs = replayElapsedUs.load(std::memory_order_relaxed);
+    replayReportValid = true;
+
+    Serial.println("=== trace replay report ===");
+    Serial.printf("samples replayed      %lu / %lu%s\n", (unsigned long)lastReplaySamples, (unsigned long)count,
+                  running ? " (still replaying)" : "");
+    Serial.printf("replay time           %lums (trace %lums)\n", (unsigned long)(lastReplayElapsedUs / 1000),
+                  count > 0 ? (unsigned long)(records[count - 1].timeUs / 1000) : 0UL);
+    Serial.printf("history points added  %ld\n", lastReplayPoints);
+    Serial.printf("touch samples dropped %lu (sample queue full)\n",
+                  (unsigned long)(touch.droppedSamples - replayDroppedStart));
+    latencyPrint(Serial);
+}
+
+void touchTraceStartRecording(Print &out)
+{
+    if (!requireIdle(out) || !ensureBuffer(out))
+        return;
+    importActive = false;
+    recordFull = false;
+    replayReportValid = false;
+    recordCount.store(0, std::memory_order_release);
+    traceState.store(TRACE_RECORDING, std::memory_order_release);
+    out.printf("trace: recording up to %u samples ('trace stop' ends)\n", (unsigned)TOUCH_TRACE_MAX_SAMPLES);
+}
+
+void touchTraceStartReplay(Print &out)
+{
+    if (!requireIdle(out))
+        return;
+    uint32_t count = recordCount.load(std::memory_order_acquire);
+    if (count == 0)
+    {
+        out.println("trace: nothing to replay (record, put or load a trace first)");
+        return;
+    }
+    TouchTaskStats_t touch;
+    touchTaskGetStats(touch);
+    replayDroppedStart = touch.droppedSamples;
+    replayHistoryStart = historyLength();
+    replayIndex = 0;
+    replayPenDown = false;
+    replayElapsedUs.store(0, std::memory_order_relaxed);
+    replayedSamples.store(0, std::memory_order_relaxed);
+    latencyReset();
+    traceState.store(TRACE_REPLAYING, std::memory_order_release);
+
+    uint32_t durationMs = records[count - 1].timeUs / 1000;
+    schedulerAddOneShot("trace_report", durationMs + TOUCH_TRACE_SETTLE_MS, replayReport);
+    out.printf("trace: replaying %lu samples (%lums)\n", (unsigned long)count, (unsigned long)durationMs);
+}
+
+void touchTraceStop(Print &out)
+{
+    uint8_t state = traceState.load(std::memory_order_acquire);
+    traceState.store(TRACE_IDLE, std::memory_order_release);
+    uint32_t count = recordCount.load(std::memory_order_acquire);
+    if (state == TRACE_RECORDING)
+        out.printf("trace: recorded %lu samples (%lums)\n", (unsigned long)count,
+                   count > 0 ? (unsigned long)(records[count - 1].timeUs / 1000) : 0UL);
+    else if (state == TRACE_REPLAYING)
+        out.printf("trace: replay stopped after %lu samples\n", (unsigned long)replayedSamples.load());
+    else
+        out.println("trace: idle");
+}
+
+void touchTraceDump(Print &out)
+{
+    if (!requireIdle(out))
+        return;
+    uint32_t count = recordCount.load(std::memory_order_acquire);
+    uint8_t chunk[TOUCH_TRACE_DUMP_BYTES];
+    char line[TOUCH_TRACE_DUMP_BYTES / 3 * 4 + 1];
+    uint32_t offset = 0;
+    size_t n;
+    while ((n = readImage(offset, chunk, sizeof(chunk))) > 0)
+    {
+        base64Encode(chunk, n, line);
+        out.printf("TRACE,%lu,%s\n", (unsigned long)offset, line);
+        offset += n;
+    }
+    out.printf("TRACE,END,%lu\n", (unsigned long)count);
+}
+
+void touchTracePut(const char *base64, Print &out)
+{
+    if (!requireIdle(out))
+        return;
+    if (*base64 == '\0')
+    {
+        importBegin();
+        out.println("trace: ready for 'trace put <base64>' lines");
+        return;
+    }
+    if (!importActive)
+        importBegin();
+    uint8_t chunk[TOUCH_TRACE_DUMP_BYTES]; // 一行最多 64 个 base64 字符
+    int n = base64Decode(base64, chunk, sizeof(chunk));
+    if (n < 0)
+    {
+        out.println("trace: bad base64, import abandoned");
+        importActive = false;
+        return;
+    }
+    if (importWrite(chunk, (size_t)n, out))
+        importFinish(out);
+}
+
+void touchTraceSave(Print &out)
+{
+    CanvasStoreStats_t store;
+    canvasStoreGetStats(store);
+    if (!requireIdle(out))
+        return;
+    if (!store.mounted || recordCount.load(std::memory_order_acquire) == 0)
+    {
+        out.println(store.mounted ? "trace: nothing to save" : "trace: LittleFS not mounted");
+        return;
+    }
+    File file = LittleFS.open(TOUCH_TRACE_PATH, FILE_WRITE);
+    if (!file)
+    {
+        out.println("trace: cannot open " TOUCH_TRACE_PATH);
+        return;
+    }
+    uint8_t chunk[TOUCH_TRACE_IO_CHUNK];
+    uint32_t offset = 0;
+    size_t n;
+    bool ok = true;
+    while (ok && (n = readImage(offset, chunk, sizeof(chunk))) > 0)
+    {
+        ok = file.write(chunk, n) == n;
+        offset += n;
+    }
+    file.close();
+    out.printf(ok ? "trace: saved %lu bytes to " TOUCH_TRACE_PATH "\n" : "trace: write failed after %lu bytes\n",
+               (unsigned long)offset);
+}
+
+void touchTraceLoad(Print &out)
+{
+    CanvasStoreStats_t store;
+    canvasStoreGetStats(store);
+    if (!requireIdle(out))
+        return;
+    File file = store.mounted ? LittleFS.open(TOUCH_TRACE_PATH, FILE_READ) : File();
+    if (!file)
+    {
+        out.println(store.mounted ? "trace: no " TOUCH_TRACE_PATH : "trace: LittleFS not mounted");
+        return;
+    }
+    importBegin();
+    uint8_t chunk[TOUCH_TRACE_IO_CHUNK];
+    bool ok = true;
+    int n;
+    while (ok && (n = file.read(chunk, sizeof(chunk))) > 0)
+        ok = importWrite(chunk, (size_t)n, out);
+    file.close();
+    if (ok && !importFinish(out))
+    {
+        out.println("trace: " TOUCH_TRACE_PATH " is truncated");
+        importActive = false;
+    }
+}
+
+void touchTracePrintInfo(Print &out)
+{
+    static const char *const stateNames[] = {"idle", "recording", "replaying"};
+    uint8_t state = traceState.load(std::memory_order_acquire);
+    uint32_t count = recordCount.load(std::memory_order_acquire);
+    out.printf("state            %s%s\n", stateNames[state], importActive ? " (import in progress)" : "");
+    out.printf("samples          %lu / %u%s, %lums\n", (unsigned long)count, (unsigned)TOUCH_TRACE_MAX_SAMPLES,
+               recordFull ? " (buffer full, recording stopped)" : "",
+               count > 0 ? (unsigned long)(records[count - 1].timeUs / 1000) : 0UL);
+    if (state == TRACE_REPLAYING)
+        out.printf("replayed         %lu\n", (unsigned long)replayedSamples.load());
+    if (replayReportValid)
+        out.printf("last replay      %lu samples in %lums, %ld history points added\n", (unsigned long)lastReplaySamples,
+                   (unsigned long)(lastReplayElapsedUs / 1000), lastReplayPoints);
+}
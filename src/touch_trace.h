@@ -0,0 +1,76 @@
+#ifndef TOUCH_TRACE_H
+#define TOUCH_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Print;
+
+// 触摸轨迹录制与回放 (串口命令 "trace")
+// 录制: 采样任务把送入样本队列的每个原始样本 (XPT2046 坐标、压力、微秒时间) 追加到内存缓冲区；
+// 回放: 采样任务按录制时的时间间隔依次输出缓冲区中的样本，代替触摸屏读数 (相当于一个假的 ts)，
+//       之后的滤波、绘图、记录和发送与真实书写完全相同，每次回放的输入样本序列一致，可用于对比性能改动。
+// 轨迹可以 base64 文本行从串口导出/导入 (tools/touch_trace_convert.cpp 转换)，或保存到 LittleFS /touch.trace。
+// 主机构建中 firenote_host --trace 直接把轨迹文件作为触摸屏读数。
+// 本头文件不依赖 Arduino，主机工具可直接包含它读取轨迹文件。
+
+// 轨迹文件格式 (小端): 文件头 + count 条定长记录
+#define TOUCH_TRACE_MAGIC 0x52544E46 // "FNTR"
+#define TOUCH_TRACE_VERSION 1
+
+typedef struct TouchTraceHeader_s
+{
+    uint32_t magic;      // TOUCH_TRACE_MAGIC
+    uint16_t version;    // TOUCH_TRACE_VERSION
+    uint16_t recordSize; // sizeof(TouchTraceRecord_t)
+    uint32_t count;      // 记录数
+    uint32_t periodUs;   // 录制时的采样周期 (微秒)
+} TouchTraceHeader_t;
+
+typedef struct TouchTraceRecord_s
+{
+    uint32_t timeUs;   // 相对第一个样本的时间 (微秒)
+    int16_t x;         // 原始触摸 X 坐标
+    int16_t y;         // 原始触摸 Y 坐标
+    int16_t z;         // 压力，0 表示抬笔
+    uint16_t reserved;
+} TouchTraceRecord_t;
+
+// 采样任务每个节拍的回放结果
+enum TouchTraceReplay_e
+{
+    TRACE_REPLAY_OFF,    // 没有在回放，读取触摸屏
+    TRACE_REPLAY_WAIT,   // 正在回放，本节拍没有样本 (下一个样本时间未到)
+    TRACE_REPLAY_SAMPLE, // 输出一个回放样本
+};
+typedef enum TouchTraceReplay_e TouchTraceReplay_t;
+
+// --- 采样任务调用 ---
+
+// 录制中时追加一个送入样本队列的样本
+void touchTraceRecordSample(int16_t x, int16_t y, int16_t z, uint32_t sampleMicros);
+
+// 回放中时取本节拍的样本。每节拍最多输出一个记录，不跳过记录 (节拍延迟时整体顺延)；
+// 轨迹结束时若笔仍按下，补发一个抬笔样本
+TouchTraceReplay_t touchTraceReplayNext(uint32_t nowUs, TouchTraceRecord_t &out);
+
+// --- 主循环 (串口命令) 调用 ---
+
+void touchTraceStartRecording(Print &out);
+void touchTraceStartReplay(Print &out); // 结束后打印回放报告 (样本数、新增历史点数、耗时、延迟直方图)
+void touchTraceStop(Print &out);        // 结束录制或中止回放
+
+// 导出为 "TRACE,偏移,base64" 行 (每行 48 字节)，最后一行为 "TRACE,END,记录数"
+void touchTraceDump(Print &out);
+
+// 导入一行 base64 (按顺序拼接成轨迹文件)；空参数表示开始一次新的导入
+void touchTracePut(const char *base64, Print &out);
+
+// 保存到 / 读取自 LittleFS
+void touchTraceSave(Print &out);
+void touchTraceLoad(Print &out);
+
+// 打印状态和最近一次回放的结果
+void touchTracePrintInfo(Print &out);
+
+#endif // TOUCH_TRACE_H
@@ -6,10 +6,15 @@
 #include <cmath>      // 包含 cmath 库，用于 round 函数
 #include <algorithm>  // 包含 algorithm 库，用于 min/max 函数
 #include "drawing_history.h" // 包含自定义绘图历史头文件
-#include "esp_now_handler.h" // 包含 esp_now_handler.h 以访问 PeerInfo_t 和 peerInfoMap
+#include "esp_now_handler.h" // 包含 esp_now_handler.h 以访问 PeerInfo_t 和 getPeerInfoList
 #include <esp_wifi.h> // 用于获取本机 MAC 地址
 #include "wifi_manager.h"
 #include "mqtt_handler.h"
+#include "qr_bitmaps.h" // 由 qr_to_text.py 生成的二维码矩形
+#include "cached_text.h" // 增量文本渲染
+#include "ui_widgets.h" // 控件树 (按钮绘制、脏标记与命中检测)
+#include "touch_handler.h" // 触摸采样任务统计 (调试信息)
+#include "latency_stats.h" // 触摸到屏幕延迟 (调试信息)
 
 // --- 全局 UI 状态变量 (在此定义) ---
 UIState_t currentUIState = UI_STATE_MAIN; // 当前 UI 状态
@@ -32,47 +37,139 @@ bool showReceiveProgress = false;
 int redValue = 255;
 int greenValue = 255;
 int blueValue = 255;
-uint16_t *savedScreenBuffer = nullptr;
+
+// --- 增量文本渲染用的缓存字段 (见 cached_text.h) ---
+// 对端信息界面布局
+#define PEER_LOCAL_INFO_X 5
+#define PEER_LOCAL_INFO_Y 30
+#define PEER_LOCAL_INFO_LINES 4
+#define PEER_LOCAL_INFO_LINE_HEIGHT 10
+#define PEER_LOCAL_INFO_W (SCREEN_WIDTH - 10)
+#define PEER_LOCAL_INFO_H (PEER_LOCAL_INFO_LINES * PEER_LOCAL_INFO_LINE_HEIGHT + 5) // 4行文本 + 间距
+#define PEER_LIST_X 5
+#define PEER_LIST_HEADER_Y (PEER_LOCAL_INFO_Y + PEER_LOCAL_INFO_H + 10) // 在本机信息下方留出间距
+#define PEER_LIST_ROW_HEIGHT 15
+#define PEER_LIST_ROWS_Y (PEER_LIST_HEADER_Y + PEER_LIST_ROW_HEIGHT) // 在表头下方开始绘制
+#define PEER_LIST_COL_MAC_W 100
+#define PEER_LIST_COL_UPTIME_W 60
+// 对端列表行数: 受 MAX_PEERS_TO_DISPLAY 限制，且不能覆盖返回按钮
+#define PEER_LIST_ROWS std::min(MAX_PEERS_TO_DISPLAY, (BACK_BUTTON_Y - 2 - PEER_LIST_ROWS_Y) / PEER_LIST_ROW_HEIGHT)
+
+static CachedText_t debugInfoLines[DEBUG_INFO_LINES];             // 调试信息框各行
+static bool debugInfoPanelValid = false;                          // 调试信息框背景是否已绘制且未被覆盖
+static CachedText_t peerLocalInfoLines[PEER_LOCAL_INFO_LINES];    // 对端信息界面的本机信息各行
+static CachedText_t peerListFields[MAX_PEERS_TO_DISPLAY][3];      // 对端列表: MAC / Uptime / 内存
+
+static const uint32_t fixedColors[4] = {TFT_BLUE, TFT_GREEN, TFT_RED, TFT_YELLOW}; // 固定颜色按钮 (与 WIDGET_COLOR_* 顺序一致)
+static size_t shownPeerCount = 0;                                                  // 对端信息按钮上当前显示的设备数
+
+// 控件绘制/按下回调 (见 uiManagerInit 中的注册)
+static void drawColorButton(WidgetId_t id);
+static void onColorButtonPressed(WidgetId_t id, int x, int y);
+static void onCustomColorButtonPressed(WidgetId_t id, int x, int y);
+static void drawUndoRedoButton(WidgetId_t id);
+static void drawWifiConnectButton(WidgetId_t id);
+static void onWifiConnectButtonPressed(WidgetId_t id, int x, int y);
 
 // --- 来自其他模块/主 .ino 文件的 Extern 变量 ---
 extern TFT_eSPI tft;    // 定义于 Project-ESPNow.ino
 extern bool isScreenOn; // 来自 power_manager 模块 (通过 ui_manager.h 间接包含 power_manager.h)
 // lastLocalPoint 和 lastLocalTouchTime 是 touch_handler 模块的内部状态, 不应在此 extern 或修改
 
-// macSet, allDrawingHistory, relativeBootTimeOffset, peerInfoMap 已在 ui_manager.h 中 extern 声明
+// allDrawingHistory, relativeBootTimeOffset 已在 ui_manager.h 中 extern 声明，对端列表通过 getPeerInfoList 读取
 // replayAllDrawings() 已在 esp_now_handler.h 中声明
-// lastRemotePoint, lastRemoteDrawTime 已在 esp_now_handler.h 中 extern 声明
 // getPeerInfoList() 已在 esp_now_handler.h 中声明
 
 // --- 函数实现 ---
 
 void uiManagerInit()
 {
-    // 占位符
+    // 调试信息框: 每行一个缓存文本字段
+    for (int i = 0; i < DEBUG_INFO_LINES; i++)
+    {
+        cachedTextInit(debugInfoLines[i], DEBUG_INFO_X + 2, DEBUG_INFO_Y + 2 + i * DEBUG_INFO_LINE_HEIGHT,
+                       (DEBUG_INFO_W - 4) / CACHED_TEXT_CELL_W, TFT_WHITE, TFT_GRAY);
+    }
+
+    // 对端信息界面: 本机信息每行一个字段，对端列表每行 MAC / Uptime / 内存三个字段
+    for (int i = 0; i < PEER_LOCAL_INFO_LINES; i++)
+    {
+        cachedTextInit(peerLocalInfoLines[i], PEER_LOCAL_INFO_X + 5, PEER_LOCAL_INFO_Y + 5 + i * PEER_LOCAL_INFO_LINE_HEIGHT,
+                       (PEER_LOCAL_INFO_W - 10) / CACHED_TEXT_CELL_W, TFT_WHITE, TFT_BLACK);
+    }
+    for (int row = 0; row < PEER_LIST_ROWS; row++)
+    {
+        int rowY = PEER_LIST_ROWS_Y + row * PEER_LIST_ROW_HEIGHT;
+        cachedTextInit(peerListFields[row][0], PEER_LIST_X, rowY,
+                       (PEER_LIST_COL_MAC_W + 5) / CACHED_TEXT_CELL_W, TFT_WHITE, TFT_BLACK);
+        cachedTextInit(peerListFields[row][1], PEER_LIST_X + PEER_LIST_COL_MAC_W + 5, rowY,
+                       (PEER_LIST_COL_UPTIME_W + 5) / CACHED_TEXT_CELL_W, TFT_WHITE, TFT_BLACK);
+        cachedTextInit(peerListFields[row][2], PEER_LIST_X + PEER_LIST_COL_MAC_W + PEER_LIST_COL_UPTIME_W + 10, rowY,
+                       (SCREEN_WIDTH - 5 - (PEER_LIST_X + PEER_LIST_COL_MAC_W + PEER_LIST_COL_UPTIME_W + 10)) / CACHED_TEXT_CELL_W, TFT_WHITE, TFT_BLACK);
+    }
+
+    // 主界面控件 (复位按钮的按下行为由 touch_handler 在 touchHandlerInit 中接管)
+    widgetRegister(WIDGET_RESET, UI_STATE_MAIN, RESET_BUTTON_X, RESET_BUTTON_Y, RESET_BUTTON_W, RESET_BUTTON_H,
+                   [](WidgetId_t) { drawResetButton(); }, nullptr);
+    for (int i = 0; i < 4; i++)
+    {
+        widgetRegister((WidgetId_t)(WIDGET_COLOR_BLUE + i), UI_STATE_MAIN,
+                       RESET_BUTTON_X, COLOR_BUTTON_START_Y + (COLOR_BUTTON_HEIGHT + COLOR_BUTTON_SPACING) * i,
+                       COLOR_BUTTON_WIDTH, COLOR_BUTTON_HEIGHT, drawColorButton, onColorButtonPressed);
+    }
+    widgetRegister(WIDGET_PEER_INFO, UI_STATE_MAIN, PEER_INFO_BUTTON_X, PEER_INFO_BUTTON_Y, PEER_INFO_BUTTON_W, PEER_INFO_BUTTON_H,
+                   [](WidgetId_t) { drawPeerInfoButton(); }, [](WidgetId_t, int, int) { showPeerInfoScreen(); });
+    widgetRegister(WIDGET_WIFI, UI_STATE_MAIN, WIFI_BUTTON_X, WIFI_BUTTON_Y, WIFI_BUTTON_W, WIFI_BUTTON_H,
+                   [](WidgetId_t) { drawWifiSettingsButton(); }, [](WidgetId_t, int, int) { showWifiSettingsScreen(); });
+    widgetRegister(WIDGET_CUSTOM_COLOR, UI_STATE_MAIN, CUSTOM_COLOR_BUTTON_X, CUSTOM_COLOR_BUTTON_Y, CUSTOM_COLOR_BUTTON_W, CUSTOM_COLOR_BUTTON_H,
+                   [](WidgetId_t) { drawStarButton(); }, onCustomColorButtonPressed);
+    widgetRegister(WIDGET_UNDO, UI_STATE_MAIN, UNDO_BUTTON_X, UNDO_BUTTON_Y, UNDO_BUTTON_W, UNDO_BUTTON_H,
+                   drawUndoRedoButton, nullptr); // 按下行为由 touch_handler 接管 (与复位按钮相同)
+    widgetRegister(WIDGET_REDO, UI_STATE_MAIN, REDO_BUTTON_X, REDO_BUTTON_Y, REDO_BUTTON_W, REDO_BUTTON_H,
+                   drawUndoRedoButton, nullptr);
+    widgetRegister(WIDGET_DEBUG_TOGGLE, UI_STATE_MAIN, DEBUG_TOGGLE_BUTTON_X, DEBUG_TOGGLE_BUTTON_Y, DEBUG_TOGGLE_BUTTON_W, DEBUG_TOGGLE_BUTTON_H,
+                   [](WidgetId_t) { drawDebugToggleButton(); }, [](WidgetId_t, int, int) { toggleDebugInfo(); });
+    widgetRegister(WIDGET_COFFEE, UI_STATE_MAIN, COFFEE_BUTTON_X, COFFEE_BUTTON_Y, COFFEE_BUTTON_W, COFFEE_BUTTON_H,
+                   [](WidgetId_t) { drawCoffeeButton(); }, [](WidgetId_t, int, int) { showCoffeePopup(); });
+    widgetRegister(WIDGET_DEBUG_PANEL, UI_STATE_MAIN, DEBUG_INFO_X, DEBUG_INFO_Y, DEBUG_INFO_W, DEBUG_INFO_H,
+                   [](WidgetId_t) { drawDebugInfo(); }, [](WidgetId_t, int, int) { toggleDebugInfo(); }, false);
+    widgetRegister(WIDGET_INFO, UI_STATE_MAIN, INFO_BUTTON_X, INFO_BUTTON_Y, INFO_BUTTON_W, INFO_BUTTON_H,
+                   [](WidgetId_t) { drawInfoButton(); }, [](WidgetId_t, int, int) { showProjectInfoPopup(); }, false);
+
+    // 对端信息界面控件
+    widgetRegister(WIDGET_PEER_BACK, UI_STATE_PEER_INFO, BACK_BUTTON_X, BACK_BUTTON_Y, BACK_BUTTON_W, BACK_BUTTON_H,
+                   [](WidgetId_t) { drawBackButton(); }, [](WidgetId_t, int, int) { hidePeerInfoScreen(); });
+
+    // WiFi 设置界面控件
+    widgetRegister(WIDGET_WIFI_CONNECT, UI_STATE_WIFI_SETTINGS, WIFI_CONNECT_BUTTON_X, WIFI_CONNECT_BUTTON_Y, WIFI_CONNECT_BUTTON_W, WIFI_CONNECT_BUTTON_H,
+                   drawWifiConnectButton, onWifiConnectButtonPressed);
+    widgetRegister(WIDGET_WIFI_BACK, UI_STATE_WIFI_SETTINGS, BACK_BUTTON_X, BACK_BUTTON_Y, BACK_BUTTON_W, BACK_BUTTON_H,
+                   [](WidgetId_t) { drawBackButton(); }, [](WidgetId_t, int, int) { hideWifiSettingsScreen(); });
+}
+
+// 根据当前 UI 状态标志更新主界面上可选控件的可见性
+static void syncMainWidgetVisibility()
+{
+    bool popupVisible = isProjectInfoPopupVisible || isCoffeePopupVisible;
+    widgetSetVisible(WIDGET_CUSTOM_COLOR, !inCustomColorMode);
+    widgetSetVisible(WIDGET_UNDO, !inCustomColorMode); // 调色盘覆盖右侧一列
+    widgetSetVisible(WIDGET_REDO, !inCustomColorMode);
+    widgetSetVisible(WIDGET_COFFEE, showDebugToggleButton && !inCustomColorMode);
+    widgetSetVisible(WIDGET_DEBUG_TOGGLE, showDebugToggleButton && !inCustomColorMode && !isCoffeePopupVisible);
+    widgetSetVisible(WIDGET_DEBUG_PANEL, isDebugInfoVisible && !inCustomColorMode);
+    widgetSetVisible(WIDGET_INFO, isDebugInfoVisible && !inCustomColorMode && !popupVisible);
 }
 
 void drawMainInterface()
 {
     tft.fillScreen(TFT_BLACK);
-    drawResetButton();
-    drawColorButtons();
-    drawPeerInfoButton(); // 此函数内部会调用 updateConnectedDevicesCount
-    drawWifiSettingsButton(); // 新增：绘制WiFi设置按钮
-    drawStarButton(); // 绘制颜色框和 "*"
+    invalidateDebugInfo(); // 调试信息框随清屏一起被擦除
+    // 按钮、调试信息框等均为控件: 同步可见性后整屏标脏，一次性重绘
+    syncMainWidgetVisibility();
+    widgetInvalidateScreen(UI_STATE_MAIN);
+    widgetRenderDirty();
     if (isScreenOn && !inCustomColorMode)
     {
-        if (isDebugInfoVisible)
-        {
-            drawDebugInfo();
-            if (!isProjectInfoPopupVisible && !isCoffeePopupVisible) { // 仅在弹窗未显示时绘制按钮
-                drawInfoButton();
-            }
-        }
-        if (showDebugToggleButton) // 并且 Coffee 弹窗未显示
-        {
-            if (!isCoffeePopupVisible) drawDebugToggleButton();
-            drawCoffeeButton(); // Coffee 按钮总是尝试绘制，但其内部会检查 isCoffeePopupVisible
-        }
         if (showSendProgress)
         {
             drawSendProgressIndicator();
@@ -110,27 +207,52 @@ void drawResetButton()
     float batteryPercentage = readBatteryVoltagePercentage();
     tft.setTextColor(TFT_WHITE, TFT_RED); // 设置文本背景为按钮颜色
     tft.setTextDatum(MC_DATUM);           // 居中对齐
-    tft.drawString(String(batteryPercentage, 0) + "%",
+    char batteryText[8];
+    snprintf(batteryText, sizeof(batteryText), "%.0f%%", batteryPercentage);
+    tft.drawString(batteryText,
                    RESET_BUTTON_X + RESET_BUTTON_W / 2,
                    RESET_BUTTON_Y + RESET_BUTTON_H / 2,
                    1);          // 使用1号字体以显示较小文本
     tft.setTextDatum(TL_DATUM); // 重置对齐方式
 }
 
+static void drawColorButton(WidgetId_t id)
+{
+    int i = id - WIDGET_COLOR_BLUE;
+    int buttonY = COLOR_BUTTON_START_Y + (COLOR_BUTTON_HEIGHT + COLOR_BUTTON_SPACING) * i;
+    tft.fillRect(RESET_BUTTON_X, buttonY, COLOR_BUTTON_WIDTH, COLOR_BUTTON_HEIGHT, fixedColors[i]);
+}
+
 void drawColorButtons()
 {
-    uint32_t colors[] = {TFT_BLUE, TFT_GREEN, TFT_RED, TFT_YELLOW};
     for (int i = 0; i < 4; i++)
     {
-        int buttonY = COLOR_BUTTON_START_Y + (COLOR_BUTTON_HEIGHT + COLOR_BUTTON_SPACING) * i;
-        tft.fillRect(RESET_BUTTON_X, buttonY, COLOR_BUTTON_WIDTH, COLOR_BUTTON_HEIGHT, colors[i]);
+        drawColorButton((WidgetId_t)(WIDGET_COLOR_BLUE + i));
     }
 }
 
+static void onColorButtonPressed(WidgetId_t id, int x, int y)
+{
+    (void)x;
+    (void)y;
+    updateCurrentColor(fixedColors[id - WIDGET_COLOR_BLUE]);
+    redrawStarButton(); // 用新颜色重绘星星按钮
+}
+
 void drawPeerInfoButton()
 {
+    shownPeerCount = peerInfoCount(); // 带详细信息的对端数
+    char deviceCountBuffer[10];
+    sprintf(deviceCountBuffer, "%u", (unsigned)shownPeerCount);
+
     tft.fillRect(PEER_INFO_BUTTON_X, PEER_INFO_BUTTON_Y, PEER_INFO_BUTTON_W, PEER_INFO_BUTTON_H, TFT_BLUE);
-    updateConnectedDevicesCount(); // 更新按钮上的设备计数
+    tft.setTextColor(TFT_WHITE, TFT_BLUE);
+    tft.setTextDatum(MC_DATUM);
+    tft.drawString(deviceCountBuffer,
+                   PEER_INFO_BUTTON_X + PEER_INFO_BUTTON_W / 2,
+                   PEER_INFO_BUTTON_Y + PEER_INFO_BUTTON_H / 2,
+                   1);
+    tft.setTextDatum(TL_DATUM);
 }
 
 void drawCustomColorButton()
@@ -147,79 +269,73 @@ void drawStarButton()
     tft.setTextDatum(TL_DATUM);
 }
 
-void drawDebugInfo()
+void invalidateDebugInfo()
 {
-    if (!isScreenOn || inCustomColorMode || !isDebugInfoVisible)
-        return;
-
-    int startX = 2;
-    int startY = SCREEN_HEIGHT - 42;
-    int lineHeight = 10;
-    uint16_t bgColor = TFT_GRAY;
-    uint16_t textColor = TFT_WHITE;
-    int rectHeight = 4 * lineHeight + 2;
-
-    // 如果弹窗可见，则不绘制调试信息背景，避免覆盖弹窗
-    if (!isProjectInfoPopupVisible && !isCoffeePopupVisible) {
-        tft.fillRect(startX, startY, 120, rectHeight, bgColor);
-    }
-
-    tft.setTextColor(textColor, bgColor); // 背景色用于文本背景，使其在弹窗上也可见
-    tft.setTextSize(1);
-    tft.setTextFont(1); // 默认字体
-
-    char buffer[50];
-
-    sprintf(buffer, "Hist: %u", allDrawingHistory.size());
-    tft.setCursor(startX + 2, startY + 2);
-    tft.print(buffer);
-
-    sprintf(buffer, "Uptime: %lu", millis());
-    tft.setCursor(startX + 2, startY + 2 + lineHeight);
-    tft.print(buffer);
-
-    sprintf(buffer, "Comp: %ld", relativeBootTimeOffset);
-    tft.setCursor(startX + 2, startY + 2 + 2 * lineHeight);
-    tft.print(buffer);
-
-    sprintf(buffer, "Mem: %u/%uKB", ESP.getFreeHeap() / 1024, ESP.getHeapSize() / 1024);
-    tft.setCursor(startX + 2, startY + 2 + 3 * lineHeight);
-    tft.print(buffer);
+    debugInfoPanelValid = false;
 }
 
-bool isResetButtonPressed(int x, int y)
+void drawDebugInfo()
 {
-    return x >= RESET_BUTTON_X && x <= RESET_BUTTON_X + RESET_BUTTON_W &&
-           y >= RESET_BUTTON_Y && y <= RESET_BUTTON_Y + RESET_BUTTON_H;
-}
+    if (!isScreenOn || inCustomColorMode || !isDebugInfoVisible || currentUIState != UI_STATE_MAIN)
+        return;
 
-bool isColorButtonPressed(int x, int y, uint32_t &selectedColor)
-{
-    uint32_t colors[] = {TFT_BLUE, TFT_GREEN, TFT_RED, TFT_YELLOW};
-    for (int i = 0; i < 4; i++)
+    if (!debugInfoPanelValid)
     {
-        int buttonY = COLOR_BUTTON_START_Y + (COLOR_BUTTON_HEIGHT + COLOR_BUTTON_SPACING) * i;
-        if (x >= RESET_BUTTON_X && x <= RESET_BUTTON_X + COLOR_BUTTON_WIDTH &&
-            y >= buttonY && y <= buttonY + COLOR_BUTTON_HEIGHT)
+        // 如果弹窗可见，则不绘制调试信息背景，避免覆盖弹窗 (文本仍带背景色绘制，使其在弹窗上也可见)
+        if (!isProjectInfoPopupVisible && !isCoffeePopupVisible) {
+            tft.fillRect(DEBUG_INFO_X, DEBUG_INFO_Y, DEBUG_INFO_W, DEBUG_INFO_H, TFT_GRAY);
+        }
+        for (int i = 0; i < DEBUG_INFO_LINES; i++)
         {
-            selectedColor = colors[i];
-            return true;
+            cachedTextInvalidate(debugInfoLines[i]);
         }
+        debugInfoPanelValid = true;
     }
-    return false;
-}
 
-bool isPeerInfoButtonPressed(int x, int y)
-{
-    return x >= PEER_INFO_BUTTON_X && x <= PEER_INFO_BUTTON_X + PEER_INFO_BUTTON_W &&
-           y >= PEER_INFO_BUTTON_Y && y <= PEER_INFO_BUTTON_Y + PEER_INFO_BUTTON_H;
-}
+    char buffer[50];
 
+    historyLock(); // 历史由网络任务写入
+    size_t historySize = allDrawingHistory.size();
+    historyUnlock();
+    snprintf(buffer, sizeof(buffer), "Hist: %u", (unsigned)historySize);
+    cachedTextDraw(debugInfoLines[0], buffer);
+
+    snprintf(buffer, sizeof(buffer), "Uptime: %lu", millis());
+    cachedTextDraw(debugInfoLines[1], buffer);
+
+    snprintf(buffer, sizeof(buffer), "Comp: %ld", relativeBootTimeOffset);
+    cachedTextDraw(debugInfoLines[2], buffer);
+
+    snprintf(buffer, sizeof(buffer), "Mem: %u/%uKB", ESP.getFreeHeap() / 1024, ESP.getHeapSize() / 1024);
+    cachedTextDraw(debugInfoLines[3], buffer);
+
+    // 触摸采样任务: 实际频率、平均/最大节拍抖动
+    TouchTaskStats_t touchStats;
+    touchTaskGetStats(touchStats);
+    snprintf(buffer, sizeof(buffer), "Tch:%luHz j%lu/%luus", (unsigned long)touchStats.sampleRateHz,
+             (unsigned long)touchStats.jitterMeanUs, (unsigned long)touchStats.jitterMaxUs);
+    cachedTextDraw(debugInfoLines[4], buffer);
+
+    // 触摸到屏幕延迟 p50/p99 (毫秒): 本机笔迹和对端笔迹
+    uint32_t renderP50 = latencyPercentile(LATENCY_RENDER, 50), renderP99 = latencyPercentile(LATENCY_RENDER, 99);
+    snprintf(buffer, sizeof(buffer), "Drw %lu.%lu/%lu.%lums", (unsigned long)(renderP50 / 1000), (unsigned long)(renderP50 % 1000 / 100),
+             (unsigned long)(renderP99 / 1000), (unsigned long)(renderP99 % 1000 / 100));
+    cachedTextDraw(debugInfoLines[5], buffer);
+
+    uint32_t remoteP50 = latencyPercentile(LATENCY_REMOTE_RENDER, 50), remoteP99 = latencyPercentile(LATENCY_REMOTE_RENDER, 99);
+    snprintf(buffer, sizeof(buffer), "Rx %lu.%lu/%lu.%lums", (unsigned long)(remoteP50 / 1000), (unsigned long)(remoteP50 % 1000 / 100),
+             (unsigned long)(remoteP99 / 1000), (unsigned long)(remoteP99 % 1000 / 100));
+    cachedTextDraw(debugInfoLines[6], buffer);
+}
 
-bool isCustomColorButtonPressed(int x, int y)
+static void onCustomColorButtonPressed(WidgetId_t id, int x, int y)
 {
-    return x >= CUSTOM_COLOR_BUTTON_X && x <= CUSTOM_COLOR_BUTTON_X + CUSTOM_COLOR_BUTTON_W &&
-           y >= CUSTOM_COLOR_BUTTON_Y && y <= CUSTOM_COLOR_BUTTON_Y + CUSTOM_COLOR_BUTTON_H;
+    (void)id;
+    (void)x;
+    (void)y;
+    inCustomColorMode = true; // 进入自定义颜色模式
+    drawColorSelectors();     // 绘制颜色选择器
+    hideStarButton();         // 隐藏星星按钮
 }
 
 bool isBackButtonPressed(int x, int y)
@@ -228,11 +344,26 @@ bool isBackButtonPressed(int x, int y)
            y >= BACK_BUTTON_Y && y <= BACK_BUTTON_Y + BACK_BUTTON_H;
 }
 
-bool isDebugToggleButtonPressed(int x, int y)
+void drawBackButton()
 {
-    // 假设按钮在左下角，尺寸为 DEBUG_TOGGLE_BUTTON_SIZE
-    return x >= DEBUG_TOGGLE_BUTTON_X && x <= DEBUG_TOGGLE_BUTTON_X + DEBUG_TOGGLE_BUTTON_W &&
-           y >= DEBUG_TOGGLE_BUTTON_Y && y <= DEBUG_TOGGLE_BUTTON_Y + DEBUG_TOGGLE_BUTTON_H;
+    tft.fillRect(BACK_BUTTON_X, BACK_BUTTON_Y, BACK_BUTTON_W, BACK_BUTTON_H, TFT_DARKGREY);
+    tft.setTextColor(TFT_WHITE, TFT_DARKGREY);
+    tft.setTextDatum(MC_DATUM);
+    tft.drawString("B", BACK_BUTTON_X + BACK_BUTTON_W / 2, BACK_BUTTON_Y + BACK_BUTTON_H / 2, 2);
+    tft.setTextDatum(TL_DATUM);
+}
+
+// 撤销 "<" / 重做 ">" 按钮
+static void drawUndoRedoButton(WidgetId_t id)
+{
+    bool undo = id == WIDGET_UNDO;
+    int x = undo ? UNDO_BUTTON_X : REDO_BUTTON_X;
+    int y = undo ? UNDO_BUTTON_Y : REDO_BUTTON_Y;
+    tft.fillRect(x, y, UNDO_BUTTON_W, UNDO_BUTTON_H, TFT_DARKGREY);
+    tft.setTextColor(TFT_WHITE, TFT_DARKGREY);
+    tft.setTextDatum(MC_DATUM);
+    tft.drawString(undo ? "<" : ">", x + UNDO_BUTTON_W / 2, y + UNDO_BUTTON_H / 2, 2);
+    tft.setTextDatum(TL_DATUM);
 }
 
 void drawDebugToggleButton()
@@ -252,10 +383,10 @@ void toggleDebugInfo()
     isDebugInfoVisible = !isDebugInfoVisible;
     showDebugToggleButton = !isDebugInfoVisible;
     if (isProjectInfoPopupVisible && !isDebugInfoVisible) { // 如果关闭调试信息时弹窗是开的，也关掉弹窗
-        hideProjectInfoPopup(); // 这会触发 redrawMainScreen
-    } else {
-        redrawMainScreen();
+        hideProjectInfoPopup(); // 重绘弹窗区域
     }
+    // 调试信息框、其上方的项目信息按钮以及框内的 "D"/"C" 按钮所在的左下角区域
+    redrawRegion(0, INFO_BUTTON_Y, DEBUG_INFO_X + DEBUG_INFO_W, SCREEN_HEIGHT - INFO_BUTTON_Y);
 }
 
 void handleCustomColorTouch(int x, int y)
@@ -264,15 +395,15 @@ void handleCustomColorTouch(int x, int y)
     {
         if (y >= 0 && y < COLOR_SLIDER_HEIGHT)
         {
-            updateSingleColorSlider(y, TFT_RED, redValue);
+            updateSingleColorSlider(y, redValue);
         }
         else if (y >= COLOR_SLIDER_HEIGHT && y < 2 * COLOR_SLIDER_HEIGHT)
         {
-            updateSingleColorSlider(y - COLOR_SLIDER_HEIGHT, TFT_GREEN, greenValue);
+            updateSingleColorSlider(y - COLOR_SLIDER_HEIGHT, greenValue);
         }
         else if (y >= 2 * COLOR_SLIDER_HEIGHT && y < 3 * COLOR_SLIDER_HEIGHT)
         {
-            updateSingleColorSlider(y - (2 * COLOR_SLIDER_HEIGHT), TFT_BLUE, blueValue);
+            updateSingleColorSlider(y - (2 * COLOR_SLIDER_HEIGHT), blueValue);
         }
         else if (isBackButtonPressed(x, y))
         {
@@ -285,7 +416,7 @@ void handleCustomColorTouch(int x, int y)
     }
 }
 
-void updateSingleColorSlider(int yPos, uint32_t sliderColor, int &channelValue)
+void updateSingleColorSlider(int yPos, int &channelValue)
 {
     channelValue = constrain(map(yPos, 0, COLOR_SLIDER_HEIGHT - 1, 255, 0), 0, 255);
     // 绘制由 refreshAllColorSliders 处理
@@ -295,12 +426,7 @@ void drawColorSelectors()
 {
     // tft.fillScreen(TFT_BLACK); // 清屏 - 移除此行，调色盘应覆盖在当前屏幕上
     refreshAllColorSliders();
-
-    tft.fillRect(BACK_BUTTON_X, BACK_BUTTON_Y, BACK_BUTTON_W, BACK_BUTTON_H, TFT_DARKGREY);
-    tft.setTextColor(TFT_WHITE, TFT_DARKGREY);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString("B", BACK_BUTTON_X + BACK_BUTTON_W / 2, BACK_BUTTON_Y + BACK_BUTTON_H / 2, 2);
-    tft.setTextDatum(TL_DATUM);
+    drawBackButton();
 }
 
 void updateCustomColorPreview()
@@ -366,14 +492,7 @@ void closeColorSelectors()
     inCustomColorMode = false;
     currentUIState = UI_STATE_MAIN; // 切换回主界面状态
 
-    if (savedScreenBuffer != nullptr)
-    {
-        restoreSavedScreenArea();
-    }
-
-    tft.fillScreen(TFT_BLACK);
-    drawMainInterface();
-    replayAllDrawings();
+    redrawRegion(COLOR_PICKER_AREA_X, 0, COLOR_PICKER_AREA_W, SCREEN_HEIGHT); // 只重绘调色盘覆盖的一列
 }
 
 void updateCurrentColor(uint32_t newColor)
@@ -383,68 +502,69 @@ void updateCurrentColor(uint32_t newColor)
 
 void updateConnectedDevicesCount()
 {
-    char deviceCountBuffer[10];
-    sprintf(deviceCountBuffer, "%d", peerInfoMap.size()); // 使用 peerInfoMap 的大小
-
-    tft.fillRect(PEER_INFO_BUTTON_X, PEER_INFO_BUTTON_Y, PEER_INFO_BUTTON_W, PEER_INFO_BUTTON_H, TFT_BLUE);
-    tft.setTextColor(TFT_WHITE, TFT_BLUE);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString(String(deviceCountBuffer),
-                   PEER_INFO_BUTTON_X + PEER_INFO_BUTTON_W / 2,
-                   PEER_INFO_BUTTON_Y + PEER_INFO_BUTTON_H / 2,
-                   1);
-    tft.setTextDatum(TL_DATUM);
-}
-
-void saveScreenArea()
-{
-    if (savedScreenBuffer == nullptr)
+    // 设备数变化时才重绘对端信息按钮
+    if (peerInfoCount() != shownPeerCount)
     {
-        int bufferHeight = 4 * COLOR_SLIDER_HEIGHT;
-        if (bufferHeight > SCREEN_HEIGHT)
-            bufferHeight = SCREEN_HEIGHT;
-        savedScreenBuffer = new uint16_t[COLOR_SLIDER_WIDTH * bufferHeight];
+        widgetInvalidate(WIDGET_PEER_INFO);
     }
-    int readHeight = 4 * COLOR_SLIDER_HEIGHT;
-    if (readHeight > SCREEN_HEIGHT)
-        readHeight = SCREEN_HEIGHT;
-    tft.readRect(SCREEN_WIDTH - COLOR_SLIDER_WIDTH - 4, 0, COLOR_SLIDER_WIDTH, readHeight, savedScreenBuffer);
 }
 
-void restoreSavedScreenArea()
+void redrawRegion(int x, int y, int w, int h)
 {
-    if (savedScreenBuffer != nullptr)
+    if (currentUIState != UI_STATE_MAIN)
+    {
+        redrawMainScreen();
+        return;
+    }
+    // 可见性刚变化 (例如弹窗关闭后重新显示的按钮) 或已标脏的控件照常完整绘制
+    syncMainWidgetVisibility();
+    widgetRenderDirty();
+
+    // 区域内: 背景、控件、进度条，然后是笔划 (与 drawMainInterface + replayAllDrawings 的顺序相同)
+    tft.setViewport(x, y, w, h, false); // 之后的绘制裁剪到区域内，坐标仍为屏幕坐标
+    tft.fillRect(x, y, w, h, TFT_BLACK);
+    if (x < DEBUG_INFO_X + DEBUG_INFO_W && x + w > DEBUG_INFO_X && y < DEBUG_INFO_Y + DEBUG_INFO_H && y + h > DEBUG_INFO_Y)
     {
-        int pushHeight = 4 * COLOR_SLIDER_HEIGHT;
-        if (pushHeight > SCREEN_HEIGHT > SCREEN_HEIGHT)
-            pushHeight = SCREEN_HEIGHT;
-        tft.pushImage(SCREEN_WIDTH - COLOR_SLIDER_WIDTH - 4, 0, COLOR_SLIDER_WIDTH, pushHeight, savedScreenBuffer);
-        delete[] savedScreenBuffer;
-        savedScreenBuffer = nullptr;
+        invalidateDebugInfo(); // 调试信息框被部分擦除
     }
+    widgetInvalidateScreen(UI_STATE_MAIN);
+    widgetRenderDirty();
+    if (isScreenOn && !inCustomColorMode)
+    {
+        if (showSendProgress)
+        {
+            drawSendProgressIndicator();
+        }
+        if (showReceiveProgress)
+        {
+            drawReceiveProgressIndicator();
+        }
+    }
+    tft.resetViewport();
+    replayRegion(x, y, w, h);
 }
 
 void clearScreenAndCache()
 {
-    allDrawingHistory.clear();
+    // 绘图历史由网络任务清空 (NET_OP_LOCAL_RESET / NET_OP_CLEAR_HISTORY 或收到的复位/同步消息)
     tft.fillScreen(TFT_BLACK);
     drawMainInterface(); // 清屏后重绘主界面骨架
 }
 
 void hideStarButton()
 {
+    widgetSetVisible(WIDGET_CUSTOM_COLOR, false);
     tft.fillRect(CUSTOM_COLOR_BUTTON_X, CUSTOM_COLOR_BUTTON_Y, CUSTOM_COLOR_BUTTON_W, CUSTOM_COLOR_BUTTON_H, TFT_BLACK);
 }
 
 void showStarButton()
 {
-    drawStarButton();
+    widgetSetVisible(WIDGET_CUSTOM_COLOR, true); // 由 widgetRenderDirty 重绘
 }
 
 void redrawStarButton()
 {
-    hideStarButton();
-    drawStarButton();
+    widgetInvalidate(WIDGET_CUSTOM_COLOR); // drawStarButton 会先用当前颜色填满按钮，无需先擦除
 }
 
 // --- 进度条函数实现 ---
@@ -585,29 +705,31 @@ void drawCoffeeButton() {
     tft.setTextDatum(TL_DATUM);
 }
 
-bool isCoffeeButtonPressed(int x, int y) {
-    if (!showDebugToggleButton || currentUIState != UI_STATE_MAIN) return false; // 如果D按钮不显示，C按钮也无效，或不在主界面
-    return x >= COFFEE_BUTTON_X && x <= COFFEE_BUTTON_X + COFFEE_BUTTON_W &&
-           y >= COFFEE_BUTTON_Y && y <= COFFEE_BUTTON_Y + COFFEE_BUTTON_H;
+// 在 (x, y) 处绘制预先合并好的二维码矩形 (背景须已填充)，每个矩形一次 fillRect
+static void drawQrRects(int x, int y, const QrRect_t *rects, int count, uint16_t color) {
+    for (int i = 0; i < count; i++) {
+        tft.fillRect(x + rects[i].x, y + rects[i].y, rects[i].w, rects[i].h, color);
+    }
 }
 
 void showCoffeePopup() {
     if (!isScreenOn || inCustomColorMode || currentUIState != UI_STATE_MAIN) return;
 
     isCoffeePopupVisible = true;
+    invalidateDebugInfo(); // 弹窗会覆盖调试信息框
+    syncMainWidgetVisibility(); // 弹窗期间隐藏 "D" 和项目信息按钮
     // isDebugInfoVisible = false; // 打开C弹窗时，可以考虑隐藏D的调试信息区域
     // showDebugToggleButton = false; // 同时隐藏D按钮
 
     // 弹窗区域和颜色
-    int popupX = 10;
-    int popupY = 10;
-    int popupW = SCREEN_WIDTH - 2 * popupX;
-    int popupH = SCREEN_HEIGHT - 2 * popupY;
+    int popupX = POPUP_X;
+    int popupY = POPUP_Y;
+    int popupW = POPUP_W;
+    int popupH = POPUP_H;
     uint16_t popupBgColor = tft.color565(70, 70, 70); // 深灰色
     uint16_t popupBorderColor = TFT_WHITE;
     uint16_t textColor = TFT_WHITE;
-    uint16_t qrPixelColor = TFT_WHITE;
-    uint16_t qrBgColor = popupBgColor; // 二维码背景与弹窗背景一致
+    uint16_t qrPixelColor = TFT_WHITE; // 二维码背景即弹窗背景，只画深色模块
 
     tft.fillRect(popupX, popupY, popupW, popupH, popupBgColor);
     tft.drawRect(popupX, popupY, popupW, popupH, popupBorderColor);
@@ -641,130 +763,25 @@ void showCoffeePopup() {
 
     textY += lineHeight * 1.5; // 文本和二维码之间的间距
 
-    // 支付宝二维码数据
-    const char *qr_data_alipay =
-        "EEEEEEE.E....EEEE.E...EEEEEEE\n"
-        "E.....E.E..EEEE..E.E..E.....E\n"
-        "E.EEE.E.EE..E.E..E.EE.E.EEE.E\n"
-        "E.EEE.E.EEE.EEEEE.EE..E.EEE.E\n"
-        "E.EEE.E..EE.E..EEEE.E.E.EEE.E\n"
-        "E.....E.EEE...E.EEEE..E.....E\n"
-        "EEEEEEE.E.E.E.E.E.E.E.EEEEEEE\n"
-        "..........EE.....EE.E........\n"
-        "EE..EEE...E.E...EE..E..E.EEEE\n"
-        "EEEE.E.E.....E.E.E....EEEEEEE\n"
-        "E..EE.E.EEE....EEE..E.......E\n"
-        "....EE..EE..E.EE.E.EEEEE.E.EE\n"
-        "EE....E.E..E..E.EEE.EE.....E.\n"
-        ".E..EE.EEEE.EE.E......EEEEEEE\n"
-        ".E..E.EE.EEEE..E.E..EE.EEEE.E\n"
-        "..E..E.E.EEE..EE.EEE..E.E..EE\n"
-        "EEEEEEEE..E.E....EEEEE.....E.\n"
-        "EEEEEE.E..E..EEEE....EE.EE.EE\n"
-        "..E..EEEEEE..E.E.....EEEE.E.E\n"
-        "...E......E.E....E.EEEEE...EE\n"
-        "EEE.EEEE...EE...EEE.EEEEEE..E\n"
-        "........E.E.EEEE.E.EE...E...E\n"
-        "EEEEEEE....EEE.EEE.EE.E.EEE.E\n"
-        "E.....E.EEEEE..E.EE.E...E...E\n"
-        "E.EEE.E.E.E.....EEEEEEEEEE.EE\n"
-        "E.EEE.E..E.EE..EE...EE.E....E\n"
-        "E.EEE.E..E.EEE.EE.E.EE...EEEE\n"
-        "E.....E.EE.EE..EEE.EEEE..E.EE\n"
-        "EEEEEEE.EEE.E..EEEE.EE..E..E.";
-
-    // 微信二维码数据
-    const char *qr_data_wechat =
-        "EEEEEEE.EE.EE..E...E..EEEEEEE\n"
-        "E.....E.E.E..EE...EE..E.....E\n"
-        "E.EEE.E.EE.E...EEEEE..E.EEE.E\n"
-        "E.EEE.E.E..EE.E.....E.E.EEE.E\n"
-        "E.EEE.E...E..E.E...E..E.EEE.E\n"
-        "E.....E.E.E.....EEEE..E.....E\n"
-        "EEEEEEE.E.E.E.E.E.E.E.EEEEEEE\n"
-        ".........E.E..EEEEEEE........\n"
-        "EE..EEE...EE.E..E...E..E.EEEE\n"
-        "E.E.EE..E.EE.EEEEEEE...EEE.EE\n"
-        ".EEEEEEE.EEEE.EEE...EE.EE.EEE\n"
-        "EEEEE...EE.EE..E.E.E..E.E..EE\n"
-        "...EE.E....EEE.....EEE..EE...\n"
-        "EE...E.EEE....E.E....E.EE..EE\n"
-        "E...EEEEE..EEEEE....E.EEEEE.E\n"
-        "...EE.....E.E...EE.E.E.....EE\n"
-        ".E...EEEEEE.E..E.E.E.E.E.E..E\n"
-        "EEE..........EE.E..E....E..EE\n"
-        "..EEEEEEEE.EE.EE..E..E.E.EE.E\n"
-        "..E.EE..E.E.E.EE.EEEEE.E.E...\n"
-        "EE...EE.EEE........EEEEEEE.E.\n"
-        "........E....EEEEEE.E...E.EEE\n"
-        "EEEEEEE....EE..EE.E.E.E.E.E.E\n"
-        "E.....E.E..EE.E.EE.EE...E...E\n"
-        "E.EEE.E.E.....EE...EEEEEE..E.\n"
-        "E.EEE.E...E..E..E...EE.E.EEEE\n"
-        "E.EEE.E..E.E...E.EE.E.EE..EEE\n"
-        "E.....E.E..E..E..E.EEE.EEE.EE\n"
-        "EEEEEEE.EEEE..E.E...E.EEEE.E.";
-
-    int qrPixelSize = 2; // 每个二维码“像素”的大小
-    int qrWidthInPixels = 29 * qrPixelSize; // 二维码的屏幕宽度
-    int qrHeightInPixels = 29 * qrPixelSize; // 二维码的屏幕高度
+    // 二维码由 qr_to_text.py 预先合并成矩形 (见 qr_bitmaps.h)
     int spacingBetweenQRs = 10; // 两个二维码之间的间距
-    int totalQRWidth = 2 * qrWidthInPixels + spacingBetweenQRs;
+    int totalQRWidth = QR_ALIPAY_WIDTH + spacingBetweenQRs + QR_WECHAT_WIDTH;
 
     int qrCommonY = textY + lineHeight; // 二维码的共同起始Y坐标 (在标签下方)
 
     // 绘制支付宝二维码
     int qrAlipayOffsetX = popupX + (popupW - totalQRWidth) / 2;
     tft.setTextDatum(TC_DATUM);
-    tft.drawString("Alipay", qrAlipayOffsetX + qrWidthInPixels / 2, textY, 1); // 标签字体大小1
-
-    char lineBuffer[35];
-    const char *p_alipay = qr_data_alipay;
-    int currentY_alipay = qrCommonY;
-
-    for (int row = 0; row < 29 && *p_alipay; ++row) { // 假设支付宝二维码是29行
-        int i = 0;
-        while (*p_alipay && *p_alipay != '\n' && i < 30) {
-            lineBuffer[i++] = *p_alipay++;
-        }
-        lineBuffer[i] = '\0';
-        if (*p_alipay == '\n') p_alipay++;
-
-        for (int j = 0; j < i; ++j) {
-            if (lineBuffer[j] == 'E') {
-                tft.fillRect(qrAlipayOffsetX + j * qrPixelSize, currentY_alipay, qrPixelSize, qrPixelSize, qrPixelColor);
-            }
-        }
-        currentY_alipay += qrPixelSize;
-        if (currentY_alipay > popupY + popupH - 5 - qrPixelSize) break;
-    }
+    tft.drawString("Alipay", qrAlipayOffsetX + QR_ALIPAY_WIDTH / 2, textY, 1); // 标签字体大小1
+    drawQrRects(qrAlipayOffsetX, qrCommonY, QR_ALIPAY_RECTS, QR_ALIPAY_RECT_COUNT, qrPixelColor);
 
     // 绘制微信二维码
-    int qrWechatOffsetX = qrAlipayOffsetX + qrWidthInPixels + spacingBetweenQRs;
-    tft.drawString("WeChat", qrWechatOffsetX + qrWidthInPixels / 2, textY, 1); // 标签字体大小1
-
-    const char *p_wechat = qr_data_wechat;
-    int currentY_wechat = qrCommonY;
-
-    for (int row = 0; row < 29 && *p_wechat; ++row) { // 假设微信二维码也是29行
-        int i = 0;
-        while (*p_wechat && *p_wechat != '\n' && i < 30) {
-            lineBuffer[i++] = *p_wechat++;
-        }
-        lineBuffer[i] = '\0';
-        if (*p_wechat == '\n') p_wechat++;
-
-        for (int j = 0; j < i; ++j) {
-            if (lineBuffer[j] == 'E') {
-                tft.fillRect(qrWechatOffsetX + j * qrPixelSize, currentY_wechat, qrPixelSize, qrPixelSize, qrPixelColor);
-            }
-        }
-        currentY_wechat += qrPixelSize;
-        if (currentY_wechat > popupY + popupH - 5 - qrPixelSize) break;
-    }
+    int qrWechatOffsetX = qrAlipayOffsetX + QR_ALIPAY_WIDTH + spacingBetweenQRs;
+    tft.drawString("WeChat", qrWechatOffsetX + QR_WECHAT_WIDTH / 2, textY, 1); // 标签字体大小1
+    drawQrRects(qrWechatOffsetX, qrCommonY, QR_WECHAT_RECTS, QR_WECHAT_RECT_COUNT, qrPixelColor);
 
     // --- 新增 Shapaper's Blog 二维码 ---
-    textY = currentY_alipay > currentY_wechat ? currentY_alipay : currentY_wechat; // 取两个二维码中较低的Y值作为基准
+    textY = qrCommonY + std::max(QR_ALIPAY_HEIGHT, QR_WECHAT_HEIGHT); // 取两个二维码中较低的Y值作为基准
     textY += lineHeight * 0.5; // 在二维码下方留出一些间距
 
     tft.setTextDatum(TC_DATUM);
@@ -774,57 +791,8 @@ void showCoffeePopup() {
     tft.drawString("Have many interesting things,Scan to visit", popupX + 5, textY, 1); // 博客二维码标签
     textY += lineHeight; // 为二维码留出空间
 
-    const char *qr_data_blog =
-        "EEEEEEE..E....E.E.EEEEEEE\n"
-        "E.....E.EE.EE.EEE.E.....E\n"
-        "E.EEE.E..EEE...EE.E.EEE.E\n"
-        "E.EEE.E.EE.E.EEE..E.EEE.E\n"
-        "E.EEE.E...E.E...E.E.EEE.E\n"
-        "E.....E.E.E....EE.E.....E\n"
-        "EEEEEEE.E.E.E.E.E.E.EEEEEEE\n"
-        "............E.EEE........\n"
-        "EEEEE.EEEEE.EE...E.E.E.E.\n"
-        "EE.EEE.E.E...E..E..E...E.\n"
-        "EE....E..E.EEEEEEE..EE.EE\n"
-        "....E..EEEEE...E..E.....E\n"
-        "..E..EE..E.E.EE..EE.E.EEE\n"
-        "E.EE.E....E.E.E.E..E.E.E.\n"
-        "E.EE.EEE......EE.E.EEE.EE\n"
-        "E..EEE..E...E..EEE.EE...E\n"
-        "E...E.E.EE..EEEEEEEEE.E..\n"
-        "........EE...E.EE...EE...\n"
-        "EEEEEEE.E.EEEEE.E.E.E.EEE\n"
-        "E.....E....E..E.E...EE..E\n"
-        "E.EEE.E.E.EEEEEEEEEEE.E..\n"
-        "E.EEE.E.EEE.E.EEEEE.EEEEE\n"
-        "E.EEE.E.EEE.....E....EE.E\n"
-        "E.....E.E.EE...EEEEEEE..E\n"
-        "EEEEEEE.E..EEE.E.E.EEEEEE";
-
-    int qrPixelSizeBlog = 2; // 博客二维码像素大小
-    int qrWidthInCharsBlog = 29; // 博客二维码字符宽度
-    int qrDisplayWidthBlog = qrWidthInCharsBlog * qrPixelSizeBlog;
-
-    int qrBlogOffsetX = popupX + (popupW - qrDisplayWidthBlog) / 2; // 单个二维码居中
-    int currentY_blog = textY;
-    const char *p_blog = qr_data_blog;
-
-    for (int row = 0; row < 25 && *p_blog; ++row) { // 假设博客二维码也是25行 (根据txt内容调整)
-        int i = 0;
-        while (*p_blog && *p_blog != '\n' && i < qrWidthInCharsBlog) {
-            lineBuffer[i++] = *p_blog++;
-        }
-        lineBuffer[i] = '\0';
-        if (*p_blog == '\n') p_blog++;
-
-        for (int j = 0; j < i; ++j) {
-            if (lineBuffer[j] == 'E') {
-                tft.fillRect(qrBlogOffsetX + j * qrPixelSizeBlog, currentY_blog, qrPixelSizeBlog, qrPixelSizeBlog, qrPixelColor);
-            }
-        }
-        currentY_blog += qrPixelSizeBlog;
-        if (currentY_blog > popupY + popupH - 5 - qrPixelSizeBlog - lineHeight) break; // 避免覆盖关闭提示
-    }
+    int qrBlogOffsetX = popupX + (popupW - QR_BLOG_WIDTH) / 2; // 单个二维码居中
+    drawQrRects(qrBlogOffsetX, textY, QR_BLOG_RECTS, QR_BLOG_RECT_COUNT, qrPixelColor);
     // --- 结束新增 Shapaper's Blog 二维码 ---
 
     tft.setTextDatum(BC_DATUM);
@@ -836,7 +804,7 @@ void hideCoffeePopup() {
     if (isCoffeePopupVisible) {
         isCoffeePopupVisible = false;
         // showDebugToggleButton = true; // 恢复D按钮的显示（如果之前隐藏了）
-        redrawMainScreen();
+        redrawRegion(POPUP_X, POPUP_Y, POPUP_W, POPUP_H); // 只重绘弹窗盖住的区域
     }
 }
 
@@ -852,22 +820,18 @@ void drawInfoButton() {
     tft.setTextDatum(TL_DATUM);
 }
 
-bool isInfoButtonPressed(int x, int y) {
-    if (!isDebugInfoVisible || isCoffeePopupVisible || currentUIState != UI_STATE_MAIN) return false; // 仅当调试信息可见且Coffee弹窗关闭时按钮才有效，且在主界面
-    return x >= INFO_BUTTON_X && x <= INFO_BUTTON_X + INFO_BUTTON_W &&
-           y >= INFO_BUTTON_Y && y <= INFO_BUTTON_Y + INFO_BUTTON_H;
-}
-
 void showProjectInfoPopup() {
     if (!isScreenOn || inCustomColorMode || isCoffeePopupVisible || currentUIState != UI_STATE_MAIN) return; // 如果Coffee弹窗显示，则不显示此弹窗，或不在主界面
 
     isProjectInfoPopupVisible = true;
+    invalidateDebugInfo(); // 弹窗会覆盖调试信息框
+    syncMainWidgetVisibility(); // 弹窗期间隐藏项目信息按钮
 
     // 弹窗区域和颜色 - 增大弹窗
-    int popupX = 10; // 减小边距，使弹窗更大
-    int popupY = 10; // 减小边距
-    int popupW = SCREEN_WIDTH - 2 * popupX;
-    int popupH = SCREEN_HEIGHT - 2 * popupY; // 占据更多高度
+    int popupX = POPUP_X;
+    int popupY = POPUP_Y;
+    int popupW = POPUP_W;
+    int popupH = POPUP_H;
     uint16_t popupBgColor = tft.color565(40, 40, 80); // 深蓝紫色
     uint16_t popupBorderColor = TFT_LIGHTGREY;
     uint16_t textColor = TFT_WHITE;
@@ -913,70 +877,12 @@ void showProjectInfoPopup() {
     tft.print("Kur1oR3iko's Bilibili Space:"); // 新增内容
     textY += lineHeight;
 
-    // 二维码数据 (原作者空间)
-    const char *qr_data_author =
-        "EEEEEEE.E..EE.EEE.E.E.EEEEEEE\n"
-        "E.....E..EE.....EE.E..E.....E\n"
-        "E.EEE.E...E.E..EE.EE..E.EEE.E\n"
-        "E.EEE.E.....E..E.E.EE.E.EEE.E\n"
-        "E.EEE.E..E.E..E..EEE..E.EEE.E\n"
-        "E.....E...E.E...E.E...E.....E\n"
-        "EEEEEEE.E.E.E.E.E.E.E.EEEEEEE\n"
-        "........E.EE.E.EE..E.........\n"
-        "EE.EE.E..EEE.E.E.E....E.....E\n"
-        "EEEE...E.E..EE.EEEEE...EE.EE.\n"
-        "...EEEE...EE.E.E..........E..\n"
-        ".EE....EEEEEEE..EE...EEEEE..E\n"
-        "E..E..EE.E.EEE......EEEE....E\n"
-        "EEE.E........EEE.EE...EEEEEEE\n"
-        ".EE.E.EEEEEEEE.EE..E...EE.E.E\n"
-        "EEEEEE.EE.EE....E..EE...E.E.E\n"
-        "E.E.EEE.E.E...E.E.E.E..E.E...\n"
-        "E.E..E.EEEEEEEEEE.EEE...E.EE.\n"
-        "EE.E.EE...EE...E...E.EEEEE..E\n"
-        "EEE..E..EE..E.E....EE.E.EEE..\n"
-        "EEE.EEEEE.E.EEEE.EE.EEEEEEEE.\n"
-        "........EE....EEE...E...EE...\n"
-        "EEEEEEE...E.E.EEE.EEE.E.EE...\n"
-        "E.....E..E....E.EE.EE...E...E\n"
-        "E.EEE.E.E.EEEEEEEEEEE.E..E.E.\n"
-        "E.EEE.E.EEE.E.EEEEE.EEEEE.E.E\n"
-        "E.EEE.E.EEE.....E....EE.E.E.E\n"
-        "E.....E.E.EE...EEEEEEE..E.E.E\n"
-        "EEEEEEE.E..EEE.E.E.EEEEEE.E.E";
-
-    int qrPixelSize = 2; // 每个二维码“像素”的大小
-    int qrWidthInChars = 29; // 二维码的字符宽度
-    // int qrHeightInChars = 29; // 二维码的字符高度
-    int qrDisplayWidth = qrWidthInChars * qrPixelSize;
-    // int qrDisplayHeight = qrHeightInChars * qrPixelSize; // 未使用
-
-    // 将二维码绘制在文本下方，居中显示
-    int qrOffsetX = popupX + (popupW - qrDisplayWidth) / 2;
+    // 将二维码绘制在文本下方，居中显示 (矩形见 qr_bitmaps.h)
+    int qrOffsetX = popupX + (popupW - QR_AUTHOR_WIDTH) / 2;
     int qrOffsetY = textY + lineHeight / 2; // 在文本下方留出一些空间
+    drawQrRects(qrOffsetX, qrOffsetY, QR_AUTHOR_RECTS, QR_AUTHOR_RECT_COUNT, qrPixelColor);
 
-    char lineBuffer[35];
-    const char *p_author = qr_data_author;
-    int currentY_qr = qrOffsetY;
-
-    for (int row = 0; row < 29 && *p_author; ++row) { // 假设作者二维码也是29行
-        int i = 0;
-        while (*p_author && *p_author != '\n' && i < qrWidthInChars) {
-            lineBuffer[i++] = *p_author++;
-        }
-        lineBuffer[i] = '\0';
-        if (*p_author == '\n') p_author++;
-
-        for (int col = 0; col < i; ++col) {
-            if (lineBuffer[col] == 'E') {
-                tft.fillRect(qrOffsetX + col * qrPixelSize, currentY_qr, qrPixelSize, qrPixelSize, qrPixelColor);
-            }
-        }
-        currentY_qr += qrPixelSize;
-        if (currentY_qr > popupY + popupH - 5 - qrPixelSize - lineHeight) break; // 避免覆盖关闭提示
-    }
-
-    textY = currentY_qr + lineHeight / 2; // 更新textY到二维码下方
+    textY = qrOffsetY + QR_AUTHOR_HEIGHT + lineHeight / 2; // 更新textY到二维码下方
 
     // Shapaper的贡献信息移到二维码下方
     tft.setCursor(textX, textY);
@@ -993,7 +899,7 @@ void showProjectInfoPopup() {
 void hideProjectInfoPopup() {
     if (isProjectInfoPopupVisible) {
         isProjectInfoPopupVisible = false;
-        redrawMainScreen(); // 重绘整个屏幕以清除弹窗并恢复UI
+        redrawRegion(POPUP_X, POPUP_Y, POPUP_W, POPUP_H); // 只重绘弹窗盖住的区域
     }
 }
 
@@ -1006,68 +912,36 @@ void drawPeerInfoScreen() {
     tft.drawString("Connected Peers", SCREEN_WIDTH / 2, 5, 2); // 标题
     tft.setTextDatum(TL_DATUM);
 
-    // 绘制返回按钮
-    tft.fillRect(BACK_BUTTON_X, BACK_BUTTON_Y, BACK_BUTTON_W, BACK_BUTTON_H, TFT_DARKGREY);
-    tft.setTextColor(TFT_WHITE, TFT_DARKGREY);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString("B", BACK_BUTTON_X + BACK_BUTTON_W / 2, BACK_BUTTON_Y + BACK_BUTTON_H / 2, 2);
-    tft.setTextDatum(TL_DATUM);
-
-    // 绘制本机信息区域
-    int localInfoStartX = 5;
-    int localInfoStartY = 30;
-    int localInfoHeight = 4 * 10 + 5; // 4行文本 + 间距
-    int localInfoWidth = SCREEN_WIDTH - 10;
-    int lineHeight = 10;
+    // 绘制返回按钮等控件
+    widgetInvalidateScreen(UI_STATE_PEER_INFO);
+    widgetRenderDirty();
 
-    tft.drawRect(localInfoStartX, localInfoStartY, localInfoWidth, localInfoHeight, TFT_DARKGREY);
+    // 绘制本机信息区域边框 (内容由 updatePeerInfoScreen 增量绘制)
+    tft.drawRect(PEER_LOCAL_INFO_X, PEER_LOCAL_INFO_Y, PEER_LOCAL_INFO_W, PEER_LOCAL_INFO_H, TFT_DARKGREY);
     tft.setTextColor(TFT_WHITE, TFT_BLACK);
     tft.setTextSize(1);
     tft.setTextFont(1);
 
-    uint8_t myMacAddr[6];
-    esp_wifi_get_mac(WIFI_IF_STA, myMacAddr);
-    char myMacStr[18];
-    sprintf(myMacStr, "%02X:%02X:%02X:%02X:%02X:%02X",
-            myMacAddr[0], myMacAddr[1], myMacAddr[2], myMacAddr[3], myMacAddr[4], myMacAddr[5]);
-
-    tft.setCursor(localInfoStartX + 5, localInfoStartY + 5);
-    tft.print("Local MAC: ");
-    tft.print(myMacStr);
-
-    tft.setCursor(localInfoStartX + 5, localInfoStartY + 5 + lineHeight);
-    tft.print("Raw Uptime: ");
-    tft.print(millis() / 1000);
-    tft.print("s");
-
-    tft.setCursor(localInfoStartX + 5, localInfoStartY + 5 + 2 * lineHeight);
-    tft.print("Effective Uptime: ");
-    tft.print((millis() + relativeBootTimeOffset) / 1000);
-    tft.print("s");
-
-    tft.setCursor(localInfoStartX + 5, localInfoStartY + 5 + 3 * lineHeight);
-    tft.print("Memory: ");
-    tft.print(ESP.getFreeHeap() / 1024);
-    tft.print("/");
-    tft.print(ESP.getHeapSize() / 1024);
-    tft.print("KB");
-
-
     // 绘制对端列表表头
-    int peerListStartX = 5;
-    int peerListStartY = localInfoStartY + localInfoHeight + 10; // 在本机信息下方留出间距
-    int colWidthMac = 100;
-    int colWidthUptime = 60;
-    int colWidthMem = 60;
-    int rowHeight = 15;
-
-    tft.drawString("MAC Address", peerListStartX, peerListStartY, 1);
-    tft.drawString("Uptime(s)", peerListStartX + colWidthMac + 5, peerListStartY, 1);
-    tft.drawString("Free/Total Mem(KB)", peerListStartX + colWidthMac + colWidthUptime + 10, peerListStartY, 1); // 修改标签
+    tft.drawString("MAC Address", PEER_LIST_X, PEER_LIST_HEADER_Y, 1);
+    tft.drawString("Uptime(s)", PEER_LIST_X + PEER_LIST_COL_MAC_W + 5, PEER_LIST_HEADER_Y, 1);
+    tft.drawString("Free/Total Mem(KB)", PEER_LIST_X + PEER_LIST_COL_MAC_W + PEER_LIST_COL_UPTIME_W + 10, PEER_LIST_HEADER_Y, 1); // 修改标签
 
     // 绘制分隔线
-    tft.drawLine(peerListStartX, peerListStartY + rowHeight - 2, SCREEN_WIDTH - 5, peerListStartY + rowHeight - 2, TFT_DARKGREY);
+    tft.drawLine(PEER_LIST_X, PEER_LIST_HEADER_Y + PEER_LIST_ROW_HEIGHT - 2, SCREEN_WIDTH - 5, PEER_LIST_HEADER_Y + PEER_LIST_ROW_HEIGHT - 2, TFT_DARKGREY);
 
+    // 清屏后所有字段需要完整重绘
+    for (int i = 0; i < PEER_LOCAL_INFO_LINES; i++)
+    {
+        cachedTextInvalidate(peerLocalInfoLines[i]);
+    }
+    for (int row = 0; row < PEER_LIST_ROWS; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            cachedTextInvalidate(peerListFields[row][col]);
+        }
+    }
 
     // 初始绘制对端列表
     updatePeerInfoScreen();
@@ -1076,81 +950,43 @@ void drawPeerInfoScreen() {
 void updatePeerInfoScreen() {
     if (currentUIState != UI_STATE_PEER_INFO) return;
 
-    // 更新本机信息区域
-    int localInfoStartX = 5;
-    int localInfoStartY = 30;
-    int localInfoHeight = 4 * 10 + 5; // 4行文本 + 间距
-    int localInfoWidth = SCREEN_WIDTH - 10;
-    int lineHeight = 10;
-
-    // 清除旧的本机信息区域
-    tft.fillRect(localInfoStartX + 1, localInfoStartY + 1, localInfoWidth - 2, localInfoHeight - 2, TFT_BLACK);
-
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    tft.setTextSize(1);
-    tft.setTextFont(1);
-
+    // 更新本机信息区域 (只重绘变化的字符)
     uint8_t myMacAddr[6];
     esp_wifi_get_mac(WIFI_IF_STA, myMacAddr);
-    char myMacStr[18];
-    sprintf(myMacStr, "%02X:%02X:%02X:%02X:%02X:%02X",
-            myMacAddr[0], myMacAddr[1], myMacAddr[2], myMacAddr[3], myMacAddr[4], myMacAddr[5]);
-
-    tft.setCursor(localInfoStartX + 5, localInfoStartY + 5);
-    tft.print("Local MAC: ");
-    tft.print(myMacStr);
-
-    tft.setCursor(localInfoStartX + 5, localInfoStartY + 5 + lineHeight);
-    tft.print("Raw Uptime: ");
-    tft.print(millis() / 1000);
-    tft.print("s");
-
-    tft.setCursor(localInfoStartX + 5, localInfoStartY + 5 + 2 * lineHeight);
-    tft.print("Effective Uptime: ");
-    tft.print((millis() + relativeBootTimeOffset) / 1000);
-    tft.print("s");
-
-    tft.setCursor(localInfoStartX + 5, localInfoStartY + 5 + 3 * lineHeight);
-    tft.print("Memory: ");
-    tft.print(ESP.getFreeHeap() / 1024);
-    tft.print("/");
-    tft.print(ESP.getHeapSize() / 1024);
-    tft.print("KB");
-
-
-    // 更新对端列表区域
-    int peerListStartX = 5;
-    int peerListStartY = localInfoStartY + localInfoHeight + 10 + 15; // 在表头下方开始绘制
-    int colWidthMac = 100;
-    int colWidthUptime = 60;
-    int colWidthMem = 60;
-    int rowHeight = 15;
-
-    // 清除旧的对端列表区域 (从表头下方到返回按钮上方)
-    tft.fillRect(peerListStartX, peerListStartY, SCREEN_WIDTH - 10, BACK_BUTTON_Y - peerListStartY - 2, TFT_BLACK);
+    char buffer[CACHED_TEXT_MAX_CHARS + 1];
 
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    tft.setTextSize(1);
-    tft.setTextFont(1);
+    snprintf(buffer, sizeof(buffer), "Local MAC: %02X:%02X:%02X:%02X:%02X:%02X",
+             myMacAddr[0], myMacAddr[1], myMacAddr[2], myMacAddr[3], myMacAddr[4], myMacAddr[5]);
+    cachedTextDraw(peerLocalInfoLines[0], buffer);
 
-    std::vector<PeerInfo_t> peerList = getPeerInfoList(); // 获取对端信息列表
+    snprintf(buffer, sizeof(buffer), "Raw Uptime: %lus", millis() / 1000);
+    cachedTextDraw(peerLocalInfoLines[1], buffer);
 
-    int currentY = peerListStartY;
-    for (const auto& peer : peerList) {
-        if (currentY + rowHeight > BACK_BUTTON_Y - 2) break; // 避免超出屏幕或覆盖返回按钮
+    snprintf(buffer, sizeof(buffer), "Effective Uptime: %lus", (millis() + relativeBootTimeOffset) / 1000);
+    cachedTextDraw(peerLocalInfoLines[2], buffer);
 
-        tft.setCursor(peerListStartX, currentY);
-        tft.print(peer.macAddress);
+    snprintf(buffer, sizeof(buffer), "Memory: %u/%uKB", ESP.getFreeHeap() / 1024, ESP.getHeapSize() / 1024);
+    cachedTextDraw(peerLocalInfoLines[3], buffer);
 
-        tft.setCursor(peerListStartX + colWidthMac + 5, currentY);
-        tft.print(peer.effectiveUptime / 1000); // 显示有效运行时间 (秒)
+    // 更新对端列表区域: 已有的行只重绘变化的字符，多余的行以空字符串清除
+    PeerInfo_t peerList[MAX_PEERS_TO_DISPLAY];
+    size_t peerListCount = getPeerInfoList(peerList, MAX_PEERS_TO_DISPLAY); // 获取对端信息列表 (拷贝到栈上)
 
-        tft.setCursor(peerListStartX + colWidthMac + colWidthUptime + 10, currentY);
-        char memBuffer[20];
-        sprintf(memBuffer, "%u/%u", peer.usedMemory / 1024, peer.totalMemory / 1024); // usedMemory 实际上是可用内存
-        tft.print(memBuffer);
+    for (int row = 0; row < PEER_LIST_ROWS; row++) {
+        if (row < (int)peerListCount) {
+            const PeerInfo_t &peer = peerList[row];
+            cachedTextDraw(peerListFields[row][0], peer.macAddress);
 
-        currentY += rowHeight;
+            snprintf(buffer, sizeof(buffer), "%lu", peer.effectiveUptime / 1000); // 显示有效运行时间 (秒)
+            cachedTextDraw(peerListFields[row][1], buffer);
+
+            snprintf(buffer, sizeof(buffer), "%u/%u", peer.usedMemory / 1024, peer.totalMemory / 1024); // usedMemory 实际上是可用内存
+            cachedTextDraw(peerListFields[row][2], buffer);
+        } else {
+            cachedTextDraw(peerListFields[row][0], "");
+            cachedTextDraw(peerListFields[row][1], "");
+            cachedTextDraw(peerListFields[row][2], "");
+        }
     }
 }
 
@@ -1170,11 +1006,6 @@ void hidePeerInfoScreen() {
     redrawMainScreen(); // 返回主界面并重绘
 }
 
-bool isPeerInfoScreenBackButtonPressed(int x, int y) {
-    if (currentUIState != UI_STATE_PEER_INFO) return false;
-     return x >= BACK_BUTTON_X && x <= BACK_BUTTON_X + BACK_BUTTON_W &&
-           y >= BACK_BUTTON_Y && y <= BACK_BUTTON_Y + BACK_BUTTON_H;
-}
 
 
 // 如果 readBatteryVoltagePercentage 是 ui_manager 的一部分，则在此定义
@@ -1194,11 +1025,6 @@ void drawWifiSettingsButton() {
     tft.setTextDatum(TL_DATUM);
 }
 
-bool isWifiSettingsButtonPressed(int x, int y) {
-    return x >= WIFI_BUTTON_X && x <= WIFI_BUTTON_X + WIFI_BUTTON_W &&
-           y >= WIFI_BUTTON_Y && y <= WIFI_BUTTON_Y + WIFI_BUTTON_H;
-}
-
 void showWifiSettingsScreen() {
     currentUIState = UI_STATE_WIFI_SETTINGS;
     drawWifiSettingsScreen();
@@ -1216,34 +1042,27 @@ void drawWifiSettingsScreen() {
     tft.drawString("WiFi Settings", SCREEN_WIDTH / 2, 10, 2);
     tft.setTextDatum(TL_DATUM);
 
-    // "Connect with Default" 按钮
-    tft.fillRect(60, 100, 200, 50, TFT_BLUE);
-    tft.setTextColor(TFT_WHITE, TFT_BLUE);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString("Connect with Default", SCREEN_WIDTH / 2, 125, 2);
-    tft.setTextDatum(TL_DATUM);
+    // "Connect with Default" 按钮和返回按钮
+    widgetInvalidateScreen(UI_STATE_WIFI_SETTINGS);
+    widgetRenderDirty();
+}
 
-    // 返回按钮
-    tft.fillRect(BACK_BUTTON_X, BACK_BUTTON_Y, BACK_BUTTON_W, BACK_BUTTON_H, TFT_DARKGREY);
-    tft.setTextColor(TFT_WHITE, TFT_DARKGREY);
+static void drawWifiConnectButton(WidgetId_t id) {
+    (void)id;
+    tft.fillRect(WIFI_CONNECT_BUTTON_X, WIFI_CONNECT_BUTTON_Y, WIFI_CONNECT_BUTTON_W, WIFI_CONNECT_BUTTON_H, TFT_BLUE);
+    tft.setTextColor(TFT_WHITE, TFT_BLUE);
     tft.setTextDatum(MC_DATUM);
-    tft.drawString("B", BACK_BUTTON_X + BACK_BUTTON_W / 2, BACK_BUTTON_Y + BACK_BUTTON_H / 2, 2);
+    tft.drawString("Connect with Default", WIFI_CONNECT_BUTTON_X + WIFI_CONNECT_BUTTON_W / 2, WIFI_CONNECT_BUTTON_Y + WIFI_CONNECT_BUTTON_H / 2, 2);
     tft.setTextDatum(TL_DATUM);
 }
 
-void handleWifiSettingsTouch(int x, int y) {
-    // 返回按钮
-    if (isBackButtonPressed(x, y)) {
-        hideWifiSettingsScreen();
-        return;
-    }
-
-    // "Connect with Default" 按钮
-    if (x >= 60 && x <= 260 && y >= 100 && y <= 150) {
-        connectToWiFi(DEFAULT_WIFI_SSID, DEFAULT_WIFI_PASSWORD);
-        if (isWifiConnected()) {
-            mqttInit(DEFAULT_MQTT_BROKER, DEFAULT_MQTT_PORT);
-        }
-        hideWifiSettingsScreen();
+static void onWifiConnectButtonPressed(WidgetId_t id, int x, int y) {
+    (void)id;
+    (void)x;
+    (void)y;
+    connectToWiFi(DEFAULT_WIFI_SSID, DEFAULT_WIFI_PASSWORD);
+    if (isWifiConnected()) {
+        mqttInit(DEFAULT_MQTT_BROKER, DEFAULT_MQTT_PORT);
     }
+    hideWifiSettingsScreen();
 }
@@ -3,12 +3,9 @@
 
 #include "config.h"
 #include <TFT_eSPI.h>
-#include <set>               // For std::set
-#include <string>            // For String (used in std::set<String> macSet)
-#include "esp_now_handler.h" // For TouchData_t, macSet, allDrawingHistory, relativeBootTimeOffset, replayAllDrawings, PeerInfo_t, peerInfoMap
+#include "esp_now_handler.h" // For TouchData_t, peerCount, allDrawingHistory, relativeBootTimeOffset, replayAllDrawings, PeerInfo_t
 #include "power_manager.h" // 包含电源管理器头文件，用于 isScreenOn
 #include "drawing_history.h" // 包含自定义绘图历史头文件
-#include <map> // For std::map
 #include <vector> // For std::vector (if needed for peer list display)
 
 // UI 状态枚举
@@ -44,11 +41,8 @@ extern bool isCoffeePopupVisible;    // "Coffee" 弹窗是否可见
 extern int redValue;                // 红色通道值 (0-255)
 extern int greenValue;              // 绿色通道值 (0-255)
 extern int blueValue;               // 蓝色通道值 (0-255)
-extern uint16_t *savedScreenBuffer; // 用于保存调色界面覆盖区域的屏幕缓冲
 
 // Variables from other modules needed by UI functions
-extern std::set<String> macSet;                    // 来自 esp_now_handler.h (用于设备计数，对端详细信息存储在 peerInfoMap 中)
-extern std::map<String, PeerInfo_t> peerInfoMap; // 来自 esp_now_handler.h (存储对端详细信息)
 extern DrawingHistory allDrawingHistory; // 来自 esp_now_handler.h (用于调试信息)
 extern long relativeBootTimeOffset;                // 来自 esp_now_handler.h (用于调试信息)
 // isScreenOn (如果 drawDebugInfo 需要) 会通过包含 power_manager.h 在 ui_manager.cpp 中获得
@@ -68,7 +62,8 @@ void drawCustomColorButton(); // 显示当前颜色
 void drawStarButton();        // 显示当前颜色, 自定义颜色入口的占位符
 
 // 调试信息函数
-void drawDebugInfo();         // 显示历史记录大小、运行时间、偏移量、内存
+void drawDebugInfo();         // 显示历史记录大小、运行时间、偏移量、内存 (只重绘变化的字符)
+void invalidateDebugInfo();   // 调试信息框被覆盖 (清屏或弹窗) 后调用，下次绘制时完整重绘
 void toggleDebugInfo();       // 切换调试信息框的显示状态
 void drawDebugToggleButton(); // 绘制调试信息切换按钮
 void drawInfoButton();        // 绘制项目信息按钮
@@ -90,38 +85,27 @@ void hidePeerInfoScreen();
 void drawWifiSettingsScreen();
 void showWifiSettingsScreen();
 void hideWifiSettingsScreen();
-void handleWifiSettingsTouch(int x, int y);
 
 
-// 按钮按下检测函数 (基于坐标)
-bool isResetButtonPressed(int x, int y);
-bool isColorButtonPressed(int x, int y, uint32_t &selectedColor); // 输出选中的颜色
-bool isPeerInfoButtonPressed(int x, int y); // 检测对端信息按钮是否被按下
-bool isPeerInfoScreenBackButtonPressed(int x, int y); // 检测对端信息界面返回按钮是否被按下 - 新增声明
-bool isWifiSettingsButtonPressed(int x, int y); // 检测WiFi设置按钮
-bool isCustomColorButtonPressed(int x, int y); // 用于进入自定义颜色模式
+// 按钮的命中检测和按下处理已改由控件树完成 (见 ui_widgets.h)
+// 调色盘不是控件，其返回按钮仍使用坐标检测
 bool isBackButtonPressed(int x, int y);        // 用于退出自定义颜色模式 (主要用于调色盘)
-bool isDebugToggleButtonPressed(int x, int y); // 检测调试信息切换按钮是否被按下
-bool isInfoButtonPressed(int x, int y);    // 检测项目信息按钮是否被按下
-bool isCoffeeButtonPressed(int x, int y);  // 检测 "Coffee" 按钮是否被按下
+void drawBackButton();                         // 绘制右下角的返回按钮 "B"
 
 // 自定义颜色选择器 UI 函数
 void handleCustomColorTouch(int x, int y); // 处理颜色选择器内的触摸
-void updateSingleColorSlider(int yPos, uint32_t sliderColor, int &channelValue);
+void updateSingleColorSlider(int yPos, int &channelValue);
 void drawColorSelectors();       // 绘制 RGB 滑块和返回按钮
 void updateCustomColorPreview(); // 更新颜色预览框
 void refreshAllColorSliders();   // 重绘所有滑块 (例如触摸后)
 void closeColorSelectors();      // 恢复屏幕，退出自定义颜色模式
 
-// 屏幕缓冲区管理 (用于自定义颜色选择器)
-void saveScreenArea();         // 保存颜色选择器将覆盖的屏幕区域
-void restoreSavedScreenArea(); // 恢复保存的屏幕区域
-
 // UI 工具函数
 void updateCurrentColor(uint32_t newColor); // 设置全局当前颜色
-void updateConnectedDevicesCount();         // 更新休眠按钮上的设备计数
+void updateConnectedDevicesCount();         // 设备数变化时标记对端信息按钮需要重绘
 void clearScreenAndCache();                 // 清屏、重绘UI、重置相关触摸点 (影响广泛)
 void redrawMainScreen();                    // 重绘整个主屏幕
+void redrawRegion(int x, int y, int w, int h); // 只重绘主界面的一块区域 (背景、控件和与区域相交的笔划，区域外不变)
 
 // 进度条绘制和更新函数
 void drawSendProgressIndicator();
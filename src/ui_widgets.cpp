@@ -0,0 +1,131 @@
+#include "ui_widgets.h"
+#include "perf_counters.h" // 重绘控件计为一帧
+
+static_assert(WIDGET_COUNT <= 32, "命中索引使用 uint32_t 位掩码，控件数不能超过 32");
+
+extern bool isScreenOn; // 来自 power_manager 模块
+
+static Widget_t widgets[WIDGET_COUNT];                          // 控件表 (按编号索引)
+static uint32_t hitGrid[WIDGET_HIT_ROWS][WIDGET_HIT_COLS];      // 命中索引: 每格覆盖它的控件位掩码
+static UIState_t hitGridScreen = UI_STATE_MAIN;                 // 命中索引对应的界面
+static bool hitGridValid = false;                               // 控件可见性或界面变化后需要重建
+
+// 为当前界面重建命中索引 (只在界面切换或可见性变化后的第一次触摸时执行)
+static void rebuildHitGrid()
+{
+    memset(hitGrid, 0, sizeof(hitGrid));
+    for (int id = 0; id < WIDGET_COUNT; id++)
+    {
+        const Widget_t &widget = widgets[id];
+        if (!widget.visible || widget.screen != currentUIState)
+            continue;
+
+        int col0 = constrain(widget.x / WIDGET_HIT_CELL, 0, WIDGET_HIT_COLS - 1);
+        int col1 = constrain((widget.x + widget.w) / WIDGET_HIT_CELL, 0, WIDGET_HIT_COLS - 1);
+        int row0 = constrain(widget.y / WIDGET_HIT_CELL, 0, WIDGET_HIT_ROWS - 1);
+        int row1 = constrain((widget.y + widget.h) / WIDGET_HIT_CELL, 0, WIDGET_HIT_ROWS - 1);
+        for (int row = row0; row <= row1; row++)
+        {
+            for (int col = col0; col <= col1; col++)
+            {
+                hitGrid[row][col] |= (1UL << id);
+            }
+        }
+    }
+    hitGridScreen = currentUIState;
+    hitGridValid = true;
+}
+
+void widgetRegister(WidgetId_t id, UIState_t screen, int x, int y, int w, int h,
+                    WidgetDrawFn draw, WidgetPressFn onPress, bool visible)
+{
+    Widget_t &widget = widgets[id];
+    widget.screen = screen;
+    widget.x = x;
+    widget.y = y;
+    widget.w = w;
+    widget.h = h;
+    widget.visible = visible;
+    widget.dirty = visible;
+    widget.draw = draw;
+    widget.onPress = onPress;
+    hitGridValid = false;
+}
+
+void widgetSetPressHandler(WidgetId_t id, WidgetPressFn onPress)
+{
+    widgets[id].onPress = onPress;
+}
+
+void widgetSetVisible(WidgetId_t id, bool visible)
+{
+    Widget_t &widget = widgets[id];
+    if (widget.visible == visible)
+        return;
+    widget.visible = visible;
+    widget.dirty = visible;
+    hitGridValid = false;
+}
+
+void widgetInvalidate(WidgetId_t id)
+{
+    widgets[id].dirty = true;
+}
+
+void widgetInvalidateScreen(UIState_t screen)
+{
+    for (int id = 0; id < WIDGET_COUNT; id++)
+    {
+        if (widgets[id].screen == screen && widgets[id].visible)
+            widgets[id].dirty = true;
+    }
+}
+
+void widgetRenderDirty()
+{
+    if (!isScreenOn)
+        return;
+
+    for (int id = 0; id < WIDGET_COUNT; id++)
+    {
+        Widget_t &widget = widgets[id];
+        if (!widget.dirty || !widget.visible || widget.screen != currentUIState || widget.draw == nullptr)
+            continue;
+        widget.dirty = false;
+        widget.draw((WidgetId_t)id);
+        perfNoteDrawn();
+    }
+}
+
+WidgetId_t widgetHitTest(int x, int y)
+{
+    if (x < 0 || y < 0 || x > SCREEN_WIDTH || y > SCREEN_HEIGHT)
+        return WIDGET_NONE;
+
+    if (!hitGridValid || hitGridScreen != currentUIState)
+        rebuildHitGrid();
+
+    uint32_t candidates = hitGrid[y / WIDGET_HIT_CELL][x / WIDGET_HIT_CELL];
+    while (candidates != 0) // 画布上的触摸在这里直接跳过
+    {
+        int id = __builtin_ctz(candidates); // 编号小的优先
+        candidates &= candidates - 1;
+        const Widget_t &widget = widgets[id];
+        if (x >= widget.x && x <= widget.x + widget.w &&
+            y >= widget.y && y <= widget.y + widget.h)
+        {
+            return (WidgetId_t)id;
+        }
+    }
+    return WIDGET_NONE;
+}
+
+bool widgetDispatchTouch(int x, int y)
+{
+    WidgetId_t id = widgetHitTest(x, y);
+    if (id == WIDGET_NONE)
+        return false;
+    if (widgets[id].onPress != nullptr)
+        widgets[id].onPress(id, x, y);
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef UI_WIDGETS_H
+#define UI_WIDGETS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "ui_manager.h" // 用于 UIState_t
+
+// 保留模式控件树
+// 每个界面 (UIState_t) 是一个根节点，按钮等控件挂在所属界面下，
+// 记录自己的矩形、可见性、脏标记以及绘制/按下回调。
+// - 触摸命中: 按 WIDGET_HIT_CELL 像素划分的网格索引，每格保存覆盖它的控件位掩码，
+//   落在画布上的触摸只需一次数组查找即可确定没有命中任何控件。
+// - 重绘: 状态变化时只标记相关控件为脏，由 widgetRenderDirty() 在主循环中统一重绘。
+// - 按下/提笔: 控件树不记录接触状态，touch_handler 只把每次接触的第一个点交给 widgetDispatchTouch()，
+//   命中后提笔前的其余点都不再处理 (按住按钮只触发一次)。
+// 新界面只需注册控件并在界面骨架绘制后调用 widgetInvalidateScreen()，无需再写专门的重绘和命中检测路径。
+
+#define WIDGET_HIT_CELL 16                                                        // 命中索引网格单元大小 (像素)
+#define WIDGET_HIT_COLS ((SCREEN_WIDTH + WIDGET_HIT_CELL) / WIDGET_HIT_CELL)      // 网格列数 (含右边界像素)
+#define WIDGET_HIT_ROWS ((SCREEN_HEIGHT + WIDGET_HIT_CELL) / WIDGET_HIT_CELL)     // 网格行数 (含下边界像素)
+
+// 控件编号，同时也是命中优先级 (编号越小越优先，与原先 handleLocalTouch 中的判断顺序一致)
+enum WidgetId_e {
+    // 主界面
+    WIDGET_COFFEE,        // "Coffee" 按钮
+    WIDGET_INFO,          // 项目信息按钮
+    WIDGET_DEBUG_PANEL,   // 调试信息框 (点击关闭)
+    WIDGET_DEBUG_TOGGLE,  // 调试信息切换按钮 "D"
+    WIDGET_RESET,         // 复位按钮 (显示电量)
+    WIDGET_COLOR_BLUE,    // 固定颜色按钮 (蓝、绿、红、黄，须连续)
+    WIDGET_COLOR_GREEN,
+    WIDGET_COLOR_RED,
+    WIDGET_COLOR_YELLOW,
+    WIDGET_PEER_INFO,     // 对端信息按钮 (显示设备数)
+    WIDGET_WIFI,          // WiFi 设置按钮
+    WIDGET_CUSTOM_COLOR,  // 自定义颜色 ("*") 按钮
+    WIDGET_UNDO,          // 撤销按钮 "<"
+    WIDGET_REDO,          // 重做按钮 ">"
+    // 对端信息界面
+    WIDGET_PEER_BACK,     // 返回按钮
+    // WiFi 设置界面
+    WIDGET_WIFI_CONNECT,  // "Connect with Default" 按钮
+    WIDGET_WIFI_BACK,     // 返回按钮
+
+    WIDGET_COUNT,
+    WIDGET_NONE = WIDGET_COUNT // 未命中任何控件 (画布)
+};
+typedef enum WidgetId_e WidgetId_t;
+
+typedef void (*WidgetDrawFn)(WidgetId_t id);               // 绘制控件
+typedef void (*WidgetPressFn)(WidgetId_t id, int x, int y); // 控件被按下 (屏幕坐标)
+
+typedef struct Widget_s
+{
+    UIState_t screen;      // 父节点: 所属界面
+    int16_t x;             // 命中/绘制区域左上角
+    int16_t y;
+    int16_t w;             // 命中区域包含右/下边界 (x + w, y + h)，与原先 is*ButtonPressed 一致
+    int16_t h;
+    bool visible;          // 是否可见 (不可见的控件不参与命中和重绘)
+    bool dirty;            // 是否需要重绘
+    WidgetDrawFn draw;
+    WidgetPressFn onPress;
+} Widget_t;
+
+// 注册控件 (通常在 uiManagerInit 中调用)
+void widgetRegister(WidgetId_t id, UIState_t screen, int x, int y, int w, int h,
+                    WidgetDrawFn draw, WidgetPressFn onPress, bool visible = true);
+
+// 替换控件的按下回调 (供其他模块接管某个控件的行为，例如复位按钮)
+void widgetSetPressHandler(WidgetId_t id, WidgetPressFn onPress);
+
+// 修改可见性。变为可见时自动标记为脏；变为不可见时不会擦除，由调用者负责重绘背景
+void widgetSetVisible(WidgetId_t id, bool visible);
+
+// 标记单个控件需要重绘
+void widgetInvalidate(WidgetId_t id);
+
+// 界面背景被整体重绘后调用: 将该界面所有可见控件标记为脏
+void widgetInvalidateScreen(UIState_t screen);
+
+// 重绘当前界面上所有脏的可见控件 (屏幕关闭时推迟到亮屏后)
+void widgetRenderDirty();
+
+// 返回 (x, y) 处当前界面上优先级最高的可见控件，未命中返回 WIDGET_NONE
+WidgetId_t widgetHitTest(int x, int y);
+
+// 命中测试并调用控件的按下回调。命中控件返回 true，落在画布上返回 false
+bool widgetDispatchTouch(int x, int y);
+
+#endif // UI_WIDGETS_H
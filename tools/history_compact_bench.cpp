@@ -0,0 +1,261 @@
+// 绘图历史压缩基准 (主机端)
+// 把录制的画布送入固件同一份 src/history_compact.cpp，报告删除的点数、回收的内存、重播耗时的变化，
+// 并逐像素比较压缩前后重播出的画面。
+//
+// 构建 (与主机运行器一起，链接固件模块和 host/mock 中的替身；src/credentials.h 不存在时使用示例配置):
+//   cmake -S host -B build-host && cmake --build build-host --target history_compact_bench
+//
+// 录制画布: 设备 LittleFS 中的 /canvas.snap 和 /canvas.log (格式见 src/canvas_store.h)，
+// 例如用 esptool read_flash 读出 spiffs 分区后以 mklittlefs -u 解包。两个文件都给出时按设备启动恢复的顺序读取。
+// 没有设备时可用 --synth 生成合成画布 (手写笔划 + 反复涂抹的区域 + 一次清屏)。
+//
+// 用法:
+//   history_compact_bench canvas.snap [canvas.log]   压缩录制的画布
+//   history_compact_bench --synth [点数]              压缩合成画布 (默认 30000 点)
+//
+// 指标:
+//   points    压缩前后的点数，以及复位前/化简/遮挡各删除多少
+//   memory    设备上历史占用的内存 (每点 sizeof(TouchData_t) = 20 字节) 和闪存快照大小 (每点 16 字节)
+//   replay    在内存帧缓冲上按 replayAllDrawings 的规则重播的平均耗时
+//   diff      压缩前后重播结果不同的像素数 (应为 0: 压缩不改变画面；不为 0 时退出码为 1)
+
+#include "history_compact.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define DEVICE_POINT_BYTES 20   // ESP32 上 sizeof(TouchData_t)
+#define FLASH_RECORD_BYTES 16   // sizeof(CanvasRecord_t)
+#define CANVAS_RECORD_FLAG_RESET 0x01
+#define REPLAY_REPEATS 20       // 重播计时的重复次数
+
+typedef struct FileHeader_s
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t generation;
+    uint32_t count;
+} FileHeader_t;
+
+typedef struct Record_s
+{
+    int16_t x;
+    int16_t y;
+    uint32_t timestamp;
+    uint32_t color;
+    uint8_t flags;
+    uint8_t reserved[3];
+} Record_t;
+
+static uint16_t frame[SCREEN_HEIGHT][SCREEN_WIDTH];
+
+// 读取快照或日志 (按文件长度读取全部记录，复位记录清空之前的点，与设备启动恢复一致)
+static bool loadCanvasFile(const char *path, DrawingHistory &history)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        perror(path);
+        return false;
+    }
+    FileHeader_t header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.recordSize != sizeof(Record_t))
+    {
+        fprintf(stderr, "%s: not a canvas snapshot/log\n", path);
+        fclose(f);
+        return false;
+    }
+    Record_t record;
+    while (fread(&record, sizeof(record), 1, f) == 1)
+    {
+        if (record.flags & CANVAS_RECORD_FLAG_RESET)
+        {
+            history.clear();
+            continue;
+        }
+        TouchData_t point;
+        point.x = record.x;
+        point.y = record.y;
+        point.timestamp = record.timestamp;
+        point.isReset = false;
+        point.color = record.color;
+        history.push_back(point);
+    }
+    fclose(f);
+    return true;
+}
+
+// 合成画布: 200Hz 的平滑手写笔划，其中约三分之一在同一块区域来回涂抹 (后画的盖住先画的)，中途清屏一次
+static void synthCanvas(size_t targetPoints, DrawingHistory &history)
+{
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const uint32_t colors[] = {0xFFFF, 0xF800, 0x07E0, 0x001F, 0xFFE0};
+    unsigned long t = 1000;
+    bool resetDone = false;
+    while (history.size() < targetPoints)
+    {
+        if (!resetDone && history.size() > targetPoints / 5)
+        {
+            TouchData_t reset;
+            memset(&reset, 0, sizeof(reset));
+            reset.isReset = true;
+            reset.timestamp = t;
+            history.push_back(reset);
+            resetDone = true;
+        }
+        TouchData_t point;
+        memset(&point, 0, sizeof(point));
+        point.color = colors[(int)(uniform(rng) * 5)];
+        bool scribble = uniform(rng) < 0.35;
+        double cx = scribble ? 60 + 40 * uniform(rng) : 20 + 280 * uniform(rng);
+        double cy = scribble ? 60 + 40 * uniform(rng) : 20 + 200 * uniform(rng);
+        double heading = 2 * M_PI * uniform(rng);
+        double turn = (uniform(rng) - 0.5) * 0.2;
+        int samples = 40 + (int)(uniform(rng) * 160);
+        for (int i = 0; i < samples; i++, t += 5)
+        {
+            heading += turn;
+            cx += 1.5 * cos(heading);
+            cy += 1.5 * sin(heading);
+            if (scribble && (cx < 50 || cx > 110 || cy < 50 || cy > 110))
+                heading += M_PI; // 在涂抹区域内来回
+            point.x = (int)lround(cx);
+            point.y = (int)lround(cy);
+            point.timestamp = t;
+            history.push_back(point);
+        }
+        t += 200 + (unsigned long)(uniform(rng) * 500); // 抬笔
+    }
+}
+
+static void plotPixel(int x, int y, uint16_t color)
+{
+    if (x >= 0 && y >= 0 && x < SCREEN_WIDTH && y < SCREEN_HEIGHT)
+        frame[y][x] = color;
+}
+
+static void drawLine(int x0, int y0, int x1, int y1, uint16_t color)
+{
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    int dx = x1 - x0, dy = abs(y1 - y0), err = dx >> 1, ystep = (y0 < y1) ? 1 : -1;
+    for (; x0 <= x1; x0++)
+    {
+        if (steep)
+            plotPixel(y0, x0, color);
+        else
+            plotPixel(x0, y0, color);
+        err -= dy;
+        if (err < 0)
+        {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+// 与 replayAllDrawings 相同的规则重播到 frame
+static void replay(const DrawingHistory &history)
+{
+    memset(frame, 0, sizeof(frame));
+    for (size_t i = 0; i < history.size(); i++)
+    {
+        const TouchData_t &p = history[i];
+        if (p.isReset)
+        {
+            memset(frame, 0, sizeof(frame));
+            continue;
+        }
+        if (history_point_hidden(p))
+            continue;
+        const TouchData_t *previous = history.stroke_previous(i);
+        if (previous == nullptr)
+            plotPixel(p.x, p.y, (uint16_t)p.color);
+        else
+            drawLine(previous->x, previous->y, p.x, p.y, (uint16_t)p.color);
+    }
+}
+
+static double replayMs(const DrawingHistory &history)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REPLAY_REPEATS; i++)
+        replay(history);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / REPLAY_REPEATS;
+}
+
+int main(int argc, char **argv)
+{
+    DrawingHistory history;
+    if (argc >= 2 && strcmp(argv[1], "--synth") == 0)
+    {
+        synthCanvas(argc >= 3 ? strtoul(argv[2], nullptr, 10) : 30000, history);
+    }
+    else if (argc >= 2)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (!loadCanvasFile(argv[i], history))
+                return 1;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "usage: %s canvas.snap [canvas.log]\n       %s --synth [points]\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    size_t before = history.size();
+    double replayBefore = replayMs(history);
+    static uint16_t reference[SCREEN_HEIGHT][SCREEN_WIDTH];
+    replay(history);
+    memcpy(reference, frame, sizeof(frame));
+
+    // 与设备相同的分步执行，统计步数
+    HistoryCompactJob_t job;
+    auto start = std::chrono::steady_clock::now();
+    historyCompactBegin(job, history, before);
+    int steps = 1;
+    while (!historyCompactStep(job, history, HISTORY_COMPACT_SLICE_POINTS))
+        steps++;
+    uint32_t hidden = job.hiddenPoints, simplified = job.simplifiedPoints, occluded = job.occludedPoints;
+    uint32_t occludedStrokes = job.occludedStrokes;
+    historyCompactApply(job, history);
+    std::chrono::duration<double, std::milli> compactMs = std::chrono::steady_clock::now() - start;
+
+    size_t after = history.size();
+    double replayAfter = replayMs(history);
+    replay(history);
+    long diff = 0;
+    for (int y = 0; y < SCREEN_HEIGHT; y++)
+        for (int x = 0; x < SCREEN_WIDTH; x++)
+            diff += frame[y][x] != reference[y][x];
+
+    printf("points   %zu -> %zu (%.1f%% removed: hidden %u, simplified %u, occluded %u in %u strokes)\n", before, after,
+           before ? 100.0 * (before - after) / before : 0.0, hidden, simplified, occluded, occludedStrokes);
+    printf("memory   %zu -> %zu bytes of history (%zu reclaimed), flash snapshot %zu -> %zu bytes\n",
+           before * DEVICE_POINT_BYTES, after * DEVICE_POINT_BYTES, (before - after) * DEVICE_POINT_BYTES,
+           before * FLASH_RECORD_BYTES, after * FLASH_RECORD_BYTES);
+    printf("compact  %.2fms on host in %d steps of %d points\n", compactMs.count(), steps, HISTORY_COMPACT_SLICE_POINTS);
+    printf("replay   %.3fms -> %.3fms (%.2fx)\n", replayBefore, replayAfter, replayAfter > 0 ? replayBefore / replayAfter : 0.0);
+    printf("diff     %ld of %d pixels differ after compaction (expected 0)\n", diff, SCREEN_WIDTH * SCREEN_HEIGHT);
+    return diff == 0 ? 0 : 1;
+}
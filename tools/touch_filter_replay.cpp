@@ -0,0 +1,270 @@
+// 触摸滤波回放工具 (主机端)
+// 把录制的 XPT2046 原始轨迹送入固件同一份 src/touch_filter.cpp，报告抖动与滞后，用于调 One Euro 参数。
+//
+// 构建 (主机构建的一个目标，链接固件模块和 host/mock 中的替身):
+//   cmake -S host -B build-host && cmake --build build-host --target touch_filter_replay
+//
+// 轨迹为 "T,时间戳ms,x,y,z" 文本行 (其他行会被忽略)，用 tools/touch_trace_convert --text 从串口命令 "trace"
+// 录制的二进制轨迹生成。
+// 没有设备时可用 --synth 生成带噪声的合成轨迹。
+//
+// 用法:
+//   touch_filter_replay trace.csv [minCutoff beta dCutoff]   按给定参数 (默认同 config.h) 回放
+//   touch_filter_replay trace.csv --sweep                     扫描一组 minCutoff x beta 组合
+//   touch_filter_replay --synth > trace.csv                   生成合成轨迹
+//
+// 指标 (单位换算为屏幕像素):
+//   jitter  输出轨迹二阶差分的均方根，越小线条越平滑
+//   resid   输出与零相位参考轨迹 (原始样本的居中滑动平均) 在最佳对齐下的均方根误差
+//   lag     最佳对齐所需的时间平移 (毫秒)，即滤波带来的笔迹滞后
+
+#include "config.h" // 触摸映射范围、压力阈值和默认滤波参数
+#include "touch_filter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define REFERENCE_HALF_WINDOW 3 // 参考轨迹居中滑动平均的半窗口 (样本数)
+#define MAX_LAG_SAMPLES 12      // 搜索的最大对齐平移 (样本数)
+
+typedef struct Sample_s
+{
+    unsigned long t;
+    int16_t x, y, z;
+} Sample_t;
+
+typedef struct Metrics_s
+{
+    double jitterSq;  // 二阶差分平方和 (像素²)
+    long jitterN;
+    double residSq;   // 最佳对齐残差平方和 (像素²)
+    long residN;
+    double lagMs;     // 各笔划滞后的加权和
+    long lagWeight;
+    long strokes;
+    long samples;
+} Metrics_t;
+
+static const double PX_PER_ADC_X = (double)SCREEN_WIDTH / (TOUCH_MAX_X - TOUCH_MIN_X);
+static const double PX_PER_ADC_Y = (double)SCREEN_HEIGHT / (TOUCH_MAX_Y - TOUCH_MIN_Y);
+
+static bool loadTrace(const char *path, std::vector<Sample_t> &out)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        const char *p = line;
+        if (p[0] == 'T' && p[1] == ',')
+            p += 2;
+        unsigned long t;
+        int x, y, z;
+        if (sscanf(p, "%lu,%d,%d,%d", &t, &x, &y, &z) == 4)
+            out.push_back({t, (int16_t)x, (int16_t)y, (int16_t)z});
+    }
+    fclose(f);
+    return true;
+}
+
+// 按抬笔 (z 低于阈值) 切分笔划
+static std::vector<std::vector<Sample_t>> splitStrokes(const std::vector<Sample_t> &trace)
+{
+    std::vector<std::vector<Sample_t>> strokes;
+    std::vector<Sample_t> current;
+    for (const Sample_t &s : trace)
+    {
+        if (s.z <= TOUCH_PRESSURE_THRESHOLD)
+        {
+            if (!current.empty())
+                strokes.push_back(current);
+            current.clear();
+            continue;
+        }
+        current.push_back(s);
+    }
+    if (!current.empty())
+        strokes.push_back(current);
+    return strokes;
+}
+
+static void evaluateStroke(const std::vector<Sample_t> &stroke, const OneEuroParams_t *params, Metrics_t &m)
+{
+    size_t n = stroke.size();
+    if (n < 2 * REFERENCE_HALF_WINDOW + MAX_LAG_SAMPLES + 3)
+        return; // 太短的笔划 (点击) 不参与统计
+
+    std::vector<double> fx(n), fy(n), rx(n), ry(n);
+    TouchFilter_t filter;
+    touchFilterReset(filter);
+    for (size_t i = 0; i < n; i++)
+    {
+        float ox = stroke[i].x, oy = stroke[i].y;
+        if (params)
+            touchFilterApply(filter, *params, stroke[i].x, stroke[i].y, stroke[i].t, ox, oy);
+        fx[i] = ox * PX_PER_ADC_X;
+        fy[i] = oy * PX_PER_ADC_Y;
+    }
+
+    // 零相位参考: 原始样本居中滑动平均 (两端不完整的部分不参与比较)
+    for (size_t i = REFERENCE_HALF_WINDOW; i + REFERENCE_HALF_WINDOW < n; i++)
+    {
+        double sx = 0, sy = 0;
+        for (int k = -REFERENCE_HALF_WINDOW; k <= REFERENCE_HALF_WINDOW; k++)
+        {
+            sx += stroke[i + k].x;
+            sy += stroke[i + k].y;
+        }
+        rx[i] = sx / (2 * REFERENCE_HALF_WINDOW + 1) * PX_PER_ADC_X;
+        ry[i] = sy / (2 * REFERENCE_HALF_WINDOW + 1) * PX_PER_ADC_Y;
+    }
+
+    for (size_t i = 2; i < n; i++)
+    {
+        double ddx = fx[i] - 2 * fx[i - 1] + fx[i - 2];
+        double ddy = fy[i] - 2 * fy[i - 1] + fy[i - 2];
+        m.jitterSq += ddx * ddx + ddy * ddy;
+        m.jitterN++;
+    }
+
+    // 找使输出与 (提前 d 个样本的) 参考轨迹误差最小的平移
+    double bestErr = 1e300;
+    long bestCount = 0;
+    int bestShift = 0;
+    for (int d = 0; d <= MAX_LAG_SAMPLES; d++)
+    {
+        double err = 0;
+        long count = 0;
+        for (size_t i = REFERENCE_HALF_WINDOW + d; i + REFERENCE_HALF_WINDOW < n; i++)
+        {
+            double ex = fx[i] - rx[i - d];
+            double ey = fy[i] - ry[i - d];
+            err += ex * ex + ey * ey;
+            count++;
+        }
+        if (count > 0 && err / count < bestErr)
+        {
+            bestErr = err / count;
+            bestCount = count;
+            bestShift = d;
+        }
+    }
+    double meanDt = (double)(stroke[n - 1].t - stroke[0].t) / (n - 1);
+    m.residSq += bestErr * bestCount;
+    m.residN += bestCount;
+    m.lagMs += bestShift * meanDt * n;
+    m.lagWeight += n;
+    m.strokes++;
+    m.samples += n;
+}
+
+static void report(const char *label, const std::vector<std::vector<Sample_t>> &strokes, const OneEuroParams_t *params)
+{
+    Metrics_t m;
+    memset(&m, 0, sizeof(m));
+    for (const auto &stroke : strokes)
+        evaluateStroke(stroke, params, m);
+    if (m.strokes == 0)
+    {
+        printf("%-24s no strokes long enough to evaluate\n", label);
+        return;
+    }
+    printf("%-24s strokes=%-4ld samples=%-6ld jitter=%.3fpx resid=%.3fpx lag=%.1fms\n",
+           label, m.strokes, m.samples,
+           sqrt(m.jitterSq / m.jitterN), sqrt(m.residSq / m.residN), m.lagMs / m.lagWeight);
+}
+
+// 合成轨迹: 若干圆弧和直线笔划，200Hz，叠加高斯噪声和偶发尖峰
+static void writeSynthTrace()
+{
+    std::mt19937 rng(12345);
+    std::normal_distribution<double> noise(0.0, 12.0); // 约 1 像素的 ADC 噪声
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    unsigned long t = 1000;
+    for (int stroke = 0; stroke < 8; stroke++)
+    {
+        double speed = 0.25 + stroke * 0.25; // 每笔速度递增 (每笔 0.8 秒内画的圈数/横越屏幕次数)
+        int samples = 160;
+        for (int i = 0; i < samples; i++, t += 5)
+        {
+            double phase = (double)i / samples;
+            double x, y;
+            if (stroke % 2 == 0)
+            {
+                double a = 2 * M_PI * phase * speed;
+                x = 1950 + 900 * cos(a);
+                y = 2050 + 900 * sin(a);
+            }
+            else
+            {
+                x = 600 + 2600 * fmod(phase * speed, 1.0);
+                y = 800 + 400 * stroke;
+            }
+            x += noise(rng);
+            y += noise(rng);
+            if (uniform(rng) < 0.02)
+                x += 300; // 尖峰
+            printf("T,%lu,%d,%d,%d\n", t, (int)x, (int)y, 800);
+        }
+        printf("T,%lu,0,0,0\n", t);
+        t += 300;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "--synth") == 0)
+    {
+        writeSynthTrace();
+        return 0;
+    }
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s trace.csv [minCutoff beta dCutoff | --sweep]\n       %s --synth\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    std::vector<Sample_t> trace;
+    if (!loadTrace(argv[1], trace))
+        return 1;
+    std::vector<std::vector<Sample_t>> strokes = splitStrokes(trace);
+
+    report("raw (no filter)", strokes, nullptr);
+
+    if (argc >= 3 && strcmp(argv[2], "--sweep") == 0)
+    {
+        const float cutoffs[] = {0.5f, 1.0f, 2.0f, 3.0f, 5.0f, 8.0f};
+        const float betas[] = {0.0f, 0.001f, 0.002f, 0.004f, 0.008f, 0.016f};
+        for (float minCutoff : cutoffs)
+        {
+            for (float beta : betas)
+            {
+                OneEuroParams_t params = {minCutoff, beta, TOUCH_FILTER_D_CUTOFF};
+                char label[64];
+                snprintf(label, sizeof(label), "fc=%.1f beta=%.3f", minCutoff, beta);
+                report(label, strokes, &params);
+            }
+        }
+        return 0;
+    }
+
+    OneEuroParams_t params = {TOUCH_FILTER_MIN_CUTOFF, TOUCH_FILTER_BETA, TOUCH_FILTER_D_CUTOFF};
+    if (argc >= 5)
+    {
+        params.minCutoff = atof(argv[2]);
+        params.beta = atof(argv[3]);
+        params.dCutoff = atof(argv[4]);
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "fc=%.1f beta=%.3f", params.minCutoff, params.beta);
+    report(label, strokes, &params);
+    return 0;
+}
@@ -0,0 +1,249 @@
+// 触摸轨迹转换工具 (主机端)
+// 在串口日志、二进制轨迹文件 (格式见 src/touch_trace.h) 和 touch_filter_replay 的文本轨迹之间转换。
+//
+// 构建 (主机构建的一个目标):
+//   cmake -S host -B build-host && cmake --build build-host --target touch_trace_convert
+//
+// 录制轨迹: 串口输入 "trace rec"，书写后 "trace stop"，再 "trace dump"，把串口输出保存为文本
+// (其他行会被忽略；日志中有多次导出时取最后一次完整的)。touch_filter_replay 的 "T,时间戳ms,x,y,z" 文本行也可转换，
+// 相邻样本间隔超过 TOUCH_STROKE_INTERVAL 时补一个抬笔样本。
+//
+// 用法:
+//   touch_trace_convert serial.log out.trace   串口日志 -> 二进制轨迹 (firenote_host --trace 或 LittleFS /touch.trace)
+//   touch_trace_convert --info in.trace        打印样本数、笔划数、时长和采样间隔
+//   touch_trace_convert --text in.trace        输出 "T,时间戳ms,x,y,z" 行 (touch_filter_replay 的输入)
+//   touch_trace_convert --put in.trace         输出 "trace put" 命令行，粘贴到串口即可把轨迹导入设备
+
+#include "config.h"         // TOUCH_STROKE_INTERVAL, TOUCH_TASK_PERIOD_MS
+#include "serial_console.h" // SERIAL_CONSOLE_LINE_MAX
+#include "touch_trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define PUT_BYTES_PER_LINE 39 // "trace put " 之后最多 54 个字符，取 4 的倍数 52 个 base64 字符
+
+static const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void base64Encode(const uint8_t *src, size_t len, char *dst)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < len)
+            v |= (uint32_t)src[i + 1] << 8;
+        if (i + 2 < len)
+            v |= src[i + 2];
+        dst[n++] = base64Alphabet[(v >> 18) & 0x3F];
+        dst[n++] = base64Alphabet[(v >> 12) & 0x3F];
+        dst[n++] = i + 1 < len ? base64Alphabet[(v >> 6) & 0x3F] : '=';
+        dst[n++] = i + 2 < len ? base64Alphabet[v & 0x3F] : '=';
+    }
+    dst[n] = '\0';
+}
+
+static bool base64Decode(const char *src, size_t len, std::vector<uint8_t> &out)
+{
+    if (len % 4 != 0)
+        return false;
+    for (size_t i = 0; i < len; i += 4)
+    {
+        uint32_t v = 0;
+        int pad = 0;
+        for (size_t k = 0; k < 4; k++)
+        {
+            const char *p = strchr(base64Alphabet, src[i + k]);
+            if (src[i + k] == '=' && i + 4 == len && k >= 2)
+                pad++;
+            else if (pad > 0 || src[i + k] == '\0' || p == nullptr)
+                return false;
+            v = (v << 6) | (uint32_t)(src[i + k] == '=' ? 0 : p - base64Alphabet);
+        }
+        for (int k = 0; k < 3 - pad; k++)
+            out.push_back((uint8_t)(v >> (16 - 8 * k)));
+    }
+    return true;
+}
+
+static bool readTrace(const char *path, TouchTraceHeader_t &header, std::vector<TouchTraceRecord_t> &records)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+        return false;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 && header.magic == TOUCH_TRACE_MAGIC &&
+              header.version == TOUCH_TRACE_VERSION && header.recordSize == sizeof(TouchTraceRecord_t);
+    if (ok)
+    {
+        records.resize(header.count);
+        ok = header.count == 0 || fread(records.data(), sizeof(TouchTraceRecord_t), header.count, f) == header.count;
+    }
+    fclose(f);
+    return ok;
+}
+
+// 从串口日志中取出轨迹: 优先用 "TRACE,偏移,base64" 导出，否则用 "T,时间戳,x,y,z" 行
+static bool parseLog(const char *path, std::vector<uint8_t> &image)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr)
+        return false;
+    std::vector<uint8_t> dump, lastComplete;
+    std::vector<TouchTraceRecord_t> legacy;
+    unsigned long firstMs = 0, prevMs = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        const char *trace = strstr(line, "TRACE,");
+        unsigned long t;
+        int x, y, z;
+        if (trace != nullptr)
+        {
+            trace += 6;
+            unsigned long count;
+            if (sscanf(trace, "END,%lu", &count) == 1)
+            {
+                if (dump.size() == sizeof(TouchTraceHeader_t) + count * sizeof(TouchTraceRecord_t))
+                    lastComplete = dump;
+                else
+                    fprintf(stderr, "incomplete dump (%zu bytes for %lu samples), skipped\n", dump.size(), count);
+                dump.clear();
+                continue;
+            }
+            unsigned long offset;
+            const char *comma = strchr(trace, ',');
+            if (sscanf(trace, "%lu", &offset) != 1 || comma == nullptr)
+                continue;
+            if (offset == 0)
+                dump.clear();
+            if (offset != dump.size() || !base64Decode(comma + 1, strlen(comma + 1), dump))
+            {
+                fprintf(stderr, "bad dump line at offset %lu, dump discarded\n", offset);
+                dump.clear();
+            }
+        }
+        else if (sscanf(line, "T,%lu,%d,%d,%d", &t, &x, &y, &z) == 4)
+        {
+            if (legacy.empty())
+                firstMs = t;
+            else if (t - prevMs > TOUCH_STROKE_INTERVAL)
+                legacy.push_back({(uint32_t)((prevMs - firstMs) * 1000 + TOUCH_TASK_PERIOD_MS * 1000), 0, 0, 0, 0});
+            legacy.push_back({(uint32_t)((t - firstMs) * 1000), (int16_t)x, (int16_t)y, (int16_t)z, 0});
+            prevMs = t;
+        }
+    }
+    fclose(f);
+
+    if (!lastComplete.empty())
+    {
+        image = lastComplete;
+        return true;
+    }
+    if (legacy.empty())
+        return false;
+    legacy.push_back({legacy.back().timeUs + TOUCH_TASK_PERIOD_MS * 1000, 0, 0, 0, 0});
+    TouchTraceHeader_t header = {TOUCH_TRACE_MAGIC, TOUCH_TRACE_VERSION, sizeof(TouchTraceRecord_t),
+                                 (uint32_t)legacy.size(), TOUCH_TASK_PERIOD_MS * 1000};
+    image.assign((const uint8_t *)&header, (const uint8_t *)&header + sizeof(header));
+    image.insert(image.end(), (const uint8_t *)legacy.data(), (const uint8_t *)(legacy.data() + legacy.size()));
+    return true;
+}
+
+static void printInfo(const TouchTraceHeader_t &header, const std::vector<TouchTraceRecord_t> &records)
+{
+    long strokes = 0, down = 0;
+    uint32_t minGap = UINT32_MAX, maxGap = 0;
+    bool penDown = false;
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        if (records[i].z > 0)
+        {
+            down++;
+            if (!penDown)
+                strokes++;
+            else
+            {
+                uint32_t gap = records[i].timeUs - records[i - 1].timeUs;
+                minGap = gap < minGap ? gap : minGap;
+                maxGap = gap > maxGap ? gap : maxGap;
+            }
+        }
+        penDown = records[i].z > 0;
+    }
+    printf("samples   %u (%ld pen-down, %ld strokes)\n", header.count, down, strokes);
+    printf("duration  %.3f s\n", records.empty() ? 0.0 : records.back().timeUs / 1e6);
+    printf("period    %u us nominal", header.periodUs);
+    if (maxGap > 0)
+        printf(", %u..%u us within strokes", minGap, maxGap);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && argv[1][0] == '-')
+    {
+        TouchTraceHeader_t header;
+        std::vector<TouchTraceRecord_t> records;
+        if (!readTrace(argv[2], header, records))
+        {
+            fprintf(stderr, "cannot read touch trace %s\n", argv[2]);
+            return 1;
+        }
+        if (strcmp(argv[1], "--info") == 0)
+        {
+            printInfo(header, records);
+        }
+        else if (strcmp(argv[1], "--text") == 0)
+        {
+            for (const TouchTraceRecord_t &r : records)
+            {
+                if (r.z > 0)
+                    printf("T,%u,%d,%d,%d\n", r.timeUs / 1000, r.x, r.y, r.z);
+            }
+        }
+        else if (strcmp(argv[1], "--put") == 0)
+        {
+            std::vector<uint8_t> image((const uint8_t *)&header, (const uint8_t *)&header + sizeof(header));
+            image.insert(image.end(), (const uint8_t *)records.data(), (const uint8_t *)(records.data() + records.size()));
+            char encoded[SERIAL_CONSOLE_LINE_MAX];
+            printf("trace put\n");
+            for (size_t i = 0; i < image.size(); i += PUT_BYTES_PER_LINE)
+            {
+                size_t n = image.size() - i < PUT_BYTES_PER_LINE ? image.size() - i : PUT_BYTES_PER_LINE;
+                base64Encode(image.data() + i, n, encoded);
+                printf("trace put %s\n", encoded);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[1]);
+            return 2;
+        }
+        return 0;
+    }
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: touch_trace_convert serial.log out.trace | --info|--text|--put in.trace\n");
+        return 2;
+    }
+    std::vector<uint8_t> image;
+    if (!parseLog(argv[1], image))
+    {
+        fprintf(stderr, "no trace found in %s (expected TRACE dump or T,ms,x,y,z lines)\n", argv[1]);
+        return 1;
+    }
+    FILE *f = fopen(argv[2], "wb");
+    if (f == nullptr || fwrite(image.data(), 1, image.size(), f) != image.size())
+    {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    fclose(f);
+    const TouchTraceHeader_t *header = (const TouchTraceHeader_t *)image.data();
+    printf("%u samples written to %s\n", header->count, argv[2]);
+    return 0;
+}